@@ -0,0 +1,90 @@
+#include "CppUnitTest.h"
+#include "TestToString.h"
+
+#include "Utils.h"
+#include "MathHeaders/Aligned.h"
+#include "MathHeaders/Batch.h"
+
+#include <cstdint>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace MathClasses;
+
+namespace MathLibraryTests
+{
+	TEST_CLASS(AlignedTests)
+	{
+	public:
+		// aligned containers start on the requested boundary
+		TEST_METHOD(AlignedVectorStorage)
+		{
+			AlignedVector<float, 32> floats(7);
+			Matrix4Array matrices(5);
+			Vector4Array vectors(3);
+
+			Assert::AreEqual(size_t(0), reinterpret_cast<uintptr_t>(floats.data()) % 32);
+			Assert::AreEqual(size_t(0), reinterpret_cast<uintptr_t>(matrices.data()) % 64);
+			Assert::AreEqual(size_t(0), reinterpret_cast<uintptr_t>(&matrices[1]) % 64);
+			Assert::AreEqual(size_t(0), reinterpret_cast<uintptr_t>(&vectors[2]) % 16);
+		}
+
+		// aligned variants still behave as the plain types
+		TEST_METHOD(AlignedTypesConvert)
+		{
+			Vector4A32 a(1, 2, 3, 4);
+			Vector4A32 b = a + Vector4(1, 1, 1, 1);
+			Matrix4A64 m = Matrix4::MakeTranslation(1.0f, 2.0f, 3.0f);
+
+			Assert::AreEqual(Vector4(2, 3, 4, 5), static_cast<Vector4>(b));
+			Assert::AreEqual(Vector4(7, 13, 19, 5), m * b);
+		}
+
+		TEST_METHOD(Vector3PaddedConverts)
+		{
+			Vector3Padded p(Vector3(1, 2, 3));
+			Vector3 v = p;
+
+			Assert::AreEqual(0.f, p.padding);
+			Assert::AreEqual(Vector3(1, 2, 3), v);
+		}
+
+		// aligned and unaligned batch transforms agree with operator*
+		TEST_METHOD(TransformAlignedVector4s)
+		{
+			Matrix4 m = Matrix4::MakeTranslation(4.0f, 5.0f, 6.0f) * Matrix4::MakeEuler(1.0f, 0.5f, -0.25f);
+			Vector4Array aligned(1000);
+			std::vector<Vector4> plain(1000);
+			for (size_t i = 0; i < aligned.size(); ++i) {
+				plain[i] = Vector4(float(i), -float(i) * 0.5f, 3.0f, (i % 2) ? 1.0f : 0.0f);
+				aligned[i] = plain[i];
+			}
+
+			std::vector<Vector4> expected(plain.size());
+			for (size_t i = 0; i < plain.size(); ++i)
+				expected[i] = m * plain[i];
+
+			TransformVector4s(m, aligned.data(), aligned.data(), aligned.size());
+			TransformVector4s(Execution::Par, m, plain.data(), plain.data(), plain.size());
+
+			for (size_t i = 0; i < plain.size(); ++i) {
+				Assert::AreEqual(expected[i], plain[i]);
+				Assert::AreEqual(expected[i], static_cast<Vector4>(aligned[i]));
+			}
+		}
+
+		// row-wise SIMD products agree with operator*, including in place
+		TEST_METHOD(MultiplyMatricesSimd)
+		{
+			Matrix4 a = Matrix4::MakeEuler(0.4f, 1.3f, -2.2f) * Matrix4::MakeScale(1.0f, 2.0f, 3.0f);
+			Matrix4 b = Matrix4::MakeTranslation(-3.0f, 7.0f, 1.0f) * Matrix4::MakeRotateY(0.9f);
+			Matrix4 expected = a * b;
+
+			Matrix4 out;
+			MultiplyMatrices(&a, &b, &out, 1);
+			Assert::AreEqual(expected, out);
+
+			MultiplyMatrices(a, &b, &b, 1);
+			Assert::AreEqual(expected, b);
+		}
+	};
+}
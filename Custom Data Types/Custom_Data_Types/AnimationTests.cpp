@@ -0,0 +1,137 @@
+#include "CppUnitTest.h"
+#include "TestToString.h"
+
+#include "Utils.h"
+#include "MathHeaders/Animation.h"
+
+#include <cmath>
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace MathClasses;
+
+namespace MathLibraryTests
+{
+	TEST_CLASS(AnimationTests)
+	{
+	public:
+		TEST_METHOD(SampleInterpolatesAndClamps)
+		{
+			Vector3Track track;
+			track.AddKey(0.0f, Vector3(0, 0, 0));
+			track.AddKey(1.0f, Vector3(2, 4, -2));
+			track.AddKey(3.0f, Vector3(2, 0, 0));
+
+			Assert::AreEqual(Vector3(1, 2, -1), track.Sample(0.5f));
+			Assert::AreEqual(Vector3(2, 2, -1), track.Sample(2.0f));
+			Assert::AreEqual(Vector3(0, 0, 0), track.Sample(-1.0f));
+			Assert::AreEqual(Vector3(2, 0, 0), track.Sample(10.0f));
+		}
+
+		// sampling through a cursor gives the same answers forwards, backwards and jumping
+		TEST_METHOD(CursorMatchesSearch)
+		{
+			Vector3Track track;
+			for (int i = 0; i < 100; ++i)
+				track.AddKey(i * 0.1f, Vector3(std::sin(i * 0.3f), float(i), std::cos(i * 0.7f)));
+
+			TrackCursor cursor;
+			for (float t = -0.5f; t < 11.0f; t += 0.037f)
+				Assert::AreEqual(track.Sample(t), track.Sample(t, cursor));
+			for (float t = 11.0f; t > -0.5f; t -= 0.51f)
+				Assert::AreEqual(track.Sample(t), track.Sample(t, cursor));
+		}
+
+		// keys on a straight line are removed, corners are kept
+		TEST_METHOD(KeyReduction)
+		{
+			Vector3Track track;
+			for (int i = 0; i <= 10; ++i)
+				track.AddKey(float(i), Vector3(float(i), 0, 0));
+			for (int i = 11; i <= 20; ++i)
+				track.AddKey(float(i), Vector3(10, float(i - 10), 0));
+
+			Vector3Track reduced = track;
+			reduced.Reduce(0.001f);
+
+			Assert::AreEqual(size_t(3), reduced.GetKeyCount());
+			for (float t = 0.0f; t <= 20.0f; t += 0.25f)
+				Assert::AreEqual(track.Sample(t), reduced.Sample(t));
+		}
+
+		// compressed tracks stay close to the source; key values are within the
+		// quantisation error and key times move by at most 1/65535 of the duration
+		TEST_METHOD(CompressedTrack)
+		{
+			Vector3Track track;
+			for (int i = 0; i < 60; ++i)
+				track.AddKey(i / 30.0f, Vector3(std::sin(i * 0.1f) * 5.0f, i * 0.25f, -3.0f));
+
+			CompressedVector3Track compressed(track);
+			float tolerance = compressed.GetQuantisationError() + 0.001f;
+
+			Assert::AreEqual(track.GetKeyCount(), compressed.GetKeyCount());
+			TrackCursor cursor;
+			for (float t = 0.0f; t < 2.0f; t += 0.01f) {
+				Vector3 expected = track.Sample(t);
+				Vector3 actual = compressed.Sample(t, cursor);
+				Assert::AreEqual(expected.x, actual.x, tolerance);
+				Assert::AreEqual(expected.y, actual.y, tolerance);
+				Assert::AreEqual(expected.z, actual.z, tolerance);
+			}
+		}
+
+		// direct TRS matrix matches composing the builders
+		TEST_METHOD(LocalTRSToMatrix)
+		{
+			LocalTRS trs;
+			trs.translation = Vector3(1, 2, 3);
+			trs.rotation = Vector3(0.3f, -1.1f, 2.4f);
+			trs.scale = Vector3(2, 0.5f, 3);
+
+			Matrix4 expected = Matrix4::MakeTranslation(trs.translation) * Matrix4::MakeEuler(trs.rotation) * Matrix4::MakeScale(trs.scale);
+			Assert::AreEqual(expected, trs.ToMatrix());
+		}
+
+		TEST_METHOD(SampleClipAndCompose)
+		{
+			AnimationClip clip(2);
+			Vector3Track move, still, spin, grow;
+			move.AddKey(0.0f, Vector3(0, 0, 0));
+			move.AddKey(1.0f, Vector3(10, 0, 0));
+			still.AddKey(0.0f, Vector3(0, 0, 0));
+			spin.AddKey(0.0f, Vector3(0, 0, 0));
+			spin.AddKey(1.0f, Vector3(0, 0, 2.0f));
+			grow.AddKey(0.0f, Vector3(1, 1, 1));
+			grow.AddKey(1.0f, Vector3(3, 3, 3));
+			clip.SetTracks(0, move, still, grow);
+			clip.SetTracks(1, still, spin, grow);
+
+			ClipCursor cursor(clip.GetBoneCount());
+			LocalTRS pose[2];
+			Matrix4 matrices[2];
+			SampleClip(Execution::Par, clip, 0.5f, cursor, pose);
+			ComposeTRS(pose, matrices, 2);
+
+			Assert::AreEqual(Vector3(5, 0, 0), pose[0].translation);
+			Assert::AreEqual(Vector3(2, 2, 2), pose[0].scale);
+			Assert::AreEqual(Vector3(0, 0, 1.0f), pose[1].rotation);
+			Assert::AreEqual(Matrix4::MakeRotateZ(1.0f) * Matrix4::MakeScale(2, 2, 2), matrices[1]);
+
+			// the same pose and matrices from a FrameArena
+			FrameArena arena(4096);
+			ClipCursor arenaCursor(clip.GetBoneCount());
+			Span<LocalTRS> arenaPose = SampleClip(Execution::Par, arena, clip, 0.5f, arenaCursor);
+			Assert::AreEqual(size_t(2), arenaPose.Size());
+			Span<Matrix4> arenaMatrices = ComposeTRS(arena, arenaPose.Data(), arenaPose.Size());
+			Assert::AreEqual(size_t(2), arenaMatrices.Size());
+			for (size_t i = 0; i < 2; ++i) {
+				Assert::AreEqual(pose[i].translation, arenaPose[i].translation);
+				Assert::AreEqual(pose[i].rotation, arenaPose[i].rotation);
+				Assert::AreEqual(matrices[i], arenaMatrices[i]);
+			}
+			FrameArena small(64);
+			Assert::IsTrue(ComposeTRS(small, pose, 2).Empty());
+		}
+	};
+}
@@ -0,0 +1,254 @@
+#include "CppUnitTest.h"
+#include "TestToString.h"
+
+#include "Utils.h"
+#include "MathHeaders/Batch.h"
+#include "MathHeaders/ThreadPool.h"
+
+#include <atomic>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace MathClasses;
+
+namespace MathLibraryTests
+{
+	TEST_CLASS(BatchTests)
+	{
+	public:
+		// every index is visited exactly once
+		TEST_METHOD(ParallelForCoversRange)
+		{
+			ThreadPool pool(3);
+			std::vector<int> visits(100000, 0);
+
+			pool.ParallelFor(0, visits.size(), 64, [&](size_t begin, size_t end) {
+				for (size_t i = begin; i < end; ++i)
+					visits[i]++;
+			});
+
+			for (int v : visits)
+				Assert::AreEqual(1, v);
+		}
+
+		// small ranges run inline as a single call
+		TEST_METHOD(ParallelForSmallRangeIsSerial)
+		{
+			ThreadPool pool(3);
+			int calls = 0;
+			std::thread::id caller = std::this_thread::get_id();
+			bool sameThread = true;
+
+			pool.ParallelFor(0, 100, 1000, [&](size_t begin, size_t end) {
+				calls++;
+				sameThread = sameThread && std::this_thread::get_id() == caller;
+				Assert::AreEqual(size_t(0), begin);
+				Assert::AreEqual(size_t(100), end);
+			});
+
+			Assert::AreEqual(1, calls);
+			Assert::IsTrue(sameThread);
+		}
+
+		// the first exception reaches the caller once the running ranges have finished,
+		// and the pool keeps working afterwards
+		TEST_METHOD(ParallelForRethrows)
+		{
+			ThreadPool pool(3);
+			std::atomic<size_t> visited{ 0 };
+			bool caught = false;
+			try {
+				pool.ParallelFor(0, 100000, 64, [&](size_t begin, size_t end) {
+					if (begin <= 5000 && 5000 < end)
+						throw std::runtime_error("range failed");
+					visited += end - begin;
+				});
+			}
+			catch (const std::runtime_error& e) {
+				caught = std::string("range failed") == e.what();
+			}
+			Assert::IsTrue(caught);
+			Assert::IsTrue(visited.load() < size_t(100000));
+
+			// thrown from a nested loop on a worker
+			caught = false;
+			try {
+				pool.ParallelFor(0, 64, 1, [&](size_t begin, size_t) {
+					pool.ParallelFor(0, 1000, 10, [&](size_t b, size_t) {
+						if (begin == 37 && b == 500)
+							throw std::runtime_error("nested");
+					});
+				});
+			}
+			catch (const std::runtime_error&) {
+				caught = true;
+			}
+			Assert::IsTrue(caught);
+
+			visited = 0;
+			pool.ParallelFor(0, 100000, 64, [&](size_t begin, size_t end) {
+				visited += end - begin;
+			});
+			Assert::AreEqual(size_t(100000), visited.load());
+		}
+
+		// ParallelFor called from inside a ParallelFor body
+		TEST_METHOD(ParallelForNested)
+		{
+			ThreadPool pool(3);
+			std::atomic<size_t> total{ 0 };
+
+			pool.ParallelFor(0, 64, 1, [&](size_t begin, size_t end) {
+				for (size_t i = begin; i < end; ++i) {
+					pool.ParallelFor(0, 1000, 10, [&](size_t b, size_t e) {
+						total += e - b;
+					});
+				}
+			});
+
+			Assert::AreEqual(size_t(64000), total.load());
+		}
+
+		TEST_METHOD(TransformPointsMatchesOperator)
+		{
+			Matrix4 m = Matrix4::MakeTranslation(1.0f, 2.0f, 3.0f) * Matrix4::MakeEuler(0.3f, -1.2f, 2.0f) * Matrix4::MakeScale(2.0f, 3.0f, 4.0f);
+			std::vector<Vector3> points(50000);
+			for (size_t i = 0; i < points.size(); ++i)
+				points[i] = Vector3(float(i % 97) - 48.0f, float(i % 13) * 0.5f, float(i % 31) - 15.0f);
+
+			std::vector<Vector3> serial(points.size());
+			std::vector<Vector3> parallel(points.size());
+			TransformPoints(m, points.data(), serial.data(), points.size());
+			TransformPoints(Execution::Par, m, points.data(), parallel.data(), points.size());
+
+			for (size_t i = 0; i < points.size(); i += 101) {
+				Vector4 expected = m * Vector4(points[i].x, points[i].y, points[i].z, 1.0f);
+				Assert::AreEqual(Vector3(expected.x, expected.y, expected.z), serial[i]);
+			}
+			for (size_t i = 0; i < points.size(); ++i) {
+				Assert::AreEqual(serial[i].x, parallel[i].x);
+				Assert::AreEqual(serial[i].y, parallel[i].y);
+				Assert::AreEqual(serial[i].z, parallel[i].z);
+			}
+		}
+
+		TEST_METHOD(TransformVectorsIgnoresTranslation)
+		{
+			Matrix4 m = Matrix4::MakeTranslation(10.0f, 20.0f, 30.0f) * Matrix4::MakeRotateZ(Pi / 2);
+			Vector3 v(1.0f, 0.0f, 0.0f);
+
+			TransformVectors(Execution::Par, m, &v, &v, 1);
+
+			Assert::AreEqual(Vector3(0.0f, 1.0f, 0.0f), v);
+		}
+
+		TEST_METHOD(MultiplyMatricesMatchesOperator)
+		{
+			Matrix4 parent = Matrix4::MakeEuler(0.1f, 0.2f, 0.3f);
+			std::vector<Matrix4> locals(20000);
+			for (size_t i = 0; i < locals.size(); ++i)
+				locals[i] = Matrix4::MakeTranslation(float(i), 1.0f, 2.0f);
+
+			std::vector<Matrix4> results(locals.size());
+			MultiplyMatrices(Execution::Par, parent, locals.data(), results.data(), locals.size());
+
+			for (size_t i = 0; i < locals.size(); i += 997) {
+				Matrix4 expected = parent * locals[i];
+				const float* e = &expected.m1;
+				const float* r = &results[i].m1;
+				for (int k = 0; k < 16; ++k)
+					Assert::IsTrue(NearlyEqualAtScale(e[k], r[k], float(i)));
+			}
+		}
+
+		TEST_METHOD(FirstTouchBufferIsValueInitialised)
+		{
+			FirstTouchBuffer<Vector3> buffer(100000);
+
+			Assert::AreEqual(size_t(100000), buffer.Size());
+			for (const Vector3& v : buffer)
+				Assert::AreEqual(Vector3(0, 0, 0), v);
+		}
+
+		TEST_METHOD(ProjectToScreenMatchesDivide)
+		{
+			Matrix4 viewProjection = Matrix4::MakePerspective(Pi / 3, 16.0f / 9.0f, 0.5f, 200.0f) *
+				Matrix4::MakeLookAt(Vector3(0, 5, 10), Vector3(0, 0, 0), Vector3(0, 1, 0));
+			Viewport viewport;
+			viewport.width = 1920.0f;
+			viewport.height = 1080.0f;
+
+			// a count that isn't a multiple of four, including points behind and beside the camera
+			std::vector<Vector3> points(10007);
+			for (size_t i = 0; i < points.size(); ++i)
+				points[i] = Vector3(float(i % 41) - 20.0f, float(i % 7) - 3.0f, float(i % 53) - 30.0f);
+
+			std::vector<Vector3> serial(points.size()), parallel(points.size());
+			std::vector<uint8_t> serialFlags(points.size()), parallelFlags(points.size());
+			ProjectToScreen(viewProjection, viewport, points.data(), serial.data(), serialFlags.data(), points.size());
+			ProjectToScreen(Execution::Par, viewProjection, viewport, points.data(), parallel.data(), parallelFlags.data(), points.size());
+
+			int onScreen = 0;
+			for (size_t i = 0; i < points.size(); ++i) {
+				Assert::AreEqual(serialFlags[i], parallelFlags[i]);
+
+				Vector4 clip = viewProjection * Vector4(points[i].x, points[i].y, points[i].z, 1.0f);
+				bool behind = clip.w <= 0.0f;
+				Assert::AreEqual(behind, (serialFlags[i] & ProjectedBehind) != 0);
+				if (behind)
+					continue;
+				Assert::AreEqual(serial[i].x, parallel[i].x);
+				Assert::AreEqual(serial[i].y, parallel[i].y);
+				float x = (clip.x / clip.w * 0.5f + 0.5f) * 1920.0f;
+				float y = (0.5f - clip.y / clip.w * 0.5f) * 1080.0f;
+				float z = clip.z / clip.w * 0.5f + 0.5f;
+				bool inside = x >= 0.0f && x <= 1920.0f && y >= 0.0f && y <= 1080.0f;
+				if (inside && x > 1.0f && x < 1919.0f && y > 1.0f && y < 1079.0f)
+					Assert::IsTrue((serialFlags[i] & ProjectedOffScreen) == 0);
+				if (!inside && (x < -1.0f || x > 1921.0f || y < -1.0f || y > 1081.0f))
+					Assert::IsTrue((serialFlags[i] & ProjectedOffScreen) != 0);
+				if (serialFlags[i] == 0) {
+					Assert::AreEqual(x, serial[i].x, 0.01f);
+					Assert::AreEqual(y, serial[i].y, 0.01f);
+					Assert::AreEqual(z, serial[i].z, 0.0001f);
+					++onScreen;
+				}
+			}
+			Assert::IsTrue(onScreen > 1000);
+		}
+
+		TEST_METHOD(TransformAABBsMatchesScalar)
+		{
+			// a count that isn't a multiple of eight, with some empty boxes
+			size_t count = 1003;
+			std::vector<Matrix4> matrices(count);
+			std::vector<AABB> local(count), serial(count), parallel(count);
+			for (size_t i = 0; i < count; ++i) {
+				float f = float(i);
+				matrices[i] = Matrix4::MakeTranslation(f, -f, 0.5f * f) * Matrix4::MakeEuler(0.01f * f, -0.02f * f, 0.03f * f) *
+					Matrix4::MakeScale(1.0f + float(i % 3), 0.5f, (i % 5 == 0) ? -2.0f : 1.0f);
+				local[i] = i % 97 == 0 ? AABB() : AABB(Vector3(-1, -2, -float(i % 4)), Vector3(float(i % 7), 2, 1));
+			}
+			TransformAABBs(matrices.data(), local.data(), serial.data(), count);
+			TransformAABBs(Execution::Par, matrices.data(), local.data(), parallel.data(), count);
+			for (size_t i = 0; i < count; ++i) {
+				AABB expected = TransformAABB(matrices[i], local[i]);
+				// translations reach about count, and the scaled extents about 20
+				float scale = float(i) + 20.0f;
+				for (int k = 0; k < 3; ++k) {
+					Assert::IsTrue(NearlyEqualAtScale(expected.min[k], serial[i].min[k], scale));
+					Assert::IsTrue(NearlyEqualAtScale(expected.max[k], serial[i].max[k], scale));
+				}
+				Assert::IsTrue(std::memcmp(&serial[i], &parallel[i], sizeof(AABB)) == 0);
+				Assert::AreEqual(local[i].IsEmpty(), serial[i].IsEmpty());
+			}
+
+			// in place
+			TransformAABBs(matrices.data(), local.data(), local.data(), count);
+			Assert::IsTrue(local[5] == serial[5]);
+		}
+	};
+}
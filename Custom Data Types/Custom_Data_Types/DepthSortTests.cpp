@@ -0,0 +1,135 @@
+#include "CppUnitTest.h"
+#include "TestToString.h"
+
+#include "MathHeaders/DepthSort.h"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace MathClasses;
+
+namespace MathLibraryTests
+{
+	static float ViewDepth(const Matrix4& view, const Vector3& p)
+	{
+		Vector4 v = view * Vector4(p.x, p.y, p.z, 1);
+		return -v.z;
+	}
+
+	static void AssertSortedByDepth(const Matrix4& view, const std::vector<Vector3>& centres, const std::vector<uint32_t>& order, DepthOrder depthOrder)
+	{
+		Assert::AreEqual(centres.size(), order.size());
+		std::vector<bool> seen(centres.size());
+		for (size_t i = 0; i < order.size(); ++i) {
+			Assert::IsFalse(seen[order[i]]);
+			seen[order[i]] = true;
+			if (i == 0)
+				continue;
+			float previous = ViewDepth(view, centres[order[i - 1]]), current = ViewDepth(view, centres[order[i]]);
+			Assert::IsTrue(depthOrder == DepthOrder::FrontToBack ? previous <= current : previous >= current);
+		}
+	}
+
+	static std::vector<Vector3> Scene(size_t count, unsigned int seed)
+	{
+		std::mt19937 rng(seed);
+		std::uniform_real_distribution<float> coordinate(-100.0f, 100.0f);
+		std::vector<Vector3> centres(count);
+		for (Vector3& c : centres)
+			c = Vector3(coordinate(rng), coordinate(rng), coordinate(rng));
+		return centres;
+	}
+
+	TEST_CLASS(DepthSortTests)
+	{
+	public:
+		TEST_METHOD(KeysFollowDepth)
+		{
+			Matrix4 view = Matrix4::MakeLookAt(Vector3(0, 0, 0), Vector3(0, 0, -1), Vector3(0, 1, 0));
+			std::vector<Vector3> centres = { Vector3(0, 0, -5), Vector3(0, 0, 3), Vector3(1, 1, -0.5f), Vector3(0, 0, 0), Vector3(0, 0, -100) };
+			std::vector<uint32_t> keys(centres.size());
+			ComputeDepthKeys(view, centres.data(), keys.data(), keys.size(), DepthOrder::FrontToBack);
+			// behind the camera, at it, then further and further in front
+			Assert::IsTrue(keys[1] < keys[3] && keys[3] < keys[2] && keys[2] < keys[0] && keys[0] < keys[4]);
+
+			std::vector<uint32_t> order(centres.size());
+			SortByDepth(view, centres.data(), centres.size(), DepthOrder::BackToFront, order.data());
+			std::vector<uint32_t> expected = { 4, 0, 2, 3, 1 };
+			Assert::IsTrue(expected == order);
+		}
+
+		TEST_METHOD(MatchesStableSort)
+		{
+			std::vector<Vector3> centres = Scene(100003, 1);
+			// repeated depths
+			for (size_t i = 0; i < centres.size(); i += 10)
+				centres[i] = Vector3(0, 0, 20);
+			Matrix4 view = Matrix4::MakeLookAt(Vector3(10, 50, 200), Vector3(0, 0, 0), Vector3(0, 1, 0));
+
+			for (DepthOrder depthOrder : { DepthOrder::FrontToBack, DepthOrder::BackToFront }) {
+				std::vector<float> depths(centres.size());
+				for (size_t i = 0; i < centres.size(); ++i)
+					depths[i] = -(view.m3 * centres[i].x + view.m7 * centres[i].y + view.m11 * centres[i].z + view.m15);
+				std::vector<uint32_t> expected(centres.size());
+				for (size_t i = 0; i < expected.size(); ++i)
+					expected[i] = uint32_t(i);
+				std::stable_sort(expected.begin(), expected.end(), [&](uint32_t a, uint32_t b) {
+					return depthOrder == DepthOrder::FrontToBack ? depths[a] < depths[b] : depths[a] > depths[b];
+				});
+
+				std::vector<uint32_t> order(centres.size());
+				SortByDepth(Execution::Par, view, centres.data(), centres.size(), depthOrder, order.data());
+				Assert::IsTrue(expected == order);
+
+				// from an arena only the order is left allocated
+				FrameArena arena(4 * 1024 * 1024);
+				Span<uint32_t> fromArena = SortByDepth(Execution::Par, arena, view, centres.data(), centres.size(), depthOrder);
+				Assert::IsTrue(std::equal(expected.begin(), expected.end(), fromArena.begin(), fromArena.end()));
+				Assert::IsTrue(arena.GetMarker().offset < centres.size() * sizeof(uint32_t) + 64);
+				FrameArena small(centres.size() * sizeof(uint32_t) * 2);
+				Assert::IsTrue(SortByDepth(small, view, centres.data(), centres.size(), depthOrder).Empty());
+				Assert::AreEqual(size_t(0), small.GetMarker().offset);
+			}
+		}
+
+		TEST_METHOD(IncrementalReusesOrder)
+		{
+			std::vector<Vector3> centres = Scene(20000, 2);
+			Vector3 eye(0, 10, 300);
+			DepthSorter sorter;
+			Matrix4 view = Matrix4::MakeLookAt(eye, Vector3(0, 0, 0), Vector3(0, 1, 0));
+			sorter.Update(view, centres.data(), centres.size(), DepthOrder::BackToFront);
+			Assert::IsFalse(sorter.WasIncremental());
+			AssertSortedByDepth(view, centres, sorter.GetOrder(), DepthOrder::BackToFront);
+
+			// a few frames of small camera and object movement
+			std::mt19937 rng(3);
+			std::uniform_real_distribution<float> jitter(-0.01f, 0.01f);
+			for (int frame = 0; frame < 5; ++frame) {
+				eye = eye + Vector3(0.05f, 0, -0.05f);
+				for (Vector3& c : centres)
+					c = c + Vector3(jitter(rng), jitter(rng), jitter(rng));
+				view = Matrix4::MakeLookAt(eye, Vector3(0, 0, 0), Vector3(0, 1, 0));
+				const std::vector<uint32_t>& order = sorter.Update(Execution::Par, view, centres.data(), centres.size(), DepthOrder::BackToFront);
+				Assert::IsTrue(sorter.WasIncremental());
+				AssertSortedByDepth(view, centres, order, DepthOrder::BackToFront);
+			}
+
+			// turning the camera round reverses the order: too much for the insertion sort
+			view = Matrix4::MakeLookAt(Vector3(0, 10, -300), Vector3(0, 0, 0), Vector3(0, 1, 0));
+			sorter.Update(view, centres.data(), centres.size(), DepthOrder::BackToFront);
+			Assert::IsFalse(sorter.WasIncremental());
+			AssertSortedByDepth(view, centres, sorter.GetOrder(), DepthOrder::BackToFront);
+
+			// a different order or count starts again
+			sorter.Update(view, centres.data(), centres.size(), DepthOrder::FrontToBack);
+			Assert::IsFalse(sorter.WasIncremental());
+			AssertSortedByDepth(view, centres, sorter.GetOrder(), DepthOrder::FrontToBack);
+			sorter.Update(view, centres.data(), 100, DepthOrder::FrontToBack);
+			Assert::IsFalse(sorter.WasIncremental());
+			Assert::AreEqual(size_t(100), sorter.GetOrder().size());
+		}
+	};
+}
@@ -0,0 +1,185 @@
+#include "CppUnitTest.h"
+#include "TestToString.h"
+
+#include "MathHeaders/Batch.h"
+#include "MathHeaders/Matrix.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <type_traits>
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace MathClasses;
+
+namespace MathLibraryTests
+{
+	static_assert(std::is_same<Vector3, Vector<float, 3>>::value && std::is_same<Matrix4, Matrix<float, 4, 4>>::value, "The float types are the templates");
+	static_assert(sizeof(Vector3d) == 3 * sizeof(double) && sizeof(Vector4d) == 4 * sizeof(double), "Vectors hold only their components");
+	static_assert(sizeof(Matrix3d) == 9 * sizeof(double) && sizeof(Matrix4d) == 16 * sizeof(double), "Matrices hold only their elements");
+	static_assert(offsetof(Matrix4d, m5) == sizeof(double) && offsetof(Matrix4d, m2) == 4 * sizeof(double), "Matrix4d is laid out as Matrix4");
+	static_assert(std::is_standard_layout<Matrix4d>::value && std::is_trivially_copyable<Matrix4d>::value, "Matrix4d must be a plain struct");
+
+	TEST_CLASS(DoublePrecisionTests)
+	{
+	public:
+		TEST_METHOD(SameOperationsAsFloat)
+		{
+			Matrix4d world = Matrix4d::MakeTranslation(100000.0, 0, -250000.0) * Matrix4d::MakeRotateY(0.3) * Matrix4d::MakeScale(2, 2, 2);
+			Matrix4 worldF(world);
+			Matrix4 expectedF = Matrix4::MakeTranslation(100000.0f, 0, -250000.0f) * Matrix4::MakeRotateY(0.3f) * Matrix4::MakeScale(2, 2, 2);
+			Assert::IsTrue(expectedF == worldF);
+
+			// a centimetre 100 km out, below float's spacing there
+			Vector4d p = world * Vector4d(0.005, 1, 0, 1);
+			Vector4d q = world * Vector4d(0.01, 1, 0, 1);
+			Assert::AreEqual(0.01, (q - p).Magnitude(), 1e-9);
+
+			Vector3d translation, scale;
+			Matrix3d rotation;
+			Assert::IsTrue(world.Decompose(translation, rotation, scale));
+			Assert::IsTrue(Vector3d(100000.0, 0, -250000.0) == translation);
+			Assert::IsTrue(Vector3d(2, 2, 2) == scale);
+			Assert::IsTrue(Matrix3d::MakeRotateY(0.3) == rotation);
+
+			// Fast and Fastest have no double estimate and give the exact result
+			Vector3d v(3, 4, 12);
+			Assert::AreEqual(v.Normalised().z, v.Normalised(Precision::Fastest).z);
+			Assert::AreEqual(Vector3(12.0f / 13, 4.0f / 13, 3.0f / 13), Vector3(Vector3d(12, 4, 3).Normalised()));
+		}
+
+		TEST_METHOD(BatchKernelsRunInDouble)
+		{
+			std::mt19937 rng(49);
+			std::uniform_real_distribution<double> coordinate(-100000.0, 100000.0);
+			std::vector<Vector3d> points(5003);
+			for (Vector3d& p : points)
+				p = Vector3d(coordinate(rng), coordinate(rng), coordinate(rng));
+			Matrix4d view = Matrix4d::MakeLookAt(Vector3d(99000.5, 20, -40000.25), Vector3d(0, 0, 0), Vector3d(0, 1, 0));
+
+			std::vector<Vector3d> transformed(points.size()), directions(points.size()), normalised(points.size());
+			TransformPoints(Execution::Par, view, points.data(), transformed.data(), points.size());
+			TransformVectors(view, points.data(), directions.data(), points.size());
+			NormaliseVectors(Execution::Par, points.data(), normalised.data(), points.size());
+			for (size_t i = 0; i < points.size(); ++i) {
+				// coordinates reach 1e5 and the view's translation about as much, so a
+				// multiply-add contracted to FMA moves the result by up to about 1e-11
+				Vector4d expected = view * Vector4d(points[i].x, points[i].y, points[i].z, 1);
+				Assert::AreEqual(expected.x, transformed[i].x, 1e-9);
+				Assert::AreEqual(expected.z, transformed[i].z, 1e-9);
+				Vector4d direction = view * Vector4d(points[i].x, points[i].y, points[i].z, 0);
+				Assert::AreEqual(direction.y, directions[i].y, 1e-9);
+				Assert::AreEqual(points[i].Normalised().x, normalised[i].x, 1e-15);
+			}
+
+			std::vector<Matrix4d> locals(101), worlds(locals.size());
+			for (size_t i = 0; i < locals.size(); ++i)
+				locals[i] = Matrix4d::MakeTranslation(double(i), 0, 0) * Matrix4d::MakeRotateZ(0.01 * double(i));
+			MultiplyMatrices(Execution::Par, view, locals.data(), worlds.data(), locals.size());
+			std::vector<Vector4d> homogeneous(locals.size(), Vector4d(1, 2, 3, 1)), projected(locals.size());
+			TransformVector4s(view, homogeneous.data(), projected.data(), homogeneous.size());
+			for (size_t i = 0; i < locals.size(); ++i) {
+				Matrix4d expected = view * locals[i];
+				Assert::AreEqual(expected.m13, worlds[i].m13, 1e-9);
+				Assert::AreEqual(expected.m6, worlds[i].m6, 1e-15);
+				Assert::AreEqual((view * homogeneous[i]).z, projected[i].z, 1e-9);
+			}
+		}
+
+		TEST_METHOD(GeneralSizes)
+		{
+			// the general template for sizes without a specialisation
+			Matrix<double, 2, 3> a;
+			a(0, 0) = 1; a(0, 1) = 2; a(0, 2) = 3;
+			a(1, 0) = 4; a(1, 1) = 5; a(1, 2) = 6;
+			Vector<double, 2> r = a * Vector3d(1, 0, -1);
+			Assert::AreEqual(-2.0, r[0]);
+			Assert::AreEqual(-2.0, r[1]);
+
+			Matrix<double, 3, 2> t = a.Transposed();
+			Matrix<double, 2, 2> square = a * t;
+			Assert::AreEqual(14.0, square(0, 0));
+			Assert::AreEqual(32.0, square(0, 1));
+			Assert::AreEqual(77.0, square(1, 1));
+			Assert::IsTrue(std::string("1.000000, 4.000000, 2.000000, 5.000000, 3.000000, 6.000000") == a.ToString());
+
+			// row and column access on the specialisations matches the named elements
+			Matrix4 m = Matrix4::MakeTranslation(7, 8, 9);
+			Assert::AreEqual(m.m13, m(0, 3));
+			Assert::AreEqual(m.m15, m(2, 3));
+			Matrix3 n(1, 2, 3, 4, 5, 6, 7, 8, 9);
+			Assert::AreEqual(n.m4, n(0, 1));
+			Assert::AreEqual(n.m3, n(2, 0));
+			Assert::AreEqual(n.m6, Matrix<float, 3, 3>::MakeIdentity()(1, 1) * n(2, 1));
+
+			Vector<float, 5> five;
+			five[4] = 3;
+			five[0] = 4;
+			Assert::AreEqual(5.0f, five.Magnitude());
+			Assert::AreEqual(0.6f, five.Normalised()[4]);
+		}
+
+		// integer vectors for grid maths compare exactly
+		TEST_METHOD(IntegerGridMaths)
+		{
+			using Vector3i = Vector<int32_t, 3>;
+			using Matrix3i = Matrix<int32_t, 3, 3>;
+			Vector3i a(1, 2, 3), b(4, -5, 6);
+			Assert::IsTrue(a == Vector3i(1, 2, 3));
+			Assert::IsFalse(a != Vector3i(1, 2, 3));
+			Assert::IsFalse(a == Vector3i(1, 2, 4));
+			Assert::IsTrue(Vector3i(5, -3, 9) == a + b);
+			Assert::IsTrue(Vector3i(-3, 7, -3) == a - b);
+			Assert::IsTrue(Vector3i(3, 6, 9) == a * 3);
+			Assert::AreEqual(12, a.Dot(b));
+			Assert::IsTrue(Vector3i(27, 6, -13) == a.Cross(b));
+			Assert::IsTrue(Vector<int32_t, 4>(1, 2, 3, 4) == Vector<int32_t, 4>(1, 2, 3, 4));
+
+			Assert::IsTrue(Matrix3i::MakeIdentity() == Matrix3i::MakeIdentity());
+			Assert::IsFalse(Matrix3i::MakeIdentity() == Matrix3i());
+			Assert::IsTrue(Matrix<int32_t, 4, 4>::MakeIdentity() == Matrix<int32_t, 4, 4>::MakeIdentity());
+			// a quarter turn about z, as on a grid
+			Matrix3i turn(0, 1, 0, -1, 0, 0, 0, 0, 1);
+			Assert::IsTrue(Vector3i(-2, 1, 3) == turn * a);
+			Assert::IsTrue(Vector3i(-1, -2, 3) == turn * (turn * a));
+			Assert::IsTrue(turn * turn * turn * turn == Matrix3i::MakeIdentity());
+
+			Matrix<int32_t, 2, 3> project;
+			project(0, 0) = 1;
+			project(1, 2) = 2;
+			Vector<int32_t, 2> projected = project * a;
+			Assert::IsTrue(Vector<int32_t, 2>() + projected == projected);
+			Assert::AreEqual(1, projected[0]);
+			Assert::AreEqual(6, projected[1]);
+			Assert::IsFalse(project == Matrix<int32_t, 2, 3>());
+		}
+
+		// indexing reaches the named members in storage order
+		TEST_METHOD(IndexingNamesEachMember)
+		{
+			Vector4d v(1, 2, 3, 4);
+			v[3] = 5;
+			Assert::AreEqual(3.0, v[2]);
+			Assert::AreEqual(5.0, v.w);
+			Vector3 u(1, 2, 3);
+			u[1] = 7;
+			Assert::AreEqual(7.0f, u.y);
+			Assert::AreEqual(3.0f, u[2]);
+
+			Matrix3d m3(1, 2, 3, 4, 5, 6, 7, 8, 9);
+			Assert::AreEqual(m3.m4, m3(0, 1));
+			Assert::AreEqual(m3.m2, m3(1, 0));
+			Assert::AreEqual(m3.m9, m3(2, 2));
+			m3(2, 0) = 10;
+			Assert::AreEqual(10.0, m3.m3);
+
+			Matrix4 m4 = Matrix4::MakeTranslation(1, 2, 3);
+			Assert::AreEqual(m4.m5, m4(0, 1));
+			Assert::AreEqual(m4.m2, m4(1, 0));
+			Assert::AreEqual(m4.m12, m4(3, 2));
+			m4(3, 3) = 2;
+			Assert::AreEqual(2.0f, m4.m16);
+		}
+	};
+}
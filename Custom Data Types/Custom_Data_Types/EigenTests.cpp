@@ -0,0 +1,200 @@
+#include "CppUnitTest.h"
+#include "TestToString.h"
+
+#include "MathHeaders/Eigen.h"
+#include "MathHeaders/OBB.h"
+#include "MathHeaders/Orthonormalise.h"
+
+#include <random>
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace MathClasses;
+
+namespace MathLibraryTests
+{
+	// R * diag(values) * R^T
+	static Matrix3 SymmetricFrom(const Matrix3& rotation, const Vector3& values)
+	{
+		Matrix3 diagonal(values.x, 0, 0, 0, values.y, 0, 0, 0, values.z);
+		return rotation * diagonal * rotation.Transposed();
+	}
+
+	static Vector3 Column(const Matrix3& m, int c)
+	{
+		return c == 0 ? Vector3(m.m1, m.m2, m.m3) : c == 1 ? Vector3(m.m4, m.m5, m.m6) : Vector3(m.m7, m.m8, m.m9);
+	}
+
+	// A v = lambda v for every pair, relative to the largest eigenvalue
+	static void AssertEigenpairs(const Matrix3& m, const SymmetricEigen& eigen, float tolerance)
+	{
+		float scale = std::fmax(std::fabs(eigen.values.x), std::fabs(eigen.values.z)) + 1e-30f;
+		float values[3] = { eigen.values.x, eigen.values.y, eigen.values.z };
+		for (int c = 0; c < 3; ++c) {
+			Vector3 v = Column(eigen.vectors, c);
+			Vector3 residual = m * v - v * values[c];
+			Assert::IsTrue(residual.Magnitude() <= tolerance * scale);
+		}
+	}
+
+	TEST_CLASS(EigenTests)
+	{
+	public:
+		TEST_METHOD(RecoversKnownDecomposition)
+		{
+			Matrix3 rotation = Matrix3::MakeEuler(0.4f, -1.1f, 2.3f);
+			Matrix3 m = SymmetricFrom(rotation, Vector3(-2, 7, 0.5f));
+			SymmetricEigen eigen = ComputeSymmetricEigen(m);
+
+			Assert::AreEqual(7.0f, eigen.values.x, 1e-5f);
+			Assert::AreEqual(0.5f, eigen.values.y, 1e-5f);
+			Assert::AreEqual(-2.0f, eigen.values.z, 1e-5f);
+			AssertEigenpairs(m, eigen, 1e-6f);
+			// a right handed orthonormal basis
+			Assert::IsTrue(OrthonormalDrift(eigen.vectors) < 1e-6f);
+			Assert::AreEqual(1.0f, Column(eigen.vectors, 0).Cross(Column(eigen.vectors, 1)).Dot(Column(eigen.vectors, 2)), 1e-6f);
+			// the eigenvector of 7 is rotation's second column, up to sign
+			Assert::AreEqual(1.0f, std::fabs(Column(eigen.vectors, 0).Dot(Column(rotation, 1))), 1e-6f);
+		}
+
+		TEST_METHOD(DegenerateInputs)
+		{
+			SymmetricEigen diagonal = ComputeSymmetricEigen(Matrix3(1, 0, 0, 0, 3, 0, 0, 0, 2));
+			Assert::AreEqual(Vector3(3, 2, 1), diagonal.values);
+			Assert::IsTrue(OrthonormalDrift(diagonal.vectors) == 0.0f);
+
+			SymmetricEigen zero = ComputeSymmetricEigen(Matrix3());
+			Assert::AreEqual(Vector3(0, 0, 0), zero.values);
+			Assert::IsTrue(Matrix3::MakeIdentity() == zero.vectors);
+
+			// repeated eigenvalue: any basis of the plane will do
+			Matrix3 repeated = SymmetricFrom(Matrix3::MakeEuler(1.0f, 0.2f, -0.7f), Vector3(4, 4, 1));
+			SymmetricEigen eigen = ComputeSymmetricEigen(repeated);
+			Assert::AreEqual(4.0f, eigen.values.x, 1e-5f);
+			Assert::AreEqual(4.0f, eigen.values.y, 1e-5f);
+			Assert::AreEqual(1.0f, eigen.values.z, 1e-5f);
+			AssertEigenpairs(repeated, eigen, 1e-6f);
+			Assert::IsTrue(OrthonormalDrift(eigen.vectors) < 1e-6f);
+
+			// widely spread magnitudes
+			Matrix3 spread = SymmetricFrom(Matrix3::MakeEuler(-0.3f, 0.8f, 0.1f), Vector3(1e6f, 1.0f, 1e-3f));
+			eigen = ComputeSymmetricEigen(spread);
+			Assert::AreEqual(1e6f, eigen.values.x, 1.0f);
+			AssertEigenpairs(spread, eigen, 1e-6f);
+		}
+
+		TEST_METHOD(BatchMatchesScalar)
+		{
+			std::mt19937 rng(43);
+			std::uniform_real_distribution<float> angle(-3.0f, 3.0f), value(-10.0f, 10.0f);
+			std::vector<Matrix3> matrices;
+			for (int i = 0; i < 1003; ++i) {
+				Vector3 values(value(rng), value(rng), value(rng));
+				if (i % 5 == 0)
+					values.y = values.x;
+				matrices.push_back(SymmetricFrom(Matrix3::MakeEuler(angle(rng), angle(rng), angle(rng)), values));
+			}
+
+			std::vector<SymmetricEigen> serial(matrices.size()), parallel(matrices.size());
+			ComputeSymmetricEigens(matrices.data(), serial.data(), matrices.size());
+			ComputeSymmetricEigens(Execution::Par, matrices.data(), parallel.data(), matrices.size());
+			for (size_t i = 0; i < matrices.size(); ++i) {
+				SymmetricEigen scalar = ComputeSymmetricEigen(matrices[i]);
+				Assert::AreEqual(scalar.values, serial[i].values);
+				Assert::AreEqual(scalar.values, parallel[i].values);
+				// a repeated eigenvalue's vectors can be any basis of its plane, and an FMA
+				// rounding can turn them, so only distinct eigenvalues' vectors are compared
+				float scale = std::fmax(std::fabs(scalar.values.x), std::fabs(scalar.values.z));
+				float gap = std::fmin(scalar.values.x - scalar.values.y, scalar.values.y - scalar.values.z);
+				if (gap > 1e-3f * scale) {
+					Assert::IsTrue(scalar.vectors == serial[i].vectors);
+					Assert::IsTrue(scalar.vectors == parallel[i].vectors);
+				}
+				AssertEigenpairs(matrices[i], serial[i], 2e-6f);
+				AssertEigenpairs(matrices[i], parallel[i], 2e-6f);
+				AssertEigenpairs(matrices[i], scalar, 2e-6f);
+				Assert::IsTrue(scalar.values.x >= scalar.values.y && scalar.values.y >= scalar.values.z);
+			}
+		}
+
+		TEST_METHOD(FitOBBToRotatedBox)
+		{
+			Matrix3 rotation = Matrix3::MakeEuler(0.6f, -0.4f, 1.3f);
+			Vector3 centre(10, -4, 2), halfSize(8, 3, 0.5f);
+			std::mt19937 rng(7);
+			std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+			std::vector<Vector3> points(40000);
+			for (Vector3& p : points)
+				p = centre + rotation * Vector3(halfSize.x * unit(rng), halfSize.y * unit(rng), halfSize.z * unit(rng));
+
+			OBB box = FitOBB(Execution::Par, points.data(), points.size());
+			Assert::AreEqual(8.0f, box.extents.x, 0.05f);
+			Assert::AreEqual(3.0f, box.extents.y, 0.05f);
+			Assert::AreEqual(0.5f, box.extents.z, 0.05f);
+			Assert::AreEqual(centre.x, box.centre.x, 0.05f);
+			Assert::AreEqual(centre.z, box.centre.z, 0.05f);
+			Assert::AreEqual(1.0f, std::fabs(Column(box.axes, 0).Dot(Column(rotation, 0))), 1e-3f);
+			for (const Vector3& p : points)
+				Assert::IsTrue(box.Contains(p, 1e-4f));
+			Assert::IsTrue(box.GetVolume() < 8 * 8.1f * 3.1f * 0.6f);
+
+			OBB serial = FitOBB(points.data(), points.size());
+			Assert::AreEqual(serial.centre, box.centre);
+			Assert::AreEqual(serial.extents, box.extents);
+
+			// enough points for the arena to hold the chunk partials
+			std::vector<Vector3> many(Detail::ReductionBatchChunks * Detail::ReductionChunk + 1);
+			for (size_t i = 0; i < many.size(); ++i)
+				many[i] = points[i % points.size()];
+			OBB batched = FitOBB(Execution::Par, many.data(), many.size());
+			FrameArena arena(16 * 1024);
+			OBB fromArena = FitOBB(Execution::Par, arena, many.data(), many.size());
+			Assert::AreEqual(size_t(0), arena.GetMarker().offset);
+			Assert::IsTrue(arena.GetHighWaterMark() > 0);
+			Assert::AreEqual(batched.centre, fromArena.centre);
+			Assert::AreEqual(batched.extents, fromArena.extents);
+			Assert::AreEqual(serial.extents.x, batched.extents.x, 1e-3f);
+		}
+
+		TEST_METHOD(FitOBBsPerCluster)
+		{
+			std::mt19937 rng(11);
+			std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+			std::vector<Vector3> points;
+			std::vector<uint32_t> offsets = { 0 };
+			// more clusters than fit in one block
+			for (int c = 0; c < int(Detail::OBBClusterBlock) * 2 + 5; ++c) {
+				Matrix3 rotation = Matrix3::MakeEuler(0.1f * c, 0.05f * c, -0.2f * c);
+				Vector3 centre(float(c), float(2 * c), 0);
+				int size = c == 5 ? 0 : 50 + c;
+				for (int i = 0; i < size; ++i)
+					points.push_back(centre + rotation * Vector3(4 * unit(rng), 2 * unit(rng), 0.5f * unit(rng)));
+				offsets.push_back(uint32_t(points.size()));
+			}
+
+			std::vector<OBB> boxes(offsets.size() - 1);
+			FitOBBs(Execution::Par, points.data(), offsets.data(), boxes.size(), boxes.data());
+			for (size_t c = 0; c < boxes.size(); ++c) {
+				if (offsets[c] == offsets[c + 1]) {
+					Assert::AreEqual(0.0f, boxes[c].GetVolume());
+					continue;
+				}
+				OBB single = FitOBB(points.data() + offsets[c], offsets[c + 1] - offsets[c]);
+				Assert::AreEqual(single.centre, boxes[c].centre);
+				Assert::AreEqual(single.extents, boxes[c].extents);
+				Assert::IsTrue(single.axes == boxes[c].axes);
+				for (uint32_t i = offsets[c]; i < offsets[c + 1]; ++i)
+					Assert::IsTrue(boxes[c].Contains(points[i], 1e-4f));
+			}
+
+			FrameArena arena(boxes.size() * sizeof(OBB) + 64);
+			Span<OBB> fromArena = FitOBBs(arena, points.data(), offsets.data(), boxes.size());
+			Assert::AreEqual(boxes.size(), fromArena.Size());
+			for (size_t c = 0; c < boxes.size(); ++c) {
+				Assert::AreEqual(boxes[c].centre, fromArena[c].centre);
+				Assert::IsTrue(boxes[c].axes == fromArena[c].axes);
+			}
+			Assert::IsTrue(FitOBBs(arena, points.data(), offsets.data(), boxes.size()).Empty());
+		}
+	};
+}
@@ -0,0 +1,177 @@
+#include "CppUnitTest.h"
+#include "TestToString.h"
+
+#include "Utils.h"
+#include "MathHeaders/FastMath.h"
+#include "MathHeaders/Matrix3.h"
+#include "MathHeaders/Matrix4.h"
+#include "MathHeaders/Quaternion.h"
+#include "MathHeaders/Batch.h"
+
+#include <cfloat>
+#include <cmath>
+#include <random>
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace MathClasses;
+
+namespace MathLibraryTests
+{
+	// Error of a float result in units of the spacing of floats around the exact value
+	static double UlpError(float result, double exact)
+	{
+		float magnitude = std::fmax(float(std::fabs(exact)), FLT_MIN);
+		double ulp = double(std::nextafter(magnitude, FLT_MAX)) - magnitude;
+		return std::fabs(result - exact) / ulp;
+	}
+
+	TEST_CLASS(FastMathTests)
+	{
+	public:
+		TEST_METHOD(InvSqrtBounds)
+		{
+			double fastUlp = 0, fastestRelative = 0;
+			for (float x = 1e-30f; x < 1e30f; x *= 1.0007f) {
+				double exact = 1.0 / std::sqrt(double(x));
+				fastUlp = std::fmax(fastUlp, UlpError(InvSqrt(Precision::Fast, x), exact));
+				fastestRelative = std::fmax(fastestRelative, std::fabs(InvSqrt(Precision::Fastest, x) - exact) / exact);
+				Assert::AreEqual(1.0f / std::sqrt(x), InvSqrt(Precision::Exact, x));
+			}
+			Assert::IsTrue(fastUlp <= 4.0);
+			Assert::IsTrue(fastestRelative <= 1.5 / 4096.0);
+		}
+
+		TEST_METHOD(SinCosBounds)
+		{
+			double fastWorst = 0, fastestAbsolute = 0;
+			for (int i = -1000000; i <= 1000000; ++i) {
+				float x = i * (8192.0f / 1000000);
+				double exactSin = std::sin(double(x)), exactCos = std::cos(double(x));
+
+				float s, c;
+				SinCos(Precision::Fast, x, s, c);
+				// 2 ulp or 1e-7, whichever is larger, scaled so 1 is the bound
+				fastWorst = std::fmax(fastWorst, std::fmin(UlpError(s, exactSin) / 2, std::fabs(s - exactSin) / 1e-7));
+				fastWorst = std::fmax(fastWorst, std::fmin(UlpError(c, exactCos) / 2, std::fabs(c - exactCos) / 1e-7));
+				Assert::AreEqual(s, Sin(Precision::Fast, x));
+				Assert::AreEqual(c, Cos(Precision::Fast, x));
+
+				SinCos(Precision::Fastest, x, s, c);
+				fastestAbsolute = std::fmax(fastestAbsolute, std::fabs(s - exactSin));
+				fastestAbsolute = std::fmax(fastestAbsolute, std::fabs(c - exactCos));
+			}
+			// small angles keep their relative accuracy
+			for (float x = 1e-20f; x < 1.0f; x *= 1.001f)
+				fastWorst = std::fmax(fastWorst, UlpError(Sin(Precision::Fast, x), std::sin(double(x))) / 2);
+
+			Assert::IsTrue(fastWorst <= 1.0);
+			Assert::IsTrue(fastestAbsolute <= 1.3e-5);
+			Assert::AreEqual(0.0f, Sin(Precision::Fastest, 0.0f));
+			Assert::AreEqual(1.0f, Cos(Precision::Fastest, 0.0f));
+		}
+
+		// past the range reduction's limit both tiers give libm's result
+		TEST_METHOD(SinCosOutOfRange)
+		{
+			const float inputs[] = { 8192.5f, -10000.0f, 1e6f, 1e9f, -2.5e9f, 3e38f, FLT_MAX };
+			for (float x : inputs) {
+				Assert::AreEqual(std::sin(x), Sin(Precision::Fast, x));
+				Assert::AreEqual(std::cos(x), Cos(Precision::Fast, x));
+				Assert::AreEqual(std::sin(x), Sin(Precision::Fastest, x));
+				Assert::AreEqual(std::cos(x), Cos(Precision::Fastest, x));
+				Assert::IsTrue(std::fabs(Sin(Precision::Fast, x)) <= 1.0f);
+			}
+			Assert::IsTrue(std::isnan(Sin(Precision::Fast, INFINITY)));
+			Assert::IsTrue(std::isnan(Cos(Precision::Fastest, -INFINITY)));
+			Assert::IsTrue(std::isnan(Sin(Precision::Fast, NAN)));
+		}
+
+		TEST_METHOD(NormaliseBounds)
+		{
+			std::mt19937 rng(38);
+			std::uniform_real_distribution<float> component(-1.0f, 1.0f), exponent(-15.0f, 15.0f);
+			double fastUlp = 0, fastestRelative = 0;
+			for (int i = 0; i < 100000; ++i) {
+				float scale = std::pow(10.0f, exponent(rng));
+				Vector4 v(component(rng) * scale, component(rng) * scale, component(rng) * scale, component(rng) * scale);
+				double length = std::sqrt(double(v.x) * v.x + double(v.y) * v.y + double(v.z) * v.z + double(v.w) * v.w);
+
+				Vector4 fast = v.Normalised(Precision::Fast), fastest = v.Normalised(Precision::Fastest);
+				const float* in = &v.x;
+				const float* f = &fast.x;
+				const float* ff = &fastest.x;
+				for (int k = 0; k < 4; ++k) {
+					double exact = in[k] / length;
+					fastUlp = std::fmax(fastUlp, UlpError(f[k], exact));
+					if (exact != 0)
+						fastestRelative = std::fmax(fastestRelative, std::fabs(ff[k] - exact) / std::fabs(exact));
+				}
+
+				Vector4 exact = v;
+				exact.Normalise(Precision::Exact);
+				Vector4 reference = v.Normalised();
+				Assert::IsTrue(exact.x == reference.x && exact.y == reference.y && exact.z == reference.z && exact.w == reference.w);
+			}
+			Assert::IsTrue(fastUlp <= 5.0);
+			Assert::IsTrue(fastestRelative <= 1.5 / 4096.0 + 2.0 * FLT_EPSILON);
+
+			// zero stays zero, denormal lengths still normalise
+			Assert::AreEqual(Vector3(0, 0, 0), Vector3(0, 0, 0).Normalised(Precision::Fast));
+			Assert::AreEqual(Vector3(0, 1, 0), Vector3(0, 1e-20f, 0).Normalised(Precision::Fastest));
+			Assert::AreEqual(Vector3(0.6f, 0, 0.8f), Vector3(3, 0, 4).Normalised(Precision::Fast));
+		}
+
+		TEST_METHOD(RotationBuilders)
+		{
+			for (float radians = -20.0f; radians < 20.0f; radians += 0.37f) {
+				Matrix4 exact = Matrix4::MakeEuler(radians, radians * 0.5f, -radians);
+				Matrix4 fast = Matrix4::MakeEuler(Precision::Fast, radians, radians * 0.5f, -radians);
+				Matrix4 fastest = Matrix4::MakeEuler(Precision::Fastest, radians, radians * 0.5f, -radians);
+				const float* e = &exact.m1;
+				const float* f = &fast.m1;
+				const float* ff = &fastest.m1;
+				for (int k = 0; k < 16; ++k) {
+					Assert::AreEqual(e[k], f[k], 1e-6f);
+					Assert::AreEqual(e[k], ff[k], 1e-4f);
+				}
+
+				Matrix3 exact3 = Matrix3::MakeRotateY(radians), fast3 = Matrix3::MakeRotateY(Precision::Fast, radians);
+				Assert::AreEqual(exact3.m1, fast3.m1, 1e-6f);
+				Assert::AreEqual(exact3.m7, fast3.m7, 1e-6f);
+				Matrix3 exact2D = Matrix3::MakeRotation(radians), fast2D = Matrix3::MakeRotation(Precision::Fast, radians);
+				Assert::AreEqual(exact2D.m4, fast2D.m4, 1e-6f);
+
+				Quaternion q = Quaternion::MakeAxisAngle(Vector3(0, 1, 0), radians);
+				Quaternion fq = Quaternion::MakeAxisAngle(Precision::Fast, Vector3(0, 1, 0), radians);
+				Assert::AreEqual(q.y, fq.y, 1e-6f);
+				Assert::AreEqual(q.w, fq.w, 1e-6f);
+			}
+		}
+
+		TEST_METHOD(BatchMatchesScalar)
+		{
+			std::mt19937 rng(5);
+			std::uniform_real_distribution<float> component(-100.0f, 100.0f);
+			std::vector<Vector3> in(10003);
+			for (Vector3& v : in)
+				v = Vector3(component(rng), component(rng), component(rng));
+			in[17] = Vector3(0, 0, 0);
+
+			std::vector<Vector3> fast(in.size()), fastest(in.size()), exact(in.size()), reference(in.size());
+			NormaliseVectors(Execution::Par, Precision::Fast, in.data(), fast.data(), in.size());
+			NormaliseVectors(Execution::Seq, Precision::Fastest, in.data(), fastest.data(), in.size());
+			NormaliseVectors(Execution::Seq, Precision::Exact, in.data(), exact.data(), in.size());
+			NormaliseVectors(in.data(), reference.data(), in.size());
+			for (size_t i = 0; i < in.size(); ++i) {
+				// the squared length may be contracted to FMA in one and not the other
+				Vector3 f = in[i].Normalised(Precision::Fast), ff = in[i].Normalised(Precision::Fastest);
+				for (int k = 0; k < 3; ++k) {
+					Assert::IsTrue(NearlyEqualAtScale(f[k], fast[i][k], 1.0f));
+					Assert::IsTrue(NearlyEqualAtScale(ff[k], fastest[i][k], 1.0f));
+				}
+				Assert::IsTrue(exact[i].x == reference[i].x && exact[i].y == reference[i].y && exact[i].z == reference[i].z);
+			}
+		}
+	};
+}
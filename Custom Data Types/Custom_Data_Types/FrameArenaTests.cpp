@@ -0,0 +1,179 @@
+#include "CppUnitTest.h"
+#include "TestToString.h"
+
+#include "Utils.h"
+#include "MathHeaders/FrameArena.h"
+#include "MathHeaders/Batch.h"
+
+#include <cstdint>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace MathClasses;
+
+namespace MathLibraryTests
+{
+	TEST_CLASS(FrameArenaTests)
+	{
+	public:
+		// allocations honour 16, 32 and 64 byte alignment
+		TEST_METHOD(Alignment)
+		{
+			FrameArena arena(4096);
+
+			for (size_t alignment : { 16, 32, 64 }) {
+				arena.Allocate(3, 1);
+				void* p = arena.Allocate(10, alignment);
+				Assert::IsTrue(p != nullptr);
+				Assert::AreEqual(size_t(0), reinterpret_cast<uintptr_t>(p) % alignment);
+			}
+		}
+
+		// typed spans are default constructed
+		TEST_METHOD(TypedAllocation)
+		{
+			FrameArena arena(4096);
+
+			Span<Vector3> points = arena.Allocate<Vector3>(10);
+			Span<Matrix4> matrices = arena.Allocate<Matrix4>(4, 32);
+
+			Assert::AreEqual(size_t(10), points.Size());
+			Assert::AreEqual(size_t(4), matrices.Size());
+			Assert::AreEqual(Vector3(0, 0, 0), points[9]);
+			Assert::AreEqual(Matrix4(), matrices[3]);
+			Assert::AreEqual(size_t(0), reinterpret_cast<uintptr_t>(matrices.Data()) % 32);
+		}
+
+		// reset gives back the whole arena, and the high water mark remembers the peak
+		TEST_METHOD(ResetAndHighWaterMark)
+		{
+			FrameArena arena(1024);
+
+			arena.Allocate(600, 16);
+			Assert::AreEqual(size_t(600), arena.GetUsed());
+
+			arena.Reset();
+			Assert::AreEqual(size_t(0), arena.GetUsed());
+			Assert::IsTrue(arena.Allocate(1000, 16) != nullptr);
+			Assert::AreEqual(size_t(1000), arena.GetHighWaterMark());
+		}
+
+		// rewinding to a marker frees only the later allocations
+		TEST_METHOD(MarkerRewind)
+		{
+			FrameArena arena(1024);
+			arena.Allocate(128, 16);
+			FrameArena::Marker marker = arena.GetMarker();
+
+			{
+				ArenaScope scope(arena);
+				arena.Allocate(256, 16);
+				Assert::AreEqual(size_t(384), arena.GetUsed());
+			}
+
+			Assert::AreEqual(marker.offset, arena.GetUsed());
+		}
+
+		// released memory is filled with the poison byte in debug builds
+		TEST_METHOD(DebugPoisoning)
+		{
+#ifdef _DEBUG
+			FrameArena arena(256);
+			Span<float> values = arena.Allocate<float>(16);
+			for (float& v : values)
+				v = 1.0f;
+
+			arena.Reset();
+
+			const unsigned char* bytes = reinterpret_cast<const unsigned char*>(values.Data());
+			for (size_t i = 0; i < values.Size() * sizeof(float); ++i)
+				Assert::AreEqual(FrameArena::PoisonByte, bytes[i]);
+#endif
+		}
+
+		TEST_METHOD(BatchOutputFromArena)
+		{
+			FrameArena arena(64 * 1024);
+			Vector3 points[3] = { Vector3(1, 0, 0), Vector3(0, 1, 0), Vector3(0, 0, 1) };
+			Matrix4 m = Matrix4::MakeTranslation(1.0f, 2.0f, 3.0f);
+
+			Span<Vector3> moved = TransformPoints(arena, m, points, 3);
+
+			Assert::AreEqual(size_t(3), moved.Size());
+			Assert::AreEqual(Vector3(2, 2, 3), moved[0]);
+			Assert::AreEqual(Vector3(1, 3, 3), moved[1]);
+			Assert::AreEqual(Vector3(1, 2, 4), moved[2]);
+		}
+
+		// the other batch functions with arena overloads give the same results as
+		// writing to caller owned arrays
+		TEST_METHOD(MoreBatchOutputsFromArena)
+		{
+			FrameArena arena(64 * 1024);
+			const size_t count = 37;
+			Vector3 points[count];
+			AABB boxes[count];
+			Matrix4 matrices[count];
+			uint32_t angles[count];
+			for (size_t i = 0; i < count; ++i) {
+				float f = float(i);
+				points[i] = Vector3(f - 18.0f, 0.5f * f, -5.0f - f);
+				boxes[i] = AABB(Vector3(-1, -f, 0), Vector3(f, 1, 2));
+				matrices[i] = Matrix4::MakeTranslation(f, 0, -f) * Matrix4::MakeRotateY(0.1f * f);
+				angles[i] = uint32_t(i * 113);
+			}
+
+			Matrix4 viewProjection = Matrix4::MakePerspective(1.0f, 1.5f, 0.1f, 100.0f);
+			Viewport viewport;
+			viewport.width = 640;
+			viewport.height = 480;
+			Vector3 screen[count];
+			uint8_t flags[count];
+			ProjectToScreen(viewProjection, viewport, points, screen, flags, count);
+			ProjectedPoints projected = ProjectToScreen(Execution::Par, arena, viewProjection, viewport, points, count);
+			Assert::AreEqual(count, projected.positions.Size());
+			Assert::AreEqual(count, projected.flags.Size());
+
+			AABB transformed[count];
+			TransformAABBs(matrices, boxes, transformed, count);
+			Span<AABB> transformedFromArena = TransformAABBs(arena, matrices, boxes, count);
+			Assert::AreEqual(count, transformedFromArena.Size());
+
+			Matrix3 rotations[count];
+			MakeRotationsQuantised(angles, rotations, count);
+			Span<Matrix3> rotationsFromArena = MakeRotationsQuantised(Execution::Par, arena, angles, count);
+			Assert::AreEqual(count, rotationsFromArena.Size());
+
+			for (size_t i = 0; i < count; ++i) {
+				Assert::AreEqual(flags[i], projected.flags[i]);
+				if (flags[i] == 0)
+					Assert::AreEqual(screen[i], projected.positions[i]);
+				Assert::AreEqual(transformed[i], transformedFromArena[i]);
+				Assert::AreEqual(rotations[i], rotationsFromArena[i]);
+			}
+
+			// the flags don't fit: neither output is kept
+			FrameArena small(count * sizeof(Vector3) + 8);
+			ProjectedPoints none = ProjectToScreen(small, viewProjection, viewport, points, count);
+			Assert::IsTrue(none.positions.Empty() && none.flags.Empty());
+			Assert::AreEqual(size_t(0), small.GetUsed());
+		}
+
+		// running out of space returns an empty span instead of overrunning, in debug
+		// builds as well
+		TEST_METHOD(OutOfSpace)
+		{
+			FrameArena arena(64);
+			Span<Matrix4> matrices = arena.AllocateUninitialised<Matrix4>(2);
+			Assert::IsTrue(matrices.Empty());
+			Assert::AreEqual(size_t(0), arena.GetUsed());
+
+			Assert::IsTrue(arena.Allocate(65, 16) == nullptr);
+			Assert::IsTrue(arena.Allocate<Vector3>(SIZE_MAX / 4).Empty());
+			Assert::IsTrue(TransformPoints(arena, Matrix4::MakeIdentity(), static_cast<const Vector3*>(nullptr), 100).Empty());
+
+			// what fits still does afterwards
+			Assert::AreEqual(size_t(1), arena.Allocate<Matrix4>(1).Size());
+			Assert::IsTrue(arena.Allocate(0, 16) != nullptr);
+		}
+	};
+}
@@ -0,0 +1,167 @@
+#include "CppUnitTest.h"
+#include "TestToString.h"
+
+#include "Utils.h"
+#include "MathHeaders/KdTree.h"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace MathClasses;
+
+namespace MathLibraryTests
+{
+	static float DistanceSq(const Vector3& a, const Vector3& b)
+	{
+		Vector3 d = a - b;
+		return d.Dot(d);
+	}
+
+	// Squared distances from query to every point, nearest first
+	static std::vector<float> SortedDistances(const std::vector<Vector3>& points, const Vector3& query)
+	{
+		std::vector<float> distances;
+		for (const Vector3& p : points)
+			distances.push_back(DistanceSq(p, query));
+		std::sort(distances.begin(), distances.end());
+		return distances;
+	}
+
+	static std::vector<Vector3> RandomPoints(size_t count, float size, unsigned int seed)
+	{
+		std::mt19937 rng(seed);
+		std::uniform_real_distribution<float> coordinate(-size, size);
+		std::vector<Vector3> points(count);
+		for (Vector3& p : points)
+			p = Vector3(coordinate(rng), coordinate(rng), 0.2f * coordinate(rng));
+		return points;
+	}
+
+	TEST_CLASS(KdTreeTests)
+	{
+	public:
+		TEST_METHOD(NearestMatchesBruteForce)
+		{
+			std::vector<Vector3> points = RandomPoints(20011, 100.0f, 1);
+			KdTree tree(points.data(), points.size());
+			Assert::AreEqual(points.size(), tree.GetCount());
+			Assert::IsTrue(tree.GetDepth() > 0);
+
+			std::vector<Vector3> queries = RandomPoints(500, 120.0f, 2);
+			for (const Vector3& q : queries) {
+				float distanceSq;
+				uint32_t nearest = tree.FindNearest(q, &distanceSq);
+				// the tree's SIMD distances can differ from these by an FMA rounding
+				float expected = SortedDistances(points, q)[0];
+				Assert::IsTrue(NearlyEqualAtScale(expected, distanceSq, expected));
+				Assert::IsTrue(NearlyEqualAtScale(distanceSq, DistanceSq(points[nearest], q), distanceSq));
+			}
+			// every point finds itself
+			for (size_t i = 0; i < points.size(); i += 97) {
+				float distanceSq;
+				tree.FindNearest(points[i], &distanceSq);
+				Assert::AreEqual(0.0f, distanceSq);
+			}
+		}
+
+		TEST_METHOD(KNearestMatchesBruteForce)
+		{
+			std::vector<Vector3> points = RandomPoints(5003, 10.0f, 3);
+			// duplicates and a dense cluster
+			for (int i = 0; i < 50; ++i)
+				points.push_back(Vector3(1, 1, 1));
+			KdTree tree(Execution::Par, points.data(), points.size());
+
+			std::vector<Vector3> queries = RandomPoints(200, 12.0f, 4);
+			queries.push_back(Vector3(1, 1, 1));
+			for (size_t k : { size_t(1), size_t(8), size_t(40) }) {
+				std::vector<uint32_t> nearest(k);
+				std::vector<float> distances(k);
+				for (const Vector3& q : queries) {
+					std::vector<float> expected = SortedDistances(points, q);
+					Assert::AreEqual(k, tree.FindKNearest(q, k, nearest.data(), distances.data()));
+					for (size_t j = 0; j < k; ++j) {
+						Assert::IsTrue(NearlyEqualAtScale(expected[j], distances[j], expected[j]));
+						Assert::IsTrue(NearlyEqualAtScale(distances[j], DistanceSq(points[nearest[j]], q), distances[j]));
+					}
+					std::sort(nearest.begin(), nearest.end());
+					Assert::IsTrue(std::adjacent_find(nearest.begin(), nearest.end()) == nearest.end());
+				}
+			}
+		}
+
+		TEST_METHOD(BatchedQueries)
+		{
+			std::vector<Vector3> points = RandomPoints(30000, 50.0f, 5);
+			KdTree serialTree(points.data(), points.size());
+			KdTree parallelTree(Execution::Par, points.data(), points.size());
+			std::vector<Vector3> queries = RandomPoints(3001, 50.0f, 6);
+
+			size_t count = queries.size(), k = 4;
+			std::vector<uint32_t> nearest(count), parallelNearest(count);
+			std::vector<float> distances(count);
+			FindNearest(serialTree, queries.data(), count, nearest.data(), distances.data());
+			FindNearest(Execution::Par, parallelTree, queries.data(), count, parallelNearest.data(), nullptr);
+
+			std::vector<uint32_t> kNearest(count * k);
+			std::vector<float> kDistances(count * k);
+			FindKNearest(Execution::Par, parallelTree, queries.data(), count, k, kNearest.data(), kDistances.data());
+			for (size_t i = 0; i < count; ++i) {
+				Assert::AreEqual(nearest[i], parallelNearest[i]);
+				Assert::AreEqual(serialTree.FindNearest(queries[i]), nearest[i]);
+				Assert::AreEqual(distances[i], kDistances[i * k]);
+				Assert::IsTrue(kDistances[i * k + 2] <= kDistances[i * k + 3]);
+			}
+		}
+
+		TEST_METHOD(SmallAndEmpty)
+		{
+			KdTree empty;
+			float distanceSq = 0;
+			Assert::AreEqual(KdTree::InvalidIndex, empty.FindNearest(Vector3(1, 2, 3), &distanceSq));
+			Assert::AreEqual(FLT_MAX, distanceSq);
+
+			std::vector<Vector3> points = { Vector3(0, 0, 0), Vector3(5, 0, 0), Vector3(0, 3, 0) };
+			KdTree tree(points.data(), points.size());
+			Assert::AreEqual(0, tree.GetDepth());
+			Assert::AreEqual(uint32_t(2), tree.FindNearest(Vector3(0, 2, 0)));
+
+			// asking for more than there are
+			Vector3 query(4, 0, 0);
+			uint32_t nearest[5];
+			float distances[5];
+			FindKNearest(tree, &query, 1, 5, nearest, distances);
+			Assert::AreEqual(uint32_t(1), nearest[0]);
+			Assert::AreEqual(uint32_t(0), nearest[1]);
+			Assert::AreEqual(uint32_t(2), nearest[2]);
+			Assert::AreEqual(KdTree::InvalidIndex, nearest[3]);
+			Assert::AreEqual(FLT_MAX, distances[4]);
+		}
+
+		// squared distances that overflow to infinity still find points
+		TEST_METHOD(OverflowingDistances)
+		{
+			std::vector<Vector3> points;
+			for (int i = 0; i < 40; ++i)
+				points.push_back(Vector3(1e19f + float(i) * 1e18f, -1e19f, 0));
+			KdTree tree(points.data(), points.size());
+			Assert::IsTrue(tree.GetDepth() > 0);
+
+			Vector3 query(-1e19f, 1e19f, 0);
+			float distanceSq = 0;
+			uint32_t nearest = tree.FindNearest(query, &distanceSq);
+			Assert::IsTrue(nearest < points.size());
+			Assert::IsTrue(std::isinf(distanceSq));
+
+			uint32_t k[5];
+			float distances[5];
+			Assert::AreEqual(size_t(5), tree.FindKNearest(query, 5, k, distances));
+			for (int j = 0; j < 5; ++j)
+				Assert::IsTrue(k[j] < points.size());
+			std::sort(k, k + 5);
+			Assert::IsTrue(std::adjacent_find(k, k + 5) == k + 5);
+		}
+	};
+}
@@ -0,0 +1,113 @@
+#include "CppUnitTest.h"
+#include "TestToString.h"
+
+#include "MathHeaders/LargeWorld.h"
+
+#include <cstring>
+#include <random>
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace MathClasses;
+
+namespace MathLibraryTests
+{
+	TEST_CLASS(LargeWorldTests)
+	{
+	public:
+		TEST_METHOD(RebaseMatchesScalar)
+		{
+			std::mt19937 rng(50);
+			std::uniform_real_distribution<double> coordinate(-60000.0, 60000.0);
+			// not a multiple of four, so the scalar tail runs too
+			std::vector<Vector3d> world(10003);
+			for (Vector3d& p : world)
+				p = Vector3d(coordinate(rng), coordinate(rng), coordinate(rng));
+			WorldOrigin origin(Vector3d(50000.3, 12.5, -49999.7));
+
+			std::vector<Vector3> serial(world.size()), parallel(world.size());
+			RebasePositions(origin, world.data(), serial.data(), world.size());
+			RebasePositions(Execution::Par, origin, world.data(), parallel.data(), world.size());
+			for (size_t i = 0; i < world.size(); ++i) {
+				Vector3 expected = origin.ToLocal(world[i]);
+				Assert::IsTrue(expected.x == serial[i].x && expected.y == serial[i].y && expected.z == serial[i].z);
+				Assert::IsTrue(std::memcmp(&serial[i], &parallel[i], sizeof(Vector3)) == 0);
+			}
+
+			std::vector<Matrix4d> transforms(37);
+			for (size_t i = 0; i < transforms.size(); ++i)
+				transforms[i] = Matrix4d::MakeTranslation(world[i]) * Matrix4d::MakeEuler(0.1 * double(i), 0.2, -0.3) * Matrix4d::MakeScale(1.5, 1.5, 1.5);
+			std::vector<Matrix4> local(transforms.size());
+			RebaseTransforms(Execution::Par, origin, transforms.data(), local.data(), transforms.size());
+			for (size_t i = 0; i < transforms.size(); ++i) {
+				Matrix4 expected(Matrix4d::MakeTranslation(Vector3d() - origin.GetPosition()) * transforms[i]);
+				Matrix4 single = origin.ToLocal(transforms[i]);
+				Assert::IsTrue(std::memcmp(&expected, &local[i], sizeof(Matrix4)) == 0);
+				Assert::IsTrue(std::memcmp(&expected, &single, sizeof(Matrix4)) == 0);
+			}
+
+			FrameArena arena(256 * 1024);
+			Span<Vector3> positionsFromArena = RebasePositions(Execution::Par, arena, origin, world.data(), world.size());
+			Span<Matrix4> transformsFromArena = RebaseTransforms(arena, origin, transforms.data(), transforms.size());
+			Assert::AreEqual(world.size(), positionsFromArena.Size());
+			Assert::AreEqual(transforms.size(), transformsFromArena.Size());
+			Assert::IsTrue(std::memcmp(serial.data(), positionsFromArena.Data(), serial.size() * sizeof(Vector3)) == 0);
+			Assert::IsTrue(std::memcmp(local.data(), transformsFromArena.Data(), local.size() * sizeof(Matrix4)) == 0);
+			FrameArena small(64);
+			Assert::IsTrue(RebasePositions(small, origin, world.data(), world.size()).Empty());
+		}
+
+		// 50 km out, objects around the camera keep sub-millimetre positions
+		TEST_METHOD(PrecisionStableFarFromOrigin)
+		{
+			std::mt19937 rng(51);
+			std::uniform_real_distribution<double> offset(-10.0, 10.0);
+			Vector3d camera(50000.123, 35.5, -50000.456);
+			WorldOrigin origin;
+			origin.Follow(camera);
+
+			std::vector<Vector3d> world(1000);
+			for (Vector3d& p : world)
+				p = camera + Vector3d(offset(rng), offset(rng), offset(rng));
+			std::vector<Vector3> local(world.size());
+			RebasePositions(Execution::Par, origin, world.data(), local.data(), world.size());
+
+			double rebasedError = 0, floatError = 0;
+			Vector3 cameraF(camera);
+			for (size_t i = 0; i < world.size(); ++i) {
+				rebasedError = std::fmax(rebasedError, (origin.ToWorld(local[i]) - world[i]).Magnitude());
+				// the same offset worked out in float world space
+				Vector3 naive = Vector3(world[i]) - cameraF;
+				floatError = std::fmax(floatError, (Vector3d(naive) + camera - world[i]).Magnitude());
+			}
+			Assert::IsTrue(rebasedError < 1e-5);
+			Assert::IsTrue(floatError > 1e-3);
+
+			// the camera relative view matches the double one on local positions
+			Matrix4d view = Matrix4d::MakeLookAt(camera, camera + Vector3d(1, -0.2, 0.5), Vector3d(0, 1, 0));
+			Matrix4 localView = origin.ToLocalView(view);
+			for (size_t i = 0; i < world.size(); i += 10) {
+				Vector4d expected = view * Vector4d(world[i].x, world[i].y, world[i].z, 1);
+				Vector4 actual = localView * Vector4(local[i].x, local[i].y, local[i].z, 1);
+				Assert::AreEqual(expected.x, double(actual.x), 1e-5);
+				Assert::AreEqual(expected.z, double(actual.z), 1e-5);
+			}
+		}
+
+		TEST_METHOD(FollowSnapsToGrid)
+		{
+			WorldOrigin origin;
+			Assert::IsTrue(origin.Follow(Vector3d(50010, 0, -49990), 1000));
+			Assert::IsTrue(Vector3d(50000, 0, -50000) == origin.GetPosition());
+			// still the same cell: nothing rebased earlier needs redoing
+			Assert::IsFalse(origin.Follow(Vector3d(50400, 20, -49600), 1000));
+			Assert::IsTrue(origin.Follow(Vector3d(50600, 20, -49600), 1000));
+			Assert::IsTrue(Vector3d(51000, 0, -50000) == origin.GetPosition());
+
+			// without a grid it sits on the camera
+			Assert::IsTrue(origin.Follow(Vector3d(1.5, 2.5, 3.5)));
+			Assert::IsFalse(origin.Follow(Vector3d(1.5, 2.5, 3.5)));
+			Assert::IsTrue(Vector3(0, 0, 0) == origin.ToLocal(Vector3d(1.5, 2.5, 3.5)));
+		}
+	};
+}
@@ -0,0 +1,100 @@
+#pragma once
+#include "Vector3.h"
+#include "Matrix4.h"
+#include <cfloat>
+#include <cmath>
+#include <string>
+
+namespace MathClasses {
+    // Axis aligned bounding box. The default box is empty (min above max) so that
+    // expanding it by the first point gives a box around just that point.
+    struct AABB {
+        Vector3 min;
+        Vector3 max;
+
+        AABB() : min(FLT_MAX, FLT_MAX, FLT_MAX), max(-FLT_MAX, -FLT_MAX, -FLT_MAX) {}
+
+        AABB(const Vector3& min, const Vector3& max) : min(min), max(max) {}
+
+        // Box around a centre with the given half size on each axis
+        static AABB FromCentreExtents(const Vector3& centre, const Vector3& extents) {
+            return AABB(centre - extents, centre + extents);
+        }
+
+        bool IsEmpty() const {
+            return min.x > max.x || min.y > max.y || min.z > max.z;
+        }
+
+        Vector3 GetCentre() const {
+            return (min + max) * 0.5f;
+        }
+
+        // Half size on each axis
+        Vector3 GetExtents() const {
+            return (max - min) * 0.5f;
+        }
+
+        void Expand(const Vector3& p) {
+            min = Vector3(std::fmin(min.x, p.x), std::fmin(min.y, p.y), std::fmin(min.z, p.z));
+            max = Vector3(std::fmax(max.x, p.x), std::fmax(max.y, p.y), std::fmax(max.z, p.z));
+        }
+
+        void Expand(const AABB& other) {
+            Expand(other.min);
+            Expand(other.max);
+        }
+
+        // Boxes that only touch count as overlapping
+        bool Overlaps(const AABB& other) const {
+            return min.x <= other.max.x && other.min.x <= max.x &&
+                min.y <= other.max.y && other.min.y <= max.y &&
+                min.z <= other.max.z && other.min.z <= max.z;
+        }
+
+        bool Contains(const Vector3& p) const {
+            return p.x >= min.x && p.x <= max.x &&
+                p.y >= min.y && p.y <= max.y &&
+                p.z >= min.z && p.z <= max.z;
+        }
+
+        bool operator==(const AABB& other) const {
+            return min == other.min && max == other.max;
+        }
+
+        bool operator!=(const AABB& other) const {
+            return !(*this == other);
+        }
+
+        std::string ToString() const {
+            return min.ToString() + ", " + max.ToString();
+        }
+    };
+
+    // World bounds of a box under an affine transform, by Arvo's method: the centre goes
+    // through the matrix and the half size through the absolute values of its 3x3 part.
+    // That is the same box as transforming all eight corners, for a fraction of the work.
+    // The bottom row of m is ignored, so projective matrices aren't handled. An empty
+    // box stays empty.
+    inline AABB TransformAABB(const Matrix4& m, const Vector3& min, const Vector3& max) {
+        if (min.x > max.x || min.y > max.y || min.z > max.z) {
+            return AABB();
+        }
+        float cx = (min.x + max.x) * 0.5f, cy = (min.y + max.y) * 0.5f, cz = (min.z + max.z) * 0.5f;
+        float ex = (max.x - min.x) * 0.5f, ey = (max.y - min.y) * 0.5f, ez = (max.z - min.z) * 0.5f;
+        Vector3 centre(
+            m.m1 * cx + m.m5 * cy + m.m9 * cz + m.m13,
+            m.m2 * cx + m.m6 * cy + m.m10 * cz + m.m14,
+            m.m3 * cx + m.m7 * cy + m.m11 * cz + m.m15
+        );
+        Vector3 extents(
+            std::fabs(m.m1) * ex + std::fabs(m.m5) * ey + std::fabs(m.m9) * ez,
+            std::fabs(m.m2) * ex + std::fabs(m.m6) * ey + std::fabs(m.m10) * ez,
+            std::fabs(m.m3) * ex + std::fabs(m.m7) * ey + std::fabs(m.m11) * ez
+        );
+        return AABB(centre - extents, centre + extents);
+    }
+
+    inline AABB TransformAABB(const Matrix4& m, const AABB& box) {
+        return TransformAABB(m, box.min, box.max);
+    }
+}
@@ -0,0 +1,120 @@
+#pragma once
+#include "Vector3.h"
+#include "Vector4.h"
+#include "Matrix3.h"
+#include "Matrix4.h"
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+namespace MathClasses {
+
+    // The batch and SIMD code reads these types as packed float arrays, so their
+    // layout must not change
+    static_assert(sizeof(Vector3) == 3 * sizeof(float), "Vector3 must be three packed floats");
+    static_assert(sizeof(Vector4) == 4 * sizeof(float), "Vector4 must be four packed floats");
+    static_assert(sizeof(Matrix3) == 9 * sizeof(float), "Matrix3 must be nine packed floats");
+    static_assert(sizeof(Matrix4) == 16 * sizeof(float), "Matrix4 must be sixteen packed floats");
+    static_assert(offsetof(Vector3, z) == 2 * sizeof(float), "Vector3 members must be x, y, z in order");
+    static_assert(offsetof(Vector4, w) == 3 * sizeof(float), "Vector4 members must be x, y, z, w in order");
+    // Matrix4 is stored a row at a time: m1 m5 m9 m13 is the first row
+    static_assert(offsetof(Matrix4, m5) == 1 * sizeof(float), "Matrix4 rows must be contiguous");
+    static_assert(offsetof(Matrix4, m2) == 4 * sizeof(float), "Matrix4 rows must be contiguous");
+    static_assert(offsetof(Matrix4, m16) == 15 * sizeof(float), "Matrix4 rows must be contiguous");
+    static_assert(offsetof(Matrix3, m4) == 1 * sizeof(float), "Matrix3 rows must be contiguous");
+    static_assert(offsetof(Matrix3, m9) == 8 * sizeof(float), "Matrix3 rows must be contiguous");
+    static_assert(std::is_standard_layout<Vector3>::value && std::is_trivially_copyable<Vector3>::value, "Vector3 must be a plain struct");
+    static_assert(std::is_standard_layout<Vector4>::value && std::is_trivially_copyable<Vector4>::value, "Vector4 must be a plain struct");
+    static_assert(std::is_standard_layout<Matrix3>::value && std::is_trivially_copyable<Matrix3>::value, "Matrix3 must be a plain struct");
+    static_assert(std::is_standard_layout<Matrix4>::value && std::is_trivially_copyable<Matrix4>::value, "Matrix4 must be a plain struct");
+
+    // Vector4 aligned for SIMD loads. Alignment is 16 (one SSE register) or 32 (an AVX
+    // register, which pads each vector to 32 bytes in arrays)
+    template<std::size_t Alignment>
+    struct alignas(Alignment) Vector4Aligned : Vector4 {
+        static_assert(Alignment >= 16 && (Alignment & (Alignment - 1)) == 0, "Alignment must be a power of two of at least 16");
+
+        using Vector4::Vector4;
+        Vector4Aligned() = default;
+        Vector4Aligned(const Vector4& v) : Vector4(v) {}
+    };
+
+    // Matrix4 aligned for SIMD loads of its rows. At 64 each matrix fills exactly one cache line
+    template<std::size_t Alignment>
+    struct alignas(Alignment) Matrix4Aligned : Matrix4 {
+        static_assert(Alignment >= 16 && (Alignment & (Alignment - 1)) == 0, "Alignment must be a power of two of at least 16");
+
+        using Matrix4::Matrix4;
+        Matrix4Aligned() = default;
+        Matrix4Aligned(const Matrix4& m) : Matrix4(m) {}
+    };
+
+    using Vector4A16 = Vector4Aligned<16>;
+    using Vector4A32 = Vector4Aligned<32>;
+    using Matrix4A16 = Matrix4Aligned<16>;
+    using Matrix4A32 = Matrix4Aligned<32>;
+    using Matrix4A64 = Matrix4Aligned<64>;
+
+    // Vector3 padded to 16 bytes so it can be loaded straight into an SSE register.
+    // The padding lane is kept at zero so dot products over four lanes stay correct.
+    struct alignas(16) Vector3Padded {
+        float x, y, z;
+        float padding;
+
+        Vector3Padded() : x(0), y(0), z(0), padding(0) {}
+        Vector3Padded(float x, float y, float z) : x(x), y(y), z(z), padding(0) {}
+        Vector3Padded(const Vector3& v) : x(v.x), y(v.y), z(v.z), padding(0) {}
+
+        operator Vector3() const {
+            return Vector3(x, y, z);
+        }
+    };
+
+    static_assert(sizeof(Vector4A16) == 16 && alignof(Vector4A16) == 16, "Vector4A16 layout");
+    static_assert(sizeof(Vector4A32) == 32 && alignof(Vector4A32) == 32, "Vector4A32 layout");
+    static_assert(sizeof(Matrix4A16) == 64 && alignof(Matrix4A16) == 16, "Matrix4A16 layout");
+    static_assert(sizeof(Matrix4A64) == 64 && alignof(Matrix4A64) == 64, "Matrix4A64 layout");
+    static_assert(sizeof(Vector3Padded) == 16 && alignof(Vector3Padded) == 16, "Vector3Padded layout");
+    static_assert(std::is_trivially_copyable<Vector3Padded>::value, "Vector3Padded must be a plain struct");
+
+    // Standard allocator that hands out memory aligned to at least Alignment bytes
+    template<typename T, std::size_t Alignment = 32>
+    struct AlignedAllocator {
+        using value_type = T;
+
+        static constexpr std::size_t alignment = Alignment > alignof(T) ? Alignment : alignof(T);
+
+        template<typename U>
+        struct rebind {
+            using other = AlignedAllocator<U, Alignment>;
+        };
+
+        AlignedAllocator() = default;
+
+        template<typename U>
+        AlignedAllocator(const AlignedAllocator<U, Alignment>&) {}
+
+        T* allocate(std::size_t count) {
+            return static_cast<T*>(::operator new(count * sizeof(T), std::align_val_t(alignment)));
+        }
+
+        void deallocate(T* p, std::size_t) {
+            ::operator delete(p, std::align_val_t(alignment));
+        }
+
+        template<typename U>
+        bool operator==(const AlignedAllocator<U, Alignment>&) const { return true; }
+
+        template<typename U>
+        bool operator!=(const AlignedAllocator<U, Alignment>&) const { return false; }
+    };
+
+    // std::vector whose storage starts on an Alignment byte boundary
+    template<typename T, std::size_t Alignment = 32>
+    using AlignedVector = std::vector<T, AlignedAllocator<T, Alignment>>;
+
+    using Vector4Array = AlignedVector<Vector4A16, 64>;
+    using Vector3PaddedArray = AlignedVector<Vector3Padded, 64>;
+    using Matrix4Array = AlignedVector<Matrix4A64, 64>;
+}
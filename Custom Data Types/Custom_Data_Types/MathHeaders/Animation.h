@@ -0,0 +1,343 @@
+#pragma once
+#include "Vector3.h"
+#include "Matrix4.h"
+#include "FrameArena.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace MathClasses {
+
+    // Remembers the key a track was last sampled at, so playing forwards finds the
+    // next key in a step or two instead of a binary search. One per track per player.
+    struct TrackCursor {
+        std::uint32_t key = 0;
+    };
+
+    namespace Detail {
+        // Returns the segment k (0 to keyCount - 2) with timeAt(k) <= time < timeAt(k + 1),
+        // clamped at either end. Tries the cursor and the next few keys before searching.
+        template<typename TimeAt>
+        std::size_t FindKey(std::size_t keyCount, float time, TrackCursor& cursor, TimeAt timeAt) {
+            std::size_t last = keyCount - 2;
+            std::size_t k = cursor.key <= last ? cursor.key : 0;
+            if (timeAt(k) <= time) {
+                for (int step = 0; step < 4 && k < last && timeAt(k + 1) <= time; ++step) {
+                    ++k;
+                }
+                if (k == last || time < timeAt(k + 1)) {
+                    cursor.key = static_cast<std::uint32_t>(k);
+                    return k;
+                }
+            }
+            else if (k == 0) {
+                return 0;
+            }
+
+            std::size_t low = 0, high = keyCount;
+            while (low < high) {
+                std::size_t mid = (low + high) / 2;
+                if (timeAt(mid) <= time) {
+                    low = mid + 1;
+                }
+                else {
+                    high = mid;
+                }
+            }
+            k = low == 0 ? 0 : std::min(low - 1, last);
+            cursor.key = static_cast<std::uint32_t>(k);
+            return k;
+        }
+
+        inline Vector3 Lerp(const Vector3& a, const Vector3& b, float t) {
+            return Vector3(a.x + (b.x - a.x) * t, a.y + (b.y - a.y) * t, a.z + (b.z - a.z) * t);
+        }
+
+        inline float SegmentFraction(float t0, float t1, float time) {
+            if (t1 <= t0) {
+                return 0.0f;
+            }
+            float t = (time - t0) / (t1 - t0);
+            return t < 0.0f ? 0.0f : (t > 1.0f ? 1.0f : t);
+        }
+    }
+
+    // Vector3 keyframes sampled with linear interpolation. Keys must be added in
+    // increasing time order; sampling outside the keys holds the first or last value.
+    class Vector3Track {
+    public:
+        void AddKey(float time, const Vector3& value) {
+            times.push_back(time);
+            values.push_back(value);
+        }
+
+        std::size_t GetKeyCount() const { return times.size(); }
+        float GetKeyTime(std::size_t i) const { return times[i]; }
+        const Vector3& GetKeyValue(std::size_t i) const { return values[i]; }
+
+        Vector3 Sample(float time) const {
+            TrackCursor cursor;
+            return Sample(time, cursor);
+        }
+
+        Vector3 Sample(float time, TrackCursor& cursor) const {
+            if (times.empty()) {
+                return Vector3();
+            }
+            if (times.size() == 1) {
+                return values[0];
+            }
+            std::size_t k = Detail::FindKey(times.size(), time, cursor, [this](std::size_t i) { return times[i]; });
+            return Detail::Lerp(values[k], values[k + 1], Detail::SegmentFraction(times[k], times[k + 1], time));
+        }
+
+        // Removes keys that linear interpolation between the remaining keys reproduces
+        // to within tolerance on every component. The first and last keys are kept.
+        void Reduce(float tolerance) {
+            if (times.size() < 3) {
+                return;
+            }
+            std::vector<float> keptTimes{ times[0] };
+            std::vector<Vector3> keptValues{ values[0] };
+            std::size_t anchor = 0;
+            for (std::size_t end = 2; end < times.size(); ++end) {
+                if (!SpanFits(anchor, end, tolerance)) {
+                    anchor = end - 1;
+                    keptTimes.push_back(times[anchor]);
+                    keptValues.push_back(values[anchor]);
+                }
+            }
+            keptTimes.push_back(times.back());
+            keptValues.push_back(values.back());
+            times.swap(keptTimes);
+            values.swap(keptValues);
+        }
+
+    private:
+        // True if every key strictly between anchor and end lies on the line between them
+        bool SpanFits(std::size_t anchor, std::size_t end, float tolerance) const {
+            for (std::size_t i = anchor + 1; i < end; ++i) {
+                Vector3 line = Detail::Lerp(values[anchor], values[end], Detail::SegmentFraction(times[anchor], times[end], times[i]));
+                Vector3 error = values[i] - line;
+                if (std::fabs(error.x) > tolerance || std::fabs(error.y) > tolerance || std::fabs(error.z) > tolerance) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        std::vector<float> times;
+        std::vector<Vector3> values;
+    };
+
+    // Read-only track with 16 bit keys: times are stored as fractions of the track's
+    // duration and each component as a fraction of the track's range on that axis,
+    // so a key takes 8 bytes instead of 16. Build from a Vector3Track, optionally
+    // running key reduction first.
+    class CompressedVector3Track {
+    public:
+        CompressedVector3Track() = default;
+
+        explicit CompressedVector3Track(const Vector3Track& source, float reduceTolerance = 0.0f) {
+            Vector3Track track = source;
+            if (reduceTolerance > 0.0f) {
+                track.Reduce(reduceTolerance);
+            }
+            std::size_t count = track.GetKeyCount();
+            if (count == 0) {
+                return;
+            }
+
+            startTime = track.GetKeyTime(0);
+            float duration = track.GetKeyTime(count - 1) - startTime;
+            timeScale = duration > 0.0f ? duration / 65535.0f : 0.0f;
+
+            Vector3 low = track.GetKeyValue(0), high = low;
+            for (std::size_t i = 1; i < count; ++i) {
+                const Vector3& v = track.GetKeyValue(i);
+                low = Vector3(std::min(low.x, v.x), std::min(low.y, v.y), std::min(low.z, v.z));
+                high = Vector3(std::max(high.x, v.x), std::max(high.y, v.y), std::max(high.z, v.z));
+            }
+            minimum = low;
+            range = Vector3((high.x - low.x) / 65535.0f, (high.y - low.y) / 65535.0f, (high.z - low.z) / 65535.0f);
+
+            keys.resize(count);
+            for (std::size_t i = 0; i < count; ++i) {
+                const Vector3& v = track.GetKeyValue(i);
+                keys[i].time = Quantise(track.GetKeyTime(i) - startTime, timeScale);
+                keys[i].x = Quantise(v.x - low.x, range.x);
+                keys[i].y = Quantise(v.y - low.y, range.y);
+                keys[i].z = Quantise(v.z - low.z, range.z);
+            }
+        }
+
+        std::size_t GetKeyCount() const { return keys.size(); }
+
+        float GetKeyTime(std::size_t i) const {
+            return startTime + keys[i].time * timeScale;
+        }
+
+        Vector3 GetKeyValue(std::size_t i) const {
+            return Vector3(minimum.x + keys[i].x * range.x, minimum.y + keys[i].y * range.y, minimum.z + keys[i].z * range.z);
+        }
+
+        // Largest error quantisation adds to any component of a key's value
+        float GetQuantisationError() const {
+            return 0.5f * std::max(range.x, std::max(range.y, range.z));
+        }
+
+        Vector3 Sample(float time) const {
+            TrackCursor cursor;
+            return Sample(time, cursor);
+        }
+
+        Vector3 Sample(float time, TrackCursor& cursor) const {
+            if (keys.empty()) {
+                return Vector3();
+            }
+            if (keys.size() == 1) {
+                return GetKeyValue(0);
+            }
+            std::size_t k = Detail::FindKey(keys.size(), time, cursor, [this](std::size_t i) { return GetKeyTime(i); });
+            return Detail::Lerp(GetKeyValue(k), GetKeyValue(k + 1), Detail::SegmentFraction(GetKeyTime(k), GetKeyTime(k + 1), time));
+        }
+
+    private:
+        struct Key {
+            std::uint16_t time, x, y, z;
+        };
+
+        static std::uint16_t Quantise(float value, float step) {
+            if (step <= 0.0f) {
+                return 0;
+            }
+            float q = std::round(value / step);
+            return static_cast<std::uint16_t>(q < 0.0f ? 0.0f : (q > 65535.0f ? 65535.0f : q));
+        }
+
+        std::vector<Key> keys;
+        float startTime = 0.0f;
+        float timeScale = 0.0f;
+        Vector3 minimum;
+        Vector3 range;
+    };
+
+    // Local transform of one bone: translation, Euler rotation (pitch, yaw, roll in
+    // radians, as used by Matrix4::MakeEuler) and scale
+    struct LocalTRS {
+        Vector3 translation;
+        Vector3 rotation;
+        Vector3 scale = Vector3(1, 1, 1);
+
+        // Same matrix as MakeTranslation(t) * MakeEuler(r) * MakeScale(s), built directly
+        Matrix4 ToMatrix() const {
+            float sp = std::sin(rotation.x), cp = std::cos(rotation.x);
+            float sy = std::sin(rotation.y), cy = std::cos(rotation.y);
+            float sr = std::sin(rotation.z), cr = std::cos(rotation.z);
+            return Matrix4(
+                cr * cy * scale.x, sr * cy * scale.x, -sy * scale.x, 0,
+                (cr * sy * sp - sr * cp) * scale.y, (sr * sy * sp + cr * cp) * scale.y, cy * sp * scale.y, 0,
+                (cr * sy * cp + sr * sp) * scale.z, (sr * sy * cp - cr * sp) * scale.z, cy * cp * scale.z, 0,
+                translation.x, translation.y, translation.z, 1
+            );
+        }
+    };
+
+    // Per-bone translation, rotation and scale tracks for one animation
+    class AnimationClip {
+    public:
+        explicit AnimationClip(std::size_t boneCount = 0)
+            : translation(boneCount), rotation(boneCount), scale(boneCount) {}
+
+        std::size_t GetBoneCount() const { return translation.size(); }
+
+        void SetTracks(std::size_t bone, const Vector3Track& translationTrack, const Vector3Track& rotationTrack,
+            const Vector3Track& scaleTrack, float reduceTolerance = 0.0f)
+        {
+            translation[bone] = CompressedVector3Track(translationTrack, reduceTolerance);
+            rotation[bone] = CompressedVector3Track(rotationTrack, reduceTolerance);
+            scale[bone] = CompressedVector3Track(scaleTrack, reduceTolerance);
+        }
+
+        const CompressedVector3Track& GetTranslationTrack(std::size_t bone) const { return translation[bone]; }
+        const CompressedVector3Track& GetRotationTrack(std::size_t bone) const { return rotation[bone]; }
+        const CompressedVector3Track& GetScaleTrack(std::size_t bone) const { return scale[bone]; }
+
+    private:
+        std::vector<CompressedVector3Track> translation;
+        std::vector<CompressedVector3Track> rotation;
+        std::vector<CompressedVector3Track> scale;
+    };
+
+    // Playback state for one instance of a clip: a cursor per track
+    struct ClipCursor {
+        std::vector<TrackCursor> cursors;
+
+        explicit ClipCursor(std::size_t boneCount = 0) : cursors(boneCount * 3) {}
+    };
+
+    // Samples every bone of a clip at one time into out (GetBoneCount() entries).
+    // Bones are independent, so they are split across threads with the parallel policy.
+    template<typename Policy>
+    void SampleClip(Policy policy, const AnimationClip& clip, float time, ClipCursor& cursor, LocalTRS* out) {
+        cursor.cursors.resize(clip.GetBoneCount() * 3);
+        TrackCursor* cursors = cursor.cursors.data();
+        // Each bone reads two keys of each track (four uint16s a key) and its cursors
+        std::size_t bytesPerBone = sizeof(LocalTRS) + 3 * (sizeof(CompressedVector3Track) + sizeof(TrackCursor) + 2 * 4 * sizeof(std::uint16_t));
+        ForEachRange(policy, clip.GetBoneCount(), GrainForBytes(bytesPerBone), [&](std::size_t begin, std::size_t end) {
+            for (std::size_t bone = begin; bone < end; ++bone) {
+                out[bone].translation = clip.GetTranslationTrack(bone).Sample(time, cursors[bone * 3]);
+                out[bone].rotation = clip.GetRotationTrack(bone).Sample(time, cursors[bone * 3 + 1]);
+                out[bone].scale = clip.GetScaleTrack(bone).Sample(time, cursors[bone * 3 + 2]);
+            }
+        });
+    }
+
+    inline void SampleClip(const AnimationClip& clip, float time, ClipCursor& cursor, LocalTRS* out) {
+        SampleClip(Execution::Seq, clip, time, cursor, out);
+    }
+
+    // Samples into a pose from a FrameArena; empty if the arena can't fit it
+    template<typename Policy>
+    Span<LocalTRS> SampleClip(Policy policy, FrameArena& arena, const AnimationClip& clip, float time, ClipCursor& cursor) {
+        Span<LocalTRS> out = arena.AllocateUninitialised<LocalTRS>(clip.GetBoneCount());
+        if (out.Size() == clip.GetBoneCount()) {
+            SampleClip(policy, clip, time, cursor, out.Data());
+        }
+        return out;
+    }
+
+    inline Span<LocalTRS> SampleClip(FrameArena& arena, const AnimationClip& clip, float time, ClipCursor& cursor) {
+        return SampleClip(Execution::Seq, arena, clip, time, cursor);
+    }
+
+    // Converts sampled local transforms to matrices
+    template<typename Policy>
+    void ComposeTRS(Policy policy, const LocalTRS* in, Matrix4* out, std::size_t count) {
+        ForEachRange(policy, count, GrainForBytes(sizeof(LocalTRS) + sizeof(Matrix4)), [&](std::size_t begin, std::size_t end) {
+            for (std::size_t i = begin; i < end; ++i) {
+                out[i] = in[i].ToMatrix();
+            }
+        });
+    }
+
+    inline void ComposeTRS(const LocalTRS* in, Matrix4* out, std::size_t count) {
+        ComposeTRS(Execution::Seq, in, out, count);
+    }
+
+    template<typename Policy>
+    Span<Matrix4> ComposeTRS(Policy policy, FrameArena& arena, const LocalTRS* in, std::size_t count) {
+        Span<Matrix4> out = arena.AllocateUninitialised<Matrix4>(count);
+        if (out.Size() == count) {
+            ComposeTRS(policy, in, out.Data(), count);
+        }
+        return out;
+    }
+
+    inline Span<Matrix4> ComposeTRS(FrameArena& arena, const LocalTRS* in, std::size_t count) {
+        return ComposeTRS(Execution::Seq, arena, in, count);
+    }
+}
@@ -0,0 +1,658 @@
+#pragma once
+#include "AABB.h"
+#include "Matrix4.h"
+#include "Matrix3.h"
+#include "Vector4.h"
+#include "Vector3.h"
+#include "ThreadPool.h"
+#include "FrameArena.h"
+#include "Span.h"
+#include "Simd.h"
+#include "Aligned.h"
+#include "FastMath.h"
+#include "TrigTable.h"
+#include <cfloat>
+#include <cstddef>
+#include <cstdint>
+
+namespace MathClasses {
+
+    // Batch versions of the Matrix4 operations. Every function takes an optional
+    // execution policy as its first argument; without one it runs on the calling thread.
+    // Each output element depends only on its own input element, so parallel results
+    // are identical to (and in the same order as) the sequential ones, unless the
+    // compiler contracts to FMA (see Simd.h).
+    // Input and output arrays may be the same array.
+    // The FrameArena overloads allocate the output from the arena and return it; the
+    // returned span is empty if the arena is out of space.
+    // The matrix and vector functions also take the double types (Matrix4d, Vector3d and
+    // Vector4d). Float uses the SIMD kernels where there are some; double runs the same
+    // operations one element at a time.
+
+    namespace Detail {
+        template<typename T>
+        void TransformPointsKernel(const Matrix<T, 4, 4>& m, const Vector<T, 3>* in, Vector<T, 3>* out, std::size_t count) {
+            for (std::size_t i = 0; i < count; ++i) {
+                T x = in[i].x, y = in[i].y, z = in[i].z;
+                out[i] = Vector<T, 3>(
+                    m.m1 * x + m.m5 * y + m.m9 * z + m.m13,
+                    m.m2 * x + m.m6 * y + m.m10 * z + m.m14,
+                    m.m3 * x + m.m7 * y + m.m11 * z + m.m15
+                );
+            }
+        }
+
+        template<typename T>
+        void TransformVectorsKernel(const Matrix<T, 4, 4>& m, const Vector<T, 3>* in, Vector<T, 3>* out, std::size_t count) {
+            for (std::size_t i = 0; i < count; ++i) {
+                T x = in[i].x, y = in[i].y, z = in[i].z;
+                out[i] = Vector<T, 3>(
+                    m.m1 * x + m.m5 * y + m.m9 * z,
+                    m.m2 * x + m.m6 * y + m.m10 * z,
+                    m.m3 * x + m.m7 * y + m.m11 * z
+                );
+            }
+        }
+
+        // Four vectors at a time, one register per component. Uses the same operations
+        // as Vector3::Normalise so results match it exactly; zero vectors stay zero.
+        inline void NormaliseVectorsKernel(const Vector3* in, Vector3* out, std::size_t count) {
+            std::size_t i = 0;
+            for (; i + 4 <= count; i += 4) {
+                Float4 x(in[i].x, in[i + 1].x, in[i + 2].x, in[i + 3].x);
+                Float4 y(in[i].y, in[i + 1].y, in[i + 2].y, in[i + 3].y);
+                Float4 z(in[i].z, in[i + 1].z, in[i + 2].z, in[i + 3].z);
+                Float4 mag = Sqrt(x * x + y * y + z * z);
+                mag = Select(mag > Float4::Zero(), mag, Float4(1.0f));
+
+                alignas(16) float xs[4], ys[4], zs[4];
+                (x / mag).Store(xs);
+                (y / mag).Store(ys);
+                (z / mag).Store(zs);
+                for (int k = 0; k < 4; ++k) {
+                    out[i + k] = Vector3(xs[k], ys[k], zs[k]);
+                }
+            }
+            for (; i < count; ++i) {
+                out[i] = in[i].Normalised();
+            }
+        }
+
+        inline void NormaliseVectorsKernel(Precision::ExactPolicy, const Vector3* in, Vector3* out, std::size_t count) {
+            NormaliseVectorsKernel(in, out, count);
+        }
+
+        // Same operations as Vector3::Normalise(precision), so results match it exactly
+        template<typename Precision>
+        void NormaliseVectorsKernel(Precision precision, const Vector3* in, Vector3* out, std::size_t count) {
+            std::size_t i = 0;
+            for (; i + 4 <= count; i += 4) {
+                Float4 x(in[i].x, in[i + 1].x, in[i + 2].x, in[i + 3].x);
+                Float4 y(in[i].y, in[i + 1].y, in[i + 2].y, in[i + 3].y);
+                Float4 z(in[i].z, in[i + 1].z, in[i + 2].z, in[i + 3].z);
+                Float4 lengthSq = x * x + y * y + z * z;
+                if (Any(lengthSq < Float4(FLT_MIN))) {
+                    // Zero or denormal lengths take the scalar path
+                    for (int k = 0; k < 4; ++k) {
+                        out[i + k] = in[i + k].Normalised(precision);
+                    }
+                    continue;
+                }
+                Float4 r = InvSqrt(precision, lengthSq);
+
+                alignas(16) float xs[4], ys[4], zs[4];
+                (x * r).Store(xs);
+                (y * r).Store(ys);
+                (z * r).Store(zs);
+                for (int k = 0; k < 4; ++k) {
+                    out[i + k] = Vector3(xs[k], ys[k], zs[k]);
+                }
+            }
+            for (; i < count; ++i) {
+                out[i] = in[i].Normalised(precision);
+            }
+        }
+
+        // Other value types take the scalar path, one vector at a time
+        template<typename T>
+        void NormaliseVectorsKernel(const Vector<T, 3>* in, Vector<T, 3>* out, std::size_t count) {
+            for (std::size_t i = 0; i < count; ++i) {
+                out[i] = in[i].Normalised();
+            }
+        }
+
+        template<typename Precision, typename T>
+        void NormaliseVectorsKernel(Precision precision, const Vector<T, 3>* in, Vector<T, 3>* out, std::size_t count) {
+            for (std::size_t i = 0; i < count; ++i) {
+                out[i] = in[i].Normalised(precision);
+            }
+        }
+
+        // Each vector is one register: out = col0 * x + col1 * y + col2 * z + col3 * w.
+        // Aligned selects aligned loads and stores for the Vector4Aligned arrays.
+        template<bool Aligned, typename V>
+        void TransformVector4sKernel(const Matrix4& m, const V* in, V* out, std::size_t count) {
+            Float4 col0(m.m1, m.m2, m.m3, m.m4);
+            Float4 col1(m.m5, m.m6, m.m7, m.m8);
+            Float4 col2(m.m9, m.m10, m.m11, m.m12);
+            Float4 col3(m.m13, m.m14, m.m15, m.m16);
+            for (std::size_t i = 0; i < count; ++i) {
+                Float4 v = Aligned ? Float4::Load(&in[i].x) : Float4::LoadUnaligned(&in[i].x);
+                Float4 r = col0 * v.Splat<0>() + col1 * v.Splat<1>() + col2 * v.Splat<2>() + col3 * v.Splat<3>();
+                if (Aligned) {
+                    r.Store(&out[i].x);
+                }
+                else {
+                    r.StoreUnaligned(&out[i].x);
+                }
+            }
+        }
+
+        inline void TransformVector4sKernel(const Matrix4& m, const Vector4* in, Vector4* out, std::size_t count) {
+            TransformVector4sKernel<false>(m, in, out, count);
+        }
+
+        template<typename T>
+        void TransformVector4sKernel(const Matrix<T, 4, 4>& m, const Vector<T, 4>* in, Vector<T, 4>* out, std::size_t count) {
+            for (std::size_t i = 0; i < count; ++i) {
+                out[i] = m * in[i];
+            }
+        }
+
+        // Matrix4 is stored a row at a time, so each row of a * b is a's row
+        // weighting the four rows of b: row(out, r) = sum over k of a(r, k) * row(b, k)
+        struct MatrixRows {
+            Float4 rows[4];
+
+            explicit MatrixRows(const Matrix4& m) {
+                const float* p = &m.m1;
+                for (int r = 0; r < 4; ++r) {
+                    rows[r] = Float4::LoadUnaligned(p + 4 * r);
+                }
+            }
+
+            // Writes a * (this matrix) to out, reading a row before writing it so out may alias a
+            void MultiplyLeft(const Matrix4& a, Matrix4& out) const {
+                const float* pa = &a.m1;
+                float* po = &out.m1;
+                for (int r = 0; r < 4; ++r) {
+                    Float4 ar = Float4::LoadUnaligned(pa + 4 * r);
+                    Float4 row = ar.Splat<0>() * rows[0] + ar.Splat<1>() * rows[1] + ar.Splat<2>() * rows[2] + ar.Splat<3>() * rows[3];
+                    row.StoreUnaligned(po + 4 * r);
+                }
+            }
+
+            // Writes (this matrix) * b to out
+            void MultiplyRight(const Matrix4& b, Matrix4& out) const {
+                MatrixRows bRows(b);
+                float* po = &out.m1;
+                for (int r = 0; r < 4; ++r) {
+                    Float4 row = rows[r].Splat<0>() * bRows.rows[0] + rows[r].Splat<1>() * bRows.rows[1] +
+                        rows[r].Splat<2>() * bRows.rows[2] + rows[r].Splat<3>() * bRows.rows[3];
+                    row.StoreUnaligned(po + 4 * r);
+                }
+            }
+        };
+
+        inline void MultiplyMatricesKernel(const Matrix4& parent, const Matrix4* in, Matrix4* out, std::size_t count) {
+            MatrixRows parentRows(parent);
+            for (std::size_t i = 0; i < count; ++i) {
+                parentRows.MultiplyRight(in[i], out[i]);
+            }
+        }
+
+        inline void MultiplyMatricesKernel(const Matrix4* a, const Matrix4* b, Matrix4* out, std::size_t count) {
+            for (std::size_t i = 0; i < count; ++i) {
+                MatrixRows(b[i]).MultiplyLeft(a[i], out[i]);
+            }
+        }
+
+        template<typename T>
+        void MultiplyMatricesKernel(const Matrix<T, 4, 4>& parent, const Matrix<T, 4, 4>* in, Matrix<T, 4, 4>* out, std::size_t count) {
+            for (std::size_t i = 0; i < count; ++i) {
+                out[i] = parent * in[i];
+            }
+        }
+
+        template<typename T>
+        void MultiplyMatricesKernel(const Matrix<T, 4, 4>* a, const Matrix<T, 4, 4>* b, Matrix<T, 4, 4>* out, std::size_t count) {
+            for (std::size_t i = 0; i < count; ++i) {
+                out[i] = a[i] * b[i];
+            }
+        }
+    }
+
+    // Transforms points (w = 1) by a matrix: out[i] = m * in[i]
+    template<typename Policy, typename T>
+    void TransformPoints(Policy policy, const Matrix<T, 4, 4>& m, const Vector<T, 3>* in, Vector<T, 3>* out, std::size_t count) {
+        ForEachRange(policy, count, GrainForBytes(2 * sizeof(Vector<T, 3>)), [&](std::size_t begin, std::size_t end) {
+            Detail::TransformPointsKernel(m, in + begin, out + begin, end - begin);
+        });
+    }
+
+    template<typename T>
+    void TransformPoints(const Matrix<T, 4, 4>& m, const Vector<T, 3>* in, Vector<T, 3>* out, std::size_t count) {
+        TransformPoints(Execution::Seq, m, in, out, count);
+    }
+
+    template<typename Policy, typename T>
+    Span<Vector<T, 3>> TransformPoints(Policy policy, FrameArena& arena, const Matrix<T, 4, 4>& m, const Vector<T, 3>* in, std::size_t count) {
+        Span<Vector<T, 3>> out = arena.AllocateUninitialised<Vector<T, 3>>(count);
+        if (out.Size() == count) {
+            TransformPoints(policy, m, in, out.Data(), count);
+        }
+        return out;
+    }
+
+    template<typename T>
+    Span<Vector<T, 3>> TransformPoints(FrameArena& arena, const Matrix<T, 4, 4>& m, const Vector<T, 3>* in, std::size_t count) {
+        return TransformPoints(Execution::Seq, arena, m, in, count);
+    }
+
+    // Transforms directions (w = 0) by a matrix, ignoring its translation
+    template<typename Policy, typename T>
+    void TransformVectors(Policy policy, const Matrix<T, 4, 4>& m, const Vector<T, 3>* in, Vector<T, 3>* out, std::size_t count) {
+        ForEachRange(policy, count, GrainForBytes(2 * sizeof(Vector<T, 3>)), [&](std::size_t begin, std::size_t end) {
+            Detail::TransformVectorsKernel(m, in + begin, out + begin, end - begin);
+        });
+    }
+
+    template<typename T>
+    void TransformVectors(const Matrix<T, 4, 4>& m, const Vector<T, 3>* in, Vector<T, 3>* out, std::size_t count) {
+        TransformVectors(Execution::Seq, m, in, out, count);
+    }
+
+    template<typename Policy, typename T>
+    Span<Vector<T, 3>> TransformVectors(Policy policy, FrameArena& arena, const Matrix<T, 4, 4>& m, const Vector<T, 3>* in, std::size_t count) {
+        Span<Vector<T, 3>> out = arena.AllocateUninitialised<Vector<T, 3>>(count);
+        if (out.Size() == count) {
+            TransformVectors(policy, m, in, out.Data(), count);
+        }
+        return out;
+    }
+
+    template<typename T>
+    Span<Vector<T, 3>> TransformVectors(FrameArena& arena, const Matrix<T, 4, 4>& m, const Vector<T, 3>* in, std::size_t count) {
+        return TransformVectors(Execution::Seq, arena, m, in, count);
+    }
+
+    // Normalises many vectors, leaving zero length vectors as zero
+    template<typename Policy, typename T>
+    void NormaliseVectors(Policy policy, const Vector<T, 3>* in, Vector<T, 3>* out, std::size_t count) {
+        ForEachRange(policy, count, GrainForBytes(2 * sizeof(Vector<T, 3>)), [&](std::size_t begin, std::size_t end) {
+            Detail::NormaliseVectorsKernel(in + begin, out + begin, end - begin);
+        });
+    }
+
+    template<typename T>
+    void NormaliseVectors(const Vector<T, 3>* in, Vector<T, 3>* out, std::size_t count) {
+        NormaliseVectors(Execution::Seq, in, out, count);
+    }
+
+    // As above with the square root at a chosen precision (see FastMath.h)
+    template<typename Policy, typename Precision, typename T>
+    void NormaliseVectors(Policy policy, Precision precision, const Vector<T, 3>* in, Vector<T, 3>* out, std::size_t count) {
+        ForEachRange(policy, count, GrainForBytes(2 * sizeof(Vector<T, 3>)), [&](std::size_t begin, std::size_t end) {
+            Detail::NormaliseVectorsKernel(precision, in + begin, out + begin, end - begin);
+        });
+    }
+
+    template<typename Policy, typename T>
+    Span<Vector<T, 3>> NormaliseVectors(Policy policy, FrameArena& arena, const Vector<T, 3>* in, std::size_t count) {
+        Span<Vector<T, 3>> out = arena.AllocateUninitialised<Vector<T, 3>>(count);
+        if (out.Size() == count) {
+            NormaliseVectors(policy, in, out.Data(), count);
+        }
+        return out;
+    }
+
+    template<typename T>
+    Span<Vector<T, 3>> NormaliseVectors(FrameArena& arena, const Vector<T, 3>* in, std::size_t count) {
+        return NormaliseVectors(Execution::Seq, arena, in, count);
+    }
+
+    // 2D rotation matrices as Matrix3::MakeRotationQuantised, for angles in 1/4096 of a turn
+    template<typename Policy>
+    void MakeRotationsQuantised(Policy policy, const uint32_t* angles, Matrix3* out, std::size_t count) {
+        const SinCosTable& table = SinCosTable::Get();
+        ForEachRange(policy, count, GrainForBytes(sizeof(uint32_t) + sizeof(Matrix3)), [&](std::size_t begin, std::size_t end) {
+            for (std::size_t i = begin; i < end; ++i) {
+                float s, c;
+                table.Lookup(angles[i], s, c);
+                out[i] = Matrix3(c, s, 0, -s, c, 0, 0, 0, 1);
+            }
+        });
+    }
+
+    inline void MakeRotationsQuantised(const uint32_t* angles, Matrix3* out, std::size_t count) {
+        MakeRotationsQuantised(Execution::Seq, angles, out, count);
+    }
+
+    template<typename Policy>
+    Span<Matrix3> MakeRotationsQuantised(Policy policy, FrameArena& arena, const uint32_t* angles, std::size_t count) {
+        Span<Matrix3> out = arena.AllocateUninitialised<Matrix3>(count);
+        if (out.Size() == count) {
+            MakeRotationsQuantised(policy, angles, out.Data(), count);
+        }
+        return out;
+    }
+
+    inline Span<Matrix3> MakeRotationsQuantised(FrameArena& arena, const uint32_t* angles, std::size_t count) {
+        return MakeRotationsQuantised(Execution::Seq, arena, angles, count);
+    }
+
+    // Transforms homogeneous vectors by a matrix
+    template<typename Policy, typename T>
+    void TransformVector4s(Policy policy, const Matrix<T, 4, 4>& m, const Vector<T, 4>* in, Vector<T, 4>* out, std::size_t count) {
+        ForEachRange(policy, count, GrainForBytes(2 * sizeof(Vector<T, 4>)), [&](std::size_t begin, std::size_t end) {
+            Detail::TransformVector4sKernel(m, in + begin, out + begin, end - begin);
+        });
+    }
+
+    template<typename T>
+    void TransformVector4s(const Matrix<T, 4, 4>& m, const Vector<T, 4>* in, Vector<T, 4>* out, std::size_t count) {
+        TransformVector4s(Execution::Seq, m, in, out, count);
+    }
+
+    template<typename Policy, typename T>
+    Span<Vector<T, 4>> TransformVector4s(Policy policy, FrameArena& arena, const Matrix<T, 4, 4>& m, const Vector<T, 4>* in, std::size_t count) {
+        Span<Vector<T, 4>> out = arena.AllocateUninitialised<Vector<T, 4>>(count);
+        if (out.Size() == count) {
+            TransformVector4s(policy, m, in, out.Data(), count);
+        }
+        return out;
+    }
+
+    template<typename T>
+    Span<Vector<T, 4>> TransformVector4s(FrameArena& arena, const Matrix<T, 4, 4>& m, const Vector<T, 4>* in, std::size_t count) {
+        return TransformVector4s(Execution::Seq, arena, m, in, count);
+    }
+
+    // Transforms arrays of aligned vectors using aligned loads and stores
+    template<typename Policy, std::size_t Alignment>
+    void TransformVector4s(Policy policy, const Matrix4& m, const Vector4Aligned<Alignment>* in, Vector4Aligned<Alignment>* out, std::size_t count) {
+        ForEachRange(policy, count, GrainForBytes(2 * sizeof(Vector4Aligned<Alignment>)), [&](std::size_t begin, std::size_t end) {
+            Detail::TransformVector4sKernel<true>(m, in + begin, out + begin, end - begin);
+        });
+    }
+
+    template<std::size_t Alignment>
+    void TransformVector4s(const Matrix4& m, const Vector4Aligned<Alignment>* in, Vector4Aligned<Alignment>* out, std::size_t count) {
+        TransformVector4s(Execution::Seq, m, in, out, count);
+    }
+
+    // Concatenates a parent onto many matrices: out[i] = parent * in[i]
+    template<typename Policy, typename T>
+    void MultiplyMatrices(Policy policy, const Matrix<T, 4, 4>& parent, const Matrix<T, 4, 4>* in, Matrix<T, 4, 4>* out, std::size_t count) {
+        ForEachRange(policy, count, GrainForBytes(2 * sizeof(Matrix<T, 4, 4>)), [&](std::size_t begin, std::size_t end) {
+            Detail::MultiplyMatricesKernel(parent, in + begin, out + begin, end - begin);
+        });
+    }
+
+    template<typename T>
+    void MultiplyMatrices(const Matrix<T, 4, 4>& parent, const Matrix<T, 4, 4>* in, Matrix<T, 4, 4>* out, std::size_t count) {
+        MultiplyMatrices(Execution::Seq, parent, in, out, count);
+    }
+
+    template<typename Policy, typename T>
+    Span<Matrix<T, 4, 4>> MultiplyMatrices(Policy policy, FrameArena& arena, const Matrix<T, 4, 4>& parent, const Matrix<T, 4, 4>* in, std::size_t count) {
+        Span<Matrix<T, 4, 4>> out = arena.AllocateUninitialised<Matrix<T, 4, 4>>(count);
+        if (out.Size() == count) {
+            MultiplyMatrices(policy, parent, in, out.Data(), count);
+        }
+        return out;
+    }
+
+    template<typename T>
+    Span<Matrix<T, 4, 4>> MultiplyMatrices(FrameArena& arena, const Matrix<T, 4, 4>& parent, const Matrix<T, 4, 4>* in, std::size_t count) {
+        return MultiplyMatrices(Execution::Seq, arena, parent, in, count);
+    }
+
+    // Pairwise products: out[i] = a[i] * b[i]
+    template<typename Policy, typename T>
+    void MultiplyMatrices(Policy policy, const Matrix<T, 4, 4>* a, const Matrix<T, 4, 4>* b, Matrix<T, 4, 4>* out, std::size_t count) {
+        ForEachRange(policy, count, GrainForBytes(3 * sizeof(Matrix<T, 4, 4>)), [&](std::size_t begin, std::size_t end) {
+            Detail::MultiplyMatricesKernel(a + begin, b + begin, out + begin, end - begin);
+        });
+    }
+
+    template<typename T>
+    void MultiplyMatrices(const Matrix<T, 4, 4>* a, const Matrix<T, 4, 4>* b, Matrix<T, 4, 4>* out, std::size_t count) {
+        MultiplyMatrices(Execution::Seq, a, b, out, count);
+    }
+
+    template<typename Policy, typename T>
+    Span<Matrix<T, 4, 4>> MultiplyMatrices(Policy policy, FrameArena& arena, const Matrix<T, 4, 4>* a, const Matrix<T, 4, 4>* b, std::size_t count) {
+        Span<Matrix<T, 4, 4>> out = arena.AllocateUninitialised<Matrix<T, 4, 4>>(count);
+        if (out.Size() == count) {
+            MultiplyMatrices(policy, a, b, out.Data(), count);
+        }
+        return out;
+    }
+
+    template<typename T>
+    Span<Matrix<T, 4, 4>> MultiplyMatrices(FrameArena& arena, const Matrix<T, 4, 4>* a, const Matrix<T, 4, 4>* b, std::size_t count) {
+        return MultiplyMatrices(Execution::Seq, arena, a, b, count);
+    }
+
+    // Which NDC depth range the projection produces; MakePerspective and MakeOrthographic
+    // give NegativeOneToOne, the reversed-Z builders ZeroToOne
+    enum class DepthRange {
+        NegativeOneToOne,
+        ZeroToOne
+    };
+
+    // Pixel rectangle that NDC maps to, with y pointing down the screen
+    struct Viewport {
+        float x = 0.0f;
+        float y = 0.0f;
+        float width = 1.0f;
+        float height = 1.0f;
+        DepthRange depthRange = DepthRange::NegativeOneToOne;
+    };
+
+    // Why a projected point isn't on screen; 0 means it is
+    enum ProjectionFlags : uint8_t {
+        ProjectedOffScreen = 1 << 0,        // outside the viewport rectangle
+        ProjectedOutsideDepth = 1 << 1,     // in front of the near or beyond the far plane
+        ProjectedBehind = 1 << 2,           // behind the camera (w <= 0); the position is meaningless
+    };
+
+    namespace Detail {
+        // Four points at a time. 1 / w is the hardware reciprocal estimate plus one Newton
+        // step, r' = r * (2 - w * r), which takes it from about 12 to about 23 bits.
+        inline void ProjectToScreenBlock(const Matrix4& m, const Viewport& viewport, const Vector3* in, Vector3* out, uint8_t* flags) {
+            Float4 x(in[0].x, in[1].x, in[2].x, in[3].x);
+            Float4 y(in[0].y, in[1].y, in[2].y, in[3].y);
+            Float4 z(in[0].z, in[1].z, in[2].z, in[3].z);
+            Float4 cx = Float4(m.m1) * x + Float4(m.m5) * y + Float4(m.m9) * z + Float4(m.m13);
+            Float4 cy = Float4(m.m2) * x + Float4(m.m6) * y + Float4(m.m10) * z + Float4(m.m14);
+            Float4 cz = Float4(m.m3) * x + Float4(m.m7) * y + Float4(m.m11) * z + Float4(m.m15);
+            Float4 cw = Float4(m.m4) * x + Float4(m.m8) * y + Float4(m.m12) * z + Float4(m.m16);
+
+            Float4 zero = Float4::Zero();
+            Float4 behind = cw <= zero;
+            Float4 negW = -cw;
+            Float4 offScreen = behind | (cx < negW) | (cx > cw) | (cy < negW) | (cy > cw);
+            Float4 nearLimit = viewport.depthRange == DepthRange::ZeroToOne ? zero : negW;
+            Float4 outsideDepth = behind | (cz < nearLimit) | (cz > cw);
+
+            Float4 r = RcpEstimate(cw);
+            r = r * (Float4(2.0f) - cw * r);
+            Float4 half(0.5f);
+            Float4 sx = Float4(viewport.x) + (cx * r * half + half) * Float4(viewport.width);
+            Float4 sy = Float4(viewport.y) + (half - cy * r * half) * Float4(viewport.height);
+            Float4 sz = cz * r;
+            if (viewport.depthRange == DepthRange::NegativeOneToOne) {
+                sz = sz * half + half;
+            }
+
+            alignas(16) float xs[4], ys[4], zs[4];
+            sx.Store(xs);
+            sy.Store(ys);
+            sz.Store(zs);
+            int off = MoveMask(offScreen), depth = MoveMask(outsideDepth), back = MoveMask(behind);
+            for (int k = 0; k < 4; ++k) {
+                out[k] = Vector3(xs[k], ys[k], zs[k]);
+                flags[k] = uint8_t(((off >> k) & 1) * ProjectedOffScreen |
+                    ((depth >> k) & 1) * ProjectedOutsideDepth |
+                    ((back >> k) & 1) * ProjectedBehind);
+            }
+        }
+
+        inline void ProjectToScreenKernel(const Matrix4& m, const Viewport& viewport, const Vector3* in, Vector3* out, uint8_t* flags, std::size_t count) {
+            std::size_t i = 0;
+            for (; i + 4 <= count; i += 4) {
+                ProjectToScreenBlock(m, viewport, in + i, out + i, flags + i);
+            }
+            if (i < count) {
+                // The tail goes through the same block so every point rounds the same way
+                // whichever chunk it lands in
+                Vector3 tailIn[4], tailOut[4];
+                uint8_t tailFlags[4];
+                for (std::size_t k = 0; k < 4; ++k) {
+                    tailIn[k] = in[i + (k < count - i ? k : 0)];
+                }
+                ProjectToScreenBlock(m, viewport, tailIn, tailOut, tailFlags);
+                for (std::size_t k = 0; i + k < count; ++k) {
+                    out[i + k] = tailOut[k];
+                    flags[i + k] = tailFlags[k];
+                }
+            }
+        }
+    }
+
+    // World space points to screen: x and y in viewport pixels, z as depth in [0, 1].
+    // viewProjection takes world space to clip space. flags[i] gets ProjectionFlags
+    // bits, 0 for points that are on screen.
+    template<typename Policy>
+    void ProjectToScreen(Policy policy, const Matrix4& viewProjection, const Viewport& viewport,
+        const Vector3* in, Vector3* out, uint8_t* flags, std::size_t count)
+    {
+        ForEachRange(policy, count, GrainForBytes(2 * sizeof(Vector3) + 1), [&](std::size_t begin, std::size_t end) {
+            Detail::ProjectToScreenKernel(viewProjection, viewport, in + begin, out + begin, flags + begin, end - begin);
+        });
+    }
+
+    inline void ProjectToScreen(const Matrix4& viewProjection, const Viewport& viewport,
+        const Vector3* in, Vector3* out, uint8_t* flags, std::size_t count)
+    {
+        ProjectToScreen(Execution::Seq, viewProjection, viewport, in, out, flags, count);
+    }
+
+    // ProjectToScreen's two outputs when they come from a FrameArena
+    struct ProjectedPoints {
+        Span<Vector3> positions;
+        Span<uint8_t> flags;
+    };
+
+    // Both spans are empty if the arena can't fit them, and nothing is left allocated
+    template<typename Policy>
+    ProjectedPoints ProjectToScreen(Policy policy, FrameArena& arena, const Matrix4& viewProjection, const Viewport& viewport,
+        const Vector3* in, std::size_t count)
+    {
+        FrameArena::Marker marker = arena.GetMarker();
+        ProjectedPoints out;
+        out.positions = arena.AllocateUninitialised<Vector3>(count);
+        out.flags = arena.AllocateUninitialised<uint8_t>(count);
+        if (out.positions.Size() != count || out.flags.Size() != count) {
+            arena.RewindTo(marker);
+            return ProjectedPoints();
+        }
+        ProjectToScreen(policy, viewProjection, viewport, in, out.positions.Data(), out.flags.Data(), count);
+        return out;
+    }
+
+    inline ProjectedPoints ProjectToScreen(FrameArena& arena, const Matrix4& viewProjection, const Viewport& viewport,
+        const Vector3* in, std::size_t count)
+    {
+        return ProjectToScreen(Execution::Seq, arena, viewProjection, viewport, in, count);
+    }
+
+    namespace Detail {
+        // Eight boxes and their matrices, transposed into one array per component so
+        // each step of TransformAABB runs on all eight at once
+        inline void TransformAABBsBlock(const Matrix4* matrices, const AABB* local, AABB* out) {
+            alignas(32) float m[12][8], box[6][8];
+            for (int k = 0; k < 8; ++k) {
+                const Matrix4& w = matrices[k];
+                const float entries[12] = { w.m1, w.m2, w.m3, w.m5, w.m6, w.m7, w.m9, w.m10, w.m11, w.m13, w.m14, w.m15 };
+                for (int e = 0; e < 12; ++e) {
+                    m[e][k] = entries[e];
+                }
+                box[0][k] = local[k].min.x; box[1][k] = local[k].min.y; box[2][k] = local[k].min.z;
+                box[3][k] = local[k].max.x; box[4][k] = local[k].max.y; box[5][k] = local[k].max.z;
+            }
+
+            Float8 minX = Float8::Load(box[0]), minY = Float8::Load(box[1]), minZ = Float8::Load(box[2]);
+            Float8 maxX = Float8::Load(box[3]), maxY = Float8::Load(box[4]), maxZ = Float8::Load(box[5]);
+            Float8 empty = (minX > maxX) | (minY > maxY) | (minZ > maxZ);
+            Float8 half(0.5f);
+            Float8 cx = (minX + maxX) * half, cy = (minY + maxY) * half, cz = (minZ + maxZ) * half;
+            Float8 ex = (maxX - minX) * half, ey = (maxY - minY) * half, ez = (maxZ - minZ) * half;
+
+            Float8 r[3][2];
+            for (int row = 0; row < 3; ++row) {
+                Float8 a = Float8::Load(m[row]), b = Float8::Load(m[3 + row]), c = Float8::Load(m[6 + row]);
+                Float8 centre = a * cx + b * cy + c * cz + Float8::Load(m[9 + row]);
+                Float8 extent = Abs(a) * ex + Abs(b) * ey + Abs(c) * ez;
+                r[row][0] = Select(empty, Float8(FLT_MAX), centre - extent);
+                r[row][1] = Select(empty, Float8(-FLT_MAX), centre + extent);
+            }
+
+            for (int row = 0; row < 3; ++row) {
+                r[row][0].Store(box[row]);
+                r[row][1].Store(box[3 + row]);
+            }
+            for (int k = 0; k < 8; ++k) {
+                out[k] = AABB(Vector3(box[0][k], box[1][k], box[2][k]), Vector3(box[3][k], box[4][k], box[5][k]));
+            }
+        }
+
+        inline void TransformAABBsKernel(const Matrix4* matrices, const AABB* local, AABB* out, std::size_t count) {
+            std::size_t i = 0;
+            for (; i + 8 <= count; i += 8) {
+                TransformAABBsBlock(matrices + i, local + i, out + i);
+            }
+            if (i < count) {
+                Matrix4 tailMatrices[8];
+                AABB tailIn[8], tailOut[8];
+                for (std::size_t k = 0; k < 8; ++k) {
+                    std::size_t from = i + (k < count - i ? k : 0);
+                    tailMatrices[k] = matrices[from];
+                    tailIn[k] = local[from];
+                }
+                TransformAABBsBlock(tailMatrices, tailIn, tailOut);
+                for (std::size_t k = 0; i + k < count; ++k) {
+                    out[i + k] = tailOut[k];
+                }
+            }
+        }
+    }
+
+    // TransformAABB(matrices[i], local[i]) for every box, eight at a time. Results are
+    // identical to the scalar version unless the compiler contracts to FMA (see Simd.h).
+    template<typename Policy>
+    void TransformAABBs(Policy policy, const Matrix4* matrices, const AABB* local, AABB* out, std::size_t count) {
+        ForEachRange(policy, count, GrainForBytes(sizeof(Matrix4) + 2 * sizeof(AABB)), [&](std::size_t begin, std::size_t end) {
+            Detail::TransformAABBsKernel(matrices + begin, local + begin, out + begin, end - begin);
+        });
+    }
+
+    inline void TransformAABBs(const Matrix4* matrices, const AABB* local, AABB* out, std::size_t count) {
+        TransformAABBs(Execution::Seq, matrices, local, out, count);
+    }
+
+    template<typename Policy>
+    Span<AABB> TransformAABBs(Policy policy, FrameArena& arena, const Matrix4* matrices, const AABB* local, std::size_t count) {
+        Span<AABB> out = arena.AllocateUninitialised<AABB>(count);
+        if (out.Size() == count) {
+            TransformAABBs(policy, matrices, local, out.Data(), count);
+        }
+        return out;
+    }
+
+    inline Span<AABB> TransformAABBs(FrameArena& arena, const Matrix4* matrices, const AABB* local, std::size_t count) {
+        return TransformAABBs(Execution::Seq, arena, matrices, local, count);
+    }
+}
@@ -0,0 +1,178 @@
+#pragma once
+#include "Matrix4.h"
+#include "Vector3.h"
+#include "FrameArena.h"
+#include "RadixSort.h"
+#include "ThreadPool.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace MathClasses {
+
+    enum class DepthOrder {
+        // Nearest first, for opaque draws
+        FrontToBack,
+        // Furthest first, for blended transparency
+        BackToFront
+    };
+
+    namespace Detail {
+        // 32 bit keys in three passes of 11 bits
+        constexpr int DepthDigitBits = 11;
+
+        inline void DepthKeysKernel(const Matrix4& view, const Vector3* centres, uint32_t* keys, std::size_t count, DepthOrder order) {
+            uint32_t flip = order == DepthOrder::BackToFront ? 0xFFFFFFFFu : 0u;
+            for (std::size_t i = 0; i < count; ++i) {
+                float x = centres[i].x, y = centres[i].y, z = centres[i].z;
+                float depth = -(view.m3 * x + view.m7 * y + view.m11 * z + view.m15);
+                keys[i] = SortableFloatBits(depth) ^ flip;
+            }
+        }
+    }
+
+    // Sort keys for view depth: the distance in front of the camera along its view
+    // direction (view matrices as made by MakeLookAt, looking down -z) as unsigned ints
+    // that sort in the order asked for. Points behind the camera have negative depth
+    // and sort as nearest.
+    template<typename Policy>
+    void ComputeDepthKeys(Policy policy, const Matrix4& view, const Vector3* centres, uint32_t* keys, std::size_t count,
+        DepthOrder order)
+    {
+        ForEachRange(policy, count, GrainForBytes(sizeof(Vector3) + sizeof(uint32_t)), [&](std::size_t begin, std::size_t end) {
+            Detail::DepthKeysKernel(view, centres + begin, keys + begin, end - begin, order);
+        });
+    }
+
+    inline void ComputeDepthKeys(const Matrix4& view, const Vector3* centres, uint32_t* keys, std::size_t count, DepthOrder order) {
+        ComputeDepthKeys(Execution::Seq, view, centres, keys, count, order);
+    }
+
+    // Draw order by depth: order[i] is the index of the i-th item to draw. Items at
+    // the same depth keep their index order. The keys and the sort's working memory are
+    // allocated on every call; the FrameArena overload and DepthSorter don't.
+    template<typename Policy>
+    void SortByDepth(Policy policy, const Matrix4& view, const Vector3* centres, std::size_t count, DepthOrder order,
+        uint32_t* drawOrder)
+    {
+        std::vector<uint32_t> keys(count);
+        ComputeDepthKeys(policy, view, centres, keys.data(), count, order);
+        RadixSort<Detail::DepthDigitBits>(policy, keys.data(), count, drawOrder);
+    }
+
+    inline void SortByDepth(const Matrix4& view, const Vector3* centres, std::size_t count, DepthOrder order, uint32_t* drawOrder) {
+        SortByDepth(Execution::Seq, view, centres, count, order, drawOrder);
+    }
+
+    // The draw order in arena memory, with the keys and the sort's working memory
+    // handed back to the arena. Empty, with nothing left allocated, if it can't fit.
+    template<typename Policy>
+    Span<uint32_t> SortByDepth(Policy policy, FrameArena& arena, const Matrix4& view, const Vector3* centres, std::size_t count,
+        DepthOrder order)
+    {
+        FrameArena::Marker marker = arena.GetMarker();
+        Span<uint32_t> drawOrder = arena.AllocateUninitialised<uint32_t>(count);
+        bool sorted = false;
+        if (drawOrder.Size() == count) {
+            ArenaScope scope(arena);
+            Span<uint32_t> keys = arena.AllocateUninitialised<uint32_t>(count);
+            if (keys.Size() == count) {
+                ComputeDepthKeys(policy, view, centres, keys.Data(), count, order);
+                sorted = RadixSort<Detail::DepthDigitBits>(policy, arena, keys.Data(), count, drawOrder.Data());
+            }
+        }
+        if (!sorted) {
+            arena.RewindTo(marker);
+            return Span<uint32_t>();
+        }
+        return drawOrder;
+    }
+
+    inline Span<uint32_t> SortByDepth(FrameArena& arena, const Matrix4& view, const Vector3* centres, std::size_t count, DepthOrder order) {
+        return SortByDepth(Execution::Seq, arena, view, centres, count, order);
+    }
+
+    // Depth sort kept from frame to frame. With a moving camera and moving objects the
+    // order changes only a little each frame, so Update starts from last frame's order
+    // and fixes it with an insertion sort, which is close to linear when little has
+    // changed. If that takes more than a few shifts per item it gives up and radix sorts
+    // from scratch, as SortByDepth does. Items at the same depth keep last frame's
+    // order in the incremental case, so they don't flicker between frames. The sorter
+    // keeps its arrays and the radix sort's working memory, so once they have grown
+    // to the item count, updates don't allocate.
+    class DepthSorter {
+    public:
+        // Insertion sort shifts allowed per item before switching to a radix sort
+        static constexpr std::size_t MaxShiftsPerItem = 4;
+
+        // Sorts this frame's items. A different count or DepthOrder from last time
+        // always sorts from scratch.
+        template<typename Policy>
+        const std::vector<uint32_t>& Update(Policy policy, const Matrix4& view, const Vector3* centres, std::size_t count,
+            DepthOrder order)
+        {
+            keys.resize(count);
+            ComputeDepthKeys(policy, view, centres, keys.data(), count, order);
+
+            incremental = count == drawOrder.size() && order == lastOrder && count > 0;
+            lastOrder = order;
+            if (incremental) {
+                sortedKeys.resize(count);
+                for (std::size_t i = 0; i < count; ++i) {
+                    sortedKeys[i] = keys[drawOrder[i]];
+                }
+                incremental = InsertionSort(count * MaxShiftsPerItem);
+            }
+            if (!incremental) {
+                sortedKeys = keys;
+                drawOrder.resize(count);
+                RadixSort<Detail::DepthDigitBits>(policy, sortedKeys.data(), count, drawOrder.data(), scratch);
+            }
+            return drawOrder;
+        }
+
+        const std::vector<uint32_t>& Update(const Matrix4& view, const Vector3* centres, std::size_t count, DepthOrder order) {
+            return Update(Execution::Seq, view, centres, count, order);
+        }
+
+        const std::vector<uint32_t>& GetOrder() const { return drawOrder; }
+
+        // Whether the last Update reused the previous order
+        bool WasIncremental() const { return incremental; }
+
+        // Forgets the previous order, so the next Update sorts from scratch
+        void Reset() {
+            drawOrder.clear();
+            incremental = false;
+        }
+
+    private:
+        // Returns false, leaving the order partly sorted, if it needs more than maxShifts
+        bool InsertionSort(std::size_t maxShifts) {
+            std::size_t shifts = 0;
+            for (std::size_t i = 1; i < sortedKeys.size(); ++i) {
+                uint32_t key = sortedKeys[i], item = drawOrder[i];
+                std::size_t j = i;
+                while (j > 0 && key < sortedKeys[j - 1]) {
+                    sortedKeys[j] = sortedKeys[j - 1];
+                    drawOrder[j] = drawOrder[j - 1];
+                    --j;
+                }
+                sortedKeys[j] = key;
+                drawOrder[j] = item;
+                shifts += i - j;
+                if (shifts > maxShifts) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        std::vector<uint32_t> keys;
+        std::vector<uint32_t> sortedKeys;
+        std::vector<uint32_t> drawOrder;
+        RadixSortScratch<uint32_t> scratch;
+        DepthOrder lastOrder = DepthOrder::FrontToBack;
+        bool incremental = false;
+    };
+}
@@ -0,0 +1,91 @@
+#pragma once
+#include "Quaternion.h"
+#include "Vector3.h"
+#include "Matrix4.h"
+#include <string>
+#include <cmath>
+
+namespace MathClasses {
+    // Rigid transform (rotation then translation) as a unit dual quaternion:
+    // real is the rotation, dual is 0.5 * translation * real.
+    // Blending dual quaternions keeps the result rigid, unlike blending matrices.
+    struct DualQuaternion {
+        Quaternion real;
+        Quaternion dual;
+
+        // Default constructor gives the identity transform
+        DualQuaternion() : real(0, 0, 0, 1), dual(0, 0, 0, 0) {}
+
+        DualQuaternion(const Quaternion& real, const Quaternion& dual) : real(real), dual(dual) {}
+
+        static DualQuaternion MakeIdentity() {
+            return DualQuaternion();
+        }
+
+        // Rotation followed by translation
+        static DualQuaternion MakeRigid(const Quaternion& rotation, const Vector3& translation) {
+            Quaternion t(translation.x, translation.y, translation.z, 0);
+            return DualQuaternion(rotation, (t * rotation) * 0.5f);
+        }
+
+        // Rigid part of a matrix; any scale or shear in the matrix is lost
+        static DualQuaternion FromMatrix(const Matrix4& m) {
+            return MakeRigid(Quaternion::FromMatrix(m).Normalised(), Vector3(m.m13, m.m14, m.m15));
+        }
+
+        Quaternion GetRotation() const {
+            return real;
+        }
+
+        Vector3 GetTranslation() const {
+            Quaternion t = (dual * 2.0f) * real.Conjugate();
+            return Vector3(t.x, t.y, t.z);
+        }
+
+        Matrix4 ToMatrix4() const {
+            Matrix4 m = real.ToMatrix4();
+            Vector3 t = GetTranslation();
+            m.m13 = t.x;
+            m.m14 = t.y;
+            m.m15 = t.z;
+            return m;
+        }
+
+        // Applies other first, then this
+        DualQuaternion operator*(const DualQuaternion& other) const {
+            return DualQuaternion(real * other.real, real * other.dual + dual * other.real);
+        }
+
+        // Transforms a point
+        Vector3 TransformPoint(const Vector3& p) const {
+            return real * p + GetTranslation();
+        }
+
+        // Scales both parts so real is unit length again, e.g. after blending
+        void Normalise() {
+            float mag = real.Magnitude();
+            if (mag > 0) {
+                real = real * (1.0f / mag);
+                dual = dual * (1.0f / mag);
+            }
+        }
+
+        DualQuaternion Normalised() const {
+            DualQuaternion copy = *this;
+            copy.Normalise();
+            return copy;
+        }
+
+        bool operator==(const DualQuaternion& other) const {
+            return ToMatrix4() == other.ToMatrix4();
+        }
+
+        bool operator!=(const DualQuaternion& other) const {
+            return !(*this == other);
+        }
+
+        std::string ToString() const {
+            return real.ToString() + ", " + dual.ToString();
+        }
+    };
+}
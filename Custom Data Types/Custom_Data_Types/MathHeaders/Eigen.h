@@ -0,0 +1,202 @@
+#pragma once
+#include "Matrix3.h"
+#include "Vector3.h"
+#include "Simd.h"
+#include "ThreadPool.h"
+#include <cstddef>
+
+namespace MathClasses {
+
+    // Eigenvalues and eigenvectors of a symmetric 3x3 matrix. The values are sorted
+    // largest first, vectors holds the matching unit eigenvectors as its columns, and
+    // the columns form a right handed basis, so vectors is a rotation.
+    struct SymmetricEigen {
+        Vector3 values;
+        Matrix3 vectors;
+    };
+
+    namespace Detail {
+        // Cyclic Jacobi sweeps, each zeroing the three off diagonal terms in turn. The
+        // count is fixed rather than tested for convergence so every lane of a batch runs
+        // the same instructions; convergence is quadratic, so four sweeps reach float
+        // precision for any input and the other two are insurance for clustered values.
+        constexpr int JacobiSweeps = 6;
+
+        // Upper triangle of a symmetric matrix and the accumulated eigenvectors, one
+        // matrix per lane. v[row][column].
+        template<typename F>
+        struct JacobiState {
+            F a00, a11, a22, a01, a02, a12;
+            F v[3][3];
+        };
+
+        // One rotation in the (p, q) plane, with r the remaining axis. The angle is
+        // chosen with the smaller root of t^2 + 2 theta t - 1 = 0, which keeps it within
+        // 45 degrees and loses no precision when theta is large. A zero off diagonal
+        // term gives t = 0, so lanes that are already diagonal pass through unchanged.
+        template<typename F>
+        void JacobiRotate(F& app, F& aqq, F& apq, F& arp, F& arq, F (&v)[3][3], int p, int q) {
+            F zero, one(1.0f);
+            F active = Abs(apq) > zero;
+            F theta = (aqq - app) / (F(2.0f) * Select(active, apq, one));
+            F t = one / (Abs(theta) + Sqrt(theta * theta + one));
+            t = Select(active, Select(theta < zero, -t, t), zero);
+            F c = one / Sqrt(t * t + one);
+            F s = t * c;
+
+            app = app - t * apq;
+            aqq = aqq + t * apq;
+            apq = zero;
+            F rp = arp, rq = arq;
+            arp = c * rp - s * rq;
+            arq = s * rp + c * rq;
+            for (int k = 0; k < 3; ++k) {
+                F vp = v[k][p], vq = v[k][q];
+                v[k][p] = c * vp - s * vq;
+                v[k][q] = s * vp + c * vq;
+            }
+        }
+
+        // Swaps eigenpairs i and j in the lanes where value j is the larger
+        template<typename F>
+        void SortPair(F (&values)[3], F (&v)[3][3], int i, int j) {
+            F swap = values[j] > values[i];
+            F a = values[i], b = values[j];
+            values[i] = Select(swap, b, a);
+            values[j] = Select(swap, a, b);
+            for (int k = 0; k < 3; ++k) {
+                F x = v[k][i], y = v[k][j];
+                v[k][i] = Select(swap, y, x);
+                v[k][j] = Select(swap, x, y);
+            }
+        }
+
+        // Diagonalises every lane, then sorts and makes the basis right handed.
+        // Only Abs, Sqrt, division and Select are used, so the result in a lane doesn't
+        // depend on the width of F or on the other lanes.
+        template<typename F>
+        void SolveSymmetricEigen(JacobiState<F>& s, F (&values)[3]) {
+            F zero, one(1.0f);
+            for (int r = 0; r < 3; ++r) {
+                for (int c = 0; c < 3; ++c) {
+                    s.v[r][c] = r == c ? one : zero;
+                }
+            }
+            for (int sweep = 0; sweep < JacobiSweeps; ++sweep) {
+                JacobiRotate(s.a00, s.a11, s.a01, s.a02, s.a12, s.v, 0, 1);
+                JacobiRotate(s.a00, s.a22, s.a02, s.a01, s.a12, s.v, 0, 2);
+                JacobiRotate(s.a11, s.a22, s.a12, s.a01, s.a02, s.v, 1, 2);
+            }
+
+            values[0] = s.a00;
+            values[1] = s.a11;
+            values[2] = s.a22;
+            SortPair(values, s.v, 0, 1);
+            SortPair(values, s.v, 1, 2);
+            SortPair(values, s.v, 0, 1);
+
+            // The columns are orthonormal already; this only fixes the sign of the last
+            s.v[0][2] = s.v[1][0] * s.v[2][1] - s.v[2][0] * s.v[1][1];
+            s.v[1][2] = s.v[2][0] * s.v[0][1] - s.v[0][0] * s.v[2][1];
+            s.v[2][2] = s.v[0][0] * s.v[1][1] - s.v[1][0] * s.v[0][1];
+        }
+
+        // Off diagonal terms are averaged, so a matrix that is only nearly symmetric
+        // (a covariance built in float, say) is treated as its symmetric part.
+        inline void SymmetricTerms(const Matrix3& m, float (&terms)[6]) {
+            terms[0] = m.m1;
+            terms[1] = m.m5;
+            terms[2] = m.m9;
+            terms[3] = 0.5f * (m.m2 + m.m4);
+            terms[4] = 0.5f * (m.m3 + m.m7);
+            terms[5] = 0.5f * (m.m6 + m.m8);
+        }
+
+        inline Matrix3 EigenvectorMatrix(const float (&v)[3][3]) {
+            return Matrix3(v[0][0], v[1][0], v[2][0], v[0][1], v[1][1], v[2][1], v[0][2], v[1][2], v[2][2]);
+        }
+    }
+
+    // Jacobi eigen-decomposition of a symmetric matrix. Runs the same branch free code
+    // as the batch version on a single lane, so the two give identical results unless
+    // the compiler contracts to FMA (see Simd.h).
+    inline SymmetricEigen ComputeSymmetricEigen(const Matrix3& m) {
+        float terms[6];
+        Detail::SymmetricTerms(m, terms);
+        Detail::JacobiState<Float4> state;
+        state.a00 = Float4(terms[0]);
+        state.a11 = Float4(terms[1]);
+        state.a22 = Float4(terms[2]);
+        state.a01 = Float4(terms[3]);
+        state.a02 = Float4(terms[4]);
+        state.a12 = Float4(terms[5]);
+        Float4 values[3];
+        Detail::SolveSymmetricEigen(state, values);
+
+        float v[3][3];
+        for (int r = 0; r < 3; ++r) {
+            for (int c = 0; c < 3; ++c) {
+                v[r][c] = state.v[r][c][0];
+            }
+        }
+        SymmetricEigen result;
+        result.values = Vector3(values[0][0], values[1][0], values[2][0]);
+        result.vectors = Detail::EigenvectorMatrix(v);
+        return result;
+    }
+
+    // ComputeSymmetricEigen over an array, eight matrices per Float8. The last block
+    // is padded with copies of the final matrix.
+    template<typename Policy>
+    void ComputeSymmetricEigens(Policy policy, const Matrix3* matrices, SymmetricEigen* out, std::size_t count) {
+        std::size_t blocks = (count + 7) / 8;
+        ForEachRange(policy, blocks, GrainForBytes(8 * (sizeof(Matrix3) + sizeof(SymmetricEigen))),
+            [&](std::size_t begin, std::size_t end) {
+                for (std::size_t b = begin; b < end; ++b) {
+                    std::size_t first = b * 8;
+                    alignas(32) float terms[6][8];
+                    for (int lane = 0; lane < 8; ++lane) {
+                        std::size_t i = first + lane < count ? first + lane : count - 1;
+                        float t[6];
+                        Detail::SymmetricTerms(matrices[i], t);
+                        for (int k = 0; k < 6; ++k) {
+                            terms[k][lane] = t[k];
+                        }
+                    }
+                    Detail::JacobiState<Float8> state;
+                    state.a00 = Float8::Load(terms[0]);
+                    state.a11 = Float8::Load(terms[1]);
+                    state.a22 = Float8::Load(terms[2]);
+                    state.a01 = Float8::Load(terms[3]);
+                    state.a02 = Float8::Load(terms[4]);
+                    state.a12 = Float8::Load(terms[5]);
+                    Float8 values[3];
+                    Detail::SolveSymmetricEigen(state, values);
+
+                    alignas(32) float lanes[12][8];
+                    for (int k = 0; k < 3; ++k) {
+                        values[k].Store(lanes[k]);
+                    }
+                    for (int r = 0; r < 3; ++r) {
+                        for (int c = 0; c < 3; ++c) {
+                            state.v[r][c].Store(lanes[3 + r * 3 + c]);
+                        }
+                    }
+                    for (int lane = 0; lane < 8 && first + lane < count; ++lane) {
+                        float v[3][3];
+                        for (int r = 0; r < 3; ++r) {
+                            for (int c = 0; c < 3; ++c) {
+                                v[r][c] = lanes[3 + r * 3 + c][lane];
+                            }
+                        }
+                        out[first + lane].values = Vector3(lanes[0][lane], lanes[1][lane], lanes[2][lane]);
+                        out[first + lane].vectors = Detail::EigenvectorMatrix(v);
+                    }
+                }
+            });
+    }
+
+    inline void ComputeSymmetricEigens(const Matrix3* matrices, SymmetricEigen* out, std::size_t count) {
+        ComputeSymmetricEigens(Execution::Seq, matrices, out, count);
+    }
+}
@@ -0,0 +1,159 @@
+#pragma once
+#include "Simd.h"
+#include <cfloat>
+#include <cmath>
+
+namespace MathClasses {
+
+    // Precision tiers for the functions and builders that take one as their first
+    // argument, in the same style as the execution policies. Errors are against the
+    // exact result and are checked by FastMathTests.
+    //
+    //                 InvSqrt                    Sin / Cos (|x| <= 8192)
+    //   Exact         libm sqrt and divide       libm sin and cos
+    //   Fast          <= 4 ulp                   <= 2 ulp or 1e-7 absolute, whichever is larger
+    //   Fastest       <= 1.5 * 2^-12 relative    <= 1.3e-5 absolute
+    //
+    // Fast and Fastest use the SSE reciprocal square root estimate, refined with one
+    // Newton step for Fast. With MATHCLASSES_NO_SIMD the estimate is exact, so both
+    // tiers are at least as accurate as the table says. Normalise adds up to one more
+    // ulp per component for the rounding of the squared length and the multiply.
+    // Sin and Cos fall back to libm outside |x| <= 8192, and for infinities and NaN.
+    namespace Precision {
+        struct ExactPolicy {};
+        struct FastPolicy {};
+        struct FastestPolicy {};
+
+        inline constexpr ExactPolicy Exact{};
+        inline constexpr FastPolicy Fast{};
+        inline constexpr FastestPolicy Fastest{};
+    }
+
+    // 1 / sqrt(x) for x > 0, four at a time
+    inline Float4 InvSqrt(Precision::ExactPolicy, Float4 x) {
+        return Float4(1.0f) / Sqrt(x);
+    }
+
+    // r' = r * (1.5 - 0.5 * x * r * r) takes the 12 bit estimate to about 22 bits
+    inline Float4 InvSqrt(Precision::FastPolicy, Float4 x) {
+        Float4 r = RsqrtEstimate(x);
+        return r * (Float4(1.5f) - Float4(0.5f) * x * r * r);
+    }
+
+    inline Float4 InvSqrt(Precision::FastestPolicy, Float4 x) {
+        return RsqrtEstimate(x);
+    }
+
+    // The scalar versions go through lane 0 so they round exactly like the batch kernels
+    inline float InvSqrt(Precision::ExactPolicy, float x) {
+        return 1.0f / std::sqrt(x);
+    }
+
+    template<typename Precision>
+    float InvSqrt(Precision precision, float x) {
+        return InvSqrt(precision, Float4(x))[0];
+    }
+
+    // Double has no estimate to speed up; every tier computes it exactly
+    template<typename Precision>
+    double InvSqrt(Precision, double x) {
+        return 1.0 / std::sqrt(x);
+    }
+
+    namespace Detail {
+        // Largest |x| ReduceOctant is accurate for
+        inline constexpr float ReduceOctantLimit = 8192.0f;
+
+        // Splits x into an octant index and a remainder in [-pi/4, pi/4]. Pi / 4 is taken
+        // off in three parts, the first two short enough that their products with the
+        // octant count are exact up to |x| = 8192 (Cody and Waite).
+        inline float ReduceOctant(float x, int& octant) {
+            int j = int(std::fabs(x) * 1.27323954473516f);
+            j += j & 1;
+            float y = float(j);
+            float r = ((std::fabs(x) - y * 0.78515625f) - y * 2.4187564849853515625e-4f) - y * 3.77489497744594108e-8f;
+            octant = j & 7;
+            return r;
+        }
+
+        // Minimax polynomials on [-pi/4, pi/4]; the Fast ones are the Cephes sinf and cosf kernels
+        inline float SinKernel(Precision::FastPolicy, float r) {
+            float r2 = r * r;
+            return ((-1.9515295891e-4f * r2 + 8.3321608736e-3f) * r2 - 1.6666654611e-1f) * r2 * r + r;
+        }
+
+        inline float CosKernel(Precision::FastPolicy, float r) {
+            float r2 = r * r;
+            return ((2.443315711809948e-5f * r2 - 1.388731625493765e-3f) * r2 + 4.166664568298827e-2f) * r2 * r2 - 0.5f * r2 + 1.0f;
+        }
+
+        inline float SinKernel(Precision::FastestPolicy, float r) {
+            float r2 = r * r;
+            return (8.1646093e-3f * r2 - 0.16663459f) * r2 * r + r;
+        }
+
+        inline float CosKernel(Precision::FastestPolicy, float r) {
+            float r2 = r * r;
+            return (4.0488940e-2f * r2 - 0.49977631f) * r2 + 1.0f;
+        }
+
+        template<typename Precision>
+        void SinCos(Precision precision, float x, float& s, float& c) {
+            // Also false for NaN
+            if (!(std::fabs(x) <= ReduceOctantLimit)) {
+                s = std::sin(x);
+                c = std::cos(x);
+                return;
+            }
+            int octant;
+            float r = ReduceOctant(x, octant);
+            float sr = SinKernel(precision, r), cr = CosKernel(precision, r);
+            // x = octant * pi / 4 + r with an even octant; a quarter turn swaps sin and cos
+            bool swap = (octant & 2) != 0;
+            s = swap ? cr : sr;
+            c = swap ? sr : cr;
+            if (octant & 4) {
+                s = -s;
+            }
+            if ((octant + 2) & 4) {
+                c = -c;
+            }
+            if (x < 0) {
+                s = -s;
+            }
+        }
+    }
+
+    inline void SinCos(Precision::ExactPolicy, float x, float& s, float& c) {
+        s = sin(x);
+        c = cos(x);
+    }
+
+    inline void SinCos(Precision::FastPolicy precision, float x, float& s, float& c) {
+        Detail::SinCos(precision, x, s, c);
+    }
+
+    inline void SinCos(Precision::FastestPolicy precision, float x, float& s, float& c) {
+        Detail::SinCos(precision, x, s, c);
+    }
+
+    template<typename Precision>
+    void SinCos(Precision, double x, double& s, double& c) {
+        s = std::sin(x);
+        c = std::cos(x);
+    }
+
+    template<typename Precision>
+    float Sin(Precision precision, float x) {
+        float s, c;
+        SinCos(precision, x, s, c);
+        return s;
+    }
+
+    template<typename Precision>
+    float Cos(Precision precision, float x) {
+        float s, c;
+        SinCos(precision, x, s, c);
+        return c;
+    }
+}
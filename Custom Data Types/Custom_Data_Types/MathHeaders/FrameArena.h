@@ -0,0 +1,140 @@
+#pragma once
+#include "Span.h"
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <type_traits>
+
+namespace MathClasses {
+
+    // Alignment of arena allocations unless one is asked for; one cache line, which
+    // also covers 16 byte (SSE) and 32 byte (AVX) loads
+    constexpr std::size_t ArenaDefaultAlignment = 64;
+
+    // Bump allocator for per-frame temporaries. The whole buffer is allocated once;
+    // Allocate only moves an offset forward, and Reset hands everything back at the
+    // start of the next frame, so steady-state frames make no heap allocations.
+    // Nothing allocated from the arena is destroyed, so only trivially destructible
+    // types may be allocated. Not thread safe: allocate before starting parallel work.
+    // Running out of space is not an error: it returns nullptr or an empty span in every
+    // build, and callers fall back or grow the arena (see GetHighWaterMark).
+    // In _DEBUG builds released memory is filled with PoisonByte to catch stale reads.
+    class FrameArena {
+    public:
+        static constexpr unsigned char PoisonByte = 0xCD;
+
+        // Position in the arena that can be rewound to
+        struct Marker {
+            std::size_t offset;
+        };
+
+        explicit FrameArena(std::size_t capacityBytes)
+            : buffer(static_cast<unsigned char*>(::operator new(capacityBytes, std::align_val_t(ArenaDefaultAlignment)))),
+            capacity(capacityBytes)
+        {
+            Poison(0, capacity);
+        }
+
+        ~FrameArena() {
+            ::operator delete(buffer, std::align_val_t(ArenaDefaultAlignment));
+        }
+
+        FrameArena(const FrameArena&) = delete;
+        FrameArena& operator=(const FrameArena&) = delete;
+
+        // Returns bytes of raw memory aligned to alignment (a power of two no larger
+        // than ArenaDefaultAlignment), or nullptr if the arena is out of space
+        void* Allocate(std::size_t bytes, std::size_t alignment = ArenaDefaultAlignment) {
+            assert(alignment != 0 && (alignment & (alignment - 1)) == 0 && alignment <= ArenaDefaultAlignment);
+            std::size_t start = (offset + alignment - 1) & ~(alignment - 1);
+            if (start > capacity || bytes > capacity - start) {
+                return nullptr;
+            }
+            offset = start + bytes;
+            if (offset > highWaterMark) {
+                highWaterMark = offset;
+            }
+            return buffer + start;
+        }
+
+        // Returns count default constructed elements, or an empty span if out of space
+        template<typename T>
+        Span<T> Allocate(std::size_t count, std::size_t alignment = ArenaDefaultAlignment) {
+            Span<T> span = AllocateUninitialised<T>(count, alignment);
+            for (T& element : span) {
+                new (&element) T();
+            }
+            return span;
+        }
+
+        // Returns count elements whose contents are left as whatever was in the arena
+        template<typename T>
+        Span<T> AllocateUninitialised(std::size_t count, std::size_t alignment = ArenaDefaultAlignment) {
+            static_assert(std::is_trivially_destructible<T>::value, "FrameArena never runs destructors");
+            if (alignment < alignof(T)) {
+                alignment = alignof(T);
+            }
+            if (count > SIZE_MAX / sizeof(T)) {
+                return Span<T>();
+            }
+            void* memory = Allocate(count * sizeof(T), alignment);
+            if (memory == nullptr) {
+                return Span<T>();
+            }
+            return Span<T>(static_cast<T*>(memory), count);
+        }
+
+        Marker GetMarker() const {
+            return Marker{ offset };
+        }
+
+        // Releases everything allocated since the marker was taken
+        void RewindTo(Marker marker) {
+            assert(marker.offset <= offset);
+            Poison(marker.offset, offset - marker.offset);
+            offset = marker.offset;
+        }
+
+        // Releases everything; call once per frame
+        void Reset() {
+            RewindTo(Marker{ 0 });
+        }
+
+        std::size_t GetUsed() const { return offset; }
+        std::size_t GetCapacity() const { return capacity; }
+
+        // Largest number of bytes in use at once since construction, for sizing the arena
+        std::size_t GetHighWaterMark() const { return highWaterMark; }
+
+    private:
+        void Poison(std::size_t start, std::size_t bytes) {
+#ifdef _DEBUG
+            std::memset(buffer + start, PoisonByte, bytes);
+#else
+            (void)start;
+            (void)bytes;
+#endif
+        }
+
+        unsigned char* buffer;
+        std::size_t capacity;
+        std::size_t offset = 0;
+        std::size_t highWaterMark = 0;
+    };
+
+    // Releases everything allocated from an arena during its lifetime
+    class ArenaScope {
+    public:
+        explicit ArenaScope(FrameArena& arena) : arena(arena), marker(arena.GetMarker()) {}
+        ~ArenaScope() { arena.RewindTo(marker); }
+
+        ArenaScope(const ArenaScope&) = delete;
+        ArenaScope& operator=(const ArenaScope&) = delete;
+
+    private:
+        FrameArena& arena;
+        FrameArena::Marker marker;
+    };
+}
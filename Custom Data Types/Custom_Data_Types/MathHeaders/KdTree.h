@@ -0,0 +1,314 @@
+#pragma once
+#include "Vector3.h"
+#include "Simd.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace MathClasses {
+
+    // Static k-d tree over points for nearest and k nearest neighbour queries.
+    //
+    // The tree is implicit: every node splits its range of points exactly in half, so
+    // node i's children are 2i + 1 and 2i + 2 and a node's range is found by halving on
+    // the way down. Nothing is stored per node but the split plane (a float and an axis
+    // byte, in heap order), and the points themselves are reordered into x, y and z
+    // arrays with each leaf contiguous, so a leaf is scanned four points at a time.
+    class KdTree {
+    public:
+        // Leaves hold at most LeafSize points, and more than half that unless the
+        // whole tree is one leaf
+        static constexpr std::size_t LeafSize = 16;
+        static constexpr uint32_t InvalidIndex = 0xFFFFFFFFu;
+
+        KdTree() = default;
+
+        template<typename Policy>
+        KdTree(Policy policy, const Vector3* points, std::size_t count) { Build(policy, points, count); }
+
+        KdTree(const Vector3* points, std::size_t count) { Build(Execution::Seq, points, count); }
+
+        // Rebuilds the tree over a copy of the points. The split position in a node is
+        // fixed by the layout, so each node uses an exact median (nth_element); the split
+        // axis is the widest of a small sample of the node's points. Levels are built one
+        // at a time with the nodes of a level in parallel, so the first few levels,
+        // which have few nodes, are the serial part of the build.
+        template<typename Policy>
+        void Build(Policy policy, const Vector3* points, std::size_t count) {
+            depth = 0;
+            while (((count + (std::size_t(1) << depth) - 1) >> depth) > LeafSize) {
+                ++depth;
+            }
+            std::size_t internal = count == 0 ? 0 : (std::size_t(1) << depth) - 1;
+            splits.assign(internal, 0.0f);
+            axes.assign(internal, 0);
+
+            std::vector<Entry> entries(count);
+            ForEachRange(policy, count, GrainForBytes(sizeof(Entry)), [&](std::size_t begin, std::size_t end) {
+                for (std::size_t i = begin; i < end; ++i) {
+                    entries[i] = Entry{ { points[i].x, points[i].y, points[i].z }, uint32_t(i) };
+                }
+            });
+
+            for (int level = 0; level < depth; ++level) {
+                std::size_t first = (std::size_t(1) << level) - 1;
+                ForEachRange(policy, std::size_t(1) << level, 1, [&](std::size_t begin, std::size_t end) {
+                    for (std::size_t j = begin; j < end; ++j) {
+                        std::size_t low, high;
+                        NodeRange(level, j, count, low, high);
+                        SplitNode(entries.data(), low, high, first + j);
+                    }
+                });
+            }
+
+            // Padded so a leaf at the end can still be loaded four at a time
+            xs.assign(count + 3, 0.0f);
+            ys.assign(count + 3, 0.0f);
+            zs.assign(count + 3, 0.0f);
+            indices.resize(count);
+            ForEachRange(policy, count, GrainForBytes(sizeof(Entry)), [&](std::size_t begin, std::size_t end) {
+                for (std::size_t i = begin; i < end; ++i) {
+                    xs[i] = entries[i].p[0];
+                    ys[i] = entries[i].p[1];
+                    zs[i] = entries[i].p[2];
+                    indices[i] = entries[i].index;
+                }
+            });
+        }
+
+        void Build(const Vector3* points, std::size_t count) {
+            Build(Execution::Seq, points, count);
+        }
+
+        std::size_t GetCount() const { return indices.size(); }
+
+        // Levels of splits above the leaves
+        int GetDepth() const { return depth; }
+
+        // Index of the closest point, or InvalidIndex for an empty tree. Ties go to
+        // whichever point is reached first.
+        uint32_t FindNearest(const Vector3& query, float* distanceSq = nullptr) const {
+            float best = INFINITY;
+            uint32_t found = InvalidIndex;
+            Search(query, [&](float d2, std::size_t slot) {
+                // The first point is taken even if its distance overflowed to infinity
+                if (d2 < best || found == InvalidIndex) {
+                    best = d2;
+                    found = uint32_t(slot);
+                }
+                return best;
+            });
+            if (distanceSq) {
+                *distanceSq = found == InvalidIndex ? FLT_MAX : best;
+            }
+            return found == InvalidIndex ? InvalidIndex : indices[found];
+        }
+
+        // The k closest points, nearest first, written to nearest and (if not null)
+        // distancesSq. Returns how many were found, which is k unless the tree holds
+        // fewer points. Candidates are kept in a sorted array, so this is meant for
+        // small k.
+        std::size_t FindKNearest(const Vector3& query, std::size_t k, uint32_t* nearest, float* distancesSq = nullptr) const {
+            if (k == 0) {
+                return 0;
+            }
+            constexpr std::size_t StackK = 32;
+            float stackDistances[StackK];
+            std::vector<float> heapDistances;
+            float* d = distancesSq;
+            if (!d) {
+                if (k > StackK) {
+                    heapDistances.resize(k);
+                }
+                d = k > StackK ? heapDistances.data() : stackDistances;
+            }
+
+            std::size_t found = 0;
+            Search(query, [&](float d2, std::size_t slot) {
+                if (found == k && d2 >= d[k - 1]) {
+                    return d[k - 1];
+                }
+                std::size_t i = found < k ? found++ : k - 1;
+                for (; i > 0 && d[i - 1] > d2; --i) {
+                    d[i] = d[i - 1];
+                    nearest[i] = nearest[i - 1];
+                }
+                d[i] = d2;
+                nearest[i] = uint32_t(slot);
+                return found == k ? d[k - 1] : INFINITY;
+            });
+            for (std::size_t i = 0; i < found; ++i) {
+                nearest[i] = indices[nearest[i]];
+            }
+            return found;
+        }
+
+    private:
+        struct Entry {
+            float p[3];
+            uint32_t index;
+        };
+
+        // Points [low, high) of node j on the given level. Each level halves the range,
+        // rounding the left half down.
+        static void NodeRange(int level, std::size_t j, std::size_t count, std::size_t& low, std::size_t& high) {
+            low = 0;
+            high = count;
+            for (int l = level - 1; l >= 0; --l) {
+                std::size_t mid = low + (high - low) / 2;
+                if ((j >> l) & 1) {
+                    low = mid;
+                } else {
+                    high = mid;
+                }
+            }
+        }
+
+        // Widest axis of up to 32 evenly spaced points, then an exact median on it
+        void SplitNode(Entry* entries, std::size_t low, std::size_t high, std::size_t node) {
+            std::size_t size = high - low;
+            std::size_t step = size > 32 ? size / 32 : 1;
+            float lo[3] = { FLT_MAX, FLT_MAX, FLT_MAX }, hi[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+            for (std::size_t i = low; i < high; i += step) {
+                for (int a = 0; a < 3; ++a) {
+                    lo[a] = std::min(lo[a], entries[i].p[a]);
+                    hi[a] = std::max(hi[a], entries[i].p[a]);
+                }
+            }
+            int axis = 0;
+            for (int a = 1; a < 3; ++a) {
+                if (hi[a] - lo[a] > hi[axis] - lo[axis]) {
+                    axis = a;
+                }
+            }
+
+            std::size_t mid = low + size / 2;
+            std::nth_element(entries + low, entries + mid, entries + high, [axis](const Entry& a, const Entry& b) {
+                return a.p[axis] < b.p[axis];
+            });
+            splits[node] = entries[mid].p[axis];
+            axes[node] = uint8_t(axis);
+        }
+
+        // Depth first, nearer child first. Every point that could be as close as the
+        // current bound is passed to visit(distanceSq, slot), which returns the new
+        // bound; visit rejects ties itself. The bound starts at infinity and points at
+        // it are still visited, so distances that overflow are found too. Far children
+        // are skipped when the distance to their split plane is already beyond it.
+        template<typename Visit>
+        void Search(const Vector3& query, Visit&& visit) const {
+            std::size_t count = indices.size();
+            if (count == 0) {
+                return;
+            }
+            struct Frame {
+                std::size_t node, low, high;
+                float boundSq;
+            };
+            Frame stack[64];
+            int top = 0;
+            stack[top++] = Frame{ 0, 0, count, 0.0f };
+            std::size_t internal = splits.size();
+            float q[3] = { query.x, query.y, query.z };
+            Float4 qx(query.x), qy(query.y), qz(query.z);
+            Float4 lanes(0.0f, 1.0f, 2.0f, 3.0f);
+            float bound = INFINITY;
+
+            while (top > 0) {
+                Frame f = stack[--top];
+                if (f.boundSq > bound) {
+                    continue;
+                }
+                while (f.node < internal) {
+                    float diff = q[axes[f.node]] - splits[f.node];
+                    std::size_t mid = f.low + (f.high - f.low) / 2;
+                    float farBound = std::max(f.boundSq, diff * diff);
+                    Frame left{ 2 * f.node + 1, f.low, mid, f.boundSq }, right{ 2 * f.node + 2, mid, f.high, f.boundSq };
+                    if (diff < 0) {
+                        right.boundSq = farBound;
+                        stack[top++] = right;
+                        f = left;
+                    } else {
+                        left.boundSq = farBound;
+                        stack[top++] = left;
+                        f = right;
+                    }
+                }
+
+                for (std::size_t i = f.low; i < f.high; i += 4) {
+                    Float4 dx = Float4::LoadUnaligned(&xs[i]) - qx;
+                    Float4 dy = Float4::LoadUnaligned(&ys[i]) - qy;
+                    Float4 dz = Float4::LoadUnaligned(&zs[i]) - qz;
+                    Float4 d2 = dx * dx + dy * dy + dz * dz;
+                    Float4 closer = (lanes < Float4(float(f.high - i))) & (d2 <= Float4(bound));
+                    int mask = MoveMask(closer);
+                    while (mask) {
+                        int lane = 0;
+                        while (!((mask >> lane) & 1)) {
+                            ++lane;
+                        }
+                        mask &= mask - 1;
+                        if (d2[lane] <= bound) {
+                            bound = visit(d2[lane], i + lane);
+                        }
+                    }
+                }
+            }
+        }
+
+        int depth = 0;
+        std::vector<float> splits;
+        std::vector<uint8_t> axes;
+        std::vector<float> xs, ys, zs;
+        std::vector<uint32_t> indices;
+    };
+
+    // KdTree::FindNearest for each query. distancesSq may be null.
+    template<typename Policy>
+    void FindNearest(Policy policy, const KdTree& tree, const Vector3* queries, std::size_t count,
+        uint32_t* nearest, float* distancesSq)
+    {
+        ForEachRange(policy, count, GrainForBytes(sizeof(Vector3) + sizeof(uint32_t) + sizeof(float)),
+            [&](std::size_t begin, std::size_t end) {
+                for (std::size_t i = begin; i < end; ++i) {
+                    nearest[i] = tree.FindNearest(queries[i], distancesSq ? distancesSq + i : nullptr);
+                }
+            });
+    }
+
+    inline void FindNearest(const KdTree& tree, const Vector3* queries, std::size_t count, uint32_t* nearest, float* distancesSq) {
+        FindNearest(Execution::Seq, tree, queries, count, nearest, distancesSq);
+    }
+
+    // KdTree::FindKNearest for each query. Query i writes k entries from nearest + i * k
+    // (and distancesSq + i * k if not null); slots past the number of points in the
+    // tree get InvalidIndex and FLT_MAX.
+    template<typename Policy>
+    void FindKNearest(Policy policy, const KdTree& tree, const Vector3* queries, std::size_t count, std::size_t k,
+        uint32_t* nearest, float* distancesSq)
+    {
+        ForEachRange(policy, count, GrainForBytes(sizeof(Vector3) + k * (sizeof(uint32_t) + sizeof(float))),
+            [&](std::size_t begin, std::size_t end) {
+                for (std::size_t i = begin; i < end; ++i) {
+                    float* d = distancesSq ? distancesSq + i * k : nullptr;
+                    std::size_t found = tree.FindKNearest(queries[i], k, nearest + i * k, d);
+                    for (std::size_t j = found; j < k; ++j) {
+                        nearest[i * k + j] = KdTree::InvalidIndex;
+                        if (d) {
+                            d[j] = FLT_MAX;
+                        }
+                    }
+                }
+            });
+    }
+
+    inline void FindKNearest(const KdTree& tree, const Vector3* queries, std::size_t count, std::size_t k,
+        uint32_t* nearest, float* distancesSq)
+    {
+        FindKNearest(Execution::Seq, tree, queries, count, k, nearest, distancesSq);
+    }
+}
@@ -0,0 +1,157 @@
+#pragma once
+#include "Matrix4.h"
+#include "FrameArena.h"
+#include "Vector3.h"
+#include "Simd.h"
+#include "ThreadPool.h"
+#include <cmath>
+#include <cstddef>
+
+namespace MathClasses {
+
+    // Large worlds keep positions in double (Vector3d, Matrix4d) and hand the float code
+    // positions relative to an origin near the camera. A float has about 4 mm of spacing
+    // at 50 km but well under a millimetre within a kilometre, so rebasing each frame
+    // keeps what is near the camera precise however far it is from the world origin.
+    // The subtraction is done in double, and only the small result is rounded to float.
+    class WorldOrigin {
+    public:
+        WorldOrigin() = default;
+        explicit WorldOrigin(const Vector3d& position) : position(position) {}
+
+        const Vector3d& GetPosition() const { return position; }
+
+        // Moves the origin to the camera, once per frame. With a grid spacing it snaps to
+        // the nearest grid point instead, so it only moves when the camera crosses into
+        // another cell and float data rebased earlier stays valid until then. Returns
+        // whether the origin moved.
+        bool Follow(const Vector3d& camera, double gridSpacing = 0) {
+            Vector3d target = camera;
+            if (gridSpacing > 0) {
+                target = Vector3d(std::round(camera.x / gridSpacing) * gridSpacing,
+                    std::round(camera.y / gridSpacing) * gridSpacing,
+                    std::round(camera.z / gridSpacing) * gridSpacing);
+            }
+            bool moved = target.x != position.x || target.y != position.y || target.z != position.z;
+            position = target;
+            return moved;
+        }
+
+        Vector3 ToLocal(const Vector3d& world) const {
+            return Vector3(world - position);
+        }
+
+        Vector3d ToWorld(const Vector3& local) const {
+            return Vector3d(local) + position;
+        }
+
+        // A world transform moved to the origin: MakeTranslation(-origin) * world
+        Matrix4 ToLocal(const Matrix4d& world) const;
+
+        // The float view matrix for local positions: view * MakeTranslation(origin). With
+        // the origin at the camera its translation is near zero.
+        Matrix4 ToLocalView(const Matrix4d& view) const {
+            return Matrix4(view * Matrix4d::MakeTranslation(position));
+        }
+
+    private:
+        Vector3d position;
+    };
+
+    namespace Detail {
+        // Four points are twelve doubles, six registers, and round to three registers of
+        // floats. The origin repeats every three doubles, so three registers hold it.
+        inline void RebasePositionsKernel(const WorldOrigin& origin, const Vector3d* world, Vector3* local, std::size_t count) {
+            const Vector3d& o = origin.GetPosition();
+            Double2 o0(o.x, o.y), o1(o.z, o.x), o2(o.y, o.z);
+            std::size_t i = 0;
+            for (; i + 4 <= count; i += 4) {
+                const double* in = &world[i].x;
+                float* out = &local[i].x;
+                ToFloat4(Double2::LoadUnaligned(in) - o0, Double2::LoadUnaligned(in + 2) - o1).StoreUnaligned(out);
+                ToFloat4(Double2::LoadUnaligned(in + 4) - o2, Double2::LoadUnaligned(in + 6) - o0).StoreUnaligned(out + 4);
+                ToFloat4(Double2::LoadUnaligned(in + 8) - o1, Double2::LoadUnaligned(in + 10) - o2).StoreUnaligned(out + 8);
+            }
+            for (; i < count; ++i) {
+                local[i] = origin.ToLocal(world[i]);
+            }
+        }
+
+        // Row r of the result is row r minus origin[r] times the bottom row, which for an
+        // affine transform only moves the translation. Each row is two registers.
+        inline void RebaseTransformsKernel(const WorldOrigin& origin, const Matrix4d* world, Matrix4* local, std::size_t count) {
+            const Vector3d& o = origin.GetPosition();
+            for (std::size_t i = 0; i < count; ++i) {
+                const double* in = &world[i].m1;
+                float* out = &local[i].m1;
+                Double2 bottomLo = Double2::LoadUnaligned(in + 12), bottomHi = Double2::LoadUnaligned(in + 14);
+                for (int r = 0; r < 3; ++r) {
+                    Double2 shift(o[r]);
+                    ToFloat4(Double2::LoadUnaligned(in + 4 * r) - shift * bottomLo,
+                        Double2::LoadUnaligned(in + 4 * r + 2) - shift * bottomHi).StoreUnaligned(out + 4 * r);
+                }
+                ToFloat4(bottomLo, bottomHi).StoreUnaligned(out + 12);
+            }
+        }
+    }
+
+    inline Matrix4 WorldOrigin::ToLocal(const Matrix4d& world) const {
+        Matrix4 local;
+        Detail::RebaseTransformsKernel(*this, &world, &local, 1);
+        return local;
+    }
+
+    // Positions relative to the origin, rounded to float: local[i] = origin.ToLocal(world[i]).
+    // Results are identical to the scalar version unless the compiler contracts to FMA
+    // (see Simd.h).
+    template<typename Policy>
+    void RebasePositions(Policy policy, const WorldOrigin& origin, const Vector3d* world, Vector3* local, std::size_t count) {
+        ForEachRange(policy, count, GrainForBytes(sizeof(Vector3d) + sizeof(Vector3)), [&](std::size_t begin, std::size_t end) {
+            Detail::RebasePositionsKernel(origin, world + begin, local + begin, end - begin);
+        });
+    }
+
+    inline void RebasePositions(const WorldOrigin& origin, const Vector3d* world, Vector3* local, std::size_t count) {
+        RebasePositions(Execution::Seq, origin, world, local, count);
+    }
+
+    // Local positions from a FrameArena; empty if the arena can't fit them
+    template<typename Policy>
+    Span<Vector3> RebasePositions(Policy policy, FrameArena& arena, const WorldOrigin& origin, const Vector3d* world, std::size_t count) {
+        Span<Vector3> local = arena.AllocateUninitialised<Vector3>(count);
+        if (local.Size() == count) {
+            RebasePositions(policy, origin, world, local.Data(), count);
+        }
+        return local;
+    }
+
+    inline Span<Vector3> RebasePositions(FrameArena& arena, const WorldOrigin& origin, const Vector3d* world, std::size_t count) {
+        return RebasePositions(Execution::Seq, arena, origin, world, count);
+    }
+
+    // World transforms relative to the origin, rounded to float, ready for the float
+    // batch kernels: local[i] = origin.ToLocal(world[i])
+    template<typename Policy>
+    void RebaseTransforms(Policy policy, const WorldOrigin& origin, const Matrix4d* world, Matrix4* local, std::size_t count) {
+        ForEachRange(policy, count, GrainForBytes(sizeof(Matrix4d) + sizeof(Matrix4)), [&](std::size_t begin, std::size_t end) {
+            Detail::RebaseTransformsKernel(origin, world + begin, local + begin, end - begin);
+        });
+    }
+
+    inline void RebaseTransforms(const WorldOrigin& origin, const Matrix4d* world, Matrix4* local, std::size_t count) {
+        RebaseTransforms(Execution::Seq, origin, world, local, count);
+    }
+
+    template<typename Policy>
+    Span<Matrix4> RebaseTransforms(Policy policy, FrameArena& arena, const WorldOrigin& origin, const Matrix4d* world, std::size_t count) {
+        Span<Matrix4> local = arena.AllocateUninitialised<Matrix4>(count);
+        if (local.Size() == count) {
+            RebaseTransforms(policy, origin, world, local.Data(), count);
+        }
+        return local;
+    }
+
+    inline Span<Matrix4> RebaseTransforms(FrameArena& arena, const WorldOrigin& origin, const Matrix4d* world, std::size_t count) {
+        return RebaseTransforms(Execution::Seq, arena, origin, world, count);
+    }
+}
@@ -0,0 +1,105 @@
+#pragma once
+#include "Vector.h"
+#include <cmath>
+#include <string>
+
+namespace MathClasses {
+
+    // An R x C matrix of T. Matrix3.h and Matrix4.h specialise the square 3 and 4 sizes
+    // with the named m1.. members; Matrix3 and Matrix4 are the float versions and
+    // Matrix3d and Matrix4d the double ones. This general version is stored a row at a
+    // time, as they are, and multiplies column vectors.
+    template<typename T, int R, int C>
+    struct Matrix {
+        static_assert(R > 0 && C > 0, "A matrix needs at least one row and column");
+
+        T m[R][C];
+
+        Matrix() : m() {}
+
+        // Converts from a matrix of another value type
+        template<typename U>
+        explicit Matrix(const Matrix<U, R, C>& other) {
+            for (int r = 0; r < R; ++r) {
+                for (int c = 0; c < C; ++c) {
+                    m[r][c] = T(other(r, c));
+                }
+            }
+        }
+
+        T& operator()(int row, int column) { return m[row][column]; }
+        const T& operator()(int row, int column) const { return m[row][column]; }
+
+        template<int K>
+        Matrix<T, R, K> operator*(const Matrix<T, C, K>& other) const {
+            Matrix<T, R, K> result;
+            for (int r = 0; r < R; ++r) {
+                for (int k = 0; k < K; ++k) {
+                    T sum = T(0);
+                    for (int c = 0; c < C; ++c) {
+                        sum += m[r][c] * other(c, k);
+                    }
+                    result(r, k) = sum;
+                }
+            }
+            return result;
+        }
+
+        Vector<T, R> operator*(const Vector<T, C>& vec) const {
+            Vector<T, R> result;
+            for (int r = 0; r < R; ++r) {
+                T sum = T(0);
+                for (int c = 0; c < C; ++c) {
+                    sum += m[r][c] * vec[c];
+                }
+                result[r] = sum;
+            }
+            return result;
+        }
+
+        Matrix<T, C, R> Transposed() const {
+            Matrix<T, C, R> result;
+            for (int r = 0; r < R; ++r) {
+                for (int c = 0; c < C; ++c) {
+                    result(c, r) = m[r][c];
+                }
+            }
+            return result;
+        }
+
+        static Matrix MakeIdentity() {
+            static_assert(R == C, "Only square matrices have an identity");
+            Matrix result;
+            for (int i = 0; i < R; ++i) {
+                result.m[i][i] = T(1);
+            }
+            return result;
+        }
+
+        bool operator==(const Matrix& other) const {
+            for (int r = 0; r < R; ++r) {
+                for (int c = 0; c < C; ++c) {
+                    if (!Detail::NearlyEqual(m[r][c], other.m[r][c])) {
+                        return false;
+                    }
+                }
+            }
+            return true;
+        }
+
+        bool operator!=(const Matrix& other) const {
+            return !(*this == other);
+        }
+
+        // Column by column, as the specialisations print theirs
+        std::string ToString() const {
+            std::string result;
+            for (int c = 0; c < C; ++c) {
+                for (int r = 0; r < R; ++r) {
+                    result += (r == 0 && c == 0 ? "" : ", ") + std::to_string(m[r][c]);
+                }
+            }
+            return result;
+        }
+    };
+}
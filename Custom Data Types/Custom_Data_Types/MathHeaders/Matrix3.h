@@ -1,23 +1,28 @@
 #pragma once
+#include "Matrix.h"
 #include "Vector3.h"
+#include "FastMath.h"
+#include "TrigTable.h"
 #include <string>
 #include <cmath>
 
 namespace MathClasses {
-	struct Matrix3 {
-		float m1, m4, m7; // First column
-		float m2, m5, m8; // Second column
-		float m3, m6, m9; // Third column
-
-		Matrix3() : 
+	// 3x3 matrix; Matrix3 is the float version (see Matrix.h)
+	template<typename T>
+	struct Matrix<T, 3, 3> {
+		T m1, m4, m7; // First column
+		T m2, m5, m8; // Second column
+		T m3, m6, m9; // Third column
+
+		Matrix() : 
 			m1(0), m2(0), m3(0), 
 			m4(0), m5(0), m6(0), 
 			m7(0), m8(0), m9(0) 
 		{}
 
-		Matrix3(float m1, float m2, float m3, 
-			float m4, float m5, float m6, 
-			float m7, float m8, float m9)
+		Matrix(T m1, T m2, T m3, 
+			T m4, T m5, T m6, 
+			T m7, T m8, T m9)
 			: 
 			m1(m1), m2(m2), m3(m3), 
 			m4(m4), m5(m5), m6(m6), 
@@ -25,16 +30,38 @@ namespace MathClasses {
 		{}
 
 
+		// Converts from a matrix of another value type, e.g. a Matrix3d to a Matrix3
+		template<typename U>
+		explicit Matrix(const Matrix<U, 3, 3>& other) :
+			m1(T(other.m1)), m4(T(other.m4)), m7(T(other.m7)),
+			m2(T(other.m2)), m5(T(other.m5)), m8(T(other.m8)),
+			m3(T(other.m3)), m6(T(other.m6)), m9(T(other.m9))
+		{}
+
 		// Constructor from array
-		explicit Matrix3(const float arr[])
+		explicit Matrix(const T arr[])
 			: 
 			m1(arr[0]), m4(arr[3]), m7(arr[6]),
 			m2(arr[1]), m5(arr[4]), m8(arr[7]),
 			m3(arr[2]), m6(arr[5]), m9(arr[8]) {}
 
+		// Element at a row and column, for code written for any size of Matrix
+		T& operator()(int row, int column) { return this->*Element(row * 3 + column); }
+		const T& operator()(int row, int column) const { return this->*Element(row * 3 + column); }
+
+		// Member at each storage index; the elements are separate members, so
+		// indexing goes through member pointers rather than pointer arithmetic off &m1
+		static T Matrix::* Element(int i) {
+			static constexpr T Matrix::* elements[] = {
+				&Matrix::m1, &Matrix::m4, &Matrix::m7,
+				&Matrix::m2, &Matrix::m5, &Matrix::m8,
+				&Matrix::m3, &Matrix::m6, &Matrix::m9 };
+			return elements[i];
+		}
+
 		// Operator overloads for matrix-matrix multiplication
-		Matrix3 operator*(const Matrix3& other) const {
-			return Matrix3(
+		Matrix operator*(const Matrix& other) const {
+			return Matrix(
 				m1 * other.m1 + m4 * other.m2 + m7 * other.m3,
 				m2 * other.m1 + m5 * other.m2 + m8 * other.m3,
 				m3 * other.m1 + m6 * other.m2 + m9 * other.m3,
@@ -48,8 +75,8 @@ namespace MathClasses {
 		}
 
 		// Operator overload for matrix-vector multiplication
-		Vector3 operator*(const Vector3& vec) const {
-			return Vector3(
+		Vector<T, 3> operator*(const Vector<T, 3>& vec) const {
+			return Vector<T, 3>(
 				m1 * vec.x + m4 * vec.y + m7 * vec.z,
 				m2 * vec.x + m5 * vec.y + m8 * vec.z,
 				m3 * vec.x + m6 * vec.y + m9 * vec.z
@@ -57,13 +84,13 @@ namespace MathClasses {
 		}
 
 		// Make an identity matrix
-		static Matrix3 MakeIdentity() {
+		static Matrix MakeIdentity() {
 			return { 1, 0, 0, 0, 1, 0, 0, 0, 1 };
 		}
 
 		// Transpose the matrix
-		Matrix3 Transposed() const {
-			return Matrix3(
+		Matrix Transposed() const {
+			return Matrix(
 				m1, m4, m7,
 				m2, m5, m8,
 				m3, m6, m9
@@ -71,83 +98,141 @@ namespace MathClasses {
 		}
 
 		// Rotate around X-axis
-		static Matrix3 MakeRotateX(float radians) {
-			return Matrix3(
+		static Matrix MakeRotateX(T radians) {
+			return MakeRotateX(Precision::Exact, radians);
+		}
+
+		// Rotate around Y-axis
+		static Matrix MakeRotateY(T radians) {
+			return MakeRotateY(Precision::Exact, radians);
+		}
+
+		// Rotate around Z-axis
+		static Matrix MakeRotateZ(T radians) {
+			return MakeRotateZ(Precision::Exact, radians);
+		}
+
+		// Rotations with sin and cos at a chosen precision (see FastMath.h)
+		template<typename Precision>
+		static Matrix MakeRotateX(Precision precision, T radians) {
+			T s, c;
+			SinCos(precision, radians, s, c);
+			return Matrix(
 				1, 0, 0,
-				0, cos(radians), sin(radians),
-				0, -sin(radians), cos(radians)
+				0, c, s,
+				0, -s, c
 			);
 		}
 
-		// Rotate around Y-axis
-		static Matrix3 MakeRotateY(float radians) {
-			return Matrix3(
-				cos(radians), 0, -sin(radians),
+		template<typename Precision>
+		static Matrix MakeRotateY(Precision precision, T radians) {
+			T s, c;
+			SinCos(precision, radians, s, c);
+			return Matrix(
+				c, 0, -s,
 				0, 1, 0,
-				sin(radians), 0, cos(radians)
+				s, 0, c
 			);
 		}
 
-		// Rotate around Z-axis
-		static Matrix3 MakeRotateZ(float radians) {
-			return Matrix3(
-				cos(radians), -sin(radians), 0,
-				sin(radians), cos(radians), 0,
+		template<typename Precision>
+		static Matrix MakeRotateZ(Precision precision, T radians) {
+			T s, c;
+			SinCos(precision, radians, s, c);
+			return Matrix(
+				c, -s, 0,
+				s, c, 0,
 				0, 0, 1
 			);
 		}
 
 		// Euler rotations
-		static Matrix3 MakeEuler(float pitch, float yaw, float roll) {
-			Matrix3 x = MakeRotateX(pitch);
-			Matrix3 y = MakeRotateY(yaw);
-			Matrix3 z = MakeRotateZ(roll);
-			return (z * y * x);
+		static Matrix MakeEuler(T pitch, T yaw, T roll) {
+			return MakeEuler(Precision::Exact, pitch, yaw, roll);
 		}
 
-		static Matrix3 MakeEuler(const Vector3& v) {
+		static Matrix MakeEuler(const Vector<T, 3>& v) {
 			return MakeEuler(v.x, v.y, v.z);
 		}
 
+		template<typename Precision>
+		static Matrix MakeEuler(Precision precision, T pitch, T yaw, T roll) {
+			Matrix x = MakeRotateX(precision, pitch);
+			Matrix y = MakeRotateY(precision, yaw);
+			Matrix z = MakeRotateZ(precision, roll);
+			return (z * y * x);
+		}
+
 		// Scaling matrices
-		static Matrix3 MakeScale(float xScale, float yScale, float zScale) {
-			return Matrix3(xScale, 0.0f, 0.0f,
+		static Matrix MakeScale(T xScale, T yScale, T zScale) {
+			return Matrix(xScale, 0.0f, 0.0f,
 				0.0f, yScale, 0.0f,
 				0.0f, 0.0f, zScale);
 		}
 
-		static Matrix3 MakeScale(float xScale, float yScale) {
-			return Matrix3(
+		static Matrix MakeScale(T xScale, T yScale) {
+			return Matrix(
 				xScale, 0.0f, 0.0f,
 				0.0f, yScale, 0.0f,
 				0.0f, 0.0f, 1.0f);
 		}
 
-		static Matrix3 MakeScale(const Vector3& v) {
+		static Matrix MakeScale(const Vector<T, 3>& v) {
 			return MakeScale(v.x, v.y, v.z);
 		}
 
 
-		static Matrix3 MakeRotation(float radians) {
-			float c = cos(radians);
-			float s = sin(radians);
-			return Matrix3(c, s, 0, -s, c, 0, 0, 0, 1);
+		static Matrix MakeRotation(T radians) {
+			return MakeRotation(Precision::Exact, radians);
+		}
+
+		template<typename Precision>
+		static Matrix MakeRotation(Precision precision, T radians) {
+			T s, c;
+			SinCos(precision, radians, s, c);
+			return Matrix(c, s, 0, -s, c, 0, 0, 0, 1);
+		}
+
+		// Rotations by angles in 1/4096 of a turn, read from SinCosTable with no trig calls
+		static Matrix MakeRotationQuantised(uint32_t angle) {
+			float s, c;
+			SinCosTable::Get().Lookup(angle, s, c);
+			return Matrix(c, s, 0, -s, c, 0, 0, 0, 1);
 		}
 
-		void Set(float m1, float m2, float m3, float m4, float m5, float m6, float m7, float m8, float m9) {
+		static Matrix MakeRotateZQuantised(uint32_t angle) {
+			float s, c;
+			SinCosTable::Get().Lookup(angle, s, c);
+			return Matrix(
+				c, -s, 0,
+				s, c, 0,
+				0, 0, 1
+			);
+		}
+
+		// As MakeRotation, interpolating the table for angles between steps. The table is
+		// float, so for Matrix3d the angle is narrowed to float and the result only has
+		// float accuracy.
+		static Matrix MakeRotationInterpolated(T radians) {
+			float s, c;
+			SinCosTable::Get().LookupInterpolated(radians, s, c);
+			return Matrix(c, s, 0, -s, c, 0, 0, 0, 1);
+		}
+
+		void Set(T m1, T m2, T m3, T m4, T m5, T m6, T m7, T m8, T m9) {
 			this->m1 = m1; this->m2 = m2; this->m3 = m3;
 			this->m4 = m4; this->m5 = m5; this->m6 = m6;
 			this->m7 = m7; this->m8 = m8; this->m9 = m9;
 		}
 
-		void Set(const Matrix3& m) {
+		void Set(const Matrix& m) {
 			this->m1 = m.m1; this->m2 = m.m2; this->m3 = m.m3;
 			this->m4 = m.m4; this->m5 = m.m5; this->m6 = m.m6;
 			this->m7 = m.m7; this->m8 = m.m8; this->m9 = m.m9;
 		}
 
-		static Matrix3 MakeTranslation(float x, float y) {
-			return Matrix3(
+		static Matrix MakeTranslation(T x, T y) {
+			return Matrix(
 				1, 0, 0, 
 				0, 1, 0, 
 				x, y, 1);
@@ -155,17 +240,17 @@ namespace MathClasses {
 
 
 		// Translation matrix from floats with z component
-		static Matrix3 MakeTranslation(float tx, float ty, float tz) {
-			return Matrix3(
+		static Matrix MakeTranslation(T tx, T ty, T tz) {
+			return Matrix(
 				1.0f, 0.0f, 0.0f,
 				0.0f, 1.0f, 0.0f,
 				tx, ty, tz
 			);
 		}
 
-		// Translation matrix from a Vector3
-		static Matrix3 MakeTranslation(const Vector3& v) {
-			return Matrix3(
+		// Translation matrix from a Vector<T, 3>
+		static Matrix MakeTranslation(const Vector<T, 3>& v) {
+			return Matrix(
 				1.0f, 0.0f, 0.0f,
 				0.0f, 1.0f, 0.0f,
 				v.x, v.y, v.z
@@ -173,43 +258,42 @@ namespace MathClasses {
 		}
 
 		// Get translation vector
-		Vector3 GetTranslation() const {
-			return Vector3(m7, m8, 0.0f);
+		Vector<T, 3> GetTranslation() const {
+			return Vector<T, 3>(m7, m8, 0);
 		}
 
-		void SetTranslation(float x, float y) {
+		void SetTranslation(T x, T y) {
 			m7 = x;
 			m8 = y;
 		}
 
-		void Translate(float x, float y) {
+		void Translate(T x, T y) {
 			m7 += x;
 			m8 += y;
 		}
 
-		bool operator==(const Matrix3& other) const {
-			const float EPSILON = 0.0001f;
-			return (std::fabs(m1 - other.m1) < EPSILON) &&
-				(std::fabs(m2 - other.m2) < EPSILON) &&
-				(std::fabs(m3 - other.m3) < EPSILON) &&
-				(std::fabs(m4 - other.m4) < EPSILON) &&
-				(std::fabs(m5 - other.m5) < EPSILON) &&
-				(std::fabs(m6 - other.m6) < EPSILON) &&
-				(std::fabs(m7 - other.m7) < EPSILON) &&
-				(std::fabs(m8 - other.m8) < EPSILON) &&
-				(std::fabs(m9 - other.m9) < EPSILON);
+		bool operator==(const Matrix& other) const {
+			return Detail::NearlyEqual(m1, other.m1) &&
+				Detail::NearlyEqual(m2, other.m2) &&
+				Detail::NearlyEqual(m3, other.m3) &&
+				Detail::NearlyEqual(m4, other.m4) &&
+				Detail::NearlyEqual(m5, other.m5) &&
+				Detail::NearlyEqual(m6, other.m6) &&
+				Detail::NearlyEqual(m7, other.m7) &&
+				Detail::NearlyEqual(m8, other.m8) &&
+				Detail::NearlyEqual(m9, other.m9);
 		}
 
-		void RotateZ(float radians) {
+		void RotateZ(T radians) {
 			*this = *this * MakeRotation(radians);
 		}
 
-		void Scale(float x, float y) {
+		void Scale(T x, T y) {
 			*this = *this * MakeScale(x, y);
 		}
 
 		// Inequality operator
-		bool operator!=(const Matrix3& other) const {
+		bool operator!=(const Matrix& other) const {
 			return !(*this == other);
 		}
 
@@ -220,4 +304,7 @@ namespace MathClasses {
 				std::to_string(m7) + ", " + std::to_string(m8) + ", " + std::to_string(m9);
 		}
 	};
-}
+
+	using Matrix3 = Matrix<float, 3, 3>;
+	using Matrix3d = Matrix<double, 3, 3>;
+}
\ No newline at end of file
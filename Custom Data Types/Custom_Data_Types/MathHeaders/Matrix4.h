@@ -1,40 +1,53 @@
 #pragma once
+#include "Matrix.h"
 #include "Vector4.h"
 #include "Vector3.h"
+#include "Matrix3.h"
+#include "FastMath.h"
 #include <string>
 #include <cmath>
 
 namespace MathClasses {
-    struct Matrix4 {
-        float m1, m5, m9, m13;  // First column
-        float m2, m6, m10, m14; // Second column
-        float m3, m7, m11, m15; // Third column
-        float m4, m8, m12, m16; // Fourth column
+    struct Quaternion;
+
+    // 4x4 matrix; Matrix4 is the float version (see Matrix.h)
+    template<typename T>
+    struct Matrix<T, 4, 4> {
+        T m1, m5, m9, m13;  // First column
+        T m2, m6, m10, m14; // Second column
+        T m3, m7, m11, m15; // Third column
+        T m4, m8, m12, m16; // Fourth column
 
         // Default constructor
-        Matrix4() :
+        Matrix() :
             m1(0), m5(0), m9(0), m13(0),
             m2(0), m6(0), m10(0), m14(0),
             m3(0), m7(0), m11(0), m15(0),
             m4(0), m8(0), m12(0), m16(0)
         {}
 
-        // Destructor
-        ~Matrix4() {}
-
         // Parameterized constructor for individual floats
-        Matrix4(float a1, float a5, float a9, float a13,
-            float a2, float a6, float a10, float a14,
-            float a3, float a7, float a11, float a15,
-            float a4, float a8, float a12, float a16)
+        Matrix(T a1, T a5, T a9, T a13,
+            T a2, T a6, T a10, T a14,
+            T a3, T a7, T a11, T a15,
+            T a4, T a8, T a12, T a16)
             : m1(a1), m2(a5), m3(a9), m4(a13),  // First column
             m5(a2), m6(a6), m7(a10), m8(a14),  // Second column
             m9(a3), m10(a7), m11(a11), m12(a15),  // Third column
             m13(a4), m14(a8), m15(a12), m16(a16) // Fourth column
         {}
 
+        // Converts from a matrix of another value type, e.g. a Matrix4d to a Matrix4
+        template<typename U>
+        explicit Matrix(const Matrix<U, 4, 4>& other) :
+            m1(T(other.m1)), m5(T(other.m5)), m9(T(other.m9)), m13(T(other.m13)),
+            m2(T(other.m2)), m6(T(other.m6)), m10(T(other.m10)), m14(T(other.m14)),
+            m3(T(other.m3)), m7(T(other.m7)), m11(T(other.m11)), m15(T(other.m15)),
+            m4(T(other.m4)), m8(T(other.m8)), m12(T(other.m12)), m16(T(other.m16))
+        {}
+
         // Constructor from array
-        explicit Matrix4(const float arr[])
+        explicit Matrix(const T arr[])
             :
             m1(arr[0]), m2(arr[1]), m3(arr[2]), m4(arr[3]),
             m5(arr[4]), m6(arr[5]), m7(arr[6]), m8(arr[7]),
@@ -42,9 +55,23 @@ namespace MathClasses {
             m13(arr[12]), m14(arr[13]), m15(arr[14]), m16(arr[15])
         {}
 
+        // Element at a row and column, for code written for any size of Matrix
+        T& operator()(int row, int column) { return this->*Element(row * 4 + column); }
+        const T& operator()(int row, int column) const { return this->*Element(row * 4 + column); }
+
+        // Member at each storage index (see Matrix3.h)
+        static T Matrix::* Element(int i) {
+            static constexpr T Matrix::* elements[] = {
+                &Matrix::m1, &Matrix::m5, &Matrix::m9, &Matrix::m13,
+                &Matrix::m2, &Matrix::m6, &Matrix::m10, &Matrix::m14,
+                &Matrix::m3, &Matrix::m7, &Matrix::m11, &Matrix::m15,
+                &Matrix::m4, &Matrix::m8, &Matrix::m12, &Matrix::m16 };
+            return elements[i];
+        }
+
         //operator overloader for multiplication
-        Matrix4 operator*(const Matrix4& other) const {
-            return Matrix4(
+        Matrix operator*(const Matrix& other) const {
+            return Matrix(
                 // First column
                 m1 * other.m1 + m5 * other.m2 + m9 * other.m3 + m13 * other.m4,
                 m2 * other.m1 + m6 * other.m2 + m10 * other.m3 + m14 * other.m4,
@@ -72,8 +99,8 @@ namespace MathClasses {
         }
 
         // Operator overload for matrix-vector multiplication
-        Vector4 operator*(const Vector4& vec) const {
-            return Vector4(
+        Vector<T, 4> operator*(const Vector<T, 4>& vec) const {
+            return Vector<T, 4>(
                 m1 * vec.x + m5 * vec.y + m9 * vec.z + m13 * vec.w,
                 m2 * vec.x + m6 * vec.y + m10 * vec.z + m14 * vec.w,
                 m3 * vec.x + m7 * vec.y + m11 * vec.z + m15 * vec.w,
@@ -82,7 +109,7 @@ namespace MathClasses {
         }
 
         // Function to create an identity matrix
-        static Matrix4 MakeIdentity() {
+        static Matrix MakeIdentity() {
             return { 1, 0, 0, 0,
                      0, 1, 0, 0,
                      0, 0, 1, 0,
@@ -90,8 +117,8 @@ namespace MathClasses {
         }
 
         // Translation matrix from floats
-        static Matrix4 MakeTranslation(float tx, float ty, float tz) {
-            return Matrix4(
+        static Matrix MakeTranslation(T tx, T ty, T tz) {
+            return Matrix(
                 1.0f, 0.0f, 0.0f, 0.0f,
                 0.0f, 1.0f, 0.0f, 0.0f,
                 0.0f, 0.0f, 1.0f, 0.0f,
@@ -100,8 +127,8 @@ namespace MathClasses {
         }
 
         // MakeTranslation method from Vector3
-        static Matrix4 MakeTranslation(const Vector3& v) {
-            return Matrix4(
+        static Matrix MakeTranslation(const Vector<T, 3>& v) {
+            return Matrix(
                 1, 0, 0, 0,
                 0, 1, 0, 0,
                 0, 0, 1, 0,
@@ -110,8 +137,8 @@ namespace MathClasses {
         }
 
         // Translation matrix from a Vector4
-        static Matrix4 MakeTranslation(const Vector4& v) {
-            return Matrix4(
+        static Matrix MakeTranslation(const Vector<T, 4>& v) {
+            return Matrix(
                 1.0f, 0.0f, 0.0f, 0.0f,
                 0.0f, 1.0f, 0.0f, 0.0f,
                 0.0f, 0.0f, 1.0f, 0.0f,
@@ -120,38 +147,60 @@ namespace MathClasses {
         }
 
         // Rotate around X-axis
-        static Matrix4 MakeRotateX(float radians) {
-            return Matrix4(
+        static Matrix MakeRotateX(T radians) {
+            return MakeRotateX(Precision::Exact, radians);
+        }
+
+        // Rotate around Y-axis
+        static Matrix MakeRotateY(T radians) {
+            return MakeRotateY(Precision::Exact, radians);
+        }
+
+        // Rotate around Z-axis
+        static Matrix MakeRotateZ(T radians) {
+            return MakeRotateZ(Precision::Exact, radians);
+        }
+
+        // Rotations with sin and cos at a chosen precision (see FastMath.h)
+        template<typename Precision>
+        static Matrix MakeRotateX(Precision precision, T radians) {
+            T s, c;
+            SinCos(precision, radians, s, c);
+            return Matrix(
                 1, 0, 0, 0,
-                0, cos(radians), sin(radians), 0,
-                0, -sin(radians), cos(radians), 0,
+                0, c, s, 0,
+                0, -s, c, 0,
                 0, 0, 0, 1
             );
         }
 
-        // Rotate around Y-axis
-        static Matrix4 MakeRotateY(float radians) {
-            return Matrix4(
-                cos(radians), 0, -sin(radians), 0,
+        template<typename Precision>
+        static Matrix MakeRotateY(Precision precision, T radians) {
+            T s, c;
+            SinCos(precision, radians, s, c);
+            return Matrix(
+                c, 0, -s, 0,
                 0, 1, 0, 0,
-                sin(radians), 0, cos(radians), 0,
+                s, 0, c, 0,
                 0, 0, 0, 1
             );
         }
 
-        // Rotate around Z-axis
-        static Matrix4 MakeRotateZ(float radians) {
-            return Matrix4(
-                cos(radians), sin(radians), 0, 0,
-                -sin(radians), cos(radians), 0, 0,
+        template<typename Precision>
+        static Matrix MakeRotateZ(Precision precision, T radians) {
+            T s, c;
+            SinCos(precision, radians, s, c);
+            return Matrix(
+                c, s, 0, 0,
+                -s, c, 0, 0,
                 0, 0, 1, 0,
                 0, 0, 0, 1
             );
         }
 
         // MakeScale method
-        static Matrix4 MakeScale(float scaleX, float scaleY, float scaleZ) {
-            return Matrix4(
+        static Matrix MakeScale(T scaleX, T scaleY, T scaleZ) {
+            return Matrix(
                 scaleX, 0, 0, 0,
                 0, scaleY, 0, 0,
                 0, 0, scaleZ, 0,
@@ -160,8 +209,8 @@ namespace MathClasses {
         }
 
         // MakeScale method from Vector3
-        static Matrix4 MakeScale(const Vector3& v) {
-            return Matrix4(
+        static Matrix MakeScale(const Vector<T, 3>& v) {
+            return Matrix(
                 v.x, 0, 0, 0,
                 0, v.y, 0, 0,
                 0, 0, v.z, 0,
@@ -170,45 +219,179 @@ namespace MathClasses {
         }
 
         // Euler rotations
-        static Matrix4 MakeEuler(float pitch, float yaw, float roll) {
-            Matrix4 x = MakeRotateX(pitch);
-            Matrix4 y = MakeRotateY(yaw);
-            Matrix4 z = MakeRotateZ(roll);
+        static Matrix MakeEuler(T pitch, T yaw, T roll) {
+            return MakeEuler(Precision::Exact, pitch, yaw, roll);
+        }
+
+        template<typename Precision>
+        static Matrix MakeEuler(Precision precision, T pitch, T yaw, T roll) {
+            Matrix x = MakeRotateX(precision, pitch);
+            Matrix y = MakeRotateY(precision, yaw);
+            Matrix z = MakeRotateZ(precision, roll);
             return z * y * x;
         }
 
-        static Matrix4 MakeEuler(const Vector3& v) {
+        static Matrix MakeEuler(const Vector<T, 3>& v) {
             return MakeEuler(v.x, v.y, v.z);
         }
 
 
-        static Matrix4 MakeEuler(const Vector4& v) {
+        static Matrix MakeEuler(const Vector<T, 4>& v) {
             return MakeEuler(v.x, v.y, v.z);
         }
 
+        // Projection and camera builders are right handed (the camera looks down -z)
+        // and, unless noted, map near to -1 and far to +1 in NDC like OpenGL.
+
+        // Perspective projection from a vertical field of view in radians
+        static Matrix MakePerspective(T fovY, T aspect, T nearPlane, T farPlane) {
+            T f = 1 / std::tan(fovY * T(0.5));
+            T range = 1 / (nearPlane - farPlane);
+            return Matrix(
+                f / aspect, 0, 0, 0,
+                0, f, 0, 0,
+                0, 0, (farPlane + nearPlane) * range, -1,
+                0, 0, 2 * farPlane * nearPlane * range, 0
+            );
+        }
+
+        // Perspective projection with the far plane at infinity
+        static Matrix MakePerspectiveInfinite(T fovY, T aspect, T nearPlane) {
+            T f = 1 / std::tan(fovY * T(0.5));
+            return Matrix(
+                f / aspect, 0, 0, 0,
+                0, f, 0, 0,
+                0, 0, -1, -1,
+                0, 0, -2 * nearPlane, 0
+            );
+        }
+
+        // Reversed-Z perspective: near maps to 1 and far to 0 in a [0, 1] depth range.
+        // Float depth precision is then spread evenly over distance; depth tests use greater.
+        static Matrix MakePerspectiveReversedZ(T fovY, T aspect, T nearPlane, T farPlane) {
+            T f = 1 / std::tan(fovY * T(0.5));
+            T range = 1 / (farPlane - nearPlane);
+            return Matrix(
+                f / aspect, 0, 0, 0,
+                0, f, 0, 0,
+                0, 0, nearPlane * range, -1,
+                0, 0, farPlane * nearPlane * range, 0
+            );
+        }
+
+        // Reversed-Z perspective with the far plane at infinity, which maps to depth 0
+        static Matrix MakePerspectiveReversedZInfinite(T fovY, T aspect, T nearPlane) {
+            T f = 1 / std::tan(fovY * T(0.5));
+            return Matrix(
+                f / aspect, 0, 0, 0,
+                0, f, 0, 0,
+                0, 0, 0, -1,
+                0, 0, nearPlane, 0
+            );
+        }
+
+        // Orthographic projection of the box between the planes
+        static Matrix MakeOrthographic(T left, T right, T bottom, T top, T nearPlane, T farPlane) {
+            T width = 1 / (right - left);
+            T height = 1 / (top - bottom);
+            T depth = 1 / (farPlane - nearPlane);
+            return Matrix(
+                2 * width, 0, 0, 0,
+                0, 2 * height, 0, 0,
+                0, 0, -2 * depth, 0,
+                -(right + left) * width, -(top + bottom) * height, -(farPlane + nearPlane) * depth, 1
+            );
+        }
+
+        // View matrix for a camera at eye looking at target. Built directly from the
+        // camera axes, so no general inverse is needed.
+        static Matrix MakeLookAt(const Vector<T, 3>& eye, const Vector<T, 3>& target, const Vector<T, 3>& up) {
+            Vector<T, 3> forward = (target - eye).Normalised();
+            Vector<T, 3> side = forward.Cross(up).Normalised();
+            Vector<T, 3> cameraUp = side.Cross(forward);
+            return Matrix(
+                side.x, cameraUp.x, -forward.x, 0,
+                side.y, cameraUp.y, -forward.y, 0,
+                side.z, cameraUp.z, -forward.z, 0,
+                -side.Dot(eye), -cameraUp.Dot(eye), forward.Dot(eye), 1
+            );
+        }
+
+        // Splits a matrix built as MakeTranslation(t) * rotation * MakeScale(s) back into
+        // its parts. Scale is the length of each basis column, with a mirroring (negative
+        // determinant) put on scale.x so rotation stays a proper rotation. Shear isn't
+        // separated out. Returns false if a scale is zero or the bottom row isn't
+        // (0, 0, 0, 1); the parts are then the best that can be recovered.
+        bool Decompose(Vector<T, 3>& translation, Matrix<T, 3, 3>& rotation, Vector<T, 3>& scale) const {
+            translation = Vector<T, 3>(m13, m14, m15);
+            Vector<T, 3> x(m1, m2, m3), y(m5, m6, m7), z(m9, m10, m11);
+            scale = Vector<T, 3>(x.Magnitude(), y.Magnitude(), z.Magnitude());
+            if (x.Dot(y.Cross(z)) < 0) {
+                scale.x = -scale.x;
+            }
+
+            bool valid = m4 == 0 && m8 == 0 && m12 == 0 && m16 == 1;
+            const T tiny = T(1e-20);
+            bool zeroX = std::fabs(scale.x) < tiny, zeroY = std::fabs(scale.y) < tiny, zeroZ = std::fabs(scale.z) < tiny;
+            if (!zeroX && !zeroY && !zeroZ) {
+                x = x * (1 / scale.x);
+                y = y * (1 / scale.y);
+                z = z * (1 / scale.z);
+            }
+            else {
+                // One flattened axis is rebuilt from the other two; with more, there's
+                // nothing to go on and the rotation is the identity
+                valid = false;
+                if (zeroX + zeroY + zeroZ > 1) {
+                    x = Vector<T, 3>(1, 0, 0);
+                    y = Vector<T, 3>(0, 1, 0);
+                    z = Vector<T, 3>(0, 0, 1);
+                }
+                else if (zeroX) {
+                    y = y.Normalised();
+                    z = z.Normalised();
+                    x = y.Cross(z);
+                }
+                else if (zeroY) {
+                    x = x.Normalised();
+                    z = z.Normalised();
+                    y = z.Cross(x);
+                }
+                else {
+                    x = x.Normalised();
+                    y = y.Normalised();
+                    z = x.Cross(y);
+                }
+            }
+            rotation = Matrix<T, 3, 3>(x.x, x.y, x.z, y.x, y.y, y.z, z.x, z.y, z.z);
+            return valid;
+        }
+
+        // As above with the rotation as a quaternion; defined in Quaternion.h
+        bool Decompose(Vector<T, 3>& translation, Quaternion& rotation, Vector<T, 3>& scale) const;
+
         // Equality operator
-        bool operator==(const Matrix4& other) const {
-            const float EPSILON = 0.0001f;
-            return (std::fabs(m1 - other.m1) < EPSILON) &&
-                (std::fabs(m2 - other.m2) < EPSILON) &&
-                (std::fabs(m3 - other.m3) < EPSILON) &&
-                (std::fabs(m4 - other.m4) < EPSILON) &&
-                (std::fabs(m5 - other.m5) < EPSILON) &&
-                (std::fabs(m6 - other.m6) < EPSILON) &&
-                (std::fabs(m7 - other.m7) < EPSILON) &&
-                (std::fabs(m8 - other.m8) < EPSILON) &&
-                (std::fabs(m9 - other.m9) < EPSILON) &&
-                (std::fabs(m10 - other.m10) < EPSILON) &&
-                (std::fabs(m11 - other.m11) < EPSILON) &&
-                (std::fabs(m12 - other.m12) < EPSILON) &&
-                (std::fabs(m13 - other.m13) < EPSILON) &&
-                (std::fabs(m14 - other.m14) < EPSILON) &&
-                (std::fabs(m15 - other.m15) < EPSILON) &&
-                (std::fabs(m16 - other.m16) < EPSILON);
+        bool operator==(const Matrix& other) const {
+            return Detail::NearlyEqual(m1, other.m1) &&
+                Detail::NearlyEqual(m2, other.m2) &&
+                Detail::NearlyEqual(m3, other.m3) &&
+                Detail::NearlyEqual(m4, other.m4) &&
+                Detail::NearlyEqual(m5, other.m5) &&
+                Detail::NearlyEqual(m6, other.m6) &&
+                Detail::NearlyEqual(m7, other.m7) &&
+                Detail::NearlyEqual(m8, other.m8) &&
+                Detail::NearlyEqual(m9, other.m9) &&
+                Detail::NearlyEqual(m10, other.m10) &&
+                Detail::NearlyEqual(m11, other.m11) &&
+                Detail::NearlyEqual(m12, other.m12) &&
+                Detail::NearlyEqual(m13, other.m13) &&
+                Detail::NearlyEqual(m14, other.m14) &&
+                Detail::NearlyEqual(m15, other.m15) &&
+                Detail::NearlyEqual(m16, other.m16);
         }
 
         // Inequality operator
-        bool operator!=(const Matrix4& other) const {
+        bool operator!=(const Matrix& other) const {
             return !(*this == other);
         }
 
@@ -220,4 +403,7 @@ namespace MathClasses {
                 std::to_string(m13) + ", " + std::to_string(m14) + ", " + std::to_string(m15) + ", " + std::to_string(m16);
         }
     };
-}
+
+    using Matrix4 = Matrix<float, 4, 4>;
+    using Matrix4d = Matrix<double, 4, 4>;
+}
\ No newline at end of file
@@ -0,0 +1,199 @@
+#pragma once
+#include "Vector3.h"
+#include "Simd.h"
+#include "ThreadPool.h"
+#include "Batch.h"
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace MathClasses {
+
+    // How each triangle's contribution to its vertices' normals is weighted
+    enum class NormalWeighting {
+        Area,   // by triangle area (the raw cross product)
+        Angle   // by the triangle's interior angle at the vertex
+    };
+
+    // Builds smooth vertex normals for an indexed triangle mesh.
+    // Works in three passes, none of which write to shared memory:
+    //  1. face normals (cross products) four triangles at a time, split by triangle
+    //  2. each vertex sums the faces it belongs to, split by vertex, using a
+    //     vertex -> triangle corner table built from the index buffer
+    //  3. the sums are normalised in the same chunk while still in cache
+    // The corner table only depends on the index buffer, so keep the builder and call
+    // Compute again when only the positions change. Results are identical for every
+    // policy and thread count, unless the compiler contracts to FMA (see Simd.h).
+    class VertexNormalBuilder {
+    public:
+        VertexNormalBuilder() = default;
+
+        VertexNormalBuilder(const std::uint32_t* indices, std::size_t indexCount, std::size_t vertexCount) {
+            SetTopology(indices, indexCount, vertexCount);
+        }
+
+        // Stores the index buffer (three indices per triangle) and builds the corner table.
+        // Every index must be less than vertexCount.
+        void SetTopology(const std::uint32_t* indices, std::size_t indexCount, std::size_t vertexCount) {
+            triangleIndices.assign(indices, indices + indexCount - indexCount % 3);
+            cornerOffsets.assign(vertexCount + 1, 0);
+            corners.resize(triangleIndices.size());
+
+            // Counting sort of corners by vertex, keeping triangle order within a vertex
+            for (std::uint32_t index : triangleIndices) {
+                assert(index < vertexCount && "VertexNormalBuilder index out of range");
+                cornerOffsets[index + 1]++;
+            }
+            for (std::size_t v = 0; v < vertexCount; ++v) {
+                cornerOffsets[v + 1] += cornerOffsets[v];
+            }
+            std::vector<std::uint32_t> next(cornerOffsets.begin(), cornerOffsets.end() - 1);
+            for (std::size_t c = 0; c < triangleIndices.size(); ++c) {
+                corners[next[triangleIndices[c]]++] = static_cast<std::uint32_t>(c);
+            }
+
+            faceNormals.resize(GetTriangleCount());
+        }
+
+        std::size_t GetVertexCount() const { return cornerOffsets.empty() ? 0 : cornerOffsets.size() - 1; }
+        std::size_t GetTriangleCount() const { return triangleIndices.size() / 3; }
+
+        // Writes one unit normal per vertex. Vertices used by no (non-degenerate) triangle get zero.
+        template<typename Policy>
+        void Compute(Policy policy, const Vector3* positions, Vector3* normals, NormalWeighting weighting = NormalWeighting::Area) {
+            bool angle = weighting == NormalWeighting::Angle;
+            cornerWeights.resize(angle ? triangleIndices.size() : 0);
+
+            ForEachRange(policy, GetTriangleCount(), GrainForBytes(sizeof(Vector3) * 4), [&](std::size_t begin, std::size_t end) {
+                FaceKernel(positions, begin, end, angle);
+            });
+
+            ForEachRange(policy, GetVertexCount(), GrainForBytes(sizeof(Vector3) * 8), [&](std::size_t begin, std::size_t end) {
+                GatherKernel(normals, begin, end, angle);
+                Detail::NormaliseVectorsKernel(normals + begin, normals + begin, end - begin);
+            });
+        }
+
+        void Compute(const Vector3* positions, Vector3* normals, NormalWeighting weighting = NormalWeighting::Area) {
+            Compute(Execution::Seq, positions, normals, weighting);
+        }
+
+    private:
+        // n = (p1 - p0) x (p2 - p0), whose length is twice the triangle's area.
+        // For angle weighting each corner also gets angle / |n|, so that n times the
+        // weight is the unit face normal scaled by the corner's angle.
+        void FaceKernel(const Vector3* positions, std::size_t begin, std::size_t end, bool angle) {
+            const std::uint32_t* idx = triangleIndices.data();
+            std::size_t t = begin;
+            for (; t + 4 <= end; t += 4) {
+                Float4 p[3][3];
+                for (int corner = 0; corner < 3; ++corner) {
+                    const Vector3& a = positions[idx[3 * t + corner]];
+                    const Vector3& b = positions[idx[3 * (t + 1) + corner]];
+                    const Vector3& c = positions[idx[3 * (t + 2) + corner]];
+                    const Vector3& d = positions[idx[3 * (t + 3) + corner]];
+                    p[corner][0] = Float4(a.x, b.x, c.x, d.x);
+                    p[corner][1] = Float4(a.y, b.y, c.y, d.y);
+                    p[corner][2] = Float4(a.z, b.z, c.z, d.z);
+                }
+
+                Float4 e1x = p[1][0] - p[0][0], e1y = p[1][1] - p[0][1], e1z = p[1][2] - p[0][2];
+                Float4 e2x = p[2][0] - p[0][0], e2y = p[2][1] - p[0][1], e2z = p[2][2] - p[0][2];
+                Float4 nx = e1y * e2z - e1z * e2y;
+                Float4 ny = e1z * e2x - e1x * e2z;
+                Float4 nz = e1x * e2y - e1y * e2x;
+
+                alignas(16) float xs[4], ys[4], zs[4];
+                nx.Store(xs);
+                ny.Store(ys);
+                nz.Store(zs);
+                for (int k = 0; k < 4; ++k) {
+                    faceNormals[t + k] = Vector3(xs[k], ys[k], zs[k]);
+                }
+
+                if (angle) {
+                    // Dot products of the two edges leaving each corner
+                    Float4 e3x = p[2][0] - p[1][0], e3y = p[2][1] - p[1][1], e3z = p[2][2] - p[1][2];
+                    Float4 dot0 = e1x * e2x + e1y * e2y + e1z * e2z;
+                    Float4 dot1 = -(e1x * e3x + e1y * e3y + e1z * e3z);
+                    Float4 dot2 = e2x * e3x + e2y * e3y + e2z * e3z;
+                    Float4 len = Sqrt(nx * nx + ny * ny + nz * nz);
+
+                    alignas(16) float lens[4], dots[3][4];
+                    len.Store(lens);
+                    dot0.Store(dots[0]);
+                    dot1.Store(dots[1]);
+                    dot2.Store(dots[2]);
+                    for (int k = 0; k < 4; ++k) {
+                        for (int corner = 0; corner < 3; ++corner) {
+                            cornerWeights[3 * (t + k) + corner] = CornerWeight(lens[k], dots[corner][k]);
+                        }
+                    }
+                }
+            }
+
+            for (; t < end; ++t) {
+                const Vector3& p0 = positions[idx[3 * t]];
+                const Vector3& p1 = positions[idx[3 * t + 1]];
+                const Vector3& p2 = positions[idx[3 * t + 2]];
+                Vector3 e1 = p1 - p0;
+                Vector3 e2 = p2 - p0;
+                Vector3 n = e1.Cross(e2);
+                faceNormals[t] = n;
+
+                if (angle) {
+                    Vector3 e3 = p2 - p1;
+                    float len = n.Magnitude();
+                    cornerWeights[3 * t] = CornerWeight(len, e1.Dot(e2));
+                    cornerWeights[3 * t + 1] = CornerWeight(len, -e1.Dot(e3));
+                    cornerWeights[3 * t + 2] = CornerWeight(len, e2.Dot(e3));
+                }
+            }
+        }
+
+        // |a x b| is the same at every corner, so the corner angle is atan2(|n|, a . b)
+        static float CornerWeight(float crossLength, float dot) {
+            return crossLength > 0.0f ? std::atan2(crossLength, dot) / crossLength : 0.0f;
+        }
+
+        void GatherKernel(Vector3* normals, std::size_t begin, std::size_t end, bool angle) const {
+            for (std::size_t v = begin; v < end; ++v) {
+                float x = 0, y = 0, z = 0;
+                for (std::uint32_t c = cornerOffsets[v]; c < cornerOffsets[v + 1]; ++c) {
+                    std::uint32_t corner = corners[c];
+                    const Vector3& n = faceNormals[corner / 3];
+                    float w = angle ? cornerWeights[corner] : 1.0f;
+                    x += n.x * w;
+                    y += n.y * w;
+                    z += n.z * w;
+                }
+                normals[v] = Vector3(x, y, z);
+            }
+        }
+
+        std::vector<std::uint32_t> triangleIndices;
+        std::vector<std::uint32_t> cornerOffsets;
+        std::vector<std::uint32_t> corners;
+        std::vector<Vector3> faceNormals;
+        std::vector<float> cornerWeights;
+    };
+
+    // One-off vertex normal generation; see VertexNormalBuilder
+    template<typename Policy>
+    void ComputeVertexNormals(Policy policy, const Vector3* positions, std::size_t vertexCount,
+        const std::uint32_t* indices, std::size_t indexCount, Vector3* normals,
+        NormalWeighting weighting = NormalWeighting::Area)
+    {
+        VertexNormalBuilder builder(indices, indexCount, vertexCount);
+        builder.Compute(policy, positions, normals, weighting);
+    }
+
+    inline void ComputeVertexNormals(const Vector3* positions, std::size_t vertexCount,
+        const std::uint32_t* indices, std::size_t indexCount, Vector3* normals,
+        NormalWeighting weighting = NormalWeighting::Area)
+    {
+        ComputeVertexNormals(Execution::Seq, positions, vertexCount, indices, indexCount, normals, weighting);
+    }
+}
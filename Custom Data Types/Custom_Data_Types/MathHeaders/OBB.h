@@ -0,0 +1,172 @@
+#pragma once
+#include "AABB.h"
+#include "Eigen.h"
+#include "FrameArena.h"
+#include "Matrix3.h"
+#include "Reductions.h"
+#include "Vector3.h"
+#include "ThreadPool.h"
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+namespace MathClasses {
+
+    // Oriented bounding box: a centre, a rotation whose columns are the box axes and
+    // the half size along each of those axes
+    struct OBB {
+        Vector3 centre;
+        Matrix3 axes = Matrix3::MakeIdentity();
+        Vector3 extents;
+
+        // The point in the box's own frame, relative to its centre
+        Vector3 ToLocal(const Vector3& p) const {
+            return axes.Transposed() * (p - centre);
+        }
+
+        bool Contains(const Vector3& p, float tolerance = 0.0f) const {
+            Vector3 local = ToLocal(p);
+            return std::fabs(local.x) <= extents.x + tolerance &&
+                std::fabs(local.y) <= extents.y + tolerance &&
+                std::fabs(local.z) <= extents.z + tolerance;
+        }
+
+        float GetVolume() const {
+            return 8.0f * extents.x * extents.y * extents.z;
+        }
+    };
+
+    namespace Detail {
+        // Bounds of the points in the frame of axes, relative to origin
+        inline AABB ProjectedBounds(const Vector3* points, std::size_t count, const Matrix3& axes, const Vector3& origin) {
+            Matrix3 toLocal = axes.Transposed();
+            AABB bounds;
+            for (std::size_t i = 0; i < count; ++i) {
+                bounds.Expand(toLocal * (points[i] - origin));
+            }
+            return bounds;
+        }
+
+        inline OBB MakeOBB(const Vector3& origin, const Matrix3& axes, const AABB& local) {
+            OBB box;
+            box.axes = axes;
+            box.centre = origin + axes * local.GetCentre();
+            box.extents = local.GetExtents();
+            return box;
+        }
+
+        // FitOBB's second pass, a chunk per partial as in Reduce
+        template<typename Policy>
+        OBB FitOBBExtents(Policy policy, const Vector3* points, std::size_t count, const PointStatistics& stats,
+            AABB* partials, std::size_t capacity)
+        {
+            Matrix3 axes = ComputeSymmetricEigen(stats.covariance).vectors;
+            AABB local;
+            ReduceChunkBatches(policy, count, partials, capacity,
+                [&](std::size_t first, std::size_t size) { return ProjectedBounds(points + first, size, axes, stats.centroid); },
+                [&local](const AABB& partial) { local.Expand(partial); });
+            return MakeOBB(stats.centroid, axes, local);
+        }
+
+        // Clusters fitted together by FitOBBs: their covariances are gathered on the
+        // stack and solved with ComputeSymmetricEigens, eight per Float8
+        constexpr std::size_t OBBClusterBlock = 64;
+
+        inline void FitOBBsBlock(const Vector3* points, const std::uint32_t* offsets, std::size_t clusterCount, OBB* out) {
+            Matrix3 covariances[OBBClusterBlock];
+            Vector3 centroids[OBBClusterBlock];
+            SymmetricEigen eigens[OBBClusterBlock];
+            for (std::size_t c = 0; c < clusterCount; ++c) {
+                PointStatistics stats = ComputePointStatistics(points + offsets[c], offsets[c + 1] - offsets[c]);
+                covariances[c] = stats.covariance;
+                centroids[c] = stats.centroid;
+            }
+
+            ComputeSymmetricEigens(Execution::Seq, covariances, eigens, clusterCount);
+
+            for (std::size_t c = 0; c < clusterCount; ++c) {
+                std::size_t size = offsets[c + 1] - offsets[c];
+                if (size == 0) {
+                    out[c] = OBB();
+                    continue;
+                }
+                AABB local = ProjectedBounds(points + offsets[c], size, eigens[c].vectors, centroids[c]);
+                out[c] = MakeOBB(centroids[c], eigens[c].vectors, local);
+            }
+        }
+    }
+
+    // Box aligned with the principal axes of the points: the eigenvectors of their
+    // covariance, largest spread first. Good for elongated or flat point sets; for
+    // nearly isotropic ones the axes are arbitrary and an AABB may well be smaller.
+    // The points are read twice, once for the covariance and once for the extents.
+    // Like ComputePointStatistics nothing is allocated, and the FrameArena overload
+    // takes the chunk partials from the arena for one parallel pass over large sets.
+    template<typename Policy>
+    OBB FitOBB(Policy policy, const Vector3* points, std::size_t count) {
+        if (count == 0) {
+            return OBB();
+        }
+        PointStatistics stats = ComputePointStatistics(policy, points, count);
+        AABB partials[Detail::ReductionBatchChunks];
+        return Detail::FitOBBExtents(policy, points, count, stats, partials, Detail::ReductionBatchChunks);
+    }
+
+    inline OBB FitOBB(const Vector3* points, std::size_t count) {
+        return FitOBB(Execution::Seq, points, count);
+    }
+
+    template<typename Policy>
+    OBB FitOBB(Policy policy, FrameArena& arena, const Vector3* points, std::size_t count) {
+        std::size_t chunks = (count + Detail::ReductionChunk - 1) / Detail::ReductionChunk;
+        if (chunks <= Detail::ReductionBatchChunks) {
+            return FitOBB(policy, points, count);
+        }
+        PointStatistics stats = ComputePointStatistics(policy, arena, points, count);
+        ArenaScope scope(arena);
+        Span<AABB> partials = arena.AllocateUninitialised<AABB>(chunks);
+        if (partials.Size() != chunks) {
+            AABB stackPartials[Detail::ReductionBatchChunks];
+            return Detail::FitOBBExtents(policy, points, count, stats, stackPartials, Detail::ReductionBatchChunks);
+        }
+        return Detail::FitOBBExtents(policy, points, count, stats, partials.Data(), chunks);
+    }
+
+    inline OBB FitOBB(FrameArena& arena, const Vector3* points, std::size_t count) {
+        return FitOBB(Execution::Seq, arena, points, count);
+    }
+
+    // FitOBB for many small clusters at once. Cluster c is points[offsets[c]] up to
+    // points[offsets[c + 1]], so offsets has clusterCount + 1 entries. The covariances
+    // are gathered, OBBClusterBlock clusters at a time on the stack, and solved
+    // together with ComputeSymmetricEigens, eight per Float8, rather than one at a
+    // time. Empty clusters give a default OBB.
+    template<typename Policy>
+    void FitOBBs(Policy policy, const Vector3* points, const std::uint32_t* offsets, std::size_t clusterCount, OBB* out) {
+        ForEachRange(policy, clusterCount, GrainForBytes(sizeof(Matrix3) + sizeof(Vector3) + sizeof(SymmetricEigen) + sizeof(OBB)),
+            [&](std::size_t begin, std::size_t end) {
+                for (std::size_t c = begin; c < end; c += Detail::OBBClusterBlock) {
+                    std::size_t size = end - c < Detail::OBBClusterBlock ? end - c : Detail::OBBClusterBlock;
+                    Detail::FitOBBsBlock(points, offsets + c, size, out + c);
+                }
+            });
+    }
+
+    inline void FitOBBs(const Vector3* points, const std::uint32_t* offsets, std::size_t clusterCount, OBB* out) {
+        FitOBBs(Execution::Seq, points, offsets, clusterCount, out);
+    }
+
+    // Boxes from a FrameArena; empty if the arena can't fit them
+    template<typename Policy>
+    Span<OBB> FitOBBs(Policy policy, FrameArena& arena, const Vector3* points, const std::uint32_t* offsets, std::size_t clusterCount) {
+        Span<OBB> out = arena.AllocateUninitialised<OBB>(clusterCount);
+        if (out.Size() == clusterCount) {
+            FitOBBs(policy, points, offsets, clusterCount, out.Data());
+        }
+        return out;
+    }
+
+    inline Span<OBB> FitOBBs(FrameArena& arena, const Vector3* points, const std::uint32_t* offsets, std::size_t clusterCount) {
+        return FitOBBs(Execution::Seq, arena, points, offsets, clusterCount);
+    }
+}
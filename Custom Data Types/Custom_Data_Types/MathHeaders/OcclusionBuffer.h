@@ -0,0 +1,209 @@
+#pragma once
+#include "Matrix4.h"
+#include "AABB.h"
+#include "Simd.h"
+#include "Rasteriser.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace MathClasses {
+
+    // Low resolution depth buffer for CPU occlusion culling.
+    //
+    // Each frame: Clear, RenderOccluders with a few large simple meshes (walls, terrain,
+    // building shells), BuildHierarchy, then test object bounds with IsVisible or
+    // TestBoxes. Occluders are drawn depth only by the tile rasteriser. The hierarchy
+    // keeps the nearest and farthest depth of every 2x2 block of the level below, so
+    // a box's screen rectangle is checked against a handful of texels whatever its size.
+    //
+    // Tests err on the side of visible: boxes crossing the near plane are always
+    // visible, and a box is only hidden if it is behind the farthest occluder depth
+    // over its whole rectangle. Occluders cover the pixels whose centres they cover,
+    // so they should be drawn slightly inside the real geometry.
+    class OcclusionBuffer {
+    public:
+        // Levels finer than this many steps below the starting level aren't visited
+        static constexpr int MaxRefineLevels = 2;
+
+        OcclusionBuffer(int width, int height) : depth(width, height) {
+            int w = width, h = height;
+            do {
+                Level level;
+                level.width = w;
+                level.height = h;
+                level.minDepth.assign(std::size_t(w) * h, 1.0f);
+                level.maxDepth.assign(std::size_t(w) * h, 1.0f);
+                levels.push_back(std::move(level));
+                w = (w + 1) / 2;
+                h = (h + 1) / 2;
+            } while (levels.back().width > 1 || levels.back().height > 1);
+        }
+
+        int GetWidth() const { return depth.GetWidth(); }
+        int GetHeight() const { return depth.GetHeight(); }
+        int GetLevelCount() const { return int(levels.size()); }
+
+        // Depth after the last BuildHierarchy; level 0 is full resolution
+        float GetMinDepth(int level, int x, int y) const { return levels[level].minDepth[std::size_t(y) * levels[level].width + x]; }
+        float GetMaxDepth(int level, int x, int y) const { return levels[level].maxDepth[std::size_t(y) * levels[level].width + x]; }
+
+        void Clear() {
+            depth.Clear(Colour(), 1.0f);
+        }
+
+        // Draws occluders into the depth buffer; their colour settings are ignored
+        template<typename Policy>
+        void RenderOccluders(Policy policy, const DrawCall* occluders, std::size_t count) {
+            draws.assign(occluders, occluders + count);
+            for (DrawCall& draw : draws) {
+                draw.writeColour = false;
+            }
+            rasteriser.Draw(policy, depth, draws.data(), draws.size());
+        }
+
+        void RenderOccluders(const DrawCall* occluders, std::size_t count) {
+            RenderOccluders(Execution::Seq, occluders, count);
+        }
+
+        // Rebuilds the min/max pyramid from the depth buffer
+        void BuildHierarchy() {
+            Level& base = levels[0];
+            for (int y = 0; y < base.height; ++y) {
+                const float* row = depth.GetDepths() + std::size_t(y) * depth.GetStride();
+                std::copy(row, row + base.width, base.maxDepth.begin() + std::size_t(y) * base.width);
+            }
+            base.minDepth = base.maxDepth;
+
+            for (std::size_t l = 1; l < levels.size(); ++l) {
+                const Level& src = levels[l - 1];
+                Level& dst = levels[l];
+                for (int y = 0; y < dst.height; ++y) {
+                    // An odd last row or column has no partner and is used on its own
+                    int y0 = y * 2, y1 = std::min(y * 2 + 1, src.height - 1);
+                    for (int x = 0; x < dst.width; ++x) {
+                        int x0 = x * 2, x1 = std::min(x * 2 + 1, src.width - 1);
+                        std::size_t a = std::size_t(y0) * src.width, b = std::size_t(y1) * src.width;
+                        dst.minDepth[std::size_t(y) * dst.width + x] = std::min(
+                            std::min(src.minDepth[a + x0], src.minDepth[a + x1]), std::min(src.minDepth[b + x0], src.minDepth[b + x1]));
+                        dst.maxDepth[std::size_t(y) * dst.width + x] = std::max(
+                            std::max(src.maxDepth[a + x0], src.maxDepth[a + x1]), std::max(src.maxDepth[b + x0], src.maxDepth[b + x1]));
+                    }
+                }
+            }
+        }
+
+        // False if the box is outside the view volume or hidden behind occluders.
+        // viewProjection takes world space to OpenGL style clip space.
+        bool IsVisible(const Matrix4& viewProjection, const AABB& box) const {
+            float minX, minY, maxX, maxY, nearDepth;
+            switch (Project(viewProjection, box, minX, minY, maxX, maxY, nearDepth)) {
+            case Projection::Outside: return false;
+            case Projection::CrossesNear: return true;
+            default: break;
+            }
+
+            int width = GetWidth(), height = GetHeight();
+            int x0 = std::max(0, int(std::floor(minX))), x1 = std::min(width - 1, int(std::floor(maxX)));
+            int y0 = std::max(0, int(std::floor(minY))), y1 = std::min(height - 1, int(std::floor(maxY)));
+            if (x0 > x1 || y0 > y1) {
+                return false;
+            }
+
+            // Coarsest level at which the rectangle spans at most two texels each way
+            int start = 0;
+            while (start + 1 < GetLevelCount() && ((x1 >> start) - (x0 >> start) > 1 || (y1 >> start) - (y0 >> start) > 1)) {
+                ++start;
+            }
+
+            for (int level = start; ; --level) {
+                bool undecided = false;
+                for (int ty = y0 >> level; ty <= (y1 >> level); ++ty) {
+                    for (int tx = x0 >> level; tx <= (x1 >> level); ++tx) {
+                        if (nearDepth <= GetMinDepth(level, tx, ty)) {
+                            // In front of everything drawn in this texel
+                            return true;
+                        }
+                        undecided |= nearDepth <= GetMaxDepth(level, tx, ty);
+                    }
+                }
+                if (!undecided) {
+                    return false;
+                }
+                if (level == 0 || level == start - MaxRefineLevels) {
+                    return true;
+                }
+            }
+        }
+
+        // visible[i] is set to 1 if boxes[i] passes IsVisible, otherwise 0
+        template<typename Policy>
+        void TestBoxes(Policy policy, const Matrix4& viewProjection, const AABB* boxes, std::size_t count, uint8_t* visible) const {
+            ForEachRange(policy, count, GrainForBytes(sizeof(AABB) * 64), [&](std::size_t begin, std::size_t end) {
+                for (std::size_t i = begin; i < end; ++i) {
+                    visible[i] = IsVisible(viewProjection, boxes[i]) ? 1 : 0;
+                }
+            });
+        }
+
+        void TestBoxes(const Matrix4& viewProjection, const AABB* boxes, std::size_t count, uint8_t* visible) const {
+            TestBoxes(Execution::Seq, viewProjection, boxes, count, visible);
+        }
+
+    private:
+        struct Level {
+            int width = 0;
+            int height = 0;
+            std::vector<float> minDepth;
+            std::vector<float> maxDepth;
+        };
+
+        enum class Projection { Outside, CrossesNear, OnScreen };
+
+        // Transforms all eight corners at once, one per Float8 lane, and returns the
+        // screen rectangle (in pixels) and nearest depth of the box
+        Projection Project(const Matrix4& m, const AABB& box, float& minX, float& minY, float& maxX, float& maxY, float& nearDepth) const {
+            Float4 xs(box.min.x, box.max.x, box.min.x, box.max.x);
+            Float4 ys(box.min.y, box.min.y, box.max.y, box.max.y);
+            Float8 x(xs, xs), y(ys, ys), z(Float4(box.min.z), Float4(box.max.z));
+
+            Float8 cx = Float8(m.m1) * x + Float8(m.m5) * y + Float8(m.m9) * z + Float8(m.m13);
+            Float8 cy = Float8(m.m2) * x + Float8(m.m6) * y + Float8(m.m10) * z + Float8(m.m14);
+            Float8 cz = Float8(m.m3) * x + Float8(m.m7) * y + Float8(m.m11) * z + Float8(m.m15);
+            Float8 cw = Float8(m.m4) * x + Float8(m.m8) * y + Float8(m.m12) * z + Float8(m.m16);
+
+            // Every corner beyond the same plane
+            Float8 negW = -cw;
+            if (All(cx < negW) || All(cx > cw) || All(cy < negW) || All(cy > cw) || All(cz < negW) || All(cz > cw)) {
+                return Projection::Outside;
+            }
+            if (Any(cz < negW)) {
+                return Projection::CrossesNear;
+            }
+
+            Float8 invW = Float8(1.0f) / cw;
+            Float8 sx = (cx * invW * Float8(0.5f) + Float8(0.5f)) * Float8(float(GetWidth()));
+            Float8 sy = (Float8(0.5f) - cy * invW * Float8(0.5f)) * Float8(float(GetHeight()));
+            Float8 sz = cz * invW * Float8(0.5f) + Float8(0.5f);
+            minX = maxX = sx[0];
+            minY = maxY = sy[0];
+            nearDepth = sz[0];
+            for (int i = 1; i < 8; ++i) {
+                minX = std::min(minX, sx[i]);
+                maxX = std::max(maxX, sx[i]);
+                minY = std::min(minY, sy[i]);
+                maxY = std::max(maxY, sy[i]);
+                nearDepth = std::min(nearDepth, sz[i]);
+            }
+            return Projection::OnScreen;
+        }
+
+        Framebuffer depth;
+        Rasteriser rasteriser;
+        std::vector<DrawCall> draws;
+        std::vector<Level> levels;
+    };
+}
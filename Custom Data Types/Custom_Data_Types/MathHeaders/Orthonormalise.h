@@ -0,0 +1,285 @@
+#pragma once
+#include "Matrix3.h"
+#include "Matrix4.h"
+#include "Vector3.h"
+#include "FrameArena.h"
+#include "Span.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+namespace MathClasses {
+
+    // Repairs rotation matrices that have drifted from orthonormal after many products,
+    // so incremental rotations can be kept instead of being rebuilt from angles.
+    //
+    // OrthonormalDrift is the cheap check (six dot products): the largest error in a
+    // column's length squared or in the dot product of two columns. Call Orthonormalise
+    // only when it passes a tolerance, or use the batch functions, which do that for you.
+    // Any scale in the matrix is removed; Matrix4 keeps its translation and bottom row.
+    enum class OrthonormaliseMethod {
+        // Normalise x, remove x from y and normalise it, z = x cross y. Exact in one pass
+        // and works from any starting point, but x keeps its direction and takes none of
+        // the correction.
+        GramSchmidt,
+        // Nearest rotation matrix (the rotation factor of the polar decomposition),
+        // spreading the correction evenly over the axes. Newton-Schulz iterations,
+        // Q = Q (3I - QtQ) / 2, converging quadratically; one or two are enough for
+        // drift under 1e-3. Falls back to Gram-Schmidt if the matrix is too far gone.
+        Polar
+    };
+
+    // Drift above this is worth repairing; float products add around 1e-7 per step
+    constexpr float DefaultOrthonormalTolerance = 1e-5f;
+
+    namespace Detail {
+        constexpr int MaxPolarIterations = 4;
+        constexpr float PolarConvergedDrift = 1e-6f;
+
+        struct Basis3 {
+            Vector3 x, y, z;
+        };
+
+        inline Basis3 GetBasis(const Matrix3& m) {
+            return { Vector3(m.m1, m.m2, m.m3), Vector3(m.m4, m.m5, m.m6), Vector3(m.m7, m.m8, m.m9) };
+        }
+
+        inline Basis3 GetBasis(const Matrix4& m) {
+            return { Vector3(m.m1, m.m2, m.m3), Vector3(m.m5, m.m6, m.m7), Vector3(m.m9, m.m10, m.m11) };
+        }
+
+        inline void SetBasis(Matrix3& m, const Basis3& b) {
+            m.m1 = b.x.x; m.m2 = b.x.y; m.m3 = b.x.z;
+            m.m4 = b.y.x; m.m5 = b.y.y; m.m6 = b.y.z;
+            m.m7 = b.z.x; m.m8 = b.z.y; m.m9 = b.z.z;
+        }
+
+        inline void SetBasis(Matrix4& m, const Basis3& b) {
+            m.m1 = b.x.x; m.m2 = b.x.y; m.m3 = b.x.z;
+            m.m5 = b.y.x; m.m6 = b.y.y; m.m7 = b.y.z;
+            m.m9 = b.z.x; m.m10 = b.z.y; m.m11 = b.z.z;
+        }
+
+        // Entries of the symmetric matrix QtQ, which is the identity for a rotation
+        struct Gram3 {
+            float xx, yy, zz, xy, xz, yz;
+        };
+
+        inline Gram3 GetGram(const Basis3& b) {
+            return { b.x.Dot(b.x), b.y.Dot(b.y), b.z.Dot(b.z), b.x.Dot(b.y), b.x.Dot(b.z), b.y.Dot(b.z) };
+        }
+
+        inline float Drift(const Gram3& g) {
+            return std::max({ std::fabs(g.xx - 1.0f), std::fabs(g.yy - 1.0f), std::fabs(g.zz - 1.0f),
+                std::fabs(g.xy), std::fabs(g.xz), std::fabs(g.yz) });
+        }
+
+        inline Basis3 GramSchmidt(const Basis3& b) {
+            Vector3 x = b.x.Normalised();
+            Vector3 y = (b.y - x * x.Dot(b.y)).Normalised();
+            return { x, y, x.Cross(y) };
+        }
+
+        inline Basis3 Polar(Basis3 b) {
+            for (int i = 0; i < MaxPolarIterations; ++i) {
+                Gram3 g = GetGram(b);
+                float drift = Drift(g);
+                if (drift <= PolarConvergedDrift) {
+                    return b;
+                }
+                if (drift >= 0.5f) {
+                    break;
+                }
+                // Column j of Q (3I - G) / 2 is (3 q_j - sum_i q_i G_ij) / 2
+                Basis3 next;
+                next.x = (b.x * (3.0f - g.xx) - b.y * g.xy - b.z * g.xz) * 0.5f;
+                next.y = (b.y * (3.0f - g.yy) - b.x * g.xy - b.z * g.yz) * 0.5f;
+                next.z = (b.z * (3.0f - g.zz) - b.x * g.xz - b.y * g.yz) * 0.5f;
+                b = next;
+            }
+            return Drift(GetGram(b)) <= PolarConvergedDrift ? b : GramSchmidt(b);
+        }
+
+        inline Basis3 Orthonormalise(const Basis3& b, OrthonormaliseMethod method) {
+            return method == OrthonormaliseMethod::Polar ? Polar(b) : GramSchmidt(b);
+        }
+
+        // Columns (m1, m2) and (m4, m5) of a 2D affine matrix
+        inline float Drift2D(const Matrix3& m) {
+            return std::max({ std::fabs(m.m1 * m.m1 + m.m2 * m.m2 - 1.0f), std::fabs(m.m4 * m.m4 + m.m5 * m.m5 - 1.0f),
+                std::fabs(m.m1 * m.m4 + m.m2 * m.m5) });
+        }
+    }
+
+    inline float OrthonormalDrift(const Matrix3& m) {
+        return Detail::Drift(Detail::GetGram(Detail::GetBasis(m)));
+    }
+
+    // Drift of the upper 3x3
+    inline float OrthonormalDrift(const Matrix4& m) {
+        return Detail::Drift(Detail::GetGram(Detail::GetBasis(m)));
+    }
+
+    // Drift of the 2x2 rotation part of a 2D affine matrix (translation in m7, m8)
+    inline float OrthonormalDrift2D(const Matrix3& m) {
+        return Detail::Drift2D(m);
+    }
+
+    inline void Orthonormalise(Matrix3& m, OrthonormaliseMethod method = OrthonormaliseMethod::Polar) {
+        Detail::SetBasis(m, Detail::Orthonormalise(Detail::GetBasis(m), method));
+    }
+
+    inline void Orthonormalise(Matrix4& m, OrthonormaliseMethod method = OrthonormaliseMethod::Polar) {
+        Detail::SetBasis(m, Detail::Orthonormalise(Detail::GetBasis(m), method));
+    }
+
+    // 2D affine matrices. The polar version has a closed form in 2D: the nearest rotation
+    // to [a b; c d] has angle atan2(c - b, a + d), so it is one normalise either way.
+    inline void Orthonormalise2D(Matrix3& m, OrthonormaliseMethod method = OrthonormaliseMethod::Polar) {
+        float c, s;
+        if (method == OrthonormaliseMethod::Polar) {
+            c = m.m1 + m.m5;
+            s = m.m2 - m.m4;
+        }
+        else {
+            c = m.m1;
+            s = m.m2;
+        }
+        float length = std::sqrt(c * c + s * s);
+        if (length > 0) {
+            c /= length;
+            s /= length;
+        }
+        else {
+            c = 1;
+            s = 0;
+        }
+        m.m1 = c; m.m2 = s;
+        m.m4 = -s; m.m5 = c;
+    }
+
+    namespace Detail {
+        // Copies in to arena memory a range at a time and repairs each range's copies
+        // while they are still in cache
+        template<typename M, typename Policy, typename Repair>
+        Span<M> OrthonormaliseCopies(Policy policy, FrameArena& arena, Span<const M> in, Repair repair) {
+            Span<M> out = arena.AllocateUninitialised<M>(in.Size());
+            if (out.Size() == in.Size()) {
+                ForEachRange(policy, in.Size(), GrainForBytes(2 * sizeof(M)), [&](std::size_t begin, std::size_t end) {
+                    std::copy(in.Data() + begin, in.Data() + end, out.Data() + begin);
+                    repair(out.Data() + begin, end - begin);
+                });
+            }
+            return out;
+        }
+    }
+
+    // Orthonormalises every matrix whose drift is above tolerance and leaves the rest
+    // untouched. The check is cheap next to the repair, so this can run every frame.
+    // The FrameArena overloads leave in alone and return repaired copies, or an empty
+    // span if the arena can't fit them.
+    template<typename Policy>
+    void OrthonormaliseMatrices(Policy policy, Matrix3* matrices, std::size_t count,
+        float tolerance = DefaultOrthonormalTolerance, OrthonormaliseMethod method = OrthonormaliseMethod::Polar)
+    {
+        ForEachRange(policy, count, GrainForBytes(sizeof(Matrix3)), [&](std::size_t begin, std::size_t end) {
+            for (std::size_t i = begin; i < end; ++i) {
+                Detail::Basis3 b = Detail::GetBasis(matrices[i]);
+                if (Detail::Drift(Detail::GetGram(b)) > tolerance) {
+                    Detail::SetBasis(matrices[i], Detail::Orthonormalise(b, method));
+                }
+            }
+        });
+    }
+
+    inline void OrthonormaliseMatrices(Matrix3* matrices, std::size_t count,
+        float tolerance = DefaultOrthonormalTolerance, OrthonormaliseMethod method = OrthonormaliseMethod::Polar)
+    {
+        OrthonormaliseMatrices(Execution::Seq, matrices, count, tolerance, method);
+    }
+
+    template<typename Policy>
+    Span<Matrix3> OrthonormaliseMatrices(Policy policy, FrameArena& arena, Span<const Matrix3> in,
+        float tolerance = DefaultOrthonormalTolerance, OrthonormaliseMethod method = OrthonormaliseMethod::Polar)
+    {
+        return Detail::OrthonormaliseCopies<Matrix3>(policy, arena, in, [&](Matrix3* matrices, std::size_t count) {
+            OrthonormaliseMatrices(Execution::Seq, matrices, count, tolerance, method);
+        });
+    }
+
+    inline Span<Matrix3> OrthonormaliseMatrices(FrameArena& arena, Span<const Matrix3> in,
+        float tolerance = DefaultOrthonormalTolerance, OrthonormaliseMethod method = OrthonormaliseMethod::Polar)
+    {
+        return OrthonormaliseMatrices(Execution::Seq, arena, in, tolerance, method);
+    }
+
+    template<typename Policy>
+    void OrthonormaliseMatrices(Policy policy, Matrix4* matrices, std::size_t count,
+        float tolerance = DefaultOrthonormalTolerance, OrthonormaliseMethod method = OrthonormaliseMethod::Polar)
+    {
+        ForEachRange(policy, count, GrainForBytes(sizeof(Matrix4)), [&](std::size_t begin, std::size_t end) {
+            for (std::size_t i = begin; i < end; ++i) {
+                Detail::Basis3 b = Detail::GetBasis(matrices[i]);
+                if (Detail::Drift(Detail::GetGram(b)) > tolerance) {
+                    Detail::SetBasis(matrices[i], Detail::Orthonormalise(b, method));
+                }
+            }
+        });
+    }
+
+    inline void OrthonormaliseMatrices(Matrix4* matrices, std::size_t count,
+        float tolerance = DefaultOrthonormalTolerance, OrthonormaliseMethod method = OrthonormaliseMethod::Polar)
+    {
+        OrthonormaliseMatrices(Execution::Seq, matrices, count, tolerance, method);
+    }
+
+    template<typename Policy>
+    Span<Matrix4> OrthonormaliseMatrices(Policy policy, FrameArena& arena, Span<const Matrix4> in,
+        float tolerance = DefaultOrthonormalTolerance, OrthonormaliseMethod method = OrthonormaliseMethod::Polar)
+    {
+        return Detail::OrthonormaliseCopies<Matrix4>(policy, arena, in, [&](Matrix4* matrices, std::size_t count) {
+            OrthonormaliseMatrices(Execution::Seq, matrices, count, tolerance, method);
+        });
+    }
+
+    inline Span<Matrix4> OrthonormaliseMatrices(FrameArena& arena, Span<const Matrix4> in,
+        float tolerance = DefaultOrthonormalTolerance, OrthonormaliseMethod method = OrthonormaliseMethod::Polar)
+    {
+        return OrthonormaliseMatrices(Execution::Seq, arena, in, tolerance, method);
+    }
+
+    template<typename Policy>
+    void OrthonormaliseMatrices2D(Policy policy, Matrix3* matrices, std::size_t count,
+        float tolerance = DefaultOrthonormalTolerance, OrthonormaliseMethod method = OrthonormaliseMethod::Polar)
+    {
+        ForEachRange(policy, count, GrainForBytes(sizeof(Matrix3)), [&](std::size_t begin, std::size_t end) {
+            for (std::size_t i = begin; i < end; ++i) {
+                if (Detail::Drift2D(matrices[i]) > tolerance) {
+                    Orthonormalise2D(matrices[i], method);
+                }
+            }
+        });
+    }
+
+    inline void OrthonormaliseMatrices2D(Matrix3* matrices, std::size_t count,
+        float tolerance = DefaultOrthonormalTolerance, OrthonormaliseMethod method = OrthonormaliseMethod::Polar)
+    {
+        OrthonormaliseMatrices2D(Execution::Seq, matrices, count, tolerance, method);
+    }
+
+    template<typename Policy>
+    Span<Matrix3> OrthonormaliseMatrices2D(Policy policy, FrameArena& arena, Span<const Matrix3> in,
+        float tolerance = DefaultOrthonormalTolerance, OrthonormaliseMethod method = OrthonormaliseMethod::Polar)
+    {
+        return Detail::OrthonormaliseCopies<Matrix3>(policy, arena, in, [&](Matrix3* matrices, std::size_t count) {
+            OrthonormaliseMatrices2D(Execution::Seq, matrices, count, tolerance, method);
+        });
+    }
+
+    inline Span<Matrix3> OrthonormaliseMatrices2D(FrameArena& arena, Span<const Matrix3> in,
+        float tolerance = DefaultOrthonormalTolerance, OrthonormaliseMethod method = OrthonormaliseMethod::Polar)
+    {
+        return OrthonormaliseMatrices2D(Execution::Seq, arena, in, tolerance, method);
+    }
+}
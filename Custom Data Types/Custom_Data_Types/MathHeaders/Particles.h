@@ -0,0 +1,279 @@
+#pragma once
+#include "Vector3.h"
+#include "Simd.h"
+#include "Aligned.h"
+#include "ThreadPool.h"
+#include <cstddef>
+
+namespace MathClasses {
+
+    // Pulls particles towards a point with inverse square falloff; a negative strength
+    // pushes them away. Within minDistance the pull stops growing.
+    struct PointAttractor {
+        Vector3 position;
+        float strength = 0.0f;
+        float minDistance = 0.1f;
+    };
+
+    // Forces applied to every particle on top of its own acceleration stream
+    struct ParticleForces {
+        Vector3 gravity;
+        float drag = 0.0f;  // fraction of velocity removed per second
+        const PointAttractor* attractors = nullptr;
+        std::size_t attractorCount = 0;
+    };
+
+    // Particles are kept on the side the normal points to: normal . p >= distance
+    struct CollisionPlane {
+        Vector3 normal;
+        float distance = 0.0f;
+    };
+
+    // Particles are kept outside the sphere
+    struct CollisionSphere {
+        Vector3 centre;
+        float radius = 0.0f;
+    };
+
+    struct ParticleColliders {
+        const CollisionPlane* planes = nullptr;
+        std::size_t planeCount = 0;
+        const CollisionSphere* spheres = nullptr;
+        std::size_t sphereCount = 0;
+        float restitution = 0.5f;   // fraction of normal speed kept when bouncing
+        float friction = 0.0f;      // fraction of tangential speed lost on contact
+    };
+
+    enum class ParticleStream {
+        PositionX, PositionY, PositionZ,
+        VelocityX, VelocityY, VelocityZ,
+        AccelerationX, AccelerationY, AccelerationZ,   // per particle, added to ParticleForces
+        Age, Lifetime,
+        Count
+    };
+
+    // Fixed capacity particle system stored as one aligned array per component (SoA),
+    // so the integrators load eight particles' x, y or z in a single register.
+    // Arrays are padded to a multiple of eight and threads are given whole blocks of
+    // eight. Particles whose age reaches their lifetime are dead; they keep being
+    // integrated (the kernels don't branch per particle) until Compact removes them.
+    class ParticleSystem {
+    public:
+        static constexpr std::size_t BlockSize = 8;
+
+        explicit ParticleSystem(std::size_t capacity)
+            : capacity(capacity)
+        {
+            std::size_t padded = (capacity + BlockSize - 1) / BlockSize * BlockSize;
+            for (AlignedVector<float, 64>& stream : streams) {
+                stream.assign(padded, 0.0f);
+            }
+        }
+
+        std::size_t GetCapacity() const { return capacity; }
+        std::size_t GetCount() const { return count; }
+
+        float* GetStream(ParticleStream stream) { return streams[static_cast<int>(stream)].data(); }
+        const float* GetStream(ParticleStream stream) const { return streams[static_cast<int>(stream)].data(); }
+
+        // Adds a particle; returns false if the system is full
+        bool Emit(const Vector3& position, const Vector3& velocity, float lifetime) {
+            if (count == capacity) {
+                return false;
+            }
+            Set(ParticleStream::PositionX, position);
+            Set(ParticleStream::VelocityX, velocity);
+            Set(ParticleStream::AccelerationX, Vector3());
+            GetStream(ParticleStream::Age)[count] = 0.0f;
+            GetStream(ParticleStream::Lifetime)[count] = lifetime;
+            ++count;
+            return true;
+        }
+
+        Vector3 GetPosition(std::size_t i) const { return Get(ParticleStream::PositionX, i); }
+        Vector3 GetVelocity(std::size_t i) const { return Get(ParticleStream::VelocityX, i); }
+
+        bool IsAlive(std::size_t i) const {
+            return GetStream(ParticleStream::Age)[i] < GetStream(ParticleStream::Lifetime)[i];
+        }
+
+        // Semi-implicit Euler: v += a * dt, then p += v * dt. Collisions push particles
+        // out and reflect the velocity's normal part with the colliders' restitution.
+        template<typename Policy>
+        void StepEuler(Policy policy, float dt, const ParticleForces& forces, const ParticleColliders& colliders = ParticleColliders()) {
+            Step(policy, dt, forces, colliders, false);
+        }
+
+        void StepEuler(float dt, const ParticleForces& forces, const ParticleColliders& colliders = ParticleColliders()) {
+            StepEuler(Execution::Seq, dt, forces, colliders);
+        }
+
+        // Position Verlet: p += v * dt + a * dt^2, then velocity is recovered as the
+        // distance moved over dt after collisions have projected the position. Contacts
+        // therefore stop particles without bouncing, which suits resting piles.
+        template<typename Policy>
+        void StepVerlet(Policy policy, float dt, const ParticleForces& forces, const ParticleColliders& colliders = ParticleColliders()) {
+            Step(policy, dt, forces, colliders, true);
+        }
+
+        void StepVerlet(float dt, const ParticleForces& forces, const ParticleColliders& colliders = ParticleColliders()) {
+            StepVerlet(Execution::Seq, dt, forces, colliders);
+        }
+
+        // Removes dead particles, keeping the survivors in their original order.
+        // Returns how many were removed.
+        std::size_t Compact() {
+            const float* age = GetStream(ParticleStream::Age);
+            const float* lifetime = GetStream(ParticleStream::Lifetime);
+            std::size_t alive = 0;
+            for (std::size_t i = 0; i < count; ++i) {
+                if (age[i] < lifetime[i]) {
+                    if (alive != i) {
+                        for (AlignedVector<float, 64>& stream : streams) {
+                            stream[alive] = stream[i];
+                        }
+                    }
+                    ++alive;
+                }
+            }
+            std::size_t removed = count - alive;
+            count = alive;
+            return removed;
+        }
+
+    private:
+        static constexpr int StreamCount = static_cast<int>(ParticleStream::Count);
+
+        void Set(ParticleStream first, const Vector3& v) {
+            int s = static_cast<int>(first);
+            streams[s][count] = v.x;
+            streams[s + 1][count] = v.y;
+            streams[s + 2][count] = v.z;
+        }
+
+        Vector3 Get(ParticleStream first, std::size_t i) const {
+            int s = static_cast<int>(first);
+            return Vector3(streams[s][i], streams[s + 1][i], streams[s + 2][i]);
+        }
+
+        // Pushes positions out of a surface with unit normal (nx, ny, nz) where penetration
+        // (how far inside, positive when inside) is > 0, and bounces the velocity
+        static void Resolve(Float8 penetration, Float8 nx, Float8 ny, Float8 nz,
+            Float8& px, Float8& py, Float8& pz, Float8& vx, Float8& vy, Float8& vz,
+            const ParticleColliders& colliders, bool verlet)
+        {
+            Float8 inside = penetration > Float8::Zero();
+            Float8 push = Select(inside, penetration, Float8::Zero());
+            px += nx * push;
+            py += ny * push;
+            pz += nz * push;
+            if (verlet) {
+                return;
+            }
+
+            Float8 vn = nx * vx + ny * vy + nz * vz;
+            Float8 hit = inside & (vn < Float8::Zero());
+            Float8 keep(1.0f - colliders.friction);
+            Float8 bounce(-colliders.restitution);
+            Float8 tx = vx - nx * vn, ty = vy - ny * vn, tz = vz - nz * vn;
+            vx = Select(hit, tx * keep + nx * vn * bounce, vx);
+            vy = Select(hit, ty * keep + ny * vn * bounce, vy);
+            vz = Select(hit, tz * keep + nz * vn * bounce, vz);
+        }
+
+        void StepBlocks(std::size_t firstBlock, std::size_t lastBlock, float dt, const ParticleForces& forces,
+            const ParticleColliders& colliders, bool verlet)
+        {
+            float* s[StreamCount];
+            for (int i = 0; i < StreamCount; ++i) {
+                s[i] = streams[i].data();
+            }
+            const Float8 zero = Float8::Zero();
+            Float8 step(dt), drag(forces.drag);
+            Float8 gx(forces.gravity.x), gy(forces.gravity.y), gz(forces.gravity.z);
+
+            for (std::size_t block = firstBlock; block < lastBlock; ++block) {
+                std::size_t i = block * BlockSize;
+                Float8 px = Float8::Load(s[0] + i), py = Float8::Load(s[1] + i), pz = Float8::Load(s[2] + i);
+                Float8 vx = Float8::Load(s[3] + i), vy = Float8::Load(s[4] + i), vz = Float8::Load(s[5] + i);
+                Float8 ax = Float8::Load(s[6] + i) + gx - drag * vx;
+                Float8 ay = Float8::Load(s[7] + i) + gy - drag * vy;
+                Float8 az = Float8::Load(s[8] + i) + gz - drag * vz;
+
+                for (std::size_t a = 0; a < forces.attractorCount; ++a) {
+                    const PointAttractor& attractor = forces.attractors[a];
+                    Float8 dx = Float8(attractor.position.x) - px;
+                    Float8 dy = Float8(attractor.position.y) - py;
+                    Float8 dz = Float8(attractor.position.z) - pz;
+                    Float8 d2 = Max(dx * dx + dy * dy + dz * dz, Float8(attractor.minDistance * attractor.minDistance));
+                    // strength / d^2 along the unit direction d / |d|
+                    Float8 scale = Float8(attractor.strength) / (d2 * Sqrt(d2));
+                    ax += dx * scale;
+                    ay += dy * scale;
+                    az += dz * scale;
+                }
+
+                Float8 oldX = px, oldY = py, oldZ = pz;
+                if (verlet) {
+                    Float8 dt2 = step * step;
+                    px += vx * step + ax * dt2;
+                    py += vy * step + ay * dt2;
+                    pz += vz * step + az * dt2;
+                }
+                else {
+                    vx += ax * step;
+                    vy += ay * step;
+                    vz += az * step;
+                    px += vx * step;
+                    py += vy * step;
+                    pz += vz * step;
+                }
+
+                for (std::size_t c = 0; c < colliders.planeCount; ++c) {
+                    const CollisionPlane& plane = colliders.planes[c];
+                    Float8 nx(plane.normal.x), ny(plane.normal.y), nz(plane.normal.z);
+                    Float8 penetration = Float8(plane.distance) - (nx * px + ny * py + nz * pz);
+                    Resolve(penetration, nx, ny, nz, px, py, pz, vx, vy, vz, colliders, verlet);
+                }
+
+                for (std::size_t c = 0; c < colliders.sphereCount; ++c) {
+                    const CollisionSphere& sphere = colliders.spheres[c];
+                    Float8 ox = px - Float8(sphere.centre.x);
+                    Float8 oy = py - Float8(sphere.centre.y);
+                    Float8 oz = pz - Float8(sphere.centre.z);
+                    Float8 d = Sqrt(ox * ox + oy * oy + oz * oz);
+                    // A particle exactly at the centre is pushed out upwards
+                    Float8 centred = d <= zero;
+                    Float8 inv = Float8(1.0f) / Select(centred, Float8(1.0f), d);
+                    Float8 nx = Select(centred, zero, ox * inv);
+                    Float8 ny = Select(centred, Float8(1.0f), oy * inv);
+                    Float8 nz = Select(centred, zero, oz * inv);
+                    Resolve(Float8(sphere.radius) - d, nx, ny, nz, px, py, pz, vx, vy, vz, colliders, verlet);
+                }
+
+                if (verlet) {
+                    Float8 invDt(dt > 0.0f ? 1.0f / dt : 0.0f);
+                    vx = (px - oldX) * invDt;
+                    vy = (py - oldY) * invDt;
+                    vz = (pz - oldZ) * invDt;
+                }
+
+                px.Store(s[0] + i); py.Store(s[1] + i); pz.Store(s[2] + i);
+                vx.Store(s[3] + i); vy.Store(s[4] + i); vz.Store(s[5] + i);
+                (Float8::Load(s[9] + i) + step).Store(s[9] + i);
+            }
+        }
+
+        template<typename Policy>
+        void Step(Policy policy, float dt, const ParticleForces& forces, const ParticleColliders& colliders, bool verlet) {
+            std::size_t blocks = (count + BlockSize - 1) / BlockSize;
+            ForEachRange(policy, blocks, GrainForBytes(BlockSize * sizeof(float) * StreamCount), [&](std::size_t begin, std::size_t end) {
+                StepBlocks(begin, end, dt, forces, colliders, verlet);
+            });
+        }
+
+        AlignedVector<float, 64> streams[StreamCount];
+        std::size_t capacity;
+        std::size_t count = 0;
+    };
+}
@@ -0,0 +1,174 @@
+#pragma once
+#include "Vector3.h"
+#include "Matrix3.h"
+#include "Matrix4.h"
+#include <string>
+#include <cmath>
+
+namespace MathClasses {
+    // Rotation stored as a unit quaternion (x, y, z) = axis * sin(angle / 2), w = cos(angle / 2).
+    // Rotates the same way as the Matrix3/Matrix4 rotation builders.
+    struct Quaternion {
+        float x, y, z, w;
+
+        // Default constructor gives the identity rotation
+        Quaternion() : x(0), y(0), z(0), w(1) {}
+
+        Quaternion(float x, float y, float z, float w) : x(x), y(y), z(z), w(w) {}
+
+        static Quaternion MakeIdentity() {
+            return Quaternion(0, 0, 0, 1);
+        }
+
+        // Rotation of radians around a unit axis
+        static Quaternion MakeAxisAngle(const Vector3& axis, float radians) {
+            return MakeAxisAngle(Precision::Exact, axis, radians);
+        }
+
+        // As above with sin and cos at a chosen precision (see FastMath.h)
+        template<typename Precision>
+        static Quaternion MakeAxisAngle(Precision precision, const Vector3& axis, float radians) {
+            float s, c;
+            SinCos(precision, radians * 0.5f, s, c);
+            return Quaternion(axis.x * s, axis.y * s, axis.z * s, c);
+        }
+
+        // Rotation part of a matrix whose upper 3x3 is a pure rotation
+        static Quaternion FromMatrix(const Matrix4& m) {
+            return FromRotation(m.m1, m.m5, m.m9, m.m2, m.m6, m.m10, m.m3, m.m7, m.m11);
+        }
+
+        // Rotation from a 3D rotation matrix
+        static Quaternion FromMatrix(const Matrix3& m) {
+            return FromRotation(m.m1, m.m4, m.m7, m.m2, m.m5, m.m8, m.m3, m.m6, m.m9);
+        }
+
+        // Builds from the rotation elements given row by row (rRC is row R, column C)
+        static Quaternion FromRotation(float r00, float r01, float r02,
+            float r10, float r11, float r12,
+            float r20, float r21, float r22)
+        {
+            // Shepperd's method: pivot on the largest of w, x, y, z to stay accurate
+            float trace = r00 + r11 + r22;
+            if (trace > 0.0f) {
+                float s = std::sqrt(trace + 1.0f) * 2.0f;
+                return Quaternion((r21 - r12) / s, (r02 - r20) / s, (r10 - r01) / s, 0.25f * s);
+            }
+            if (r00 > r11 && r00 > r22) {
+                float s = std::sqrt(1.0f + r00 - r11 - r22) * 2.0f;
+                return Quaternion(0.25f * s, (r01 + r10) / s, (r02 + r20) / s, (r21 - r12) / s);
+            }
+            if (r11 > r22) {
+                float s = std::sqrt(1.0f + r11 - r00 - r22) * 2.0f;
+                return Quaternion((r01 + r10) / s, 0.25f * s, (r12 + r21) / s, (r02 - r20) / s);
+            }
+            float s = std::sqrt(1.0f + r22 - r00 - r11) * 2.0f;
+            return Quaternion((r02 + r20) / s, (r12 + r21) / s, 0.25f * s, (r10 - r01) / s);
+        }
+
+        // Rotation matrix with no translation
+        Matrix4 ToMatrix4() const {
+            float xx = x * x, yy = y * y, zz = z * z;
+            float xy = x * y, xz = x * z, yz = y * z;
+            float wx = w * x, wy = w * y, wz = w * z;
+            return Matrix4(
+                1 - 2 * (yy + zz), 2 * (xy + wz), 2 * (xz - wy), 0,
+                2 * (xy - wz), 1 - 2 * (xx + zz), 2 * (yz + wx), 0,
+                2 * (xz + wy), 2 * (yz - wx), 1 - 2 * (xx + yy), 0,
+                0, 0, 0, 1
+            );
+        }
+
+        Matrix3 ToMatrix3() const {
+            float xx = x * x, yy = y * y, zz = z * z;
+            float xy = x * y, xz = x * z, yz = y * z;
+            float wx = w * x, wy = w * y, wz = w * z;
+            return Matrix3(
+                1 - 2 * (yy + zz), 2 * (xy + wz), 2 * (xz - wy),
+                2 * (xy - wz), 1 - 2 * (xx + zz), 2 * (yz + wx),
+                2 * (xz + wy), 2 * (yz - wx), 1 - 2 * (xx + yy)
+            );
+        }
+
+        // Hamilton product: applies other first, then this
+        Quaternion operator*(const Quaternion& other) const {
+            return Quaternion(
+                w * other.x + x * other.w + y * other.z - z * other.y,
+                w * other.y - x * other.z + y * other.w + z * other.x,
+                w * other.z + x * other.y - y * other.x + z * other.w,
+                w * other.w - x * other.x - y * other.y - z * other.z
+            );
+        }
+
+        Quaternion operator+(const Quaternion& other) const {
+            return Quaternion(x + other.x, y + other.y, z + other.z, w + other.w);
+        }
+
+        Quaternion operator*(float scalar) const {
+            return Quaternion(x * scalar, y * scalar, z * scalar, w * scalar);
+        }
+
+        // Rotates a vector
+        Vector3 operator*(const Vector3& v) const {
+            // v + 2w(q x v) + 2q x (q x v), with q the vector part
+            Vector3 q(x, y, z);
+            Vector3 t = q.Cross(v) * 2.0f;
+            return v + t * w + q.Cross(t);
+        }
+
+        // Inverse rotation for a unit quaternion
+        Quaternion Conjugate() const {
+            return Quaternion(-x, -y, -z, w);
+        }
+
+        float Dot(const Quaternion& other) const {
+            return x * other.x + y * other.y + z * other.z + w * other.w;
+        }
+
+        float Magnitude() const {
+            return std::sqrt(x * x + y * y + z * z + w * w);
+        }
+
+        void Normalise() {
+            float mag = Magnitude();
+            if (mag > 0) {
+                x /= mag;
+                y /= mag;
+                z /= mag;
+                w /= mag;
+            }
+        }
+
+        Quaternion Normalised() const {
+            Quaternion copy = *this;
+            copy.Normalise();
+            return copy;
+        }
+
+        // q and -q are the same rotation, so both compare equal
+        bool operator==(const Quaternion& other) const {
+            const float EPSILON = 0.0001f;
+            float sign = Dot(other) < 0 ? -1.0f : 1.0f;
+            return (std::fabs(x - sign * other.x) < EPSILON) &&
+                (std::fabs(y - sign * other.y) < EPSILON) &&
+                (std::fabs(z - sign * other.z) < EPSILON) &&
+                (std::fabs(w - sign * other.w) < EPSILON);
+        }
+
+        bool operator!=(const Quaternion& other) const {
+            return !(*this == other);
+        }
+
+        std::string ToString() const {
+            return std::to_string(x) + ", " + std::to_string(y) + ", " + std::to_string(z) + ", " + std::to_string(w);
+        }
+    };
+
+    template<typename T>
+    bool Matrix<T, 4, 4>::Decompose(Vector<T, 3>& translation, Quaternion& rotation, Vector<T, 3>& scale) const {
+        Matrix<T, 3, 3> basis;
+        bool valid = Decompose(translation, basis, scale);
+        rotation = Quaternion::FromMatrix(Matrix3(basis));
+        return valid;
+    }
+}
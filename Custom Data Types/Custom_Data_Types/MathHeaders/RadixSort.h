@@ -0,0 +1,204 @@
+#pragma once
+#include "FrameArena.h"
+#include "ThreadPool.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace MathClasses {
+
+    namespace Detail {
+        // Keys per histogram block. Fixed, so the blocks (and the result) don't depend
+        // on the thread count.
+        constexpr std::size_t RadixBlock = 1 << 16;
+
+        // Maps a float to an unsigned int that sorts in the same order
+        inline uint32_t SortableFloatBits(float f) {
+            uint32_t bits;
+            std::memcpy(&bits, &f, sizeof(bits));
+            return (bits & 0x80000000u) ? ~bits : (bits | 0x80000000u);
+        }
+
+        inline std::size_t RadixBlocks(std::size_t count) {
+            return (count + RadixBlock - 1) / RadixBlock;
+        }
+    }
+
+    // Working memory for RadixSort. Kept from call to call, it only allocates when
+    // asked to sort more keys than before.
+    template<typename Key>
+    struct RadixSortScratch {
+        std::vector<Key> keys;
+        std::vector<uint32_t> order;
+        std::vector<std::size_t> offsets;
+    };
+
+    namespace Detail {
+        // RadixSort with its working memory given: count keys, count order entries if
+        // order isn't null, and RadixBlocks(count) << DigitBits offsets
+        template<int DigitBits, typename Policy, typename Key>
+        void RadixSortWith(Policy policy, Key* keys, std::size_t count, uint32_t* order, int keyBits,
+            Key* keyScratch, uint32_t* orderScratch, std::size_t* offsets)
+        {
+            static_assert(std::is_unsigned<Key>::value, "RadixSort sorts unsigned integer keys");
+            static_assert(DigitBits > 0 && DigitBits <= 16, "RadixSort digits are 1 to 16 bits");
+            constexpr std::size_t Radix = std::size_t(1) << DigitBits;
+            if (order) {
+                ForEachRange(policy, count, GrainForBytes(sizeof(uint32_t)), [&](std::size_t begin, std::size_t end) {
+                    for (std::size_t i = begin; i < end; ++i) {
+                        order[i] = uint32_t(i);
+                    }
+                });
+            }
+
+            std::size_t blocks = RadixBlocks(count);
+            Key* src = keys;
+            Key* dst = keyScratch;
+            uint32_t* srcOrder = order;
+            uint32_t* dstOrder = order ? orderScratch : nullptr;
+
+            int passes = (keyBits + DigitBits - 1) / DigitBits;
+            for (int pass = 0; pass < passes; ++pass) {
+                int shift = pass * DigitBits;
+                uint32_t mask = keyBits - shift >= DigitBits ? uint32_t(Radix - 1) : (1u << (keyBits - shift)) - 1;
+                ForEachRange(policy, blocks, 1, [&](std::size_t begin, std::size_t end) {
+                    for (std::size_t b = begin; b < end; ++b) {
+                        std::size_t* counts = offsets + b * Radix;
+                        std::memset(counts, 0, Radix * sizeof(std::size_t));
+                        std::size_t last = (b + 1) * RadixBlock < count ? (b + 1) * RadixBlock : count;
+                        for (std::size_t i = b * RadixBlock; i < last; ++i) {
+                            ++counts[(src[i] >> shift) & mask];
+                        }
+                    }
+                });
+
+                // Digit by digit, block by block, so block b's share of a digit lands after
+                // every earlier block's
+                std::size_t offset = 0;
+                bool trivial = false;
+                for (std::size_t digit = 0; digit < Radix && !trivial; ++digit) {
+                    std::size_t digitStart = offset;
+                    for (std::size_t b = 0; b < blocks; ++b) {
+                        std::size_t c = offsets[b * Radix + digit];
+                        offsets[b * Radix + digit] = offset;
+                        offset += c;
+                    }
+                    trivial = offset - digitStart == count;
+                }
+                if (trivial || count == 0) {
+                    continue;
+                }
+
+                ForEachRange(policy, blocks, 1, [&](std::size_t begin, std::size_t end) {
+                    for (std::size_t b = begin; b < end; ++b) {
+                        std::size_t* next = offsets + b * Radix;
+                        std::size_t last = (b + 1) * RadixBlock < count ? (b + 1) * RadixBlock : count;
+                        for (std::size_t i = b * RadixBlock; i < last; ++i) {
+                            std::size_t to = next[(src[i] >> shift) & mask]++;
+                            dst[to] = src[i];
+                            if (srcOrder) {
+                                dstOrder[to] = srcOrder[i];
+                            }
+                        }
+                    }
+                });
+                std::swap(src, dst);
+                std::swap(srcOrder, dstOrder);
+            }
+
+            if (src != keys) {
+                ForEachRange(policy, count, GrainForBytes(sizeof(Key) + sizeof(uint32_t)), [&](std::size_t begin, std::size_t end) {
+                    for (std::size_t i = begin; i < end; ++i) {
+                        keys[i] = src[i];
+                        if (order) {
+                            order[i] = srcOrder[i];
+                        }
+                    }
+                });
+            }
+        }
+    }
+
+    // Stable LSD radix sort of unsigned keys on DigitBits bit digits, sorting the keys in
+    // place. Eight bit digits keep the counts small; wider ones (RadixSort<11> does 32
+    // bit keys in three passes) trade larger counts for fewer passes over the keys.
+    // If order isn't null, order[i] receives the original index of the key that ends
+    // up at i, which ApplyPermutation can use to reorder any arrays that go with the
+    // keys. Only the low keyBits bits are sorted on, one pass per digit, so 24 bit keys
+    // in a uint32_t take three 8 bit passes rather than four.
+    //
+    // Each pass counts digits per block of keys in parallel, turns the counts into
+    // per block offsets, then scatters the blocks in parallel; a block writes its keys
+    // in order, so the sort stays stable. Passes where every key has the same digit
+    // are skipped.
+    template<int DigitBits = 8, typename Policy, typename Key>
+    void RadixSort(Policy policy, Key* keys, std::size_t count, uint32_t* order, RadixSortScratch<Key>& scratch,
+        int keyBits = int(sizeof(Key) * 8))
+    {
+        // resize only allocates when the scratch grows
+        scratch.keys.resize(count);
+        scratch.order.resize(order ? count : 0);
+        scratch.offsets.resize(Detail::RadixBlocks(count) << DigitBits);
+        Detail::RadixSortWith<DigitBits>(policy, keys, count, order, keyBits, scratch.keys.data(), scratch.order.data(),
+            scratch.offsets.data());
+    }
+
+    template<int DigitBits = 8, typename Key>
+    void RadixSort(Key* keys, std::size_t count, uint32_t* order, RadixSortScratch<Key>& scratch, int keyBits = int(sizeof(Key) * 8)) {
+        RadixSort<DigitBits>(Execution::Seq, keys, count, order, scratch, keyBits);
+    }
+
+    // Allocates its working memory on every call; sorts that run every frame should
+    // keep a RadixSortScratch or use the FrameArena overload
+    template<int DigitBits = 8, typename Policy, typename Key>
+    void RadixSort(Policy policy, Key* keys, std::size_t count, uint32_t* order, int keyBits = int(sizeof(Key) * 8)) {
+        RadixSortScratch<Key> scratch;
+        RadixSort<DigitBits>(policy, keys, count, order, scratch, keyBits);
+    }
+
+    template<int DigitBits = 8, typename Key>
+    void RadixSort(Key* keys, std::size_t count, uint32_t* order, int keyBits = int(sizeof(Key) * 8)) {
+        RadixSort<DigitBits>(Execution::Seq, keys, count, order, keyBits);
+    }
+
+    // Takes the working memory from the arena and hands it back before returning.
+    // Returns false, with the keys left as they were, if the arena can't fit it.
+    template<int DigitBits = 8, typename Policy, typename Key>
+    bool RadixSort(Policy policy, FrameArena& arena, Key* keys, std::size_t count, uint32_t* order, int keyBits = int(sizeof(Key) * 8)) {
+        ArenaScope scope(arena);
+        std::size_t orderCount = order ? count : 0;
+        std::size_t offsetCount = Detail::RadixBlocks(count) << DigitBits;
+        Span<Key> keyScratch = arena.AllocateUninitialised<Key>(count);
+        Span<uint32_t> orderScratch = arena.AllocateUninitialised<uint32_t>(orderCount);
+        Span<std::size_t> offsets = arena.AllocateUninitialised<std::size_t>(offsetCount);
+        if (keyScratch.Size() != count || orderScratch.Size() != orderCount || offsets.Size() != offsetCount) {
+            return false;
+        }
+        Detail::RadixSortWith<DigitBits>(policy, keys, count, order, keyBits, keyScratch.Data(), orderScratch.Data(), offsets.Data());
+        return true;
+    }
+
+    template<int DigitBits = 8, typename Key>
+    bool RadixSort(FrameArena& arena, Key* keys, std::size_t count, uint32_t* order, int keyBits = int(sizeof(Key) * 8)) {
+        return RadixSort<DigitBits>(Execution::Seq, arena, keys, count, order, keyBits);
+    }
+
+    // out[i] = in[order[i]], e.g. to bring an attribute array into the order RadixSort
+    // produced. out must not overlap in.
+    template<typename Policy, typename T>
+    void ApplyPermutation(Policy policy, const T* in, const uint32_t* order, T* out, std::size_t count) {
+        ForEachRange(policy, count, GrainForBytes(sizeof(T) + sizeof(uint32_t)), [&](std::size_t begin, std::size_t end) {
+            for (std::size_t i = begin; i < end; ++i) {
+                out[i] = in[order[i]];
+            }
+        });
+    }
+
+    template<typename T>
+    void ApplyPermutation(const T* in, const uint32_t* order, T* out, std::size_t count) {
+        ApplyPermutation(Execution::Seq, in, order, out, count);
+    }
+}
@@ -0,0 +1,419 @@
+#pragma once
+#include "Vector3.h"
+#include "Vector4.h"
+#include "Matrix4.h"
+#include "Colour.h"
+#include "Simd.h"
+#include "Aligned.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace MathClasses {
+
+    // Colour plus depth render target. Rows are padded to a multiple of four pixels so
+    // the rasteriser can always work on four pixels at once; the padding is never shown.
+    class Framebuffer {
+    public:
+        Framebuffer(int width, int height)
+            : width(width), height(height), stride((width + 3) & ~3),
+            colours(std::size_t(stride) * height), depths(std::size_t(stride) * height, 1.0f) {}
+
+        int GetWidth() const { return width; }
+        int GetHeight() const { return height; }
+
+        // Distance in pixels from one row to the next
+        int GetStride() const { return stride; }
+
+        Colour* GetColours() { return colours.data(); }
+        const Colour* GetColours() const { return colours.data(); }
+        float* GetDepths() { return depths.data(); }
+        const float* GetDepths() const { return depths.data(); }
+
+        // (0, 0) is the top left pixel
+        Colour GetPixel(int x, int y) const { return colours[std::size_t(y) * stride + x]; }
+
+        // 0 at the near plane, 1 at the far plane
+        float GetDepth(int x, int y) const { return depths[std::size_t(y) * stride + x]; }
+
+        void Clear(Colour colour, float depth = 1.0f) {
+            std::fill(colours.begin(), colours.end(), colour);
+            std::fill(depths.begin(), depths.end(), depth);
+        }
+
+    private:
+        int width;
+        int height;
+        int stride;
+        std::vector<Colour> colours;
+        AlignedVector<float, 64> depths;
+    };
+
+    enum class CullMode {
+        None,
+        Back,   // triangles wound clockwise on screen
+        Front
+    };
+
+    // An indexed triangle list and the matrix that takes its positions to clip space
+    // (projection * view * model). Triangles wound counter-clockwise on screen face
+    // the camera, as in OpenGL.
+    struct DrawCall {
+        Matrix4 transform;
+        const Vector3* positions = nullptr;
+        std::size_t vertexCount = 0;
+        const uint32_t* indices = nullptr;
+        std::size_t triangleCount = 0;
+        const Colour* colours = nullptr;    // per vertex; when null the whole draw uses colour
+        Colour colour;
+        CullMode cull = CullMode::Back;
+        bool writeColour = true;            // false only updates depth, e.g. for occluders
+    };
+
+    namespace Detail {
+        struct ClipVertex {
+            Vector4 position;
+            float colour[4];
+        };
+
+        // Triangle ready to rasterise: snapped screen position, depth in [0, 1] and 1/w,
+        // with colour premultiplied by 1/w for perspective correct interpolation
+        struct ScreenTriangle {
+            float x[3], y[3], z[3], invW[3];
+            float colour[3][4];
+            int minX, minY, maxX, maxY;
+            bool flat;
+            bool writeColour;
+        };
+
+        // Signed distance inside each clip plane: -w <= x, y, z <= w (OpenGL clip space)
+        inline float ClipDistance(const Vector4& p, int plane) {
+            switch (plane) {
+            case 0: return p.w + p.x;
+            case 1: return p.w - p.x;
+            case 2: return p.w + p.y;
+            case 3: return p.w - p.y;
+            case 4: return p.w + p.z;
+            default: return p.w - p.z;
+            }
+        }
+
+        inline int ClipOutcode(const Vector4& p) {
+            int code = 0;
+            for (int plane = 0; plane < 6; ++plane) {
+                code |= (ClipDistance(p, plane) < 0.0f) << plane;
+            }
+            return code;
+        }
+
+        // Sutherland-Hodgman against the planes in the mask. A triangle can grow to
+        // nine vertices after six planes.
+        inline int ClipPolygon(ClipVertex* polygon, int count, int planes) {
+            ClipVertex scratch[9];
+            for (int plane = 0; plane < 6 && count > 0; ++plane) {
+                if (!(planes & (1 << plane))) {
+                    continue;
+                }
+                int out = 0;
+                for (int i = 0; i < count; ++i) {
+                    const ClipVertex& a = polygon[i];
+                    const ClipVertex& b = polygon[(i + 1) % count];
+                    float da = ClipDistance(a.position, plane);
+                    float db = ClipDistance(b.position, plane);
+                    if (da >= 0.0f) {
+                        scratch[out++] = a;
+                    }
+                    if ((da >= 0.0f) != (db >= 0.0f)) {
+                        float t = da / (da - db);
+                        ClipVertex& v = scratch[out++];
+                        v.position = a.position + (b.position - a.position) * t;
+                        for (int c = 0; c < 4; ++c) {
+                            v.colour[c] = a.colour[c] + (b.colour[c] - a.colour[c]) * t;
+                        }
+                    }
+                }
+                std::copy(scratch, scratch + out, polygon);
+                count = out;
+            }
+            return count;
+        }
+
+        inline void ColourToFloats(Colour c, float* out) {
+            out[0] = c.GetRed();
+            out[1] = c.GetGreen();
+            out[2] = c.GetBlue();
+            out[3] = c.GetAlpha();
+        }
+
+        inline Byte ToByte(float v) {
+            return Byte(std::min(255, std::max(0, int(v + 0.5f))));
+        }
+    }
+
+    // Tile binned software rasteriser. Each Draw runs three stages:
+    //   1. vertices are transformed to clip space and triangles are clipped against the
+    //      view volume, culled and set up in screen space, in parallel chunks;
+    //   2. triangles are binned, in submission order, into every TileSize square they touch;
+    //   3. tiles are rasterised in parallel, each by one thread, four pixels at a time with
+    //      SIMD edge functions, depth tested (less) and written.
+    // A tile always sees its triangles in submission order and nothing is shared between
+    // tiles, so the image is identical for any thread count. Screen positions are snapped
+    // to 1/16 pixel and a top-left rule decides pixels on shared edges, so meshes render
+    // without gaps or double-drawn pixels.
+    class Rasteriser {
+    public:
+        static constexpr int TileSize = 64;
+        static constexpr int SubpixelSteps = 16;
+
+        template<typename Policy>
+        void Draw(Policy policy, Framebuffer& target, const DrawCall* draws, std::size_t drawCount) {
+            triangles.clear();
+            for (std::size_t d = 0; d < drawCount; ++d) {
+                SetupDraw(policy, target, draws[d]);
+            }
+            Bin(target);
+
+            int tilesX = (target.GetWidth() + TileSize - 1) / TileSize;
+            ForEachRange(policy, bins.size(), 1, [&](std::size_t begin, std::size_t end) {
+                for (std::size_t tile = begin; tile < end; ++tile) {
+                    RasteriseTile(target, int(tile % tilesX) * TileSize, int(tile / tilesX) * TileSize, bins[tile]);
+                }
+            });
+        }
+
+        void Draw(Framebuffer& target, const DrawCall& draw) {
+            Draw(Execution::Seq, target, &draw, 1);
+        }
+
+        // Triangles that reached the binning stage in the last Draw, after clipping and culling
+        std::size_t GetTriangleCount() const { return triangles.size(); }
+
+    private:
+        static constexpr std::size_t SetupChunk = 4096;
+
+        template<typename Policy>
+        void SetupDraw(Policy policy, const Framebuffer& target, const DrawCall& draw) {
+            clip.resize(draw.vertexCount);
+            ForEachRange(policy, draw.vertexCount, GrainForBytes(sizeof(Vector3) + sizeof(Vector4)), [&](std::size_t begin, std::size_t end) {
+                for (std::size_t i = begin; i < end; ++i) {
+                    const Vector3& p = draw.positions[i];
+                    clip[i] = draw.transform * Vector4(p.x, p.y, p.z, 1.0f);
+                }
+            });
+
+            // Each chunk writes to its own list; joining them in order keeps the output deterministic
+            std::size_t chunks = (draw.triangleCount + SetupChunk - 1) / SetupChunk;
+            if (chunkTriangles.size() < chunks) {
+                chunkTriangles.resize(chunks);
+            }
+            ForEachRange(policy, chunks, 1, [&](std::size_t begin, std::size_t end) {
+                for (std::size_t chunk = begin; chunk < end; ++chunk) {
+                    std::vector<Detail::ScreenTriangle>& out = chunkTriangles[chunk];
+                    out.clear();
+                    std::size_t last = std::min(draw.triangleCount, (chunk + 1) * SetupChunk);
+                    for (std::size_t t = chunk * SetupChunk; t < last; ++t) {
+                        SetupTriangle(target, draw, draw.indices + t * 3, out);
+                    }
+                }
+            });
+            for (std::size_t chunk = 0; chunk < chunks; ++chunk) {
+                triangles.insert(triangles.end(), chunkTriangles[chunk].begin(), chunkTriangles[chunk].end());
+            }
+        }
+
+        void SetupTriangle(const Framebuffer& target, const DrawCall& draw, const uint32_t* index,
+            std::vector<Detail::ScreenTriangle>& out) const
+        {
+            Detail::ClipVertex polygon[9];
+            int outAll = ~0, outAny = 0;
+            for (int v = 0; v < 3; ++v) {
+                polygon[v].position = clip[index[v]];
+                Detail::ColourToFloats(draw.colours ? draw.colours[index[v]] : draw.colour, polygon[v].colour);
+                int code = Detail::ClipOutcode(polygon[v].position);
+                outAll &= code;
+                outAny |= code;
+            }
+            if (outAll) {
+                return;
+            }
+            int count = outAny ? Detail::ClipPolygon(polygon, 3, outAny) : 3;
+            // Fan triangulate the clipped polygon
+            for (int i = 1; i + 1 < count; ++i) {
+                Emit(target, draw, polygon[0], polygon[i], polygon[i + 1], out);
+            }
+        }
+
+        void Emit(const Framebuffer& target, const DrawCall& draw, const Detail::ClipVertex& a,
+            const Detail::ClipVertex& b, const Detail::ClipVertex& c, std::vector<Detail::ScreenTriangle>& out) const
+        {
+            const Detail::ClipVertex* v[3] = { &a, &b, &c };
+            Detail::ScreenTriangle tri;
+            float width = float(target.GetWidth()), height = float(target.GetHeight());
+            for (int i = 0; i < 3; ++i) {
+                const Vector4& p = v[i]->position;
+                if (p.w <= 0.0f) {
+                    return;
+                }
+                float invW = 1.0f / p.w;
+                float sx = (p.x * invW * 0.5f + 0.5f) * width;
+                float sy = (0.5f - p.y * invW * 0.5f) * height;
+                tri.x[i] = std::round(sx * SubpixelSteps) / SubpixelSteps;
+                tri.y[i] = std::round(sy * SubpixelSteps) / SubpixelSteps;
+                tri.z[i] = p.z * invW * 0.5f + 0.5f;
+                tri.invW[i] = invW;
+                for (int ch = 0; ch < 4; ++ch) {
+                    tri.colour[i][ch] = v[i]->colour[ch] * invW;
+                }
+            }
+
+            // Positive for triangles wound counter-clockwise on screen (y points down)
+            float area = (tri.x[2] - tri.x[0]) * (tri.y[1] - tri.y[0]) - (tri.y[2] - tri.y[0]) * (tri.x[1] - tri.x[0]);
+            if (area == 0.0f ||
+                (draw.cull == CullMode::Back && area < 0.0f) ||
+                (draw.cull == CullMode::Front && area > 0.0f)) {
+                return;
+            }
+            if (area < 0.0f) {
+                // Swap to counter-clockwise so the edge functions are positive inside
+                std::swap(tri.x[1], tri.x[2]);
+                std::swap(tri.y[1], tri.y[2]);
+                std::swap(tri.z[1], tri.z[2]);
+                std::swap(tri.invW[1], tri.invW[2]);
+                for (int ch = 0; ch < 4; ++ch) {
+                    std::swap(tri.colour[1][ch], tri.colour[2][ch]);
+                }
+            }
+
+            // Pixels whose centre (i + 0.5) lies within the bounds
+            float minX = std::min({ tri.x[0], tri.x[1], tri.x[2] }), maxX = std::max({ tri.x[0], tri.x[1], tri.x[2] });
+            float minY = std::min({ tri.y[0], tri.y[1], tri.y[2] }), maxY = std::max({ tri.y[0], tri.y[1], tri.y[2] });
+            tri.minX = std::max(0, int(std::ceil(minX - 0.5f)));
+            tri.minY = std::max(0, int(std::ceil(minY - 0.5f)));
+            tri.maxX = std::min(target.GetWidth() - 1, int(std::floor(maxX - 0.5f)));
+            tri.maxY = std::min(target.GetHeight() - 1, int(std::floor(maxY - 0.5f)));
+            if (tri.minX > tri.maxX || tri.minY > tri.maxY) {
+                return;
+            }
+            tri.flat = draw.colours == nullptr;
+            tri.writeColour = draw.writeColour;
+            out.push_back(tri);
+        }
+
+        void Bin(const Framebuffer& target) {
+            int tilesX = (target.GetWidth() + TileSize - 1) / TileSize;
+            int tilesY = (target.GetHeight() + TileSize - 1) / TileSize;
+            bins.resize(std::size_t(tilesX) * tilesY);
+            for (std::vector<uint32_t>& bin : bins) {
+                bin.clear();
+            }
+            for (std::size_t i = 0; i < triangles.size(); ++i) {
+                const Detail::ScreenTriangle& tri = triangles[i];
+                for (int ty = tri.minY / TileSize; ty <= tri.maxY / TileSize; ++ty) {
+                    for (int tx = tri.minX / TileSize; tx <= tri.maxX / TileSize; ++tx) {
+                        bins[std::size_t(ty) * tilesX + tx].push_back(uint32_t(i));
+                    }
+                }
+            }
+        }
+
+        void RasteriseTile(Framebuffer& target, int tileX, int tileY, const std::vector<uint32_t>& bin) const {
+            const Float4 zero = Float4::Zero();
+            const Float4 allSet = zero <= zero;
+            const Float4 laneOffset(0.5f, 1.5f, 2.5f, 3.5f);
+            int stride = target.GetStride();
+            Colour* colours = target.GetColours();
+            float* depths = target.GetDepths();
+
+            for (uint32_t index : bin) {
+                const Detail::ScreenTriangle& tri = triangles[index];
+                // Start on a multiple of four; tiles are too, so this never leaves the tile
+                int x0 = std::max(tri.minX, tileX) & ~3;
+                int x1 = std::min(tri.maxX, tileX + TileSize - 1);
+                int y0 = std::max(tri.minY, tileY);
+                int y1 = std::min(tri.maxY, tileY + TileSize - 1);
+
+                // Edge i is opposite vertex i and runs from vertex i + 1 to i + 2.
+                // w_i(p) = (p.x - a.x) * (b.y - a.y) - (p.y - a.y) * (b.x - a.x)
+                Float4 ax[3], ay[3], ex[3], ey[3], topLeft[3];
+                for (int i = 0; i < 3; ++i) {
+                    int a = (i + 1) % 3, b = (i + 2) % 3;
+                    float dx = tri.x[b] - tri.x[a], dy = tri.y[b] - tri.y[a];
+                    ax[i] = Float4(tri.x[a]);
+                    ay[i] = Float4(tri.y[a]);
+                    ex[i] = Float4(dx);
+                    ey[i] = Float4(dy);
+                    // Of two triangles sharing an edge exactly one sees it this way round,
+                    // so a pixel centre on the edge is drawn once
+                    topLeft[i] = (dy > 0.0f || (dy == 0.0f && dx < 0.0f)) ? allSet : zero;
+                }
+                float area = (tri.x[2] - tri.x[0]) * (tri.y[1] - tri.y[0]) - (tri.y[2] - tri.y[0]) * (tri.x[1] - tri.x[0]);
+                Float4 invArea(1.0f / area);
+                Colour flatColour(Detail::ToByte(tri.colour[0][0] / tri.invW[0]), Detail::ToByte(tri.colour[0][1] / tri.invW[0]),
+                    Detail::ToByte(tri.colour[0][2] / tri.invW[0]), Detail::ToByte(tri.colour[0][3] / tri.invW[0]));
+
+                for (int y = y0; y <= y1; ++y) {
+                    Float4 py(float(y) + 0.5f);
+                    float* depthRow = depths + std::size_t(y) * stride;
+                    Colour* colourRow = colours + std::size_t(y) * stride;
+                    for (int x = x0; x <= x1; x += 4) {
+                        Float4 px = Float4(float(x)) + laneOffset;
+                        Float4 w[3];
+                        Float4 inside = allSet;
+                        for (int i = 0; i < 3; ++i) {
+                            w[i] = (px - ax[i]) * ey[i] - (py - ay[i]) * ex[i];
+                            inside = inside & ((w[i] > zero) | ((w[i] >= zero) & topLeft[i]));
+                        }
+                        if (!Any(inside)) {
+                            continue;
+                        }
+
+                        Float4 b0 = w[0] * invArea, b1 = w[1] * invArea, b2 = w[2] * invArea;
+                        Float4 z = b0 * Float4(tri.z[0]) + b1 * Float4(tri.z[1]) + b2 * Float4(tri.z[2]);
+                        Float4 oldDepth = Float4::LoadUnaligned(depthRow + x);
+                        Float4 pass = inside & (z < oldDepth);
+                        int mask = MoveMask(pass);
+                        if (mask == 0) {
+                            continue;
+                        }
+                        Select(pass, z, oldDepth).StoreUnaligned(depthRow + x);
+
+                        if (!tri.writeColour) {
+                            continue;
+                        }
+                        if (tri.flat) {
+                            for (int lane = 0; lane < 4; ++lane) {
+                                if (mask & (1 << lane)) {
+                                    colourRow[x + lane] = flatColour;
+                                }
+                            }
+                            continue;
+                        }
+
+                        Float4 invW = b0 * Float4(tri.invW[0]) + b1 * Float4(tri.invW[1]) + b2 * Float4(tri.invW[2]);
+                        Float4 toLinear = Float4(1.0f) / invW;
+                        Float4 channel[4];
+                        for (int ch = 0; ch < 4; ++ch) {
+                            channel[ch] = (b0 * Float4(tri.colour[0][ch]) + b1 * Float4(tri.colour[1][ch]) +
+                                b2 * Float4(tri.colour[2][ch])) * toLinear;
+                        }
+                        for (int lane = 0; lane < 4; ++lane) {
+                            if (mask & (1 << lane)) {
+                                colourRow[x + lane] = Colour(Detail::ToByte(channel[0][lane]), Detail::ToByte(channel[1][lane]),
+                                    Detail::ToByte(channel[2][lane]), Detail::ToByte(channel[3][lane]));
+                            }
+                        }
+                    }
+                }
+            }
+        }
+
+        std::vector<Vector4> clip;
+        std::vector<std::vector<Detail::ScreenTriangle>> chunkTriangles;
+        std::vector<Detail::ScreenTriangle> triangles;
+        std::vector<std::vector<uint32_t>> bins;
+    };
+}
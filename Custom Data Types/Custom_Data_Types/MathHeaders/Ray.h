@@ -0,0 +1,238 @@
+#pragma once
+#include "Vector3.h"
+#include "AABB.h"
+#include "Simd.h"
+#include <cfloat>
+#include <cmath>
+
+namespace MathClasses {
+    // Half line from origin along direction. The direction doesn't have to be unit
+    // length; hit distances are in multiples of it.
+    struct Ray {
+        Vector3 origin;
+        Vector3 direction;
+
+        Ray() : direction(0, 0, 1) {}
+
+        Ray(const Vector3& origin, const Vector3& direction) : origin(origin), direction(direction) {}
+
+        Vector3 GetPoint(float t) const {
+            return origin + direction * t;
+        }
+    };
+
+    // Where a ray hit a triangle: distance along the ray and barycentrics of the
+    // second and third vertices
+    struct RayHit {
+        float t = FLT_MAX;
+        float u = 0.0f;
+        float v = 0.0f;
+    };
+
+    // Hits from a SIMD test, one lane per ray or primitive. Lanes that missed are unchanged.
+    template<typename F>
+    struct RayHitPack {
+        F t = F(FLT_MAX);
+        F u;
+        F v;
+    };
+
+    // Rays whose Moller-Trumbore determinant is this small are treated as parallel
+    // to the triangle and miss
+    inline constexpr float RayParallelEpsilon = 1e-8f;
+
+    // Up to F::Width triangles stored as first vertex plus two edges, one array per
+    // component. Lanes that are never set are degenerate and never hit.
+    template<typename F>
+    struct TrianglePack {
+        static constexpr int Width = F::Width;
+        alignas(32) float v0x[Width] = {}, v0y[Width] = {}, v0z[Width] = {};
+        alignas(32) float e1x[Width] = {}, e1y[Width] = {}, e1z[Width] = {};
+        alignas(32) float e2x[Width] = {}, e2y[Width] = {}, e2z[Width] = {};
+
+        void Set(int lane, const Vector3& a, const Vector3& b, const Vector3& c) {
+            Vector3 e1 = b - a, e2 = c - a;
+            v0x[lane] = a.x; v0y[lane] = a.y; v0z[lane] = a.z;
+            e1x[lane] = e1.x; e1y[lane] = e1.y; e1z[lane] = e1.z;
+            e2x[lane] = e2.x; e2y[lane] = e2.y; e2z[lane] = e2.z;
+        }
+    };
+
+    // Up to F::Width boxes, one array per component. Unset lanes are empty boxes.
+    template<typename F>
+    struct AABBPack {
+        static constexpr int Width = F::Width;
+        alignas(32) float minX[Width], minY[Width], minZ[Width];
+        alignas(32) float maxX[Width], maxY[Width], maxZ[Width];
+
+        AABBPack() {
+            for (int i = 0; i < Width; ++i) {
+                Set(i, AABB());
+            }
+        }
+
+        void Set(int lane, const AABB& box) {
+            minX[lane] = box.min.x; minY[lane] = box.min.y; minZ[lane] = box.min.z;
+            maxX[lane] = box.max.x; maxY[lane] = box.max.y; maxZ[lane] = box.max.z;
+        }
+    };
+
+    // F::Width rays tested together, e.g. neighbouring texels or a cone of shadow rays.
+    // The reciprocal direction is stored for the box test.
+    template<typename F>
+    struct RayPacket {
+        static constexpr int Width = F::Width;
+        alignas(32) float ox[Width] = {}, oy[Width] = {}, oz[Width] = {};
+        alignas(32) float dx[Width] = {}, dy[Width] = {}, dz[Width] = {};
+        alignas(32) float invX[Width] = {}, invY[Width] = {}, invZ[Width] = {};
+
+        void Set(int lane, const Ray& ray) {
+            ox[lane] = ray.origin.x; oy[lane] = ray.origin.y; oz[lane] = ray.origin.z;
+            dx[lane] = ray.direction.x; dy[lane] = ray.direction.y; dz[lane] = ray.direction.z;
+            invX[lane] = 1.0f / ray.direction.x;
+            invY[lane] = 1.0f / ray.direction.y;
+            invZ[lane] = 1.0f / ray.direction.z;
+        }
+    };
+
+    // Moller-Trumbore ray/triangle test. Hits between 0 and hit.t replace hit.
+    inline bool IntersectTriangle(const Ray& ray, const Vector3& a, const Vector3& b, const Vector3& c, RayHit& hit) {
+        Vector3 e1 = b - a, e2 = c - a;
+        Vector3 p = ray.direction.Cross(e2);
+        float det = e1.Dot(p);
+        if (std::fabs(det) <= RayParallelEpsilon) {
+            return false;
+        }
+        float invDet = 1.0f / det;
+        Vector3 s = ray.origin - a;
+        float u = s.Dot(p) * invDet;
+        if (u < 0.0f || u > 1.0f) {
+            return false;
+        }
+        Vector3 q = s.Cross(e1);
+        float v = ray.direction.Dot(q) * invDet;
+        if (v < 0.0f || u + v > 1.0f) {
+            return false;
+        }
+        float t = e2.Dot(q) * invDet;
+        if (t <= 0.0f || t >= hit.t) {
+            return false;
+        }
+        hit.t = t;
+        hit.u = u;
+        hit.v = v;
+        return true;
+    }
+
+    // Slab test. On a hit between 0 and tMax, tEntry is where the ray enters the
+    // box (0 if it starts inside).
+    inline bool IntersectAABB(const Ray& ray, const AABB& box, float tMax, float& tEntry) {
+        if (box.IsEmpty()) {
+            return false;
+        }
+        float tNear = 0.0f, tFar = tMax;
+        const float origin[3] = { ray.origin.x, ray.origin.y, ray.origin.z };
+        const float dir[3] = { ray.direction.x, ray.direction.y, ray.direction.z };
+        const float lo[3] = { box.min.x, box.min.y, box.min.z };
+        const float hi[3] = { box.max.x, box.max.y, box.max.z };
+        for (int k = 0; k < 3; ++k) {
+            float inv = 1.0f / dir[k];
+            float t0 = (lo[k] - origin[k]) * inv;
+            float t1 = (hi[k] - origin[k]) * inv;
+            tNear = std::fmax(tNear, std::fmin(t0, t1));
+            tFar = std::fmin(tFar, std::fmax(t0, t1));
+        }
+        if (tNear > tFar) {
+            return false;
+        }
+        tEntry = tNear;
+        return true;
+    }
+
+    namespace Detail {
+        // Moller-Trumbore on SIMD lanes; any argument can be a splatted scalar
+        template<typename F>
+        int IntersectTriangleLanes(F ox, F oy, F oz, F dx, F dy, F dz,
+            F v0x, F v0y, F v0z, F e1x, F e1y, F e1z, F e2x, F e2y, F e2z, RayHitPack<F>& hit)
+        {
+            F px = dy * e2z - dz * e2y;
+            F py = dz * e2x - dx * e2z;
+            F pz = dx * e2y - dy * e2x;
+            F det = e1x * px + e1y * py + e1z * pz;
+            F invDet = F(1.0f) / det;
+            F sx = ox - v0x, sy = oy - v0y, sz = oz - v0z;
+            F u = (sx * px + sy * py + sz * pz) * invDet;
+            F qx = sy * e1z - sz * e1y;
+            F qy = sz * e1x - sx * e1z;
+            F qz = sx * e1y - sy * e1x;
+            F v = (dx * qx + dy * qy + dz * qz) * invDet;
+            F t = (e2x * qx + e2y * qy + e2z * qz) * invDet;
+
+            F zero = F::Zero(), one(1.0f);
+            F mask = (Abs(det) > F(RayParallelEpsilon)) & (u >= zero) & (u <= one) & (v >= zero) &
+                (u + v <= one) & (t > zero) & (t < hit.t);
+            hit.t = Select(mask, t, hit.t);
+            hit.u = Select(mask, u, hit.u);
+            hit.v = Select(mask, v, hit.v);
+            return MoveMask(mask);
+        }
+
+        template<typename F>
+        int IntersectAABBLanes(F ox, F oy, F oz, F invX, F invY, F invZ,
+            F minX, F minY, F minZ, F maxX, F maxY, F maxZ, F tMax, F& tEntry)
+        {
+            F tx0 = (minX - ox) * invX, tx1 = (maxX - ox) * invX;
+            F ty0 = (minY - oy) * invY, ty1 = (maxY - oy) * invY;
+            F tz0 = (minZ - oz) * invZ, tz1 = (maxZ - oz) * invZ;
+            F tNear = Max(Max(Min(tx0, tx1), Min(ty0, ty1)), Max(Min(tz0, tz1), F::Zero()));
+            F tFar = Min(Min(Max(tx0, tx1), Max(ty0, ty1)), Min(Max(tz0, tz1), tMax));
+            // The slabs of an empty box (min above max on any axis) would swap round into
+            // a valid interval
+            F mask = (tNear <= tFar) & (minX <= maxX) & (minY <= maxY) & (minZ <= maxZ);
+            tEntry = Select(mask, tNear, tEntry);
+            return MoveMask(mask);
+        }
+    }
+
+    // One ray against every triangle in the pack. Returns a bit per lane that hit
+    // closer than hit.t in that lane.
+    template<typename F>
+    int IntersectTriangles(const Ray& ray, const TrianglePack<F>& tris, RayHitPack<F>& hit) {
+        return Detail::IntersectTriangleLanes(
+            F(ray.origin.x), F(ray.origin.y), F(ray.origin.z),
+            F(ray.direction.x), F(ray.direction.y), F(ray.direction.z),
+            F::Load(tris.v0x), F::Load(tris.v0y), F::Load(tris.v0z),
+            F::Load(tris.e1x), F::Load(tris.e1y), F::Load(tris.e1z),
+            F::Load(tris.e2x), F::Load(tris.e2y), F::Load(tris.e2z), hit);
+    }
+
+    // Every ray in the packet against one triangle. Returns a bit per ray that hit.
+    template<typename F>
+    int IntersectTriangle(const RayPacket<F>& rays, const Vector3& a, const Vector3& b, const Vector3& c, RayHitPack<F>& hit) {
+        Vector3 e1 = b - a, e2 = c - a;
+        return Detail::IntersectTriangleLanes(
+            F::Load(rays.ox), F::Load(rays.oy), F::Load(rays.oz),
+            F::Load(rays.dx), F::Load(rays.dy), F::Load(rays.dz),
+            F(a.x), F(a.y), F(a.z), F(e1.x), F(e1.y), F(e1.z), F(e2.x), F(e2.y), F(e2.z), hit);
+    }
+
+    // One ray against every box in the pack; tEntry is updated in the lanes that hit
+    template<typename F>
+    int IntersectAABBs(const Ray& ray, const AABBPack<F>& boxes, float tMax, F& tEntry) {
+        return Detail::IntersectAABBLanes(
+            F(ray.origin.x), F(ray.origin.y), F(ray.origin.z),
+            F(1.0f / ray.direction.x), F(1.0f / ray.direction.y), F(1.0f / ray.direction.z),
+            F::Load(boxes.minX), F::Load(boxes.minY), F::Load(boxes.minZ),
+            F::Load(boxes.maxX), F::Load(boxes.maxY), F::Load(boxes.maxZ), F(tMax), tEntry);
+    }
+
+    // Every ray in the packet against one box. tMax is per ray, e.g. the closest hit so far.
+    template<typename F>
+    int IntersectAABB(const RayPacket<F>& rays, const AABB& box, F tMax, F& tEntry) {
+        return Detail::IntersectAABBLanes(
+            F::Load(rays.ox), F::Load(rays.oy), F::Load(rays.oz),
+            F::Load(rays.invX), F::Load(rays.invY), F::Load(rays.invZ),
+            F(box.min.x), F(box.min.y), F(box.min.z),
+            F(box.max.x), F(box.max.y), F(box.max.z), tMax, tEntry);
+    }
+}
@@ -0,0 +1,287 @@
+#pragma once
+#include "AABB.h"
+#include "Matrix3.h"
+#include "Vector3.h"
+#include "Simd.h"
+#include "FrameArena.h"
+#include "Span.h"
+#include "ThreadPool.h"
+#include <cstddef>
+
+namespace MathClasses {
+
+    // Bounds, centroid and covariance of a point set, from one pass over the points
+    struct PointStatistics {
+        std::size_t count = 0;
+        AABB bounds;
+        Vector3 centroid;
+        // Population covariance (divided by count, not count - 1)
+        Matrix3 covariance;
+    };
+
+    namespace Detail {
+        // Points per chunk. Fixed rather than derived from the thread count, and chunks
+        // are merged in order, so every policy gives bit identical results unless the
+        // compiler contracts to FMA (see Simd.h).
+        constexpr std::size_t ReductionChunk = 16384;
+
+        // Chunk partials kept on the stack when no arena is given. Larger sets are
+        // reduced this many chunks at a time.
+        constexpr std::size_t ReductionBatchChunks = 64;
+
+        // Blocks of four points summed in float before being added to the double totals.
+        // The sums are of offsets from the chunk's first point, so they stay small enough
+        // for a short float run to cost no noticeable accuracy.
+        constexpr int ReductionFlushBlocks = 64;
+
+        // Count, mean and the sum of outer products of the offsets from the mean.
+        // Two partials merge exactly with Chan et al.'s update, so nothing is lost
+        // however many chunks there are.
+        struct Moments {
+            double count = 0;
+            double mean[3] = {};
+            double xx = 0, yy = 0, zz = 0, xy = 0, xz = 0, yz = 0;
+
+            void Merge(const Moments& other) {
+                if (other.count == 0) {
+                    return;
+                }
+                if (count == 0) {
+                    *this = other;
+                    return;
+                }
+                double total = count + other.count;
+                double d[3] = { other.mean[0] - mean[0], other.mean[1] - mean[1], other.mean[2] - mean[2] };
+                double f = count * other.count / total;
+                xx += other.xx + d[0] * d[0] * f;
+                yy += other.yy + d[1] * d[1] * f;
+                zz += other.zz + d[2] * d[2] * f;
+                xy += other.xy + d[0] * d[1] * f;
+                xz += other.xz + d[0] * d[2] * f;
+                yz += other.yz + d[1] * d[2] * f;
+                for (int k = 0; k < 3; ++k) {
+                    mean[k] += d[k] * (other.count / total);
+                }
+                count = total;
+            }
+        };
+
+        struct ReductionPartial {
+            AABB bounds;
+            Moments moments;
+        };
+
+        inline double SumLanes(Float4 v) {
+            return double(v[0]) + double(v[1]) + double(v[2]) + double(v[3]);
+        }
+
+        // Raw sums of offsets from a shift point, in double
+        struct ShiftedSums {
+            double x = 0, y = 0, z = 0;
+            double xx = 0, yy = 0, zz = 0, xy = 0, xz = 0, yz = 0;
+
+            void Add(double dx, double dy, double dz) {
+                x += dx; y += dy; z += dz;
+                xx += dx * dx; yy += dy * dy; zz += dz * dz;
+                xy += dx * dy; xz += dx * dz; yz += dy * dz;
+            }
+        };
+
+        // One chunk, four points at a time. Bounds use Min and Max; the moments are
+        // accumulated as offsets from the first point so large coordinates don't cancel.
+        template<bool WithMoments>
+        ReductionPartial ReduceChunk(const Vector3* points, std::size_t count) {
+            ReductionPartial partial;
+            if (count == 0) {
+                return partial;
+            }
+            Vector3 shift = points[0];
+            Float4 shiftX(shift.x), shiftY(shift.y), shiftZ(shift.z);
+            Float4 minX(shift.x), minY(shift.y), minZ(shift.z);
+            Float4 maxX = minX, maxY = minY, maxZ = minZ;
+            ShiftedSums sums;
+
+            std::size_t i = 0;
+            while (i + 4 <= count) {
+                Float4 sx, sy, sz, sxx, syy, szz, sxy, sxz, syz;
+                for (int block = 0; block < ReductionFlushBlocks && i + 4 <= count; ++block, i += 4) {
+                    const Vector3* p = points + i;
+                    Float4 x(p[0].x, p[1].x, p[2].x, p[3].x);
+                    Float4 y(p[0].y, p[1].y, p[2].y, p[3].y);
+                    Float4 z(p[0].z, p[1].z, p[2].z, p[3].z);
+                    minX = Min(minX, x); maxX = Max(maxX, x);
+                    minY = Min(minY, y); maxY = Max(maxY, y);
+                    minZ = Min(minZ, z); maxZ = Max(maxZ, z);
+                    if (WithMoments) {
+                        Float4 dx = x - shiftX, dy = y - shiftY, dz = z - shiftZ;
+                        sx = sx + dx; sy = sy + dy; sz = sz + dz;
+                        sxx = sxx + dx * dx; syy = syy + dy * dy; szz = szz + dz * dz;
+                        sxy = sxy + dx * dy; sxz = sxz + dx * dz; syz = syz + dy * dz;
+                    }
+                }
+                if (WithMoments) {
+                    sums.x += SumLanes(sx); sums.y += SumLanes(sy); sums.z += SumLanes(sz);
+                    sums.xx += SumLanes(sxx); sums.yy += SumLanes(syy); sums.zz += SumLanes(szz);
+                    sums.xy += SumLanes(sxy); sums.xz += SumLanes(sxz); sums.yz += SumLanes(syz);
+                }
+            }
+
+            Vector3 low(std::fmin(std::fmin(minX[0], minX[1]), std::fmin(minX[2], minX[3])),
+                std::fmin(std::fmin(minY[0], minY[1]), std::fmin(minY[2], minY[3])),
+                std::fmin(std::fmin(minZ[0], minZ[1]), std::fmin(minZ[2], minZ[3])));
+            Vector3 high(std::fmax(std::fmax(maxX[0], maxX[1]), std::fmax(maxX[2], maxX[3])),
+                std::fmax(std::fmax(maxY[0], maxY[1]), std::fmax(maxY[2], maxY[3])),
+                std::fmax(std::fmax(maxZ[0], maxZ[1]), std::fmax(maxZ[2], maxZ[3])));
+            partial.bounds = AABB(low, high);
+            for (; i < count; ++i) {
+                partial.bounds.Expand(points[i]);
+                if (WithMoments) {
+                    sums.Add(double(points[i].x) - shift.x, double(points[i].y) - shift.y, double(points[i].z) - shift.z);
+                }
+            }
+
+            if (WithMoments) {
+                double n = double(count);
+                Moments& m = partial.moments;
+                m.count = n;
+                m.mean[0] = shift.x + sums.x / n;
+                m.mean[1] = shift.y + sums.y / n;
+                m.mean[2] = shift.z + sums.z / n;
+                m.xx = sums.xx - sums.x * sums.x / n;
+                m.yy = sums.yy - sums.y * sums.y / n;
+                m.zz = sums.zz - sums.z * sums.z / n;
+                m.xy = sums.xy - sums.x * sums.y / n;
+                m.xz = sums.xz - sums.x * sums.z / n;
+                m.yz = sums.yz - sums.y * sums.z / n;
+            }
+            return partial;
+        }
+
+        // Runs reduce(first, size) on each chunk of count points, in parallel up to
+        // capacity chunks at a time into partials, and passes the partials to merge in
+        // chunk order, so the result doesn't depend on capacity
+        template<typename Partial, typename Policy, typename ReduceFn, typename MergeFn>
+        void ReduceChunkBatches(Policy policy, std::size_t count, Partial* partials, std::size_t capacity, ReduceFn reduce, MergeFn merge) {
+            std::size_t chunks = (count + ReductionChunk - 1) / ReductionChunk;
+            for (std::size_t batch = 0; batch < chunks; batch += capacity) {
+                std::size_t batchChunks = chunks - batch < capacity ? chunks - batch : capacity;
+                ForEachRange(policy, batchChunks, 1, [&](std::size_t begin, std::size_t end) {
+                    for (std::size_t c = begin; c < end; ++c) {
+                        std::size_t first = (batch + c) * ReductionChunk;
+                        std::size_t size = first + ReductionChunk < count ? ReductionChunk : count - first;
+                        partials[c] = reduce(first, size);
+                    }
+                });
+                for (std::size_t c = 0; c < batchChunks; ++c) {
+                    merge(partials[c]);
+                }
+            }
+        }
+
+        template<bool WithMoments, typename Policy>
+        ReductionPartial ReduceChunks(Policy policy, const Vector3* points, std::size_t count, ReductionPartial* partials, std::size_t capacity) {
+            ReductionPartial result;
+            ReduceChunkBatches(policy, count, partials, capacity,
+                [points](std::size_t first, std::size_t size) { return ReduceChunk<WithMoments>(points + first, size); },
+                [&result](const ReductionPartial& partial) {
+                    result.bounds.Expand(partial.bounds);
+                    result.moments.Merge(partial.moments);
+                });
+            return result;
+        }
+
+        // Merging one chunk into an empty partial copies it, so a set that fits in one
+        // chunk skips the partials
+        template<bool WithMoments, typename Policy>
+        ReductionPartial Reduce(Policy policy, const Vector3* points, std::size_t count) {
+            if (count <= ReductionChunk) {
+                return ReduceChunk<WithMoments>(points, count);
+            }
+            ReductionPartial partials[ReductionBatchChunks];
+            return ReduceChunks<WithMoments>(policy, points, count, partials, ReductionBatchChunks);
+        }
+
+        // Takes a partial per chunk from the arena, so every chunk is reduced in one
+        // parallel pass, or falls back to the stack batches if it can't fit them
+        template<bool WithMoments, typename Policy>
+        ReductionPartial Reduce(Policy policy, FrameArena& arena, const Vector3* points, std::size_t count) {
+            std::size_t chunks = (count + ReductionChunk - 1) / ReductionChunk;
+            if (chunks <= ReductionBatchChunks) {
+                return Reduce<WithMoments>(policy, points, count);
+            }
+            ArenaScope scope(arena);
+            Span<ReductionPartial> partials = arena.AllocateUninitialised<ReductionPartial>(chunks);
+            if (partials.Size() != chunks) {
+                return Reduce<WithMoments>(policy, points, count);
+            }
+            return ReduceChunks<WithMoments>(policy, points, count, partials.Data(), chunks);
+        }
+
+        inline PointStatistics MakePointStatistics(const ReductionPartial& total, std::size_t count) {
+            PointStatistics stats;
+            stats.count = count;
+            stats.bounds = total.bounds;
+            if (count > 0) {
+                const Moments& m = total.moments;
+                stats.centroid = Vector3(float(m.mean[0]), float(m.mean[1]), float(m.mean[2]));
+                float xx = float(m.xx / m.count), yy = float(m.yy / m.count), zz = float(m.zz / m.count);
+                float xy = float(m.xy / m.count), xz = float(m.xz / m.count), yz = float(m.yz / m.count);
+                stats.covariance = Matrix3(xx, xy, xz, xy, yy, yz, xz, yz, zz);
+            }
+            return stats;
+        }
+    }
+
+    // Bounds, centroid and covariance in one fused pass, so a large point set is read
+    // from memory once. Each chunk finds its bounds with SIMD min/max and its moments
+    // relative to its own first point, summing four points per lane in float for short
+    // runs and in double beyond that; the chunks are then merged in order in double.
+    // Nothing is allocated: chunk partials live on the stack, a batch of chunks at a
+    // time. The FrameArena overloads take them from the arena instead, so a large set
+    // is reduced in one parallel pass; the result is the same either way.
+    template<typename Policy>
+    PointStatistics ComputePointStatistics(Policy policy, const Vector3* points, std::size_t count) {
+        return Detail::MakePointStatistics(Detail::Reduce<true>(policy, points, count), count);
+    }
+
+    inline PointStatistics ComputePointStatistics(const Vector3* points, std::size_t count) {
+        return ComputePointStatistics(Execution::Seq, points, count);
+    }
+
+    template<typename Policy>
+    PointStatistics ComputePointStatistics(Policy policy, Span<const Vector3> points) {
+        return ComputePointStatistics(policy, points.Data(), points.Size());
+    }
+
+    inline PointStatistics ComputePointStatistics(Span<const Vector3> points) {
+        return ComputePointStatistics(Execution::Seq, points.Data(), points.Size());
+    }
+
+    template<typename Policy>
+    PointStatistics ComputePointStatistics(Policy policy, FrameArena& arena, const Vector3* points, std::size_t count) {
+        return Detail::MakePointStatistics(Detail::Reduce<true>(policy, arena, points, count), count);
+    }
+
+    inline PointStatistics ComputePointStatistics(FrameArena& arena, const Vector3* points, std::size_t count) {
+        return ComputePointStatistics(Execution::Seq, arena, points, count);
+    }
+
+    // Bounds alone, for when the moments aren't needed. Empty input gives an empty box.
+    template<typename Policy>
+    AABB ComputeBounds(Policy policy, const Vector3* points, std::size_t count) {
+        return Detail::Reduce<false>(policy, points, count).bounds;
+    }
+
+    inline AABB ComputeBounds(const Vector3* points, std::size_t count) {
+        return ComputeBounds(Execution::Seq, points, count);
+    }
+
+    template<typename Policy>
+    AABB ComputeBounds(Policy policy, FrameArena& arena, const Vector3* points, std::size_t count) {
+        return Detail::Reduce<false>(policy, arena, points, count).bounds;
+    }
+
+    inline AABB ComputeBounds(FrameArena& arena, const Vector3* points, std::size_t count) {
+        return ComputeBounds(Execution::Seq, arena, points, count);
+    }
+}
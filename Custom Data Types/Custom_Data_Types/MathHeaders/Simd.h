@@ -0,0 +1,333 @@
+#pragma once
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+// SSE2 is always available on x64; AVX when the compiler is targeting it (/arch:AVX, -mavx).
+// Define MATHCLASSES_NO_SIMD to force the portable versions.
+//
+// Where results are documented as identical (batch and scalar versions, parallel and
+// serial runs) that holds when the compiler keeps multiplies and adds separate: MSVC
+// /fp:precise without /fp:contract, GCC in ISO mode or with -ffp-contract=off. If it
+// fuses them into FMAs (-ffp-contract=fast with FMA enabled, clang's default
+// contraction) it may do so differently in each copy of the code, and results can
+// differ in the last bit or so.
+#if defined(MATHCLASSES_NO_SIMD)
+#elif defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#define MATHCLASSES_SSE 1
+#include <emmintrin.h>
+#endif
+
+#if defined(__AVX__) && !defined(MATHCLASSES_NO_SIMD)
+#define MATHCLASSES_AVX 1
+#include <immintrin.h>
+#endif
+
+namespace MathClasses {
+
+    // Four floats processed together. Uses SSE where available and plain loops otherwise,
+    // so kernels are written once against this type. Comparisons return lane masks
+    // (all bits set or clear) for use with Select, And and MoveMask.
+    struct Float4 {
+#ifdef MATHCLASSES_SSE
+        __m128 v;
+
+        Float4() : v(_mm_setzero_ps()) {}
+        Float4(__m128 v) : v(v) {}
+        Float4(float x, float y, float z, float w) : v(_mm_setr_ps(x, y, z, w)) {}
+        explicit Float4(float s) : v(_mm_set1_ps(s)) {}
+
+        // p must be 16 byte aligned
+        static Float4 Load(const float* p) { return _mm_load_ps(p); }
+        static Float4 LoadUnaligned(const float* p) { return _mm_loadu_ps(p); }
+        void Store(float* p) const { _mm_store_ps(p, v); }
+        void StoreUnaligned(float* p) const { _mm_storeu_ps(p, v); }
+
+        friend Float4 operator+(Float4 a, Float4 b) { return _mm_add_ps(a.v, b.v); }
+        friend Float4 operator-(Float4 a, Float4 b) { return _mm_sub_ps(a.v, b.v); }
+        friend Float4 operator*(Float4 a, Float4 b) { return _mm_mul_ps(a.v, b.v); }
+        friend Float4 operator/(Float4 a, Float4 b) { return _mm_div_ps(a.v, b.v); }
+        friend Float4 operator-(Float4 a) { return _mm_xor_ps(a.v, _mm_set1_ps(-0.0f)); }
+
+        friend Float4 operator<(Float4 a, Float4 b) { return _mm_cmplt_ps(a.v, b.v); }
+        friend Float4 operator<=(Float4 a, Float4 b) { return _mm_cmple_ps(a.v, b.v); }
+        friend Float4 operator>(Float4 a, Float4 b) { return _mm_cmpgt_ps(a.v, b.v); }
+        friend Float4 operator>=(Float4 a, Float4 b) { return _mm_cmpge_ps(a.v, b.v); }
+        friend Float4 operator&(Float4 a, Float4 b) { return _mm_and_ps(a.v, b.v); }
+        friend Float4 operator|(Float4 a, Float4 b) { return _mm_or_ps(a.v, b.v); }
+
+        friend Float4 Min(Float4 a, Float4 b) { return _mm_min_ps(a.v, b.v); }
+        friend Float4 Max(Float4 a, Float4 b) { return _mm_max_ps(a.v, b.v); }
+        friend Float4 Sqrt(Float4 a) { return _mm_sqrt_ps(a.v); }
+        friend Float4 Abs(Float4 a) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a.v); }
+
+        // Hardware estimates, roughly 12 bits of precision
+        friend Float4 RsqrtEstimate(Float4 a) { return _mm_rsqrt_ps(a.v); }
+        friend Float4 RcpEstimate(Float4 a) { return _mm_rcp_ps(a.v); }
+
+        // Lanes of a where mask is set, b elsewhere
+        friend Float4 Select(Float4 mask, Float4 a, Float4 b) {
+            return _mm_or_ps(_mm_and_ps(mask.v, a.v), _mm_andnot_ps(mask.v, b.v));
+        }
+
+        // One bit per lane, set where the lane's sign bit (or mask) is set
+        friend int MoveMask(Float4 a) { return _mm_movemask_ps(a.v); }
+
+        // Copies lane i into every lane
+        template<int i>
+        Float4 Splat() const { return _mm_shuffle_ps(v, v, _MM_SHUFFLE(i, i, i, i)); }
+
+        float operator[](int i) const {
+            alignas(16) float lanes[4];
+            _mm_store_ps(lanes, v);
+            return lanes[i];
+        }
+
+        friend void Transpose(Float4& a, Float4& b, Float4& c, Float4& d) {
+            _MM_TRANSPOSE4_PS(a.v, b.v, c.v, d.v);
+        }
+#else
+        float v[4];
+
+        Float4() : v{ 0, 0, 0, 0 } {}
+        Float4(float x, float y, float z, float w) : v{ x, y, z, w } {}
+        explicit Float4(float s) : v{ s, s, s, s } {}
+
+        static Float4 Load(const float* p) { return LoadUnaligned(p); }
+        static Float4 LoadUnaligned(const float* p) { return Float4(p[0], p[1], p[2], p[3]); }
+        void Store(float* p) const { StoreUnaligned(p); }
+        void StoreUnaligned(float* p) const { for (int i = 0; i < 4; ++i) p[i] = v[i]; }
+
+        template<typename Op>
+        static Float4 Map(Float4 a, Float4 b, Op op) {
+            return Float4(op(a.v[0], b.v[0]), op(a.v[1], b.v[1]), op(a.v[2], b.v[2]), op(a.v[3], b.v[3]));
+        }
+
+        static float MaskOf(bool b) {
+            std::uint32_t bits = b ? 0xFFFFFFFFu : 0u;
+            float f;
+            std::memcpy(&f, &bits, sizeof(f));
+            return f;
+        }
+
+        static std::uint32_t BitsOf(float f) {
+            std::uint32_t bits;
+            std::memcpy(&bits, &f, sizeof(bits));
+            return bits;
+        }
+
+        static float FromBits(std::uint32_t bits) {
+            float f;
+            std::memcpy(&f, &bits, sizeof(f));
+            return f;
+        }
+
+        friend Float4 operator+(Float4 a, Float4 b) { return Map(a, b, [](float x, float y) { return x + y; }); }
+        friend Float4 operator-(Float4 a, Float4 b) { return Map(a, b, [](float x, float y) { return x - y; }); }
+        friend Float4 operator*(Float4 a, Float4 b) { return Map(a, b, [](float x, float y) { return x * y; }); }
+        friend Float4 operator/(Float4 a, Float4 b) { return Map(a, b, [](float x, float y) { return x / y; }); }
+        friend Float4 operator-(Float4 a) { return Float4(-a.v[0], -a.v[1], -a.v[2], -a.v[3]); }
+
+        friend Float4 operator<(Float4 a, Float4 b) { return Map(a, b, [](float x, float y) { return MaskOf(x < y); }); }
+        friend Float4 operator<=(Float4 a, Float4 b) { return Map(a, b, [](float x, float y) { return MaskOf(x <= y); }); }
+        friend Float4 operator>(Float4 a, Float4 b) { return Map(a, b, [](float x, float y) { return MaskOf(x > y); }); }
+        friend Float4 operator>=(Float4 a, Float4 b) { return Map(a, b, [](float x, float y) { return MaskOf(x >= y); }); }
+        friend Float4 operator&(Float4 a, Float4 b) { return Map(a, b, [](float x, float y) { return FromBits(BitsOf(x) & BitsOf(y)); }); }
+        friend Float4 operator|(Float4 a, Float4 b) { return Map(a, b, [](float x, float y) { return FromBits(BitsOf(x) | BitsOf(y)); }); }
+
+        // Matches minps/maxps: the second operand is returned when either is NaN
+        friend Float4 Min(Float4 a, Float4 b) { return Map(a, b, [](float x, float y) { return x < y ? x : y; }); }
+        friend Float4 Max(Float4 a, Float4 b) { return Map(a, b, [](float x, float y) { return x > y ? x : y; }); }
+        friend Float4 Sqrt(Float4 a) { return Float4(std::sqrt(a.v[0]), std::sqrt(a.v[1]), std::sqrt(a.v[2]), std::sqrt(a.v[3])); }
+        friend Float4 Abs(Float4 a) { return Float4(std::fabs(a.v[0]), std::fabs(a.v[1]), std::fabs(a.v[2]), std::fabs(a.v[3])); }
+
+        friend Float4 RsqrtEstimate(Float4 a) { return Float4(1.0f) / Sqrt(a); }
+        friend Float4 RcpEstimate(Float4 a) { return Float4(1.0f) / a; }
+
+        friend Float4 Select(Float4 mask, Float4 a, Float4 b) {
+            Float4 r;
+            for (int i = 0; i < 4; ++i) r.v[i] = FromBits((BitsOf(mask.v[i]) & BitsOf(a.v[i])) | (~BitsOf(mask.v[i]) & BitsOf(b.v[i])));
+            return r;
+        }
+
+        friend int MoveMask(Float4 a) {
+            int mask = 0;
+            for (int i = 0; i < 4; ++i) mask |= int(BitsOf(a.v[i]) >> 31) << i;
+            return mask;
+        }
+
+        template<int i>
+        Float4 Splat() const { return Float4(v[i]); }
+
+        float operator[](int i) const { return v[i]; }
+
+        friend void Transpose(Float4& a, Float4& b, Float4& c, Float4& d) {
+            Float4 ta = a, tb = b, tc = c, td = d;
+            a = Float4(ta.v[0], tb.v[0], tc.v[0], td.v[0]);
+            b = Float4(ta.v[1], tb.v[1], tc.v[1], td.v[1]);
+            c = Float4(ta.v[2], tb.v[2], tc.v[2], td.v[2]);
+            d = Float4(ta.v[3], tb.v[3], tc.v[3], td.v[3]);
+        }
+#endif
+
+        static constexpr int Width = 4;
+
+        static Float4 Zero() { return Float4(); }
+
+        Float4& operator+=(Float4 b) { return *this = *this + b; }
+        Float4& operator-=(Float4 b) { return *this = *this - b; }
+        Float4& operator*=(Float4 b) { return *this = *this * b; }
+
+        // a * b + c
+        friend Float4 MulAdd(Float4 a, Float4 b, Float4 c) { return a * b + c; }
+
+        friend bool Any(Float4 mask) { return MoveMask(mask) != 0; }
+        friend bool All(Float4 mask) { return MoveMask(mask) == 0xF; }
+    };
+
+    // Eight floats processed together: one AVX register, or a pair of Float4 without AVX
+    struct Float8 {
+#ifdef MATHCLASSES_AVX
+        __m256 v;
+
+        Float8() : v(_mm256_setzero_ps()) {}
+        Float8(__m256 v) : v(v) {}
+        explicit Float8(float s) : v(_mm256_set1_ps(s)) {}
+        Float8(Float4 lo, Float4 hi) : v(_mm256_insertf128_ps(_mm256_castps128_ps256(lo.v), hi.v, 1)) {}
+
+        // p must be 32 byte aligned
+        static Float8 Load(const float* p) { return _mm256_load_ps(p); }
+        static Float8 LoadUnaligned(const float* p) { return _mm256_loadu_ps(p); }
+        void Store(float* p) const { _mm256_store_ps(p, v); }
+        void StoreUnaligned(float* p) const { _mm256_storeu_ps(p, v); }
+
+        Float4 Low() const { return _mm256_castps256_ps128(v); }
+        Float4 High() const { return _mm256_extractf128_ps(v, 1); }
+
+        friend Float8 operator+(Float8 a, Float8 b) { return _mm256_add_ps(a.v, b.v); }
+        friend Float8 operator-(Float8 a, Float8 b) { return _mm256_sub_ps(a.v, b.v); }
+        friend Float8 operator*(Float8 a, Float8 b) { return _mm256_mul_ps(a.v, b.v); }
+        friend Float8 operator/(Float8 a, Float8 b) { return _mm256_div_ps(a.v, b.v); }
+        friend Float8 operator-(Float8 a) { return _mm256_xor_ps(a.v, _mm256_set1_ps(-0.0f)); }
+
+        friend Float8 operator<(Float8 a, Float8 b) { return _mm256_cmp_ps(a.v, b.v, _CMP_LT_OQ); }
+        friend Float8 operator<=(Float8 a, Float8 b) { return _mm256_cmp_ps(a.v, b.v, _CMP_LE_OQ); }
+        friend Float8 operator>(Float8 a, Float8 b) { return _mm256_cmp_ps(a.v, b.v, _CMP_GT_OQ); }
+        friend Float8 operator>=(Float8 a, Float8 b) { return _mm256_cmp_ps(a.v, b.v, _CMP_GE_OQ); }
+        friend Float8 operator&(Float8 a, Float8 b) { return _mm256_and_ps(a.v, b.v); }
+        friend Float8 operator|(Float8 a, Float8 b) { return _mm256_or_ps(a.v, b.v); }
+
+        friend Float8 Min(Float8 a, Float8 b) { return _mm256_min_ps(a.v, b.v); }
+        friend Float8 Max(Float8 a, Float8 b) { return _mm256_max_ps(a.v, b.v); }
+        friend Float8 Sqrt(Float8 a) { return _mm256_sqrt_ps(a.v); }
+        friend Float8 Abs(Float8 a) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a.v); }
+        friend Float8 RsqrtEstimate(Float8 a) { return _mm256_rsqrt_ps(a.v); }
+        friend Float8 RcpEstimate(Float8 a) { return _mm256_rcp_ps(a.v); }
+
+        friend Float8 Select(Float8 mask, Float8 a, Float8 b) { return _mm256_blendv_ps(b.v, a.v, mask.v); }
+        friend int MoveMask(Float8 a) { return _mm256_movemask_ps(a.v); }
+#else
+        Float4 lo, hi;
+
+        Float8() {}
+        explicit Float8(float s) : lo(s), hi(s) {}
+        Float8(Float4 lo, Float4 hi) : lo(lo), hi(hi) {}
+
+        static Float8 Load(const float* p) { return Float8(Float4::Load(p), Float4::Load(p + 4)); }
+        static Float8 LoadUnaligned(const float* p) { return Float8(Float4::LoadUnaligned(p), Float4::LoadUnaligned(p + 4)); }
+        void Store(float* p) const { lo.Store(p); hi.Store(p + 4); }
+        void StoreUnaligned(float* p) const { lo.StoreUnaligned(p); hi.StoreUnaligned(p + 4); }
+
+        Float4 Low() const { return lo; }
+        Float4 High() const { return hi; }
+
+        friend Float8 operator+(Float8 a, Float8 b) { return Float8(a.lo + b.lo, a.hi + b.hi); }
+        friend Float8 operator-(Float8 a, Float8 b) { return Float8(a.lo - b.lo, a.hi - b.hi); }
+        friend Float8 operator*(Float8 a, Float8 b) { return Float8(a.lo * b.lo, a.hi * b.hi); }
+        friend Float8 operator/(Float8 a, Float8 b) { return Float8(a.lo / b.lo, a.hi / b.hi); }
+        friend Float8 operator-(Float8 a) { return Float8(-a.lo, -a.hi); }
+
+        friend Float8 operator<(Float8 a, Float8 b) { return Float8(a.lo < b.lo, a.hi < b.hi); }
+        friend Float8 operator<=(Float8 a, Float8 b) { return Float8(a.lo <= b.lo, a.hi <= b.hi); }
+        friend Float8 operator>(Float8 a, Float8 b) { return Float8(a.lo > b.lo, a.hi > b.hi); }
+        friend Float8 operator>=(Float8 a, Float8 b) { return Float8(a.lo >= b.lo, a.hi >= b.hi); }
+        friend Float8 operator&(Float8 a, Float8 b) { return Float8(a.lo & b.lo, a.hi & b.hi); }
+        friend Float8 operator|(Float8 a, Float8 b) { return Float8(a.lo | b.lo, a.hi | b.hi); }
+
+        friend Float8 Min(Float8 a, Float8 b) { return Float8(Min(a.lo, b.lo), Min(a.hi, b.hi)); }
+        friend Float8 Max(Float8 a, Float8 b) { return Float8(Max(a.lo, b.lo), Max(a.hi, b.hi)); }
+        friend Float8 Sqrt(Float8 a) { return Float8(Sqrt(a.lo), Sqrt(a.hi)); }
+        friend Float8 Abs(Float8 a) { return Float8(Abs(a.lo), Abs(a.hi)); }
+        friend Float8 RsqrtEstimate(Float8 a) { return Float8(RsqrtEstimate(a.lo), RsqrtEstimate(a.hi)); }
+        friend Float8 RcpEstimate(Float8 a) { return Float8(RcpEstimate(a.lo), RcpEstimate(a.hi)); }
+
+        friend Float8 Select(Float8 mask, Float8 a, Float8 b) { return Float8(Select(mask.lo, a.lo, b.lo), Select(mask.hi, a.hi, b.hi)); }
+        friend int MoveMask(Float8 a) { return MoveMask(a.lo) | (MoveMask(a.hi) << 4); }
+#endif
+
+        static constexpr int Width = 8;
+
+        static Float8 Zero() { return Float8(); }
+
+        Float8& operator+=(Float8 b) { return *this = *this + b; }
+        Float8& operator-=(Float8 b) { return *this = *this - b; }
+        Float8& operator*=(Float8 b) { return *this = *this * b; }
+
+        float operator[](int i) const { return i < 4 ? Low()[i] : High()[i - 4]; }
+
+        friend Float8 MulAdd(Float8 a, Float8 b, Float8 c) { return a * b + c; }
+
+        friend bool Any(Float8 mask) { return MoveMask(mask) != 0; }
+        friend bool All(Float8 mask) { return MoveMask(mask) == 0xFF; }
+    };
+
+    // Two doubles processed together, for the few kernels that need double precision
+    // before narrowing to float. SSE2 where available and plain loops otherwise.
+    struct Double2 {
+#ifdef MATHCLASSES_SSE
+        __m128d v;
+
+        Double2() : v(_mm_setzero_pd()) {}
+        Double2(__m128d v) : v(v) {}
+        Double2(double x, double y) : v(_mm_setr_pd(x, y)) {}
+        explicit Double2(double s) : v(_mm_set1_pd(s)) {}
+
+        static Double2 LoadUnaligned(const double* p) { return _mm_loadu_pd(p); }
+        void StoreUnaligned(double* p) const { _mm_storeu_pd(p, v); }
+
+        friend Double2 operator+(Double2 a, Double2 b) { return _mm_add_pd(a.v, b.v); }
+        friend Double2 operator-(Double2 a, Double2 b) { return _mm_sub_pd(a.v, b.v); }
+        friend Double2 operator*(Double2 a, Double2 b) { return _mm_mul_pd(a.v, b.v); }
+
+        // Rounds lo's two lanes then hi's to the four floats of one register
+        friend Float4 ToFloat4(Double2 lo, Double2 hi) { return _mm_movelh_ps(_mm_cvtpd_ps(lo.v), _mm_cvtpd_ps(hi.v)); }
+
+        double operator[](int i) const {
+            alignas(16) double lanes[2];
+            _mm_store_pd(lanes, v);
+            return lanes[i];
+        }
+#else
+        double v[2];
+
+        Double2() : v{ 0, 0 } {}
+        Double2(double x, double y) : v{ x, y } {}
+        explicit Double2(double s) : v{ s, s } {}
+
+        static Double2 LoadUnaligned(const double* p) { return Double2(p[0], p[1]); }
+        void StoreUnaligned(double* p) const { p[0] = v[0]; p[1] = v[1]; }
+
+        friend Double2 operator+(Double2 a, Double2 b) { return Double2(a.v[0] + b.v[0], a.v[1] + b.v[1]); }
+        friend Double2 operator-(Double2 a, Double2 b) { return Double2(a.v[0] - b.v[0], a.v[1] - b.v[1]); }
+        friend Double2 operator*(Double2 a, Double2 b) { return Double2(a.v[0] * b.v[0], a.v[1] * b.v[1]); }
+
+        friend Float4 ToFloat4(Double2 lo, Double2 hi) {
+            return Float4(float(lo.v[0]), float(lo.v[1]), float(hi.v[0]), float(hi.v[1]));
+        }
+
+        double operator[](int i) const { return v[i]; }
+#endif
+
+        static constexpr int Width = 2;
+    };
+}
@@ -0,0 +1,314 @@
+#pragma once
+#include "Matrix4.h"
+#include "DualQuaternion.h"
+#include "FrameArena.h"
+#include "Simd.h"
+#include "ThreadPool.h"
+#include <cstddef>
+#include <cstdint>
+
+namespace MathClasses {
+
+    // Bind pose vertex data as separate x/y/z arrays. Each vertex has up to four
+    // influences: boneIndices packs four 8 bit palette indices (influence 0 in the
+    // lowest byte) and boneWeights holds four weights per vertex, summing to 1.
+    // Normals are optional; leave them null to skin positions only.
+    struct SkinningInput {
+        const float* positionX = nullptr;
+        const float* positionY = nullptr;
+        const float* positionZ = nullptr;
+        const float* normalX = nullptr;
+        const float* normalY = nullptr;
+        const float* normalZ = nullptr;
+        const std::uint32_t* boneIndices = nullptr;
+        const float* boneWeights = nullptr;
+        std::size_t vertexCount = 0;
+    };
+
+    // Skinned vertex arrays, at least vertexCount long. Normals are written only if
+    // both the input and output normal arrays are set.
+    struct SkinningOutput {
+        float* positionX = nullptr;
+        float* positionY = nullptr;
+        float* positionZ = nullptr;
+        float* normalX = nullptr;
+        float* normalY = nullptr;
+        float* normalZ = nullptr;
+    };
+
+    namespace Detail {
+        // Position, normal, packed bone indices and four weights in; position and normal out
+        constexpr std::size_t SkinningBytesPerVertex = 6 * sizeof(float) + sizeof(std::uint32_t) + 4 * sizeof(float) + 6 * sizeof(float);
+
+        inline std::uint32_t BoneIndex(std::uint32_t packed, int influence) {
+            return (packed >> (8 * influence)) & 0xFF;
+        }
+
+        // Runs block(in, i, out) over four vertices at a time. The last partial block is
+        // copied into padded local arrays (with zero weights) so block never reads or
+        // writes past the caller's arrays.
+        template<typename Block>
+        void ForEachSkinningBlock(const SkinningInput& in, const SkinningOutput& out, std::size_t begin, std::size_t end, Block block) {
+            std::size_t i = begin;
+            for (; i + 4 <= end; i += 4) {
+                block(in, i, out);
+            }
+            if (i == end) {
+                return;
+            }
+
+            bool normals = in.normalX != nullptr && out.normalX != nullptr;
+            float p[3][4] = {}, n[3][4] = {}, op[3][4], on[3][4];
+            float w[16] = {};
+            std::uint32_t bones[4] = {};
+            std::size_t count = end - i;
+            for (std::size_t k = 0; k < count; ++k) {
+                p[0][k] = in.positionX[i + k];
+                p[1][k] = in.positionY[i + k];
+                p[2][k] = in.positionZ[i + k];
+                if (normals) {
+                    n[0][k] = in.normalX[i + k];
+                    n[1][k] = in.normalY[i + k];
+                    n[2][k] = in.normalZ[i + k];
+                }
+                bones[k] = in.boneIndices[i + k];
+                for (int j = 0; j < 4; ++j) {
+                    w[4 * k + j] = in.boneWeights[4 * (i + k) + j];
+                }
+            }
+
+            SkinningInput localIn;
+            localIn.positionX = p[0];
+            localIn.positionY = p[1];
+            localIn.positionZ = p[2];
+            localIn.normalX = normals ? n[0] : nullptr;
+            localIn.normalY = n[1];
+            localIn.normalZ = n[2];
+            localIn.boneIndices = bones;
+            localIn.boneWeights = w;
+            localIn.vertexCount = 4;
+            SkinningOutput localOut{ op[0], op[1], op[2], on[0], on[1], on[2] };
+            block(localIn, 0, localOut);
+
+            for (std::size_t k = 0; k < count; ++k) {
+                out.positionX[i + k] = op[0][k];
+                out.positionY[i + k] = op[1][k];
+                out.positionZ[i + k] = op[2][k];
+                if (normals) {
+                    out.normalX[i + k] = on[0][k];
+                    out.normalY[i + k] = on[1][k];
+                    out.normalZ[i + k] = on[2][k];
+                }
+            }
+        }
+
+        // Unit length without dividing zero vectors by zero
+        inline void NormaliseLanes(Float4& x, Float4& y, Float4& z) {
+            Float4 mag = Sqrt(x * x + y * y + z * z);
+            mag = Select(mag > Float4::Zero(), mag, Float4(1.0f));
+            x = x / mag;
+            y = y / mag;
+            z = z / mag;
+        }
+
+        // Linear blend skinning of four vertices. Each vertex blends the top three rows
+        // of its bone matrices (Matrix4 stores rows contiguously, so a row is one
+        // register); a transpose then turns the blended rows into per-element registers
+        // holding that element for all four vertices.
+        inline void LinearBlendBlock(const Matrix4* palette, const SkinningInput& in, std::size_t i, const SkinningOutput& out) {
+            Float4 rows[3][4];
+            for (int v = 0; v < 4; ++v) {
+                std::uint32_t packed = in.boneIndices[i + v];
+                const float* weights = in.boneWeights + 4 * (i + v);
+                Float4 r0, r1, r2;
+                for (int k = 0; k < 4; ++k) {
+                    const float* m = &palette[BoneIndex(packed, k)].m1;
+                    Float4 weight(weights[k]);
+                    r0 += weight * Float4::LoadUnaligned(m);
+                    r1 += weight * Float4::LoadUnaligned(m + 4);
+                    r2 += weight * Float4::LoadUnaligned(m + 8);
+                }
+                rows[0][v] = r0;
+                rows[1][v] = r1;
+                rows[2][v] = r2;
+            }
+            // rows[r][c] now holds element (r, c) of each vertex's blended matrix
+            for (int r = 0; r < 3; ++r) {
+                Transpose(rows[r][0], rows[r][1], rows[r][2], rows[r][3]);
+            }
+
+            Float4 px = Float4::LoadUnaligned(in.positionX + i);
+            Float4 py = Float4::LoadUnaligned(in.positionY + i);
+            Float4 pz = Float4::LoadUnaligned(in.positionZ + i);
+            (rows[0][0] * px + rows[0][1] * py + rows[0][2] * pz + rows[0][3]).StoreUnaligned(out.positionX + i);
+            (rows[1][0] * px + rows[1][1] * py + rows[1][2] * pz + rows[1][3]).StoreUnaligned(out.positionY + i);
+            (rows[2][0] * px + rows[2][1] * py + rows[2][2] * pz + rows[2][3]).StoreUnaligned(out.positionZ + i);
+
+            if (in.normalX != nullptr && out.normalX != nullptr) {
+                Float4 nx = Float4::LoadUnaligned(in.normalX + i);
+                Float4 ny = Float4::LoadUnaligned(in.normalY + i);
+                Float4 nz = Float4::LoadUnaligned(in.normalZ + i);
+                Float4 ox = rows[0][0] * nx + rows[0][1] * ny + rows[0][2] * nz;
+                Float4 oy = rows[1][0] * nx + rows[1][1] * ny + rows[1][2] * nz;
+                Float4 oz = rows[2][0] * nx + rows[2][1] * ny + rows[2][2] * nz;
+                NormaliseLanes(ox, oy, oz);
+                ox.StoreUnaligned(out.normalX + i);
+                oy.StoreUnaligned(out.normalY + i);
+                oz.StoreUnaligned(out.normalZ + i);
+            }
+        }
+
+        // Dual quaternion skinning of four vertices. Influences are flipped into the
+        // same hemisphere as the first before blending, and the blend is renormalised.
+        inline void DualQuaternionBlock(const DualQuaternion* palette, const SkinningInput& in, std::size_t i, const SkinningOutput& out) {
+            Float4 reals[4], duals[4];
+            for (int v = 0; v < 4; ++v) {
+                std::uint32_t packed = in.boneIndices[i + v];
+                const float* weights = in.boneWeights + 4 * (i + v);
+                const Quaternion& pivot = palette[BoneIndex(packed, 0)].real;
+                Float4 real, dual;
+                for (int k = 0; k < 4; ++k) {
+                    const DualQuaternion& dq = palette[BoneIndex(packed, k)];
+                    Float4 weight(pivot.Dot(dq.real) < 0.0f ? -weights[k] : weights[k]);
+                    real += weight * Float4::LoadUnaligned(&dq.real.x);
+                    dual += weight * Float4::LoadUnaligned(&dq.dual.x);
+                }
+                reals[v] = real;
+                duals[v] = dual;
+            }
+            Transpose(reals[0], reals[1], reals[2], reals[3]);
+            Transpose(duals[0], duals[1], duals[2], duals[3]);
+
+            Float4 rx = reals[0], ry = reals[1], rz = reals[2], rw = reals[3];
+            Float4 dx = duals[0], dy = duals[1], dz = duals[2], dw = duals[3];
+            Float4 mag = Sqrt(rx * rx + ry * ry + rz * rz + rw * rw);
+            Float4 inv = Float4(1.0f) / Select(mag > Float4::Zero(), mag, Float4(1.0f));
+            rx *= inv; ry *= inv; rz *= inv; rw *= inv;
+            dx *= inv; dy *= inv; dz *= inv; dw *= inv;
+
+            // Translation is the vector part of 2 * dual * conjugate(real)
+            Float4 two(2.0f);
+            Float4 tx = two * (rw * dx - dw * rx + ry * dz - rz * dy);
+            Float4 ty = two * (rw * dy - dw * ry + rz * dx - rx * dz);
+            Float4 tz = two * (rw * dz - dw * rz + rx * dy - ry * dx);
+
+            // v' = v + 2 r x (r x v + w v)
+            auto rotate = [&](Float4& x, Float4& y, Float4& z) {
+                Float4 cx = ry * z - rz * y + rw * x;
+                Float4 cy = rz * x - rx * z + rw * y;
+                Float4 cz = rx * y - ry * x + rw * z;
+                Float4 nx = x + two * (ry * cz - rz * cy);
+                Float4 ny = y + two * (rz * cx - rx * cz);
+                Float4 nz = z + two * (rx * cy - ry * cx);
+                x = nx;
+                y = ny;
+                z = nz;
+            };
+
+            Float4 px = Float4::LoadUnaligned(in.positionX + i);
+            Float4 py = Float4::LoadUnaligned(in.positionY + i);
+            Float4 pz = Float4::LoadUnaligned(in.positionZ + i);
+            rotate(px, py, pz);
+            (px + tx).StoreUnaligned(out.positionX + i);
+            (py + ty).StoreUnaligned(out.positionY + i);
+            (pz + tz).StoreUnaligned(out.positionZ + i);
+
+            if (in.normalX != nullptr && out.normalX != nullptr) {
+                Float4 nx = Float4::LoadUnaligned(in.normalX + i);
+                Float4 ny = Float4::LoadUnaligned(in.normalY + i);
+                Float4 nz = Float4::LoadUnaligned(in.normalZ + i);
+                rotate(nx, ny, nz);
+                nx.StoreUnaligned(out.normalX + i);
+                ny.StoreUnaligned(out.normalY + i);
+                nz.StoreUnaligned(out.normalZ + i);
+            }
+        }
+    }
+
+    // Linear blend skinning with a palette of skinning matrices (bone world * inverse bind).
+    // Normals are transformed by the blended matrix and renormalised, which is exact for
+    // rotations and uniform scale.
+    template<typename Policy>
+    void SkinLinearBlend(Policy policy, const Matrix4* palette, const SkinningInput& in, const SkinningOutput& out) {
+        ForEachRange(policy, in.vertexCount, GrainForBytes(Detail::SkinningBytesPerVertex), [&](std::size_t begin, std::size_t end) {
+            Detail::ForEachSkinningBlock(in, out, begin, end, [palette](const SkinningInput& blockIn, std::size_t i, const SkinningOutput& blockOut) {
+                Detail::LinearBlendBlock(palette, blockIn, i, blockOut);
+            });
+        });
+    }
+
+    inline void SkinLinearBlend(const Matrix4* palette, const SkinningInput& in, const SkinningOutput& out) {
+        SkinLinearBlend(Execution::Seq, palette, in, out);
+    }
+
+    namespace Detail {
+        // Output arrays for in from an arena, with normals only if in has them. All null
+        // if the arena can't fit them, and nothing is left allocated.
+        inline SkinningOutput AllocateSkinningOutput(FrameArena& arena, const SkinningInput& in) {
+            FrameArena::Marker marker = arena.GetMarker();
+            std::size_t count = in.vertexCount;
+            bool normals = in.normalX != nullptr && in.normalY != nullptr && in.normalZ != nullptr;
+            float* arrays[6] = {};
+            for (int a = 0; a < (normals ? 6 : 3); ++a) {
+                arrays[a] = arena.AllocateUninitialised<float>(count).Data();
+                if (arrays[a] == nullptr && count > 0) {
+                    arena.RewindTo(marker);
+                    return SkinningOutput();
+                }
+            }
+            return SkinningOutput{ arrays[0], arrays[1], arrays[2], arrays[3], arrays[4], arrays[5] };
+        }
+    }
+
+    // Skins into arrays from a FrameArena. The returned arrays are all null if the arena
+    // can't fit them.
+    template<typename Policy>
+    SkinningOutput SkinLinearBlend(Policy policy, FrameArena& arena, const Matrix4* palette, const SkinningInput& in) {
+        SkinningOutput out = Detail::AllocateSkinningOutput(arena, in);
+        if (out.positionX != nullptr) {
+            SkinLinearBlend(policy, palette, in, out);
+        }
+        return out;
+    }
+
+    inline SkinningOutput SkinLinearBlend(FrameArena& arena, const Matrix4* palette, const SkinningInput& in) {
+        return SkinLinearBlend(Execution::Seq, arena, palette, in);
+    }
+
+    // Dual quaternion skinning with a palette built by BuildDualQuaternionPalette.
+    // Avoids the volume loss of linear blending at twisting joints, but only supports
+    // rigid bone transforms.
+    template<typename Policy>
+    void SkinDualQuaternion(Policy policy, const DualQuaternion* palette, const SkinningInput& in, const SkinningOutput& out) {
+        ForEachRange(policy, in.vertexCount, GrainForBytes(Detail::SkinningBytesPerVertex), [&](std::size_t begin, std::size_t end) {
+            Detail::ForEachSkinningBlock(in, out, begin, end, [palette](const SkinningInput& blockIn, std::size_t i, const SkinningOutput& blockOut) {
+                Detail::DualQuaternionBlock(palette, blockIn, i, blockOut);
+            });
+        });
+    }
+
+    inline void SkinDualQuaternion(const DualQuaternion* palette, const SkinningInput& in, const SkinningOutput& out) {
+        SkinDualQuaternion(Execution::Seq, palette, in, out);
+    }
+
+    // Skins into arrays from a FrameArena, as SkinLinearBlend does
+    template<typename Policy>
+    SkinningOutput SkinDualQuaternion(Policy policy, FrameArena& arena, const DualQuaternion* palette, const SkinningInput& in) {
+        SkinningOutput out = Detail::AllocateSkinningOutput(arena, in);
+        if (out.positionX != nullptr) {
+            SkinDualQuaternion(policy, palette, in, out);
+        }
+        return out;
+    }
+
+    inline SkinningOutput SkinDualQuaternion(FrameArena& arena, const DualQuaternion* palette, const SkinningInput& in) {
+        return SkinDualQuaternion(Execution::Seq, arena, palette, in);
+    }
+
+    // Converts skinning matrices to dual quaternions, dropping any scale
+    inline void BuildDualQuaternionPalette(const Matrix4* matrices, DualQuaternion* palette, std::size_t count) {
+        for (std::size_t i = 0; i < count; ++i) {
+            palette[i] = DualQuaternion::FromMatrix(matrices[i]);
+        }
+    }
+}
@@ -0,0 +1,313 @@
+#pragma once
+#include "AABB.h"
+#include "FrameArena.h"
+#include "Vector3.h"
+#include "RadixSort.h"
+#include "Reductions.h"
+#include "ThreadPool.h"
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// BMI2's PDEP and PEXT interleave and de-interleave bits in one instruction each.
+// GCC and Clang say so with __BMI2__ (-mbmi2, -march=haswell); MSVC has no such macro,
+// but every CPU with AVX2 has BMI2, so /arch:AVX2 is taken to mean it's there.
+#if !defined(MATHCLASSES_NO_SIMD) && (defined(_M_X64) || defined(__x86_64__)) && \
+    (defined(__BMI2__) || (defined(_MSC_VER) && defined(__AVX2__)))
+#define MATHCLASSES_BMI2 1
+#include <immintrin.h>
+#endif
+
+namespace MathClasses {
+
+    // Maps points in a box to integer cells on a 2^bits grid per axis. Points outside
+    // the box are clamped to the edge cells, and a flat axis maps everything to cell 0.
+    class GridQuantiser {
+    public:
+        GridQuantiser(const AABB& bounds, int bits) : origin(bounds.min), maxCell(float((1u << bits) - 1)) {
+            Vector3 size = bounds.max - bounds.min;
+            float cells = float(1u << bits);
+            scale = Vector3(size.x > 0 ? cells / size.x : 0.0f, size.y > 0 ? cells / size.y : 0.0f,
+                size.z > 0 ? cells / size.z : 0.0f);
+        }
+
+        void Quantise(const Vector3& p, uint32_t& x, uint32_t& y, uint32_t& z) const {
+            x = Cell(p.x - origin.x, scale.x);
+            y = Cell(p.y - origin.y, scale.y);
+            z = Cell(p.z - origin.z, scale.z);
+        }
+
+    private:
+        uint32_t Cell(float offset, float s) const {
+            return uint32_t(std::fmax(0.0f, std::fmin(offset * s, maxCell)));
+        }
+
+        Vector3 origin;
+        Vector3 scale;
+        float maxCell;
+    };
+
+    namespace Detail {
+        // Moves the low 10 bits of v two places apart: bit i goes to bit 3i
+        inline uint32_t SpreadBits3(uint32_t v) {
+#ifdef MATHCLASSES_BMI2
+            return _pdep_u32(v, 0x09249249u);
+#else
+            v &= 0x3FFu;
+            v = (v | (v << 16)) & 0x030000FFu;
+            v = (v | (v << 8)) & 0x0300F00Fu;
+            v = (v | (v << 4)) & 0x030C30C3u;
+            v = (v | (v << 2)) & 0x09249249u;
+            return v;
+#endif
+        }
+
+        inline uint32_t CompactBits3(uint32_t v) {
+#ifdef MATHCLASSES_BMI2
+            return _pext_u32(v, 0x09249249u);
+#else
+            v &= 0x09249249u;
+            v = (v ^ (v >> 2)) & 0x030C30C3u;
+            v = (v ^ (v >> 4)) & 0x0300F00Fu;
+            v = (v ^ (v >> 8)) & 0x030000FFu;
+            v = (v ^ (v >> 16)) & 0x000003FFu;
+            return v;
+#endif
+        }
+
+        // The same for the low 21 bits into 63
+        inline uint64_t SpreadBits3(uint64_t v) {
+#ifdef MATHCLASSES_BMI2
+            return _pdep_u64(v, 0x1249249249249249ull);
+#else
+            v &= 0x1FFFFFull;
+            v = (v | (v << 32)) & 0x001F00000000FFFFull;
+            v = (v | (v << 16)) & 0x001F0000FF0000FFull;
+            v = (v | (v << 8)) & 0x100F00F00F00F00Full;
+            v = (v | (v << 4)) & 0x10C30C30C30C30C3ull;
+            v = (v | (v << 2)) & 0x1249249249249249ull;
+            return v;
+#endif
+        }
+
+        inline uint64_t CompactBits3(uint64_t v) {
+#ifdef MATHCLASSES_BMI2
+            return _pext_u64(v, 0x1249249249249249ull);
+#else
+            v &= 0x1249249249249249ull;
+            v = (v ^ (v >> 2)) & 0x10C30C30C30C30C3ull;
+            v = (v ^ (v >> 4)) & 0x100F00F00F00F00Full;
+            v = (v ^ (v >> 8)) & 0x001F0000FF0000FFull;
+            v = (v ^ (v >> 16)) & 0x001F00000000FFFFull;
+            v = (v ^ (v >> 32)) & 0x00000000001FFFFFull;
+            return v;
+#endif
+        }
+
+        // Skilling's in place conversion between grid coordinates and the "transposed"
+        // Hilbert index, whose bits interleaved (a first) give the index itself.
+        // J. Skilling, "Programming the Hilbert curve", AIP Conf. Proc. 707 (2004).
+        inline void AxesToHilbertTranspose(uint32_t (&a)[3], int bits) {
+            uint32_t high = 1u << (bits - 1);
+            for (uint32_t q = high; q > 1; q >>= 1) {
+                uint32_t p = q - 1;
+                for (int i = 0; i < 3; ++i) {
+                    if (a[i] & q) {
+                        a[0] ^= p;
+                    } else {
+                        uint32_t t = (a[0] ^ a[i]) & p;
+                        a[0] ^= t;
+                        a[i] ^= t;
+                    }
+                }
+            }
+            a[1] ^= a[0];
+            a[2] ^= a[1];
+            uint32_t t = 0;
+            for (uint32_t q = high; q > 1; q >>= 1) {
+                if (a[2] & q) {
+                    t ^= q - 1;
+                }
+            }
+            for (int i = 0; i < 3; ++i) {
+                a[i] ^= t;
+            }
+        }
+
+        inline void HilbertTransposeToAxes(uint32_t (&a)[3], int bits) {
+            uint32_t end = 2u << (bits - 1);
+            uint32_t t = a[2] >> 1;
+            a[2] ^= a[1];
+            a[1] ^= a[0];
+            a[0] ^= t;
+            for (uint32_t q = 2; q != end; q <<= 1) {
+                uint32_t p = q - 1;
+                for (int i = 2; i >= 0; --i) {
+                    if (a[i] & q) {
+                        a[0] ^= p;
+                    } else {
+                        t = (a[0] ^ a[i]) & p;
+                        a[0] ^= t;
+                        a[i] ^= t;
+                    }
+                }
+            }
+        }
+    }
+
+    // Morton (Z order) codes: the bits of x, y and z interleaved, x lowest.
+    // 30 bit codes take 10 bits per axis, 63 bit codes 21.
+    inline uint32_t EncodeMorton30(uint32_t x, uint32_t y, uint32_t z) {
+        return Detail::SpreadBits3(x) | (Detail::SpreadBits3(y) << 1) | (Detail::SpreadBits3(z) << 2);
+    }
+
+    inline void DecodeMorton30(uint32_t code, uint32_t& x, uint32_t& y, uint32_t& z) {
+        x = Detail::CompactBits3(code);
+        y = Detail::CompactBits3(code >> 1);
+        z = Detail::CompactBits3(code >> 2);
+    }
+
+    inline uint64_t EncodeMorton63(uint32_t x, uint32_t y, uint32_t z) {
+        return Detail::SpreadBits3(uint64_t(x)) | (Detail::SpreadBits3(uint64_t(y)) << 1) | (Detail::SpreadBits3(uint64_t(z)) << 2);
+    }
+
+    inline void DecodeMorton63(uint64_t code, uint32_t& x, uint32_t& y, uint32_t& z) {
+        x = uint32_t(Detail::CompactBits3(code));
+        y = uint32_t(Detail::CompactBits3(code >> 1));
+        z = uint32_t(Detail::CompactBits3(code >> 2));
+    }
+
+    // Hilbert codes on the same grids. Consecutive codes are always neighbouring cells,
+    // unlike Morton codes, which jump at every power of two boundary; they cost a few
+    // times more to compute.
+    inline uint32_t EncodeHilbert30(uint32_t x, uint32_t y, uint32_t z) {
+        uint32_t a[3] = { x & 0x3FFu, y & 0x3FFu, z & 0x3FFu };
+        Detail::AxesToHilbertTranspose(a, 10);
+        return EncodeMorton30(a[2], a[1], a[0]);
+    }
+
+    inline void DecodeHilbert30(uint32_t code, uint32_t& x, uint32_t& y, uint32_t& z) {
+        uint32_t a[3];
+        DecodeMorton30(code, a[2], a[1], a[0]);
+        Detail::HilbertTransposeToAxes(a, 10);
+        x = a[0];
+        y = a[1];
+        z = a[2];
+    }
+
+    inline uint64_t EncodeHilbert63(uint32_t x, uint32_t y, uint32_t z) {
+        uint32_t a[3] = { x & 0x1FFFFFu, y & 0x1FFFFFu, z & 0x1FFFFFu };
+        Detail::AxesToHilbertTranspose(a, 21);
+        return EncodeMorton63(a[2], a[1], a[0]);
+    }
+
+    inline void DecodeHilbert63(uint64_t code, uint32_t& x, uint32_t& y, uint32_t& z) {
+        uint32_t a[3];
+        DecodeMorton63(code, a[2], a[1], a[0]);
+        Detail::HilbertTransposeToAxes(a, 21);
+        x = a[0];
+        y = a[1];
+        z = a[2];
+    }
+
+    enum class SpaceFillingCurve {
+        Morton,
+        Hilbert
+    };
+
+    namespace Detail {
+        template<typename Code>
+        Code EncodeCurve(SpaceFillingCurve curve, uint32_t x, uint32_t y, uint32_t z);
+
+        template<>
+        inline uint32_t EncodeCurve<uint32_t>(SpaceFillingCurve curve, uint32_t x, uint32_t y, uint32_t z) {
+            return curve == SpaceFillingCurve::Morton ? EncodeMorton30(x, y, z) : EncodeHilbert30(x, y, z);
+        }
+
+        template<>
+        inline uint64_t EncodeCurve<uint64_t>(SpaceFillingCurve curve, uint32_t x, uint32_t y, uint32_t z) {
+            return curve == SpaceFillingCurve::Morton ? EncodeMorton63(x, y, z) : EncodeHilbert63(x, y, z);
+        }
+    }
+
+    // Curve codes for points quantised to a grid over bounds. The code type picks the
+    // precision: uint32_t codes are 30 bit, uint64_t codes 63 bit.
+    template<typename Policy, typename Code>
+    void ComputeCurveCodes(Policy policy, SpaceFillingCurve curve, const Vector3* points, std::size_t count,
+        const AABB& bounds, Code* codes)
+    {
+        GridQuantiser grid(bounds, sizeof(Code) == 4 ? 10 : 21);
+        ForEachRange(policy, count, GrainForBytes(sizeof(Vector3) + sizeof(Code)), [&](std::size_t begin, std::size_t end) {
+            for (std::size_t i = begin; i < end; ++i) {
+                uint32_t x, y, z;
+                grid.Quantise(points[i], x, y, z);
+                codes[i] = Detail::EncodeCurve<Code>(curve, x, y, z);
+            }
+        });
+    }
+
+    template<typename Code>
+    void ComputeCurveCodes(SpaceFillingCurve curve, const Vector3* points, std::size_t count, const AABB& bounds, Code* codes) {
+        ComputeCurveCodes(Execution::Seq, curve, points, count, bounds, codes);
+    }
+
+    // Codes from a FrameArena, e.g. ComputeCurveCodes<uint64_t>(arena, ...); empty if
+    // the arena can't fit them
+    template<typename Code, typename Policy>
+    Span<Code> ComputeCurveCodes(Policy policy, FrameArena& arena, SpaceFillingCurve curve, const Vector3* points, std::size_t count,
+        const AABB& bounds)
+    {
+        Span<Code> codes = arena.AllocateUninitialised<Code>(count);
+        if (codes.Size() == count) {
+            ComputeCurveCodes(policy, curve, points, count, bounds, codes.Data());
+        }
+        return codes;
+    }
+
+    template<typename Code>
+    Span<Code> ComputeCurveCodes(FrameArena& arena, SpaceFillingCurve curve, const Vector3* points, std::size_t count, const AABB& bounds) {
+        return ComputeCurveCodes<Code>(Execution::Seq, arena, curve, points, count, bounds);
+    }
+
+    // The order that walks the points along a curve over their bounds: order[i] is the
+    // index of the i-th point along it. Points in the same cell keep their original
+    // order. Use ApplyPermutation to reorder the points and anything stored with them.
+    // The codes and the sort's working memory are allocated on every call; the
+    // FrameArena overload takes them from the arena instead.
+    template<typename Policy>
+    void ComputeCurveOrder(Policy policy, SpaceFillingCurve curve, const Vector3* points, std::size_t count, uint32_t* order) {
+        AABB bounds = ComputeBounds(policy, points, count);
+        std::vector<uint64_t> codes(count);
+        ComputeCurveCodes(policy, curve, points, count, bounds, codes.data());
+        RadixSort(policy, codes.data(), count, order, 63);
+    }
+
+    inline void ComputeCurveOrder(SpaceFillingCurve curve, const Vector3* points, std::size_t count, uint32_t* order) {
+        ComputeCurveOrder(Execution::Seq, curve, points, count, order);
+    }
+
+    // The order in arena memory, with everything else it needs handed back to the
+    // arena. Empty, with nothing left allocated, if the arena can't fit it all.
+    template<typename Policy>
+    Span<uint32_t> ComputeCurveOrder(Policy policy, FrameArena& arena, SpaceFillingCurve curve, const Vector3* points, std::size_t count) {
+        FrameArena::Marker marker = arena.GetMarker();
+        Span<uint32_t> order = arena.AllocateUninitialised<uint32_t>(count);
+        bool sorted = false;
+        if (order.Size() == count) {
+            ArenaScope scope(arena);
+            AABB bounds = ComputeBounds(policy, arena, points, count);
+            Span<uint64_t> codes = ComputeCurveCodes<uint64_t>(policy, arena, curve, points, count, bounds);
+            sorted = codes.Size() == count && RadixSort(policy, arena, codes.Data(), count, order.Data(), 63);
+        }
+        if (!sorted) {
+            arena.RewindTo(marker);
+            return Span<uint32_t>();
+        }
+        return order;
+    }
+
+    inline Span<uint32_t> ComputeCurveOrder(FrameArena& arena, SpaceFillingCurve curve, const Vector3* points, std::size_t count) {
+        return ComputeCurveOrder(Execution::Seq, arena, curve, points, count);
+    }
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include <cstddef>
+#include <type_traits>
+
+namespace MathClasses {
+
+    // Non-owning view of a contiguous array
+    template<typename T>
+    struct Span {
+        T* data;
+        std::size_t size;
+
+        Span() : data(nullptr), size(0) {}
+
+        Span(T* data, std::size_t size) : data(data), size(size) {}
+
+        // Allows a Span<T> to be passed where a Span<const T> is expected
+        template<typename U, typename = std::enable_if_t<std::is_convertible<U(*)[], T(*)[]>::value>>
+        Span(const Span<U>& other) : data(other.data), size(other.size) {}
+
+        T* Data() const { return data; }
+        std::size_t Size() const { return size; }
+        bool Empty() const { return size == 0; }
+
+        T& operator[](std::size_t i) const { return data[i]; }
+
+        // Sub-span of count elements starting at offset
+        Span SubSpan(std::size_t offset, std::size_t count) const {
+            return Span(data + offset, count);
+        }
+
+        T* begin() const { return data; }
+        T* end() const { return data + size; }
+    };
+}
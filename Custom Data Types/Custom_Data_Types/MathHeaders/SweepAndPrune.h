@@ -0,0 +1,264 @@
+#pragma once
+#include "AABB.h"
+#include "RadixSort.h"
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace MathClasses {
+    // Two overlapping boxes, by index into the bounds given to SweepAndPrune; a < b
+    struct BroadphasePair {
+        uint32_t a;
+        uint32_t b;
+
+        bool operator==(const BroadphasePair& other) const {
+            return a == other.a && b == other.b;
+        }
+
+        bool operator<(const BroadphasePair& other) const {
+            return a != other.a ? a < other.a : b < other.b;
+        }
+    };
+
+    namespace Detail {
+        inline float Component(const Vector3& v, int axis) {
+            return axis == 0 ? v.x : (axis == 1 ? v.y : v.z);
+        }
+    }
+
+    // Incremental sweep and prune broadphase. Each box's min and max on one axis are
+    // kept as a sorted list of endpoints; boxes whose intervals overlap on that axis
+    // are then checked on the other two.
+    //
+    // The sweep axis is the one with the largest spread of box centres. Between
+    // frames most boxes move a little, so Update re-sorts the existing list with an
+    // insertion sort, which is close to linear when the order barely changes. If the
+    // insertion sort does more than a few shifts per endpoint it gives up and the list
+    // is radix sorted instead.
+    //
+    // Empty boxes (such as a default AABB) keep their endpoints but never pair.
+    class SweepAndPrune {
+    public:
+        // Insertion sort shifts allowed per endpoint before switching to a radix sort
+        static constexpr std::size_t MaxShiftsPerEndpoint = 4;
+
+        // Replaces every box and sorts from scratch
+        void SetBounds(const AABB* bounds, std::size_t count) {
+            boxes.assign(bounds, bounds + count);
+            axis = DominantAxis(-1);
+            endpoints.clear();
+            endpoints.reserve(count * 2);
+            for (std::size_t i = 0; i < count; ++i) {
+                endpoints.push_back(Endpoint{ 0.0f, uint32_t(i) << 1 });
+                endpoints.push_back(Endpoint{ 0.0f, (uint32_t(i) << 1) | 1u });
+            }
+            RefreshValues();
+            RadixSort();
+        }
+
+        // New bounds for the same boxes, e.g. after a physics step. A different box
+        // count is treated as SetBounds.
+        void UpdateBounds(const AABB* bounds, std::size_t count) {
+            if (count != boxes.size()) {
+                SetBounds(bounds, count);
+                return;
+            }
+            boxes.assign(bounds, bounds + count);
+            int best = DominantAxis(axis);
+            if (best != axis) {
+                axis = best;
+                RefreshValues();
+                RadixSort();
+                return;
+            }
+            RefreshValues();
+            if (!InsertionSort(endpoints.size() * MaxShiftsPerEndpoint)) {
+                RadixSort();
+            }
+        }
+
+        // Writes every overlapping pair to pairs, which is cleared first. Passing the
+        // same vector each frame reuses its storage.
+        void FindPairs(std::vector<BroadphasePair>& pairs) {
+            pairs.clear();
+            active.clear();
+            activeSlot.assign(boxes.size(), NotActive);
+            int axisA = (axis + 1) % 3, axisB = (axis + 2) % 3;
+
+            for (const Endpoint& e : endpoints) {
+                uint32_t id = e.data >> 1;
+                if (e.data & 1u) {
+                    // Max endpoint: remove from the active list by swapping with the last.
+                    // An empty box's max sorts before its min, and it was never added.
+                    uint32_t slot = activeSlot[id];
+                    if (slot == NotActive) {
+                        continue;
+                    }
+                    uint32_t last = active.back();
+                    active[slot] = last;
+                    activeSlot[last] = slot;
+                    active.pop_back();
+                    continue;
+                }
+
+                const AABB& box = boxes[id];
+                if (box.IsEmpty()) {
+                    continue;
+                }
+                float minA = Detail::Component(box.min, axisA), maxA = Detail::Component(box.max, axisA);
+                float minB = Detail::Component(box.min, axisB), maxB = Detail::Component(box.max, axisB);
+                for (uint32_t other : active) {
+                    const AABB& o = boxes[other];
+                    if (minA <= Detail::Component(o.max, axisA) && Detail::Component(o.min, axisA) <= maxA &&
+                        minB <= Detail::Component(o.max, axisB) && Detail::Component(o.min, axisB) <= maxB) {
+                        pairs.push_back(other < id ? BroadphasePair{ other, id } : BroadphasePair{ id, other });
+                    }
+                }
+                activeSlot[id] = uint32_t(active.size());
+                active.push_back(id);
+            }
+        }
+
+        // 0, 1 or 2 for x, y or z
+        int GetAxis() const { return axis; }
+
+        std::size_t GetCount() const { return boxes.size(); }
+
+    private:
+        // activeSlot for a box not in the active list
+        static constexpr uint32_t NotActive = 0xFFFFFFFFu;
+
+        // data is the box index shifted left one, with the low bit set for a max
+        struct Endpoint {
+            float value;
+            uint32_t data;
+        };
+
+        // At equal values mins sort before maxes so touching boxes are reported
+        static bool Less(const Endpoint& a, const Endpoint& b) {
+            return a.value < b.value || (a.value == b.value && (a.data & 1u) < (b.data & 1u));
+        }
+
+        // Axis with the largest variance of box centres. Only moves away from the
+        // current axis when another is clearly better, so the sort isn't thrown away
+        // every time two axes are close.
+        int DominantAxis(int current) const {
+            if (boxes.empty()) {
+                return current < 0 ? 0 : current;
+            }
+            double sum[3] = {}, sumSq[3] = {};
+            std::size_t count = 0;
+            for (const AABB& box : boxes) {
+                if (box.IsEmpty()) {
+                    continue;
+                }
+                ++count;
+                Vector3 c = box.GetCentre();
+                float v[3] = { c.x, c.y, c.z };
+                for (int k = 0; k < 3; ++k) {
+                    sum[k] += v[k];
+                    sumSq[k] += double(v[k]) * v[k];
+                }
+            }
+            if (count == 0) {
+                return current < 0 ? 0 : current;
+            }
+            double n = double(count);
+            double variance[3];
+            int best = 0;
+            for (int k = 0; k < 3; ++k) {
+                variance[k] = sumSq[k] / n - (sum[k] / n) * (sum[k] / n);
+                if (variance[k] > variance[best]) {
+                    best = k;
+                }
+            }
+            if (current >= 0 && variance[best] <= variance[current] * 1.5) {
+                return current;
+            }
+            return best;
+        }
+
+        void RefreshValues() {
+            for (Endpoint& e : endpoints) {
+                const AABB& box = boxes[e.data >> 1];
+                e.value = Detail::Component((e.data & 1u) ? box.max : box.min, axis);
+            }
+        }
+
+        // Returns false, leaving the list partly sorted, if it needs more than maxShifts
+        bool InsertionSort(std::size_t maxShifts) {
+            std::size_t shifts = 0;
+            for (std::size_t i = 1; i < endpoints.size(); ++i) {
+                Endpoint e = endpoints[i];
+                std::size_t j = i;
+                while (j > 0 && Less(e, endpoints[j - 1])) {
+                    endpoints[j] = endpoints[j - 1];
+                    --j;
+                }
+                endpoints[j] = e;
+                shifts += i - j;
+                if (shifts > maxShifts) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        // Radix key for an endpoint. Adding zero turns -0 into +0, which Less treats as
+        // equal, so a max at -0 doesn't sort ahead of a min at +0 and miss the pair.
+        static uint32_t SortKey(float value) {
+            return Detail::SortableFloatBits(value + 0.0f);
+        }
+
+        // Stable LSD radix sort on 8 bit digits. Mins are moved ahead of maxes first
+        // so that ties come out in the same order Less gives.
+        void RadixSort() {
+            std::size_t n = endpoints.size();
+            scratch.resize(n);
+            std::size_t mins = 0;
+            for (const Endpoint& e : endpoints) {
+                mins += (e.data & 1u) ? 0 : 1;
+            }
+            std::size_t nextMin = 0, nextMax = mins;
+            for (const Endpoint& e : endpoints) {
+                scratch[(e.data & 1u) ? nextMax++ : nextMin++] = e;
+            }
+            endpoints.swap(scratch);
+
+            std::size_t counts[4][256] = {};
+            for (const Endpoint& e : endpoints) {
+                uint32_t key = SortKey(e.value);
+                for (int pass = 0; pass < 4; ++pass) {
+                    ++counts[pass][(key >> (pass * 8)) & 0xFF];
+                }
+            }
+
+            for (int pass = 0; pass < 4; ++pass) {
+                // Every key has the same digit, so this pass wouldn't move anything
+                uint32_t firstDigit = n ? (SortKey(endpoints[0].value) >> (pass * 8)) & 0xFF : 0;
+                if (counts[pass][firstDigit] == n) {
+                    continue;
+                }
+                std::size_t offset = 0;
+                for (std::size_t& count : counts[pass]) {
+                    std::size_t c = count;
+                    count = offset;
+                    offset += c;
+                }
+                for (const Endpoint& e : endpoints) {
+                    uint32_t digit = (SortKey(e.value) >> (pass * 8)) & 0xFF;
+                    scratch[counts[pass][digit]++] = e;
+                }
+                endpoints.swap(scratch);
+            }
+        }
+
+        std::vector<AABB> boxes;
+        std::vector<Endpoint> endpoints;
+        std::vector<Endpoint> scratch;
+        std::vector<uint32_t> active;
+        std::vector<uint32_t> activeSlot;
+        int axis = 0;
+    };
+}
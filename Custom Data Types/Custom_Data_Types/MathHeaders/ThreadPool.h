@@ -0,0 +1,343 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace MathClasses {
+
+    // Execution policies for the batch functions, in the style of std::execution
+    namespace Execution {
+        struct SequencedPolicy {};
+        struct ParallelPolicy {};
+
+        inline constexpr SequencedPolicy Seq{};
+        inline constexpr ParallelPolicy Par{};
+    }
+
+    // Size of the per-core L2 cache that batch work is split against
+    constexpr std::size_t L2CacheBytes = 256 * 1024;
+
+    // Number of items that fit in half of L2, so a chunk's input and output stay cache resident
+    constexpr std::size_t GrainForBytes(std::size_t bytesPerItem) {
+        return (bytesPerItem == 0 || bytesPerItem >= L2CacheBytes / 2) ? 1 : L2CacheBytes / 2 / bytesPerItem;
+    }
+
+    // Work-stealing thread pool. Every thread owns a deque of index ranges; a thread splits
+    // the range it is running in half, pushes the upper half onto its own deque and keeps
+    // going with the lower half. Idle threads steal the oldest (largest) ranges from others.
+    class ThreadPool {
+    public:
+        // Creates a pool with the given number of worker threads; the calling thread also helps
+        explicit ThreadPool(unsigned int workerCount = DefaultWorkerCount())
+            : queues(workerCount + 1)
+        {
+            workers.reserve(workerCount);
+            for (unsigned int i = 0; i < workerCount; ++i) {
+                workers.emplace_back([this, i] { WorkerLoop(i); });
+            }
+        }
+
+        ~ThreadPool() {
+            {
+                std::lock_guard<std::mutex> lock(sleepMutex);
+                stopping = true;
+            }
+            wake.notify_all();
+            for (std::thread& worker : workers) {
+                worker.join();
+            }
+        }
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        // Shared pool used by the parallel batch functions
+        static ThreadPool& Get() {
+            static ThreadPool pool;
+            return pool;
+        }
+
+        // One worker per hardware thread, minus the caller
+        static unsigned int DefaultWorkerCount() {
+            unsigned int hardwareThreads = std::thread::hardware_concurrency();
+            return hardwareThreads > 1 ? hardwareThreads - 1 : 0;
+        }
+
+        // Worker threads plus the calling thread
+        unsigned int GetThreadCount() const {
+            return static_cast<unsigned int>(workers.size()) + 1;
+        }
+
+        // Calls func(rangeBegin, rangeEnd) over disjoint sub-ranges covering [begin, end).
+        // Sub-ranges are never split below grain items, and a range of grain items or
+        // fewer runs inline on the calling thread without touching the pool.
+        // Returns once every sub-range has finished. Safe to call from inside func.
+        // If func throws, sub-ranges that haven't started are skipped and the first
+        // exception is rethrown here once the ones already running have finished.
+        template<typename Func>
+        void ParallelFor(std::size_t begin, std::size_t end, std::size_t grain, Func&& func) {
+            if (end <= begin) {
+                return;
+            }
+            if (grain == 0) {
+                grain = 1;
+            }
+            if (end - begin <= grain || workers.empty()) {
+                func(begin, end);
+                return;
+            }
+
+            using FuncType = std::remove_reference_t<Func>;
+            Job job;
+            job.grain = grain;
+            job.context = const_cast<void*>(static_cast<const void*>(&func));
+            job.invoke = [](void* context, std::size_t rangeBegin, std::size_t rangeEnd) {
+                (*static_cast<FuncType*>(context))(rangeBegin, rangeEnd);
+            };
+            job.remaining.store(end - begin, std::memory_order_relaxed);
+
+            std::size_t queue = CurrentQueue();
+            RunRange(Range{ &job, begin, end }, queue);
+
+            // Help with any outstanding work until every range of this job has completed
+            while (job.remaining.load(std::memory_order_acquire) != 0) {
+                if (!RunOne(queue)) {
+                    std::this_thread::yield();
+                }
+            }
+            if (job.error) {
+                std::rethrow_exception(job.error);
+            }
+        }
+
+    private:
+        struct Job {
+            void (*invoke)(void*, std::size_t, std::size_t) = nullptr;
+            void* context = nullptr;
+            std::size_t grain = 1;
+            std::atomic<std::size_t> remaining{ 0 };
+            // Set by the first range to throw; read by the owner after remaining is zero
+            std::atomic<bool> failed{ false };
+            std::exception_ptr error;
+        };
+
+        struct Range {
+            Job* job;
+            std::size_t begin;
+            std::size_t end;
+        };
+
+        struct alignas(64) WorkQueue {
+            std::mutex mutex;
+            std::deque<Range> ranges;
+        };
+
+        struct WorkerSlot {
+            const ThreadPool* pool = nullptr;
+            std::size_t index = 0;
+        };
+
+        static WorkerSlot& CurrentSlot() {
+            thread_local WorkerSlot slot;
+            return slot;
+        }
+
+        // Workers use their own queue; any other thread shares the last one
+        std::size_t CurrentQueue() const {
+            const WorkerSlot& slot = CurrentSlot();
+            return slot.pool == this ? slot.index : workers.size();
+        }
+
+        void Push(std::size_t queue, const Range& range) {
+            {
+                std::lock_guard<std::mutex> lock(queues[queue].mutex);
+                queues[queue].ranges.push_back(range);
+            }
+            pending.fetch_add(1);
+            if (sleeping.load() > 0) {
+                std::lock_guard<std::mutex> lock(sleepMutex);
+                wake.notify_one();
+            }
+        }
+
+        // Owners take the newest range (still warm in cache), thieves take the oldest
+        bool TryPop(std::size_t queue, bool steal, Range& range) {
+            std::lock_guard<std::mutex> lock(queues[queue].mutex);
+            std::deque<Range>& ranges = queues[queue].ranges;
+            if (ranges.empty()) {
+                return false;
+            }
+            if (steal) {
+                range = ranges.front();
+                ranges.pop_front();
+            }
+            else {
+                range = ranges.back();
+                ranges.pop_back();
+            }
+            pending.fetch_sub(1);
+            return true;
+        }
+
+        bool RunOne(std::size_t queue) {
+            Range range;
+            bool found = TryPop(queue, false, range);
+            for (std::size_t i = 1; !found && i < queues.size(); ++i) {
+                found = TryPop((queue + i) % queues.size(), true, range);
+            }
+            if (found) {
+                RunRange(range, queue);
+            }
+            return found;
+        }
+
+        void RunRange(Range range, std::size_t queue) {
+            Job* job = range.job;
+            // After a failure the remaining ranges are only counted off, not run
+            if (!job->failed.load(std::memory_order_relaxed)) {
+                try {
+                    while (range.end - range.begin > job->grain) {
+                        std::size_t mid = range.begin + (range.end - range.begin) / 2;
+                        Push(queue, Range{ job, mid, range.end });
+                        range.end = mid;
+                    }
+                    job->invoke(job->context, range.begin, range.end);
+                }
+                catch (...) {
+                    bool expected = false;
+                    if (job->failed.compare_exchange_strong(expected, true)) {
+                        job->error = std::current_exception();
+                    }
+                }
+            }
+            // The job may be destroyed by its owner as soon as this reaches zero
+            job->remaining.fetch_sub(range.end - range.begin, std::memory_order_acq_rel);
+        }
+
+        void WorkerLoop(std::size_t index) {
+            CurrentSlot().pool = this;
+            CurrentSlot().index = index;
+
+            while (true) {
+                if (RunOne(index)) {
+                    continue;
+                }
+                std::unique_lock<std::mutex> lock(sleepMutex);
+                if (stopping) {
+                    return;
+                }
+                sleeping.fetch_add(1);
+                wake.wait(lock, [this] { return stopping || pending.load() > 0; });
+                sleeping.fetch_sub(1);
+                if (stopping) {
+                    return;
+                }
+            }
+        }
+
+        std::vector<WorkQueue> queues;
+        std::vector<std::thread> workers;
+        std::atomic<std::size_t> pending{ 0 };
+        std::atomic<unsigned int> sleeping{ 0 };
+        std::mutex sleepMutex;
+        std::condition_variable wake;
+        bool stopping = false;
+    };
+
+    // Runs func(begin, end) once over the whole of [0, count) on the calling thread
+    template<typename Func>
+    void ForEachRange(Execution::SequencedPolicy, std::size_t count, std::size_t, Func&& func) {
+        if (count > 0) {
+            func(std::size_t(0), count);
+        }
+    }
+
+    // Runs func(begin, end) over [0, count) split across the shared pool
+    template<typename Func>
+    void ForEachRange(Execution::ParallelPolicy, std::size_t count, std::size_t grain, Func&& func) {
+        ThreadPool::Get().ParallelFor(0, count, grain, func);
+    }
+
+    // Storage whose elements are constructed by the pool threads using the same
+    // L2-sized split the batch functions use, so on NUMA systems each page is
+    // first touched (and therefore placed) near a thread that will work on it
+    template<typename T>
+    class FirstTouchBuffer {
+    public:
+        FirstTouchBuffer() = default;
+
+        explicit FirstTouchBuffer(std::size_t count) : count(count) {
+            if (count == 0) {
+                return;
+            }
+            data = static_cast<T*>(::operator new(count * sizeof(T), std::align_val_t(Alignment)));
+            T* storage = data;
+            ForEachRange(Execution::Par, count, GrainForBytes(sizeof(T)), [storage](std::size_t begin, std::size_t end) {
+                for (std::size_t i = begin; i < end; ++i) {
+                    new (storage + i) T();
+                }
+            });
+        }
+
+        ~FirstTouchBuffer() {
+            Release();
+        }
+
+        FirstTouchBuffer(FirstTouchBuffer&& other) noexcept : data(other.data), count(other.count) {
+            other.data = nullptr;
+            other.count = 0;
+        }
+
+        FirstTouchBuffer& operator=(FirstTouchBuffer&& other) noexcept {
+            if (this != &other) {
+                Release();
+                data = other.data;
+                count = other.count;
+                other.data = nullptr;
+                other.count = 0;
+            }
+            return *this;
+        }
+
+        FirstTouchBuffer(const FirstTouchBuffer&) = delete;
+        FirstTouchBuffer& operator=(const FirstTouchBuffer&) = delete;
+
+        T* Data() { return data; }
+        const T* Data() const { return data; }
+        std::size_t Size() const { return count; }
+
+        T& operator[](std::size_t i) { return data[i]; }
+        const T& operator[](std::size_t i) const { return data[i]; }
+
+        T* begin() { return data; }
+        T* end() { return data + count; }
+        const T* begin() const { return data; }
+        const T* end() const { return data + count; }
+
+    private:
+        static constexpr std::size_t Alignment = alignof(T) > 64 ? alignof(T) : 64;
+
+        void Release() {
+            if (data == nullptr) {
+                return;
+            }
+            for (std::size_t i = 0; i < count; ++i) {
+                data[i].~T();
+            }
+            ::operator delete(data, std::align_val_t(Alignment));
+            data = nullptr;
+            count = 0;
+        }
+
+        T* data = nullptr;
+        std::size_t count = 0;
+    };
+}
@@ -0,0 +1,166 @@
+#pragma once
+#include "Matrix3.h"
+#include "Matrix4.h"
+#include "FrameArena.h"
+#include "Quaternion.h"
+#include "Vector3.h"
+#include "ThreadPool.h"
+#include <cstddef>
+#include <cstdint>
+
+namespace MathClasses {
+
+    // A transform kept as both translation/rotation/scale and a Matrix4, where either
+    // form can be stale. Setting one form marks the other stale and the getters rebuild
+    // it on first use, so a transform that is only ever set from matrices and read
+    // as components (or the other way round) converts once per change. Translation is
+    // the same in both forms, so setting it never makes either one stale.
+    //
+    // The getters update the cache, so reading one Transform from several threads at
+    // once needs the form to be current first (see IsMatrixCurrent and friends).
+    class Transform {
+    public:
+        Transform() : matrix(Matrix4::MakeIdentity()) {}
+
+        Transform(const Vector3& translation, const Quaternion& rotation, const Vector3& scale)
+            : translation(translation), rotation(rotation), scale(scale), stale(MatrixStale) {}
+
+        explicit Transform(const Matrix4& matrix)
+            : translation(matrix.m13, matrix.m14, matrix.m15), matrix(matrix), stale(ComponentsStale) {}
+
+        bool IsMatrixCurrent() const { return (stale & MatrixStale) == 0; }
+        bool AreComponentsCurrent() const { return (stale & ComponentsStale) == 0; }
+
+        const Vector3& GetTranslation() const { return translation; }
+
+        const Quaternion& GetRotation() const {
+            UpdateComponents();
+            return rotation;
+        }
+
+        const Vector3& GetScale() const {
+            UpdateComponents();
+            return scale;
+        }
+
+        const Matrix4& GetMatrix() const {
+            UpdateMatrix();
+            return matrix;
+        }
+
+        void SetTranslation(const Vector3& t) {
+            translation = t;
+            matrix.m13 = t.x;
+            matrix.m14 = t.y;
+            matrix.m15 = t.z;
+        }
+
+        void SetRotation(const Quaternion& r) {
+            UpdateComponents();
+            rotation = r;
+            stale = MatrixStale;
+        }
+
+        void SetScale(const Vector3& s) {
+            UpdateComponents();
+            scale = s;
+            stale = MatrixStale;
+        }
+
+        void SetMatrix(const Matrix4& m) {
+            matrix = m;
+            translation = Vector3(m.m13, m.m14, m.m15);
+            stale = ComponentsStale;
+        }
+
+        // Same matrix as MakeTranslation(t) * rotation.ToMatrix4() * MakeScale(s)
+        static Matrix4 ComposeMatrix(const Vector3& t, const Quaternion& r, const Vector3& s) {
+            Matrix3 basis = r.ToMatrix3();
+            return Matrix4(
+                basis.m1 * s.x, basis.m2 * s.x, basis.m3 * s.x, 0,
+                basis.m4 * s.y, basis.m5 * s.y, basis.m6 * s.y, 0,
+                basis.m7 * s.z, basis.m8 * s.z, basis.m9 * s.z, 0,
+                t.x, t.y, t.z, 1
+            );
+        }
+
+    private:
+        enum : uint8_t {
+            MatrixStale = 1 << 0,
+            ComponentsStale = 1 << 1
+        };
+
+        void UpdateComponents() const {
+            if (stale & ComponentsStale) {
+                Vector3 t;
+                matrix.Decompose(t, rotation, scale);
+                stale &= ~ComponentsStale;
+            }
+        }
+
+        void UpdateMatrix() const {
+            if (stale & MatrixStale) {
+                matrix = ComposeMatrix(translation, rotation, scale);
+                stale &= ~MatrixStale;
+            }
+        }
+
+        Vector3 translation;
+        mutable Quaternion rotation;
+        mutable Vector3 scale = Vector3(1, 1, 1);
+        mutable Matrix4 matrix;
+        mutable uint8_t stale = 0;
+    };
+
+    // Matrix4::Decompose over arrays, written out as separate component arrays.
+    // valid[i] gets the result of Decompose; pass nullptr to skip it.
+    template<typename Policy>
+    void DecomposeMatrices(Policy policy, const Matrix4* matrices, Vector3* translations, Quaternion* rotations,
+        Vector3* scales, uint8_t* valid, std::size_t count)
+    {
+        ForEachRange(policy, count, GrainForBytes(sizeof(Matrix4) + 2 * sizeof(Vector3) + sizeof(Quaternion)),
+            [&](std::size_t begin, std::size_t end) {
+                for (std::size_t i = begin; i < end; ++i) {
+                    bool ok = matrices[i].Decompose(translations[i], rotations[i], scales[i]);
+                    if (valid) {
+                        valid[i] = ok ? 1 : 0;
+                    }
+                }
+            });
+    }
+
+    inline void DecomposeMatrices(const Matrix4* matrices, Vector3* translations, Quaternion* rotations,
+        Vector3* scales, uint8_t* valid, std::size_t count)
+    {
+        DecomposeMatrices(Execution::Seq, matrices, translations, rotations, scales, valid, count);
+    }
+
+    // DecomposeMatrices' outputs when they come from a FrameArena
+    struct DecomposedMatrices {
+        Span<Vector3> translations;
+        Span<Quaternion> rotations;
+        Span<Vector3> scales;
+        Span<uint8_t> valid;
+    };
+
+    // Every span is empty if the arena can't fit them all, and nothing is left allocated
+    template<typename Policy>
+    DecomposedMatrices DecomposeMatrices(Policy policy, FrameArena& arena, const Matrix4* matrices, std::size_t count) {
+        FrameArena::Marker marker = arena.GetMarker();
+        DecomposedMatrices out;
+        out.translations = arena.AllocateUninitialised<Vector3>(count);
+        out.rotations = arena.AllocateUninitialised<Quaternion>(count);
+        out.scales = arena.AllocateUninitialised<Vector3>(count);
+        out.valid = arena.AllocateUninitialised<uint8_t>(count);
+        if (out.translations.Size() != count || out.rotations.Size() != count || out.scales.Size() != count || out.valid.Size() != count) {
+            arena.RewindTo(marker);
+            return DecomposedMatrices();
+        }
+        DecomposeMatrices(policy, matrices, out.translations.Data(), out.rotations.Data(), out.scales.Data(), out.valid.Data(), count);
+        return out;
+    }
+
+    inline DecomposedMatrices DecomposeMatrices(FrameArena& arena, const Matrix4* matrices, std::size_t count) {
+        return DecomposeMatrices(Execution::Seq, arena, matrices, count);
+    }
+}
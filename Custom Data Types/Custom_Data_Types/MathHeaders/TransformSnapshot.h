@@ -0,0 +1,140 @@
+#pragma once
+#include "Matrix4.h"
+#include "Vector3.h"
+#include "Span.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace MathClasses {
+
+    // Array handed from one writer thread (simulation) to one reader thread (render)
+    // without locks or whole-array copies. There are three copies of the array: the
+    // writer fills one, the reader reads another, and the third holds the newest
+    // published frame. Publish swaps the writer's copy into the middle with one atomic
+    // exchange, and Acquire swaps the middle out to the reader if it's newer than what
+    // the reader has. Neither side ever waits for the other, and a snapshot the reader
+    // holds is never written until the reader acquires again.
+    //
+    // The array is split into blocks, each with the frame it was last written in. After
+    // a publish the writer's new copy is brought up to date by copying only the blocks
+    // it is behind on from the copy just published, so a frame that changes a few
+    // transforms copies a few blocks, not the whole array.
+    //
+    // One thread may call the writer functions and one (other) thread the reader ones.
+    template<typename T>
+    class SnapshotBuffer {
+    public:
+        static constexpr std::size_t DefaultBlockSize = 64;
+
+        explicit SnapshotBuffer(std::size_t count, const T& initial = T(), std::size_t blockSize = DefaultBlockSize)
+            : count(count), blockSize(blockSize ? blockSize : 1), blockCount((count + this->blockSize - 1) / this->blockSize),
+              latest(blockCount, 0)
+        {
+            for (Copy& copy : copies) {
+                copy.values.assign(count, initial);
+                copy.versions.assign(blockCount, 0);
+            }
+        }
+
+        std::size_t GetCount() const { return count; }
+        std::size_t GetBlockSize() const { return blockSize; }
+
+        // Writer: the copy being filled for the next Publish. It already holds every
+        // earlier frame's values. Changes must be reported with MarkDirty (Set does it)
+        // or they may not survive into later frames.
+        Span<T> GetWriteBuffer() {
+            return Span<T>(copies[back].values.data(), count);
+        }
+
+        // Writer: values [first, first + n) have been, or are about to be, changed
+        void MarkDirty(std::size_t first, std::size_t n) {
+            if (n == 0) {
+                return;
+            }
+            std::vector<uint64_t>& versions = copies[back].versions;
+            for (std::size_t b = first / blockSize, last = (first + n - 1) / blockSize; b <= last; ++b) {
+                latest[b] = frame;
+                versions[b] = frame;
+            }
+        }
+
+        void Set(std::size_t i, const T& value) {
+            copies[back].values[i] = value;
+            MarkDirty(i, 1);
+        }
+
+        // Writer: makes the write buffer the newest snapshot and takes over an old copy,
+        // bringing its stale blocks up to date. Returns the number of blocks copied.
+        std::size_t Publish() {
+            uint32_t published = back;
+            copies[published].frame = frame;
+            uint32_t previous = middle.exchange(published | FreshBit, std::memory_order_acq_rel);
+            back = previous & IndexMask;
+            ++frame;
+
+            // The copy just published is only ever read from here on, by either thread
+            Copy& target = copies[back];
+            const Copy& source = copies[published];
+            std::size_t copied = 0;
+            for (std::size_t b = 0; b < blockCount; ++b) {
+                if (target.versions[b] != latest[b]) {
+                    std::size_t first = b * blockSize;
+                    std::size_t last = first + blockSize < count ? first + blockSize : count;
+                    for (std::size_t i = first; i < last; ++i) {
+                        target.values[i] = source.values[i];
+                    }
+                    target.versions[b] = latest[b];
+                    ++copied;
+                }
+            }
+            return copied;
+        }
+
+        // Reader: the newest published snapshot. It stays valid and unchanged until the
+        // next Acquire. Before the first Publish this is the initial values, frame 0.
+        Span<const T> Acquire() {
+            if (middle.load(std::memory_order_acquire) & FreshBit) {
+                front = middle.exchange(front, std::memory_order_acq_rel) & IndexMask;
+            }
+            return Span<const T>(copies[front].values.data(), count);
+        }
+
+        // Reader: the frame number of the snapshot from the last Acquire. Frames count up
+        // from 1 with each Publish.
+        uint64_t GetSnapshotFrame() const {
+            return copies[front].frame;
+        }
+
+    private:
+        static constexpr uint32_t FreshBit = 4;
+        static constexpr uint32_t IndexMask = 3;
+
+        struct Copy {
+            std::vector<T> values;
+            // Frame each block was last brought up to date in
+            std::vector<uint64_t> versions;
+            uint64_t frame = 0;
+        };
+
+        std::size_t count;
+        std::size_t blockSize;
+        std::size_t blockCount;
+        Copy copies[3];
+
+        // Writer only
+        uint32_t back = 0;
+        uint64_t frame = 1;
+        std::vector<uint64_t> latest;
+
+        // The middle copy's index, with FreshBit set when the reader hasn't taken it
+        std::atomic<uint32_t> middle{ 1 };
+
+        // Reader only
+        uint32_t front = 2;
+    };
+
+    using TransformSnapshot = SnapshotBuffer<Matrix4>;
+    using PositionSnapshot = SnapshotBuffer<Vector3>;
+}
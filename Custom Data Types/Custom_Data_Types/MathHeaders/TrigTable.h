@@ -0,0 +1,79 @@
+#pragma once
+#include <cmath>
+#include <cstdint>
+
+namespace MathClasses {
+
+    // Sine and cosine of angles quantised to 1/4096 of a turn, e.g. replicated headings.
+    //
+    // Only the first quarter wave is stored (1025 floats, just over 4KB, so it stays in
+    // L1); the other quarters are the same values swapped and negated. Values are
+    // correctly rounded sin and cos of the exact quantised angle, so quarter turns give
+    // exactly 0 and +-1.
+    class SinCosTable {
+    public:
+        static constexpr int Bits = 12;
+        static constexpr uint32_t Steps = 1u << Bits;
+        static constexpr uint32_t QuarterSteps = Steps / 4;
+        static constexpr double TwoPi = 6.283185307179586476925;
+
+        // The shared table, built on first use
+        static const SinCosTable& Get() {
+            static const SinCosTable table;
+            return table;
+        }
+
+        // Angle in steps of 1/4096 of a turn; any value works and wraps around
+        void Lookup(uint32_t angle, float& s, float& c) const {
+            uint32_t quadrant = (angle >> (Bits - 2)) & 3;
+            uint32_t i = angle & (QuarterSteps - 1);
+            float a = quarter[i], b = quarter[QuarterSteps - i];
+            // Each quarter turn: (s, c) -> (c, -s)
+            s = (quadrant & 1) ? b : a;
+            c = (quadrant & 1) ? a : b;
+            if (quadrant & 2) {
+                s = -s;
+            }
+            if ((quadrant + 1) & 2) {
+                c = -c;
+            }
+        }
+
+        // Any finite angle in radians, reduced to [-pi, pi] first. Takes the nearest step
+        // and turns it by the remainder d, |d| <= pi / 4096, using sin d ~ d and
+        // cos d ~ 1 - d^2 / 2 (error below 1e-10). Within 2e-7 of libm. Infinity and NaN
+        // give NaN, as std::sin does.
+        void LookupInterpolated(float radians, float& s, float& c) const {
+            double reduced = std::remainder(double(radians), TwoPi);
+            if (std::isnan(reduced)) {
+                s = c = float(reduced);
+                return;
+            }
+            double step = std::floor(reduced * (Steps / TwoPi) + 0.5);
+            float d = float(reduced - step * (TwoPi / Steps));
+            float sa, ca;
+            Lookup(uint32_t(int64_t(step)), sa, ca);
+            float cd = 1.0f - 0.5f * d * d;
+            s = sa * cd + ca * d;
+            c = ca * cd - sa * d;
+        }
+
+        // Nearest step to a finite angle in radians, in [0, Steps); 0 for infinity and NaN
+        static uint32_t Quantise(float radians) {
+            double reduced = std::remainder(double(radians), TwoPi);
+            if (std::isnan(reduced)) {
+                return 0;
+            }
+            return uint32_t(int64_t(std::floor(reduced * (Steps / TwoPi) + 0.5))) & (Steps - 1);
+        }
+
+    private:
+        SinCosTable() {
+            for (uint32_t i = 0; i <= QuarterSteps; ++i) {
+                quarter[i] = float(std::sin(i * (TwoPi / Steps)));
+            }
+        }
+
+        float quarter[QuarterSteps + 1];
+    };
+}
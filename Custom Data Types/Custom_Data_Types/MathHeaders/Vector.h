@@ -0,0 +1,121 @@
+#pragma once
+#include <cmath>
+#include <string>
+#include <type_traits>
+
+namespace MathClasses {
+
+    namespace Detail {
+        // Element comparison for operator==: within 0.0001 for floating point types,
+        // exact for integer ones
+        template<typename T>
+        bool NearlyEqual(T a, T b) {
+            if constexpr (std::is_integral_v<T>) {
+                return a == b;
+            }
+            else {
+                return std::fabs(a - b) < T(0.0001);
+            }
+        }
+    }
+
+    // A vector of N values of type T: float, double, or an integer type for grid maths.
+    // Vector3.h and Vector4.h specialise sizes 3 and 4 with named x, y, z (and w) members;
+    // Vector3 and Vector4 are the float versions and Vector3d and Vector4d the double
+    // ones. This general version keeps its values in an array, for the other sizes.
+    template<typename T, int N>
+    struct Vector {
+        static_assert(N > 0, "A vector needs at least one value");
+
+        T v[N];
+
+        Vector() : v() {}
+
+        // Converts from a vector of another value type
+        template<typename U>
+        explicit Vector(const Vector<U, N>& other) {
+            for (int i = 0; i < N; ++i) {
+                v[i] = T(other[i]);
+            }
+        }
+
+        T& operator[](int i) { return v[i]; }
+        const T& operator[](int i) const { return v[i]; }
+
+        Vector operator+(const Vector& other) const {
+            Vector result;
+            for (int i = 0; i < N; ++i) {
+                result.v[i] = v[i] + other.v[i];
+            }
+            return result;
+        }
+
+        Vector operator-(const Vector& other) const {
+            Vector result;
+            for (int i = 0; i < N; ++i) {
+                result.v[i] = v[i] - other.v[i];
+            }
+            return result;
+        }
+
+        Vector operator*(T scalar) const {
+            Vector result;
+            for (int i = 0; i < N; ++i) {
+                result.v[i] = v[i] * scalar;
+            }
+            return result;
+        }
+
+        friend Vector operator*(T scalar, const Vector& vec) {
+            return vec * scalar;
+        }
+
+        T Dot(const Vector& other) const {
+            T sum = T(0);
+            for (int i = 0; i < N; ++i) {
+                sum += v[i] * other.v[i];
+            }
+            return sum;
+        }
+
+        T Magnitude() const {
+            return std::sqrt(Dot(*this));
+        }
+
+        void Normalise() {
+            T mag = Magnitude();
+            if (mag > 0) {
+                for (int i = 0; i < N; ++i) {
+                    v[i] /= mag;
+                }
+            }
+        }
+
+        Vector Normalised() const {
+            Vector copy = *this;
+            copy.Normalise();
+            return copy;
+        }
+
+        bool operator==(const Vector& other) const {
+            for (int i = 0; i < N; ++i) {
+                if (!Detail::NearlyEqual(v[i], other.v[i])) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        bool operator!=(const Vector& other) const {
+            return !(*this == other);
+        }
+
+        std::string ToString() const {
+            std::string result = std::to_string(v[0]);
+            for (int i = 1; i < N; ++i) {
+                result += ", " + std::to_string(v[i]);
+            }
+            return result;
+        }
+    };
+}
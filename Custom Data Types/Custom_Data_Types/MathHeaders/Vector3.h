@@ -1,46 +1,64 @@
 #pragma once
+#include "Vector.h"
+#include "FastMath.h"
 #include <cmath>
+#include <limits>
 #include <string>
 
 namespace MathClasses
 {
-    struct Vector3
+    // Three component vector; Vector3 is the float version (see Vector.h)
+    template<typename T>
+    struct Vector<T, 3>
     {
-        float x, y, z;
+        T x, y, z;
 
-        Vector3() : x(0), y(0), z(0) {};
-        ~Vector3() {};
+        Vector() : x(0), y(0), z(0) {};
 
-        Vector3(float x1, float y1, float z1) : x(x1), y(y1), z(z1) {};
+        Vector(T x1, T y1, T z1) : x(x1), y(y1), z(z1) {};
+
+        // Converts from a vector of another value type, e.g. a Vector3d to a Vector3
+        template<typename U>
+        explicit Vector(const Vector<U, 3>& other) : x(T(other.x)), y(T(other.y)), z(T(other.z)) {}
+
+        T& operator[](int i) { return this->*Component(i); }
+        const T& operator[](int i) const { return this->*Component(i); }
+
+        // Member for each index; x, y and z are separate members, so indexing goes
+        // through member pointers rather than pointer arithmetic off &x
+        static T Vector::* Component(int i) {
+            static constexpr T Vector::* components[] = { &Vector::x, &Vector::y, &Vector::z };
+            return components[i];
+        }
 
         // Addition of two vectors
-        Vector3 operator+(const Vector3& other) const {
-            return Vector3(x + other.x, y + other.y, z + other.z);
+        Vector operator+(const Vector& other) const {
+            return Vector(x + other.x, y + other.y, z + other.z);
         }
 
-        // Multiplication of a float and a Vector
-        friend Vector3 operator*(float scalar, const Vector3& vec) {
-            return Vector3(scalar * vec.x, scalar * vec.y, scalar * vec.z);
+        // Multiplication of a scalar and a Vector
+        friend Vector operator*(T scalar, const Vector& vec) {
+            return Vector(scalar * vec.x, scalar * vec.y, scalar * vec.z);
         }
 
         // Subtraction of two vectors
-        Vector3 operator-(const Vector3& other) const {
-            return Vector3(x - other.x, y - other.y, z - other.z);
+        Vector operator-(const Vector& other) const {
+            return Vector(x - other.x, y - other.y, z - other.z);
         }
 
         // Scalar multiplication
-        Vector3 operator*(float scalar) const {
-            return Vector3(x * scalar, y * scalar, z * scalar);
+        Vector operator*(T scalar) const {
+            return Vector(x * scalar, y * scalar, z * scalar);
         }
 
         // Dot product of two vectors
-        float Dot(const Vector3& other) const {
+        T Dot(const Vector& other) const {
             return x * other.x + y * other.y + z * other.z;
         }
 
         // Cross product of two vectors
-        Vector3 Cross(const Vector3& other) const {
-            return Vector3(
+        Vector Cross(const Vector& other) const {
+            return Vector(
                 y * other.z - z * other.y,
                 z * other.x - x * other.z,
                 x * other.y - y * other.x
@@ -48,13 +66,13 @@ namespace MathClasses
         }
 
         // Magnitude of the vector
-        float Magnitude() const {
+        T Magnitude() const {
             return std::sqrt(x * x + y * y + z * z);
         }
 
         // Normalize the vector
         void Normalise() {
-            float mag = Magnitude();
+            T mag = Magnitude();
             if (mag > 0) {
                 x /= mag;
                 y /= mag;
@@ -63,23 +81,49 @@ namespace MathClasses
         }
 
         // Returns a normalised copy of the Vector
-        Vector3 Normalised() const
+        Vector Normalised() const
         {
-            Vector3 copy = *this;
+            Vector copy = *this;
             copy.Normalise();
 
             return copy;
         }
 
-        bool operator==(const Vector3& other) const {
-            const float EPSILON = 0.0001f;
-            return (std::fabs(x - other.x) < EPSILON) &&
-                (std::fabs(y - other.y) < EPSILON) &&
-                (std::fabs(z - other.z) < EPSILON);
+        // Normalise at a chosen precision (see FastMath.h). Exact is the same as Normalise().
+        void Normalise(Precision::ExactPolicy) {
+            Normalise();
+        }
+
+        template<typename Precision>
+        void Normalise(Precision precision) {
+            T lengthSq = x * x + y * y + z * z;
+            if (lengthSq >= std::numeric_limits<T>::min()) {
+                T r = InvSqrt(precision, lengthSq);
+                x *= r;
+                y *= r;
+                z *= r;
+            }
+            else if (lengthSq > 0) {
+                // The estimate doesn't handle denormals
+                Normalise();
+            }
+        }
+
+        template<typename Precision>
+        Vector Normalised(Precision precision) const {
+            Vector copy = *this;
+            copy.Normalise(precision);
+            return copy;
+        }
+
+        bool operator==(const Vector& other) const {
+            return Detail::NearlyEqual(x, other.x) &&
+                Detail::NearlyEqual(y, other.y) &&
+                Detail::NearlyEqual(z, other.z);
         }
 
         // Inequality operator
-        bool operator!=(const Vector3& other) const {
+        bool operator!=(const Vector& other) const {
             return !(*this == other);
         }
 
@@ -89,4 +133,7 @@ namespace MathClasses
         }
 
     };
+
+    using Vector3 = Vector<float, 3>;
+    using Vector3d = Vector<double, 3>;
 }
\ No newline at end of file
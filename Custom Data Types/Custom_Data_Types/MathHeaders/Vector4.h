@@ -1,39 +1,57 @@
 #pragma once
+#include "Vector.h"
+#include "FastMath.h"
 #include <string>
+#include <limits>
 #include <cmath>
 
 namespace MathClasses {
-    struct Vector4
+    // Four component vector; Vector4 is the float version (see Vector.h)
+    template<typename T>
+    struct Vector<T, 4>
     {
-        float x, y, z, w;
+        T x, y, z, w;
 
         // Default constructor
-        Vector4() : x(0), y(0), z(0), w(0) {}
+        Vector() : x(0), y(0), z(0), w(0) {}
 
         // Constructor with components
-        Vector4(float x, float y, float z, float w) : x(x), y(y), z(z), w(w) {}
+        Vector(T x, T y, T z, T w) : x(x), y(y), z(z), w(w) {}
+
+        // Converts from a vector of another value type, e.g. a Vector4d to a Vector4
+        template<typename U>
+        explicit Vector(const Vector<U, 4>& other) : x(T(other.x)), y(T(other.y)), z(T(other.z)), w(T(other.w)) {}
+
+        T& operator[](int i) { return this->*Component(i); }
+        const T& operator[](int i) const { return this->*Component(i); }
+
+        // Member for each index (see Vector3.h)
+        static T Vector::* Component(int i) {
+            static constexpr T Vector::* components[] = { &Vector::x, &Vector::y, &Vector::z, &Vector::w };
+            return components[i];
+        }
 
         // Addition of two vectors
-        Vector4 operator+(const Vector4& other) const {
-            return Vector4(x + other.x, y + other.y, z + other.z, w + other.w);
+        Vector operator+(const Vector& other) const {
+            return Vector(x + other.x, y + other.y, z + other.z, w + other.w);
         }
 
         // Subtraction of two vectors
-        Vector4 operator-(const Vector4& other) const {
-            return Vector4(x - other.x, y - other.y, z - other.z, w - other.w);
+        Vector operator-(const Vector& other) const {
+            return Vector(x - other.x, y - other.y, z - other.z, w - other.w);
         }
 
         // Scalar multiplication
-        Vector4 operator*(float scalar) const {
-            return Vector4(x * scalar, y * scalar, z * scalar, w * scalar);
+        Vector operator*(T scalar) const {
+            return Vector(x * scalar, y * scalar, z * scalar, w * scalar);
         }
 
-        friend Vector4 operator*(float scalar, const Vector4& vec) {
-            return Vector4(scalar * vec.x, scalar * vec.y, scalar * vec.z, scalar * vec.w);
+        friend Vector operator*(T scalar, const Vector& vec) {
+            return Vector(scalar * vec.x, scalar * vec.y, scalar * vec.z, scalar * vec.w);
         }
 
         // Dot product of two vectors
-        float Dot(const Vector4& other) const {
+        T Dot(const Vector& other) const {
             return x * other.x + y * other.y + z * other.z + w * other.w;
         }
 
@@ -42,23 +60,23 @@ namespace MathClasses {
         // Cross product of two vectors
         // Note: Cross product is typically not defined for 4D vectors in the same way as for 3D.
         // Implementing as if ignoring the fourth component (w), treating them as 3D vectors.
-        Vector4 Cross(const Vector4& other) const {
-            return Vector4(
+        Vector Cross(const Vector& other) const {
+            return Vector(
                 y * other.z - z * other.y,
                 z * other.x - x * other.z,
                 x * other.y - y * other.x,
-                0.0f  // Typically, the w component for a cross product result might be set to 0 or 1 depending on context
+                0  // Typically, the w component for a cross product result might be set to 0 or 1 depending on context
             );
         }
 
         // Magnitude of the vector
-        float Magnitude() const {
+        T Magnitude() const {
             return std::sqrt(x * x + y * y + z * z + w * w);
         }
 
         // Normalize the vector
         void Normalise() {
-            float mag = Magnitude();
+            T mag = Magnitude();
             if (mag > 0) {
                 x /= mag;
                 y /= mag;
@@ -68,24 +86,51 @@ namespace MathClasses {
         }
 
         // Returns a normalised copy of the Vector
-        Vector4 Normalised() const
+        Vector Normalised() const
         {
-            Vector4 copy = *this;
+            Vector copy = *this;
             copy.Normalise();
 
             return copy;
         }
 
-        bool operator==(const Vector4& other) const {
-            const float EPSILON = 0.0001f;
-            return (std::fabs(x - other.x) < EPSILON) &&
-                (std::fabs(y - other.y) < EPSILON) &&
-                (std::fabs(z - other.z) < EPSILON) &&
-                (std::fabs(w - other.w) < EPSILON);
+        // Normalise at a chosen precision (see FastMath.h). Exact is the same as Normalise().
+        void Normalise(Precision::ExactPolicy) {
+            Normalise();
+        }
+
+        template<typename Precision>
+        void Normalise(Precision precision) {
+            T lengthSq = x * x + y * y + z * z + w * w;
+            if (lengthSq >= std::numeric_limits<T>::min()) {
+                T r = InvSqrt(precision, lengthSq);
+                x *= r;
+                y *= r;
+                z *= r;
+                w *= r;
+            }
+            else if (lengthSq > 0) {
+                // The estimate doesn't handle denormals
+                Normalise();
+            }
+        }
+
+        template<typename Precision>
+        Vector Normalised(Precision precision) const {
+            Vector copy = *this;
+            copy.Normalise(precision);
+            return copy;
+        }
+
+        bool operator==(const Vector& other) const {
+            return Detail::NearlyEqual(x, other.x) &&
+                Detail::NearlyEqual(y, other.y) &&
+                Detail::NearlyEqual(z, other.z) &&
+                Detail::NearlyEqual(w, other.w);
         }
 
         // Inequality operator
-        bool operator!=(const Vector4& other) const {
+        bool operator!=(const Vector& other) const {
             return !(*this == other);
         }
 
@@ -95,4 +140,7 @@ namespace MathClasses {
         }
 
     };
+
+    using Vector4 = Vector<float, 4>;
+    using Vector4d = Vector<double, 4>;
 }
\ No newline at end of file
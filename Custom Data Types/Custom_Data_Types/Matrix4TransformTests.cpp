@@ -8,6 +8,8 @@
 using namespace Microsoft::VisualStudio::CppUnitTestFramework;
 using ::MathClasses::Matrix4;
 using ::MathClasses::Vector3;
+using ::MathClasses::Vector4;
+using ::MathClasses::Pi;
 
 namespace MathLibraryTests
 {
@@ -117,5 +119,79 @@ namespace MathLibraryTests
 					0, 0, 4.0f, 0,
 					0, 0, 0, 1), actual);
 		}
+
+		// NDC position of a point under a projection
+		static Vector3 Project(const Matrix4& m, const Vector3& p)
+		{
+			Vector4 clip = m * Vector4(p.x, p.y, p.z, 1.0f);
+			return Vector3(clip.x / clip.w, clip.y / clip.w, clip.z / clip.w);
+		}
+
+		// near and far map to -1 and 1, the edges of the view to +-1
+		TEST_METHOD(MakePerspective)
+		{
+			Matrix4 actual = Matrix4::MakePerspective(Pi / 2, 2.0f, 1.0f, 10.0f);
+
+			Assert::AreEqual(Vector3(0, 0, -1), Project(actual, Vector3(0, 0, -1)));
+			Assert::AreEqual(Vector3(0, 0, 1), Project(actual, Vector3(0, 0, -10)));
+			Assert::AreEqual(Vector3(1, 1, Project(actual, Vector3(0, 0, -4)).z), Project(actual, Vector3(8, 4, -4)));
+		}
+
+		TEST_METHOD(MakePerspectiveInfinite)
+		{
+			Matrix4 actual = Matrix4::MakePerspectiveInfinite(Pi / 2, 1.0f, 0.5f);
+
+			Assert::AreEqual(-1.0f, Project(actual, Vector3(0, 0, -0.5f)).z, 0.0001f);
+			Assert::AreEqual(1.0f, Project(actual, Vector3(0, 0, -1e6f)).z, 0.0001f);
+			Assert::AreEqual(Project(Matrix4::MakePerspective(Pi / 2, 1.0f, 0.5f, 100.0f), Vector3(3, 2, -7)).x,
+				Project(actual, Vector3(3, 2, -7)).x, 0.0001f);
+		}
+
+		TEST_METHOD(MakePerspectiveReversedZ)
+		{
+			Matrix4 actual = Matrix4::MakePerspectiveReversedZ(Pi / 3, 1.5f, 0.1f, 1000.0f);
+			Assert::AreEqual(1.0f, Project(actual, Vector3(0, 0, -0.1f)).z, 0.0001f);
+			Assert::AreEqual(0.0f, Project(actual, Vector3(0, 0, -1000.0f)).z, 0.0001f);
+
+			Matrix4 infinite = Matrix4::MakePerspectiveReversedZInfinite(Pi / 3, 1.5f, 0.1f);
+			Assert::AreEqual(1.0f, Project(infinite, Vector3(0, 0, -0.1f)).z, 0.0001f);
+			Assert::AreEqual(0.001f, Project(infinite, Vector3(0, 0, -100.0f)).z, 0.00001f);
+
+			// x and y match the standard projection
+			Vector3 expected = Project(Matrix4::MakePerspective(Pi / 3, 1.5f, 0.1f, 1000.0f), Vector3(1, 2, -5));
+			Vector3 reversed = Project(actual, Vector3(1, 2, -5));
+			Assert::AreEqual(expected.x, reversed.x, 0.0001f);
+			Assert::AreEqual(expected.y, reversed.y, 0.0001f);
+		}
+
+		TEST_METHOD(MakeOrthographic)
+		{
+			Matrix4 actual = Matrix4::MakeOrthographic(-2.0f, 6.0f, -1.0f, 3.0f, 1.0f, 11.0f);
+
+			Assert::AreEqual(Vector3(-1, -1, -1), Project(actual, Vector3(-2, -1, -1)));
+			Assert::AreEqual(Vector3(1, 1, 1), Project(actual, Vector3(6, 3, -11)));
+			Assert::AreEqual(Vector3(0, 0, 0), Project(actual, Vector3(2, 1, -6)));
+		}
+
+		TEST_METHOD(MakeLookAt)
+		{
+			// looking down -z from +z is just a translation
+			Assert::AreEqual(Matrix4::MakeTranslation(0.0f, 0.0f, -5.0f),
+				Matrix4::MakeLookAt(Vector3(0, 0, 5), Vector3(0, 0, 0), Vector3(0, 1, 0)));
+
+			// the eye goes to the origin and the target onto -z
+			Vector3 eye(3, 4, -2), target(-1, 0, 6);
+			Matrix4 view = Matrix4::MakeLookAt(eye, target, Vector3(0, 1, 0));
+			Vector4 e = view * Vector4(eye.x, eye.y, eye.z, 1);
+			Vector4 t = view * Vector4(target.x, target.y, target.z, 1);
+			Assert::AreEqual(Vector4(0, 0, 0, 1), e);
+			Assert::AreEqual(Vector4(0, 0, -(target - eye).Magnitude(), 1), t);
+
+			// and undoes the camera's own transform
+			Matrix4 camera = Matrix4::MakeTranslation(eye) * Matrix4::MakeRotateY(0.7f);
+			Vector4 forward = camera * Vector4(0, 0, -1, 0);
+			Matrix4 lookAt = Matrix4::MakeLookAt(eye, eye + Vector3(forward.x, forward.y, forward.z), Vector3(0, 1, 0));
+			Assert::AreEqual(Matrix4::MakeIdentity(), lookAt * camera);
+		}
 	};
 }
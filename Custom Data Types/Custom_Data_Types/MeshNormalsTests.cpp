@@ -0,0 +1,100 @@
+#include "CppUnitTest.h"
+#include "TestToString.h"
+
+#include "Utils.h"
+#include "MathHeaders/MeshNormals.h"
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace MathClasses;
+
+namespace MathLibraryTests
+{
+	TEST_CLASS(MeshNormalsTests)
+	{
+	public:
+		// a flat quad gets the plane normal everywhere
+		TEST_METHOD(FlatQuad)
+		{
+			Vector3 positions[4] = { Vector3(0, 0, 0), Vector3(1, 0, 0), Vector3(1, 1, 0), Vector3(0, 1, 0) };
+			uint32_t indices[6] = { 0, 1, 2, 0, 2, 3 };
+			Vector3 normals[4];
+
+			ComputeVertexNormals(positions, 4, indices, 6, normals);
+
+			for (const Vector3& n : normals)
+				Assert::AreEqual(Vector3(0, 0, 1), n);
+		}
+
+		// the corner of a cube made of uneven triangles points along the diagonal
+		// with angle weighting, but not with area weighting
+		TEST_METHOD(AngleWeighting)
+		{
+			// three faces meeting at the origin, the z face split into two triangles
+			Vector3 positions[6] = {
+				Vector3(0, 0, 0), Vector3(1, 0, 0), Vector3(0, 1, 0),
+				Vector3(0, 0, 1), Vector3(1, 1, 0), Vector3(0, 0, 0)
+			};
+			uint32_t indices[12] = {
+				0, 2, 1,	// z = 0 face, first half (normal -z)
+				2, 4, 1,	// z = 0 face, second half (doesn't touch the origin)
+				0, 1, 3,	// y = 0 face (normal -y)
+				0, 3, 2		// x = 0 face (normal -x)
+			};
+			Vector3 normals[6];
+
+			ComputeVertexNormals(positions, 6, indices, 12, normals, NormalWeighting::Angle);
+			float d = -1.0f / std::sqrt(3.0f);
+			Assert::AreEqual(Vector3(d, d, d), normals[0]);
+
+			// vertex 5 is unused
+			Assert::AreEqual(Vector3(0, 0, 0), normals[5]);
+		}
+
+		// parallel results match serial results, to a rounding if the compiler contracts to FMA
+		TEST_METHOD(ParallelMatchesSerial)
+		{
+			const uint32_t size = 128;
+			std::vector<Vector3> positions;
+			for (uint32_t y = 0; y < size; ++y)
+				for (uint32_t x = 0; x < size; ++x)
+					positions.push_back(Vector3(float(x), std::sin(x * 0.3f) * std::cos(y * 0.2f) * 4.0f, float(y)));
+
+			std::vector<uint32_t> indices;
+			for (uint32_t y = 0; y + 1 < size; ++y) {
+				for (uint32_t x = 0; x + 1 < size; ++x) {
+					uint32_t i = y * size + x;
+					indices.insert(indices.end(), { i, i + size, i + 1, i + 1, i + size, i + size + 1 });
+				}
+			}
+
+			VertexNormalBuilder builder(indices.data(), indices.size(), positions.size());
+			std::vector<Vector3> serial(positions.size()), parallel(positions.size());
+			builder.Compute(positions.data(), serial.data(), NormalWeighting::Angle);
+			builder.Compute(Execution::Par, positions.data(), parallel.data(), NormalWeighting::Angle);
+
+			for (size_t i = 0; i < positions.size(); ++i) {
+				for (int k = 0; k < 3; ++k)
+					Assert::IsTrue(NearlyEqualAtScale(serial[i][k], parallel[i][k], 1.0f));
+				Assert::AreEqual(1.0f, serial[i].Magnitude(), 0.0001f);
+				Assert::IsTrue(serial[i].y > 0.0f);
+			}
+		}
+
+		// batch normalise agrees with Vector3::Normalised
+		TEST_METHOD(NormaliseVectorsMatchesNormalised)
+		{
+			std::vector<Vector3> v = { Vector3(13.5f, -48.23f, 862), Vector3(0, 0, 0), Vector3(3, 4, 0),
+				Vector3(-1, -1, -1), Vector3(0.001f, 0, 0), Vector3(5, 5, 5) };
+			std::vector<Vector3> out(v.size());
+
+			NormaliseVectors(v.data(), out.data(), v.size());
+
+			for (size_t i = 0; i < v.size(); ++i)
+				Assert::AreEqual(v[i].Normalised(), out[i]);
+		}
+	};
+}
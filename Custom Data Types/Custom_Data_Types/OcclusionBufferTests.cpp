@@ -0,0 +1,116 @@
+#include "CppUnitTest.h"
+#include "TestToString.h"
+
+#include "Utils.h"
+#include "MathHeaders/OcclusionBuffer.h"
+
+#include <random>
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace MathClasses;
+
+namespace MathLibraryTests
+{
+	// A wall covering the left half of the view, five units in front of the camera
+	struct OcclusionFixture
+	{
+		std::vector<Vector3> positions = { Vector3(-10, -10, -5), Vector3(0, -10, -5), Vector3(0, 10, -5), Vector3(-10, 10, -5) };
+		std::vector<uint32_t> indices = { 0, 1, 2, 0, 2, 3 };
+		Matrix4 viewProjection = Matrix4::MakePerspective(Pi / 2, 1.0f, 0.1f, 100.0f);
+		OcclusionBuffer buffer;
+
+		OcclusionFixture() : buffer(64, 48)
+		{
+			DrawCall wall;
+			wall.transform = viewProjection;
+			wall.positions = positions.data();
+			wall.vertexCount = positions.size();
+			wall.indices = indices.data();
+			wall.triangleCount = 2;
+			buffer.Clear();
+			buffer.RenderOccluders(&wall, 1);
+			buffer.BuildHierarchy();
+		}
+	};
+
+	static AABB Cube(float x, float y, float z, float halfSize)
+	{
+		return AABB::FromCentreExtents(Vector3(x, y, z), Vector3(halfSize, halfSize, halfSize));
+	}
+
+	TEST_CLASS(OcclusionBufferTests)
+	{
+	public:
+		TEST_METHOD(EmptyBuffer)
+		{
+			OcclusionBuffer buffer(32, 32);
+			buffer.Clear();
+			buffer.BuildHierarchy();
+			Matrix4 viewProjection = Matrix4::MakePerspective(Pi / 2, 1.0f, 0.1f, 100.0f);
+
+			Assert::IsTrue(buffer.IsVisible(viewProjection, Cube(0, 0, -10, 1)));
+			// behind the camera, and off to the side
+			Assert::IsFalse(buffer.IsVisible(viewProjection, Cube(0, 0, 10, 1)));
+			Assert::IsFalse(buffer.IsVisible(viewProjection, Cube(50, 0, -10, 1)));
+			// crossing the near plane
+			Assert::IsTrue(buffer.IsVisible(viewProjection, Cube(0, 0, 0, 1)));
+		}
+
+		TEST_METHOD(Hierarchy)
+		{
+			OcclusionFixture f;
+			int top = f.buffer.GetLevelCount() - 1;
+			Assert::AreEqual(7, f.buffer.GetLevelCount());
+			Assert::AreEqual(1.0f, f.buffer.GetMaxDepth(top, 0, 0));
+			Assert::IsTrue(f.buffer.GetMinDepth(top, 0, 0) < 1.0f);
+
+			// the left half is all wall, the right half empty
+			float wall = f.buffer.GetMaxDepth(0, 0, 0);
+			Assert::AreEqual(wall, f.buffer.GetMinDepth(2, 1, 3), 0.0001f);
+			Assert::AreEqual(wall, f.buffer.GetMaxDepth(2, 1, 3), 0.0001f);
+			Assert::AreEqual(1.0f, f.buffer.GetMinDepth(2, 12, 3));
+		}
+
+		TEST_METHOD(WallHidesBoxes)
+		{
+			OcclusionFixture f;
+			// behind the wall, small and large
+			Assert::IsFalse(f.buffer.IsVisible(f.viewProjection, Cube(-4, 0, -20, 1)));
+			Assert::IsFalse(f.buffer.IsVisible(f.viewProjection, Cube(-15, 2, -40, 10)));
+			// in front of the wall
+			Assert::IsTrue(f.buffer.IsVisible(f.viewProjection, Cube(-2, 0, -3, 0.5f)));
+			// behind the wall but sticking out past its edge
+			Assert::IsTrue(f.buffer.IsVisible(f.viewProjection, Cube(0, 0, -20, 2)));
+			// on the open side
+			Assert::IsTrue(f.buffer.IsVisible(f.viewProjection, Cube(5, 0, -20, 1)));
+		}
+
+		TEST_METHOD(BatchMatchesSingle)
+		{
+			OcclusionFixture f;
+			std::mt19937 rng(4);
+			std::uniform_real_distribution<float> across(-30.0f, 30.0f), depth(-60.0f, -1.0f), size(0.2f, 3.0f);
+			std::vector<AABB> boxes;
+			for (int i = 0; i < 2000; ++i)
+				boxes.push_back(Cube(across(rng), across(rng) * 0.5f, depth(rng), size(rng)));
+
+			std::vector<uint8_t> serial(boxes.size()), parallel(boxes.size());
+			f.buffer.TestBoxes(f.viewProjection, boxes.data(), boxes.size(), serial.data());
+			f.buffer.TestBoxes(Execution::Par, f.viewProjection, boxes.data(), boxes.size(), parallel.data());
+
+			int hidden = 0;
+			for (size_t i = 0; i < boxes.size(); ++i) {
+				Assert::AreEqual(f.buffer.IsVisible(f.viewProjection, boxes[i]), serial[i] != 0);
+				Assert::AreEqual(serial[i], parallel[i]);
+				// nothing wholly inside the open side of the view is ever hidden
+				const AABB& box = boxes[i];
+				float edge = -box.max.z;
+				if (box.min.x > 0.0f && box.max.x < edge && box.min.y > -edge && box.max.y < edge)
+					Assert::IsTrue(serial[i] != 0);
+				hidden += serial[i] == 0;
+			}
+			Assert::IsTrue(hidden > 0);
+		}
+	};
+}
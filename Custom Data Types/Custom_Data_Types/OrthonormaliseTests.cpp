@@ -0,0 +1,157 @@
+#include "CppUnitTest.h"
+#include "TestToString.h"
+
+#include "Utils.h"
+#include "MathHeaders/Orthonormalise.h"
+
+#include <random>
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace MathClasses;
+
+namespace MathLibraryTests
+{
+	static void AssertClose(const Matrix3& expected, const Matrix3& actual, float tolerance)
+	{
+		const float* e = &expected.m1;
+		const float* a = &actual.m1;
+		for (int k = 0; k < 9; ++k)
+			Assert::AreEqual(e[k], a[k], tolerance);
+	}
+
+	// a rotation that has been through many products
+	static Matrix3 Drifted(float amount, unsigned int seed)
+	{
+		std::mt19937 rng(seed);
+		std::uniform_real_distribution<float> noise(-amount, amount);
+		Matrix3 m = Matrix3::MakeEuler(0.3f, -1.2f, 2.0f);
+		float* p = &m.m1;
+		for (int k = 0; k < 9; ++k)
+			p[k] += noise(rng);
+		return m;
+	}
+
+	TEST_CLASS(OrthonormaliseTests)
+	{
+	public:
+		TEST_METHOD(AccumulatedRotation)
+		{
+			Matrix3 step = Matrix3::MakeEuler(0.001f, 0.002f, -0.0015f);
+			Matrix3 m = Matrix3::MakeIdentity();
+			Assert::AreEqual(0.0f, OrthonormalDrift(m));
+			for (int i = 0; i < 20000; ++i)
+				m = m * step;
+			Assert::IsTrue(OrthonormalDrift(m) > DefaultOrthonormalTolerance);
+
+			Matrix3 polar = m, gramSchmidt = m;
+			Orthonormalise(polar);
+			Orthonormalise(gramSchmidt, OrthonormaliseMethod::GramSchmidt);
+			Assert::IsTrue(OrthonormalDrift(polar) < 1e-6f);
+			Assert::IsTrue(OrthonormalDrift(gramSchmidt) < 1e-6f);
+			AssertClose(m, polar, 1e-3f);
+			AssertClose(m, gramSchmidt, 1e-3f);
+		}
+
+		// the polar factor of R * S, S symmetric positive definite, is R
+		TEST_METHOD(PolarRecoversRotation)
+		{
+			Matrix3 rotation = Matrix3::MakeEuler(0.7f, 0.1f, -0.4f);
+			Matrix3 stretch(1.01f, 0.004f, -0.002f, 0.004f, 0.995f, 0.003f, -0.002f, 0.003f, 1.006f);
+			Matrix3 m = rotation * stretch;
+			Orthonormalise(m, OrthonormaliseMethod::Polar);
+			AssertClose(rotation, m, 2e-6f);
+
+			Matrix3 gramSchmidt = rotation * stretch;
+			Orthonormalise(gramSchmidt, OrthonormaliseMethod::GramSchmidt);
+			Assert::IsTrue(OrthonormalDrift(gramSchmidt) < 1e-6f);
+
+			// far from orthonormal falls back to Gram-Schmidt rather than diverging
+			Matrix3 skewed(2, 0, 0, 1.5f, 0.5f, 0, 0, 0, 3);
+			Orthonormalise(skewed);
+			Assert::IsTrue(OrthonormalDrift(skewed) < 1e-6f);
+		}
+
+		TEST_METHOD(Matrix4KeepsTranslation)
+		{
+			Matrix4 m = Matrix4::MakeTranslation(3, -4, 5) * Matrix4::MakeEuler(0.2f, 0.9f, -0.3f);
+			m.m1 += 0.002f;
+			m.m6 -= 0.001f;
+			m.m9 += 0.0015f;
+			Assert::IsTrue(OrthonormalDrift(m) > DefaultOrthonormalTolerance);
+			Orthonormalise(m);
+			Assert::IsTrue(OrthonormalDrift(m) < 1e-6f);
+			Assert::AreEqual(3.0f, m.m13);
+			Assert::AreEqual(-4.0f, m.m14);
+			Assert::AreEqual(5.0f, m.m15);
+			Assert::AreEqual(1.0f, m.m16);
+		}
+
+		TEST_METHOD(Affine2D)
+		{
+			Matrix3 m = Matrix3::MakeTranslation(10.0f, 20.0f) * Matrix3::MakeRotation(1.1f);
+			Assert::IsTrue(OrthonormalDrift2D(m) < 1e-6f);
+			Matrix3 expected = m;
+			for (int i = 0; i < 5000; ++i)
+				m.RotateZ(0.01f);
+			for (int i = 0; i < 5000; ++i)
+				m.RotateZ(-0.01f);
+
+			// symmetric stretch of the 2x2 part, which the polar version removes exactly
+			m = m * Matrix3(1.002f, 0.001f, 0, 0.001f, 0.998f, 0, 0, 0, 1);
+			Assert::IsTrue(OrthonormalDrift2D(m) > DefaultOrthonormalTolerance);
+			Matrix3 gramSchmidt = m;
+			Orthonormalise2D(m);
+			Orthonormalise2D(gramSchmidt, OrthonormaliseMethod::GramSchmidt);
+			Assert::IsTrue(OrthonormalDrift2D(m) < 1e-6f);
+			Assert::IsTrue(OrthonormalDrift2D(gramSchmidt) < 1e-6f);
+			AssertClose(expected, m, 1e-4f);
+			Assert::AreEqual(10.0f, m.m7, 1e-4f);
+			Assert::AreEqual(20.0f, m.m8, 1e-4f);
+			Assert::AreEqual(1.0f, m.m9);
+		}
+
+		TEST_METHOD(BatchOnlyRepairsDrifted)
+		{
+			std::vector<Matrix3> matrices;
+			for (unsigned int i = 0; i < 3001; ++i)
+				matrices.push_back(i % 3 == 0 ? Drifted(1e-3f, i) : Matrix3::MakeEuler(i * 0.01f, 0.5f, -i * 0.02f));
+			std::vector<Matrix3> serial = matrices, parallel = matrices;
+			OrthonormaliseMatrices(serial.data(), serial.size());
+			OrthonormaliseMatrices(Execution::Par, parallel.data(), parallel.size());
+
+			for (size_t i = 0; i < matrices.size(); ++i) {
+				const float* before = &matrices[i].m1;
+				const float* s = &serial[i].m1;
+				const float* p = &parallel[i].m1;
+				bool drifted = OrthonormalDrift(matrices[i]) > DefaultOrthonormalTolerance;
+				Assert::AreEqual(i % 3 == 0, drifted);
+				for (int k = 0; k < 9; ++k) {
+					Assert::IsTrue(NearlyEqualAtScale(s[k], p[k], 1.0f));
+					if (!drifted)
+						Assert::AreEqual(before[k], s[k]);
+				}
+				Assert::IsTrue(OrthonormalDrift(serial[i]) <= DefaultOrthonormalTolerance);
+			}
+
+			// arena copies match the in place repair and leave the input alone
+			FrameArena arena(matrices.size() * sizeof(Matrix3) + 64);
+			Span<Matrix3> copies = OrthonormaliseMatrices(Execution::Par, arena, Span<const Matrix3>(matrices.data(), matrices.size()));
+			Assert::AreEqual(matrices.size(), copies.Size());
+			for (size_t i = 0; i < matrices.size(); ++i)
+				Assert::AreEqual(parallel[i], copies[i]);
+			Assert::IsTrue(OrthonormalDrift(matrices[0]) > DefaultOrthonormalTolerance);
+			Assert::IsTrue(OrthonormaliseMatrices(arena, Span<const Matrix3>(matrices.data(), matrices.size())).Empty());
+
+			std::vector<Matrix4> matrices4(100, Matrix4::MakeRotateY(0.5f));
+			matrices4[7].m2 += 0.01f;
+			OrthonormaliseMatrices(Execution::Par, matrices4.data(), matrices4.size(), 1e-6f, OrthonormaliseMethod::GramSchmidt);
+			Assert::IsTrue(OrthonormalDrift(matrices4[7]) < 1e-6f);
+
+			std::vector<Matrix3> matrices2D(100, Matrix3::MakeRotation(0.5f));
+			matrices2D[3].m1 += 0.01f;
+			OrthonormaliseMatrices2D(matrices2D.data(), matrices2D.size());
+			Assert::IsTrue(OrthonormalDrift2D(matrices2D[3]) < 1e-6f);
+		}
+	};
+}
@@ -0,0 +1,181 @@
+#include "CppUnitTest.h"
+#include "TestToString.h"
+
+#include "MathHeaders/Particles.h"
+
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace MathClasses;
+
+namespace MathLibraryTests
+{
+	TEST_CLASS(ParticlesTests)
+	{
+	public:
+		// semi-implicit Euler under gravity matches the same steps done with Vector3 operators
+		TEST_METHOD(EulerMatchesVector3)
+		{
+			ParticleSystem particles(13);
+			std::vector<Vector3> p, v;
+			for (int i = 0; i < 13; ++i) {
+				p.push_back(Vector3(float(i), 10.0f, -float(i)));
+				v.push_back(Vector3(1.0f, float(i) * 0.5f, 0.0f));
+				particles.Emit(p.back(), v.back(), 10.0f);
+			}
+
+			ParticleForces forces;
+			forces.gravity = Vector3(0, -9.8f, 0);
+			forces.drag = 0.1f;
+			float dt = 1.0f / 60.0f;
+			for (int step = 0; step < 30; ++step) {
+				particles.StepEuler(dt, forces);
+				for (size_t i = 0; i < p.size(); ++i) {
+					Vector3 a = forces.gravity - v[i] * forces.drag;
+					v[i] = v[i] + a * dt;
+					p[i] = p[i] + v[i] * dt;
+				}
+			}
+
+			for (size_t i = 0; i < p.size(); ++i) {
+				Assert::AreEqual(p[i], particles.GetPosition(i));
+				Assert::AreEqual(v[i], particles.GetVelocity(i));
+			}
+		}
+
+		// with no collisions Verlet and Euler take the same path
+		TEST_METHOD(VerletMatchesEuler)
+		{
+			ParticleSystem euler(5), verlet(5);
+			for (int i = 0; i < 5; ++i) {
+				euler.Emit(Vector3(0, float(i), 0), Vector3(2, 0, 1), 10.0f);
+				verlet.Emit(Vector3(0, float(i), 0), Vector3(2, 0, 1), 10.0f);
+			}
+			ParticleForces forces;
+			forces.gravity = Vector3(0, -9.8f, 0);
+			for (int step = 0; step < 10; ++step) {
+				euler.StepEuler(0.01f, forces);
+				verlet.StepVerlet(0.01f, forces);
+			}
+			for (size_t i = 0; i < 5; ++i) {
+				Assert::AreEqual(euler.GetPosition(i), verlet.GetPosition(i));
+				Assert::AreEqual(euler.GetVelocity(i), verlet.GetVelocity(i));
+			}
+		}
+
+		TEST_METHOD(AttractorPullsInverseSquare)
+		{
+			PointAttractor attractor;
+			attractor.position = Vector3(0, 0, 0);
+			attractor.strength = 8.0f;
+			ParticleForces forces;
+			forces.attractors = &attractor;
+			forces.attractorCount = 1;
+
+			ParticleSystem particles(2);
+			particles.Emit(Vector3(2, 0, 0), Vector3(), 1.0f);
+			particles.Emit(Vector3(0, 0, -4), Vector3(), 1.0f);
+			particles.StepEuler(0.5f, forces);
+
+			// a = 8 / d^2 towards the origin, v = a * dt
+			Assert::AreEqual(Vector3(-1.0f, 0, 0), particles.GetVelocity(0));
+			Assert::AreEqual(Vector3(0, 0, 0.25f), particles.GetVelocity(1));
+		}
+
+		TEST_METHOD(PlaneBounce)
+		{
+			CollisionPlane ground;
+			ground.normal = Vector3(0, 1, 0);
+			ParticleColliders colliders;
+			colliders.planes = &ground;
+			colliders.planeCount = 1;
+			colliders.restitution = 0.5f;
+			colliders.friction = 0.25f;
+
+			ParticleSystem particles(1);
+			particles.Emit(Vector3(0, 0.1f, 0), Vector3(4, -1, 0), 1.0f);
+			particles.StepEuler(0.5f, ParticleForces(), colliders);
+
+			Assert::AreEqual(Vector3(2, 0, 0), particles.GetPosition(0));
+			Assert::AreEqual(Vector3(3, 0.5f, 0), particles.GetVelocity(0));
+
+			// Verlet stops at the surface and keeps the sliding speed
+			ParticleSystem verlet(1);
+			verlet.Emit(Vector3(0, 0.1f, 0), Vector3(4, -1, 0), 1.0f);
+			verlet.StepVerlet(0.5f, ParticleForces(), colliders);
+			Assert::AreEqual(Vector3(2, 0, 0), verlet.GetPosition(0));
+			Assert::AreEqual(Vector3(4, -0.2f, 0), verlet.GetVelocity(0));
+		}
+
+		TEST_METHOD(SpherePushesOut)
+		{
+			CollisionSphere sphere;
+			sphere.centre = Vector3(1, 1, 1);
+			sphere.radius = 2.0f;
+			ParticleColliders colliders;
+			colliders.spheres = &sphere;
+			colliders.sphereCount = 1;
+			colliders.restitution = 0.0f;
+
+			ParticleSystem particles(2);
+			particles.Emit(Vector3(1, 1, 2), Vector3(0, 0, -1), 1.0f);
+			particles.Emit(Vector3(1, 1, 1), Vector3(), 1.0f);
+			particles.StepEuler(0.1f, ParticleForces(), colliders);
+
+			Assert::AreEqual(Vector3(1, 1, 3), particles.GetPosition(0));
+			Assert::AreEqual(Vector3(0, 0, 0), particles.GetVelocity(0));
+			Assert::AreEqual(Vector3(1, 3, 1), particles.GetPosition(1));
+		}
+
+		TEST_METHOD(CompactKeepsOrder)
+		{
+			ParticleSystem particles(10);
+			for (int i = 0; i < 10; ++i)
+				particles.Emit(Vector3(float(i), 0, 0), Vector3(), (i % 3 == 0) ? 0.5f : 2.0f);
+			Assert::IsFalse(particles.Emit(Vector3(), Vector3(), 1.0f));
+
+			particles.StepEuler(1.0f, ParticleForces());
+			Assert::IsFalse(particles.IsAlive(0));
+			Assert::AreEqual(size_t(4), particles.Compact());
+			Assert::AreEqual(size_t(6), particles.GetCount());
+
+			float expected[] = { 1, 2, 4, 5, 7, 8 };
+			for (size_t i = 0; i < 6; ++i)
+				Assert::AreEqual(expected[i], particles.GetPosition(i).x);
+
+			Assert::IsTrue(particles.Emit(Vector3(), Vector3(), 1.0f));
+		}
+
+		TEST_METHOD(ParallelMatchesSerial)
+		{
+			const int count = 20000;
+			ParticleSystem serial(count), parallel(count);
+			for (int i = 0; i < count; ++i) {
+				Vector3 p(float(i % 97), float(i % 13), float(i % 7));
+				Vector3 v(float(i % 5) - 2.0f, 1.0f, 0.5f);
+				serial.Emit(p, v, 5.0f);
+				parallel.Emit(p, v, 5.0f);
+			}
+			PointAttractor attractor;
+			attractor.strength = 3.0f;
+			ParticleForces forces;
+			forces.gravity = Vector3(0, -9.8f, 0);
+			forces.attractors = &attractor;
+			forces.attractorCount = 1;
+			CollisionPlane ground;
+			ground.normal = Vector3(0, 1, 0);
+			ParticleColliders colliders;
+			colliders.planes = &ground;
+			colliders.planeCount = 1;
+
+			for (int step = 0; step < 5; ++step) {
+				serial.StepEuler(0.02f, forces, colliders);
+				parallel.StepEuler(Execution::Par, 0.02f, forces, colliders);
+			}
+			const float* a = serial.GetStream(ParticleStream::PositionY);
+			const float* b = parallel.GetStream(ParticleStream::PositionY);
+			for (int i = 0; i < count; ++i)
+				Assert::AreEqual(a[i], b[i]);
+		}
+	};
+}
@@ -0,0 +1,78 @@
+#include "CppUnitTest.h"
+#include "TestToString.h"
+
+#include "Utils.h"
+#include "MathHeaders/Quaternion.h"
+#include "MathHeaders/DualQuaternion.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace MathClasses;
+
+namespace MathLibraryTests
+{
+	TEST_CLASS(QuaternionTests)
+	{
+	public:
+		TEST_METHOD(DefaultConstructorIsIdentity)
+		{
+			Quaternion q;
+			Assert::AreEqual(Matrix4::MakeIdentity(), q.ToMatrix4());
+		}
+
+		// axis-angle rotations match the matrix builders
+		TEST_METHOD(AxisAngleMatchesMatrices)
+		{
+			Assert::AreEqual(Matrix4::MakeRotateX(4.5f), Quaternion::MakeAxisAngle(Vector3(1, 0, 0), 4.5f).ToMatrix4());
+			Assert::AreEqual(Matrix4::MakeRotateY(-2.6f), Quaternion::MakeAxisAngle(Vector3(0, 1, 0), -2.6f).ToMatrix4());
+			Assert::AreEqual(Matrix4::MakeRotateZ(0.72f), Quaternion::MakeAxisAngle(Vector3(0, 0, 1), 0.72f).ToMatrix4());
+			Assert::AreEqual(Matrix3::MakeRotateX(1.1f), Quaternion::MakeAxisAngle(Vector3(1, 0, 0), 1.1f).ToMatrix3());
+		}
+
+		// matrix -> quaternion -> matrix round trips, including near 180 degrees
+		TEST_METHOD(FromMatrixRoundTrip)
+		{
+			Matrix4 rotations[] = {
+				Matrix4::MakeEuler(0.3f, -1.2f, 2.0f),
+				Matrix4::MakeRotateX(3.1f),
+				Matrix4::MakeRotateY(3.1f),
+				Matrix4::MakeRotateZ(-3.1f),
+				Matrix4::MakeIdentity()
+			};
+			for (const Matrix4& m : rotations)
+				Assert::AreEqual(m, Quaternion::FromMatrix(m).ToMatrix4());
+
+			Matrix3 m3 = Matrix3::MakeEuler(0.5f, 0.25f, -1.5f);
+			Assert::AreEqual(m3, Quaternion::FromMatrix(m3).ToMatrix3());
+		}
+
+		// product order matches matrix product order, and rotating a vector matches the matrix
+		TEST_METHOD(MultiplyAndRotate)
+		{
+			Quaternion a = Quaternion::MakeAxisAngle(Vector3(0, 0, 1), 0.8f);
+			Quaternion b = Quaternion::MakeAxisAngle(Vector3(1, 0, 0), -0.3f);
+			Matrix4 m = a.ToMatrix4() * b.ToMatrix4();
+
+			Assert::AreEqual(m, (a * b).ToMatrix4());
+
+			Vector3 v(1, 2, 3);
+			Vector4 expected = m * Vector4(v.x, v.y, v.z, 0);
+			Assert::AreEqual(Vector3(expected.x, expected.y, expected.z), (a * b) * v);
+		}
+
+		TEST_METHOD(DualQuaternionRigidTransform)
+		{
+			Matrix4 m = Matrix4::MakeTranslation(1.0f, -2.0f, 5.0f) * Matrix4::MakeEuler(0.2f, 0.9f, -0.4f);
+			DualQuaternion dq = DualQuaternion::FromMatrix(m);
+
+			Assert::AreEqual(m, dq.ToMatrix4());
+			Assert::AreEqual(Vector3(1.0f, -2.0f, 5.0f), dq.GetTranslation());
+
+			Vector3 p(3, -1, 2);
+			Vector4 expected = m * Vector4(p.x, p.y, p.z, 1);
+			Assert::AreEqual(Vector3(expected.x, expected.y, expected.z), dq.TransformPoint(p));
+
+			Matrix4 n = Matrix4::MakeTranslation(0.0f, 3.0f, 0.0f) * Matrix4::MakeRotateY(1.0f);
+			Assert::AreEqual(n * m, (DualQuaternion::FromMatrix(n) * dq).ToMatrix4());
+		}
+	};
+}
@@ -0,0 +1,135 @@
+#include "CppUnitTest.h"
+#include "TestToString.h"
+
+#include "MathHeaders/RadixSort.h"
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace MathClasses;
+
+namespace MathLibraryTests
+{
+	// std::stable_sort of the indices by key, as the reference permutation
+	template<typename Key>
+	static std::vector<uint32_t> StableOrder(const std::vector<Key>& keys, Key mask)
+	{
+		std::vector<uint32_t> order(keys.size());
+		for (size_t i = 0; i < order.size(); ++i)
+			order[i] = uint32_t(i);
+		std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return (keys[a] & mask) < (keys[b] & mask); });
+		return order;
+	}
+
+	TEST_CLASS(RadixSortTests)
+	{
+	public:
+		TEST_METHOD(MatchesStableSort)
+		{
+			std::mt19937 rng(45);
+			std::vector<uint32_t> keys(200003);
+			// few distinct values, so stability is tested too
+			for (uint32_t& key : keys)
+				key = (rng() % 5000) * 0x10001u;
+			std::vector<uint32_t> expected = StableOrder(keys, 0xFFFFFFFFu);
+
+			std::vector<uint32_t> serialKeys = keys, parallelKeys = keys;
+			std::vector<uint32_t> serialOrder(keys.size()), parallelOrder(keys.size());
+			RadixSort(serialKeys.data(), serialKeys.size(), serialOrder.data());
+			RadixSort(Execution::Par, parallelKeys.data(), parallelKeys.size(), parallelOrder.data());
+			for (size_t i = 0; i < keys.size(); ++i) {
+				Assert::AreEqual(expected[i], serialOrder[i]);
+				Assert::AreEqual(expected[i], parallelOrder[i]);
+				Assert::AreEqual(keys[expected[i]], serialKeys[i]);
+				Assert::AreEqual(keys[expected[i]], parallelKeys[i]);
+			}
+
+			// wider digits, fewer passes, same result
+			std::vector<uint32_t> wideKeys = keys, wideOrder(keys.size());
+			RadixSort<11>(Execution::Par, wideKeys.data(), wideKeys.size(), wideOrder.data());
+			Assert::IsTrue(wideOrder == expected);
+			Assert::IsTrue(wideKeys == serialKeys);
+		}
+
+		// scratch kept between sorts, or taken from an arena, gives the same result
+		TEST_METHOD(ScratchAndArena)
+		{
+			std::mt19937 rng(47);
+			std::vector<uint32_t> keys(100000);
+			for (uint32_t& key : keys)
+				key = rng() % 3000;
+			std::vector<uint32_t> expected = StableOrder(keys, 0xFFFFFFFFu);
+
+			RadixSortScratch<uint32_t> scratch;
+			std::vector<uint32_t> sorted = keys, order(keys.size());
+			RadixSort(Execution::Par, sorted.data(), sorted.size(), order.data(), scratch);
+			Assert::IsTrue(order == expected);
+			const uint32_t* kept = scratch.keys.data();
+			sorted = keys;
+			RadixSort(sorted.data(), sorted.size() / 2, order.data(), scratch);
+			Assert::IsTrue(kept == scratch.keys.data());
+			Assert::IsTrue(std::is_sorted(sorted.begin(), sorted.begin() + sorted.size() / 2));
+
+			FrameArena arena(1024 * 1024);
+			sorted = keys;
+			std::fill(order.begin(), order.end(), 0u);
+			Assert::IsTrue(RadixSort<11>(Execution::Par, arena, sorted.data(), sorted.size(), order.data()));
+			Assert::IsTrue(order == expected);
+			Assert::AreEqual(size_t(0), arena.GetMarker().offset);
+
+			// too small for the scratch: the keys are left alone
+			FrameArena small(1024);
+			sorted = keys;
+			Assert::IsFalse(RadixSort(small, sorted.data(), sorted.size(), order.data()));
+			Assert::IsTrue(sorted == keys);
+		}
+
+		TEST_METHOD(SixtyFourBitAndKeyBits)
+		{
+			std::mt19937_64 rng(46);
+			std::vector<uint64_t> keys(70000);
+			for (uint64_t& key : keys)
+				key = rng() >> 1;
+			std::vector<uint32_t> expected = StableOrder(keys, ~uint64_t(0));
+			std::vector<uint64_t> sorted = keys;
+			std::vector<uint32_t> order(keys.size());
+			RadixSort(Execution::Par, sorted.data(), sorted.size(), order.data(), 63);
+			for (size_t i = 0; i < keys.size(); ++i)
+				Assert::AreEqual(expected[i], order[i]);
+
+			// only the low 12 bits: the high bits are carried along, not sorted on
+			std::vector<uint64_t> partial = keys;
+			RadixSort(partial.data(), partial.size(), order.data(), 12);
+			expected = StableOrder(keys, uint64_t(0xFFF));
+			for (size_t i = 0; i < keys.size(); ++i) {
+				Assert::AreEqual(expected[i], order[i]);
+				Assert::AreEqual(keys[order[i]], partial[i]);
+			}
+		}
+
+		TEST_METHOD(KeysOnlyAndPermutation)
+		{
+			std::vector<uint32_t> keys = { 9, 3, 3, 0, 250, 7, 3 };
+			std::vector<uint32_t> sorted = keys;
+			RadixSort(sorted.data(), sorted.size(), nullptr);
+			Assert::IsTrue(std::is_sorted(sorted.begin(), sorted.end()));
+
+			std::vector<uint32_t> order(keys.size());
+			std::vector<uint32_t> copy = keys;
+			RadixSort(copy.data(), copy.size(), order.data());
+			std::vector<char> names = { 'a', 'b', 'c', 'd', 'e', 'f', 'g' }, reordered(names.size());
+			ApplyPermutation(names.data(), order.data(), reordered.data(), names.size());
+			Assert::IsTrue(std::string("dbcgfae") == std::string(reordered.begin(), reordered.end()));
+
+			// all the same digit everywhere: nothing moves
+			std::vector<uint32_t> same(10, 0x12345678u), sameOrder(10);
+			RadixSort(same.data(), same.size(), sameOrder.data());
+			for (uint32_t i = 0; i < 10; ++i)
+				Assert::AreEqual(i, sameOrder[i]);
+			RadixSort(same.data(), 0, sameOrder.data());
+		}
+	};
+}
@@ -0,0 +1,206 @@
+#include "CppUnitTest.h"
+#include "TestToString.h"
+
+#include "Utils.h"
+#include "MathHeaders/Rasteriser.h"
+
+#include <random>
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace MathClasses;
+
+namespace MathLibraryTests
+{
+	static const Colour Black(0, 0, 0, 255);
+
+	static DrawCall MakeDraw(const std::vector<Vector3>& positions, const std::vector<uint32_t>& indices, Colour colour)
+	{
+		DrawCall draw;
+		draw.transform = Matrix4::MakeIdentity();
+		draw.positions = positions.data();
+		draw.vertexCount = positions.size();
+		draw.indices = indices.data();
+		draw.triangleCount = indices.size() / 3;
+		draw.colour = colour;
+		return draw;
+	}
+
+	static int CountPixels(const Framebuffer& target, Colour colour)
+	{
+		int count = 0;
+		for (int y = 0; y < target.GetHeight(); ++y)
+			for (int x = 0; x < target.GetWidth(); ++x)
+				count += target.GetPixel(x, y) == colour;
+		return count;
+	}
+
+	TEST_CLASS(RasteriserTests)
+	{
+	public:
+		TEST_METHOD(FullScreenQuad)
+		{
+			// width not a multiple of four or of the tile size
+			Framebuffer target(150, 70);
+			target.Clear(Black);
+			std::vector<Vector3> positions = { Vector3(-1, -1, 0), Vector3(1, -1, 0), Vector3(1, 1, 0), Vector3(-1, 1, 0) };
+			std::vector<uint32_t> indices = { 0, 1, 2, 0, 2, 3 };
+			Colour red(255, 0, 0, 255);
+
+			Rasteriser rasteriser;
+			rasteriser.Draw(target, MakeDraw(positions, indices, red));
+			Assert::AreEqual(150 * 70, CountPixels(target, red));
+			Assert::AreEqual(0.5f, target.GetDepth(149, 69));
+		}
+
+		// every pixel on a shared edge belongs to exactly one triangle
+		TEST_METHOD(SharedEdgesDrawnOnce)
+		{
+			std::mt19937 rng(2);
+			std::uniform_real_distribution<float> jitter(-0.04f, 0.04f);
+			const int grid = 8;
+			std::vector<Vector3> positions;
+			for (int y = 0; y <= grid; ++y)
+				for (int x = 0; x <= grid; ++x) {
+					bool edge = x == 0 || y == 0 || x == grid || y == grid;
+					positions.push_back(Vector3(x * 2.0f / grid - 1 + (edge ? 0 : jitter(rng)),
+						y * 2.0f / grid - 1 + (edge ? 0 : jitter(rng)), 0));
+				}
+
+			Framebuffer target(97, 61);
+			Rasteriser rasteriser;
+			Colour white(255, 255, 255, 255);
+			int total = 0;
+			for (int y = 0; y < grid; ++y)
+				for (int x = 0; x < grid; ++x) {
+					uint32_t i = y * (grid + 1) + x;
+					std::vector<uint32_t> quad = { i, i + 1, i + grid + 2, i, i + grid + 2, i + grid + 1 };
+					for (int t = 0; t < 2; ++t) {
+						std::vector<uint32_t> tri(quad.begin() + t * 3, quad.begin() + t * 3 + 3);
+						target.Clear(Black);
+						rasteriser.Draw(target, MakeDraw(positions, tri, white));
+						total += CountPixels(target, white);
+					}
+				}
+			Assert::AreEqual(97 * 61, total);
+		}
+
+		TEST_METHOD(DepthTest)
+		{
+			Framebuffer target(64, 64);
+			std::vector<Vector3> near = { Vector3(-1, -1, -0.5f), Vector3(1, -1, -0.5f), Vector3(0, 1, -0.5f) };
+			std::vector<Vector3> far = { Vector3(-1, -1, 0.5f), Vector3(1, -1, 0.5f), Vector3(0, 1, 0.5f) };
+			std::vector<uint32_t> indices = { 0, 1, 2 };
+			Colour red(255, 0, 0, 255), blue(0, 0, 255, 255);
+
+			Rasteriser rasteriser;
+			for (int order = 0; order < 2; ++order) {
+				target.Clear(Black);
+				DrawCall draws[2] = { MakeDraw(near, indices, red), MakeDraw(far, indices, blue) };
+				if (order)
+					std::swap(draws[0], draws[1]);
+				rasteriser.Draw(Execution::Seq, target, draws, 2);
+				Assert::IsTrue(target.GetPixel(32, 40) == red);
+				Assert::AreEqual(0.25f, target.GetDepth(32, 40));
+				Assert::AreEqual(0, CountPixels(target, blue));
+			}
+		}
+
+		TEST_METHOD(Culling)
+		{
+			Framebuffer target(32, 32);
+			std::vector<Vector3> positions = { Vector3(-1, -1, 0), Vector3(1, -1, 0), Vector3(0, 1, 0) };
+			std::vector<uint32_t> front = { 0, 1, 2 }, back = { 0, 2, 1 };
+			Colour white(255, 255, 255, 255);
+			Rasteriser rasteriser;
+
+			target.Clear(Black);
+			rasteriser.Draw(target, MakeDraw(positions, back, white));
+			Assert::AreEqual(0, CountPixels(target, white));
+
+			rasteriser.Draw(target, MakeDraw(positions, front, white));
+			int visible = CountPixels(target, white);
+			Assert::IsTrue(visible > 0);
+
+			DrawCall draw = MakeDraw(positions, back, white);
+			draw.cull = CullMode::None;
+			target.Clear(Black);
+			rasteriser.Draw(target, draw);
+			Assert::AreEqual(visible, CountPixels(target, white));
+		}
+
+		// a floor running from behind the camera to the horizon is clipped at the near plane
+		TEST_METHOD(NearPlaneClipping)
+		{
+			Framebuffer target(64, 64);
+			target.Clear(Black);
+			std::vector<Vector3> positions = { Vector3(-10, -1, 5), Vector3(10, -1, 5), Vector3(10, -1, -50), Vector3(-10, -1, -50) };
+			std::vector<uint32_t> indices = { 0, 1, 2, 0, 2, 3 };
+			Colour grey(128, 128, 128, 255);
+			DrawCall draw = MakeDraw(positions, indices, grey);
+			draw.transform = Matrix4::MakePerspective(Pi / 2, 1.0f, 0.1f, 100.0f);
+
+			Rasteriser rasteriser;
+			rasteriser.Draw(target, draw);
+			Assert::IsTrue(rasteriser.GetTriangleCount() > 2);
+			// bottom row is floor, top half is sky
+			Assert::IsTrue(target.GetPixel(32, 63) == grey);
+			Assert::IsTrue(target.GetPixel(32, 10) == Black);
+
+			// entirely behind the camera
+			for (Vector3& p : positions)
+				p.z += 60.0f;
+			target.Clear(Black);
+			rasteriser.Draw(target, draw);
+			Assert::AreEqual(size_t(0), rasteriser.GetTriangleCount());
+			Assert::AreEqual(0, CountPixels(target, grey));
+		}
+
+		TEST_METHOD(ColourInterpolation)
+		{
+			Framebuffer target(64, 64);
+			std::vector<Vector3> positions = { Vector3(-1, -1, 0), Vector3(1, -1, 0), Vector3(1, 1, 0), Vector3(-1, 1, 0) };
+			std::vector<uint32_t> indices = { 0, 1, 2, 0, 2, 3 };
+			std::vector<Colour> colours = {
+				Colour(0, 0, 0, 255), Colour(255, 0, 0, 255), Colour(255, 0, 0, 255), Colour(0, 0, 0, 255) };
+			DrawCall draw = MakeDraw(positions, indices, Black);
+			draw.colours = colours.data();
+
+			Rasteriser rasteriser;
+			rasteriser.Draw(target, draw);
+			// red ramps left to right through the pixel centres
+			for (int x = 0; x < 64; ++x)
+				Assert::AreEqual((x + 0.5f) / 64.0f * 255.0f, float(target.GetPixel(x, 20).GetRed()), 1.0f);
+		}
+
+		TEST_METHOD(ParallelMatchesSerial)
+		{
+			std::mt19937 rng(9);
+			std::uniform_real_distribution<float> coord(-1.2f, 1.2f);
+			std::uniform_int_distribution<int> byte(0, 255);
+			std::vector<Vector3> positions;
+			std::vector<Colour> colours;
+			std::vector<uint32_t> indices;
+			for (int i = 0; i < 3000; ++i) {
+				positions.push_back(Vector3(coord(rng), coord(rng), coord(rng) * 0.8f));
+				colours.push_back(Colour(Byte(byte(rng)), Byte(byte(rng)), Byte(byte(rng)), 255));
+				indices.push_back(uint32_t(i));
+			}
+			DrawCall draw = MakeDraw(positions, indices, Black);
+			draw.colours = colours.data();
+			draw.cull = CullMode::None;
+
+			Framebuffer serial(200, 150), parallel(200, 150);
+			serial.Clear(Black);
+			parallel.Clear(Black);
+			Rasteriser a, b;
+			a.Draw(Execution::Seq, serial, &draw, 1);
+			b.Draw(Execution::Par, parallel, &draw, 1);
+			for (int y = 0; y < 150; ++y)
+				for (int x = 0; x < 200; ++x) {
+					Assert::IsTrue(serial.GetPixel(x, y) == parallel.GetPixel(x, y));
+					Assert::AreEqual(serial.GetDepth(x, y), parallel.GetDepth(x, y));
+				}
+		}
+	};
+}
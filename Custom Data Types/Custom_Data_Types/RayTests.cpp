@@ -0,0 +1,168 @@
+#include "CppUnitTest.h"
+#include "TestToString.h"
+
+#include "MathHeaders/Ray.h"
+
+#include <random>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace MathClasses;
+
+namespace MathLibraryTests
+{
+	struct RayFixture
+	{
+		std::mt19937 rng;
+		std::uniform_real_distribution<float> coord;
+
+		RayFixture() : rng(5), coord(-2.0f, 2.0f) {}
+
+		Vector3 Point() { return Vector3(coord(rng), coord(rng), coord(rng)); }
+
+		// rays from one side of the box aimed roughly through the middle
+		Ray RandomRay() { return Ray(Vector3(coord(rng), coord(rng), -5.0f), Vector3(coord(rng) * 0.2f, coord(rng) * 0.2f, 1.0f)); }
+	};
+
+	// checks the SIMD kernels against the scalar ones at the given width
+	template<typename F>
+	static void CheckTriangleKernels()
+	{
+		RayFixture f;
+		for (int round = 0; round < 50; ++round) {
+			Ray ray = f.RandomRay();
+			Vector3 tris[F::Width][3];
+			TrianglePack<F> pack;
+			for (int lane = 0; lane < F::Width; ++lane) {
+				tris[lane][0] = f.Point(); tris[lane][1] = f.Point(); tris[lane][2] = f.Point();
+				pack.Set(lane, tris[lane][0], tris[lane][1], tris[lane][2]);
+			}
+			RayHitPack<F> hits;
+			int mask = IntersectTriangles(ray, pack, hits);
+			for (int lane = 0; lane < F::Width; ++lane) {
+				RayHit hit;
+				bool expected = IntersectTriangle(ray, tris[lane][0], tris[lane][1], tris[lane][2], hit);
+				Assert::AreEqual(expected, ((mask >> lane) & 1) != 0);
+				if (expected) {
+					Assert::AreEqual(hit.t, hits.t[lane], 0.0001f);
+					Assert::AreEqual(hit.u, hits.u[lane], 0.0001f);
+					Assert::AreEqual(hit.v, hits.v[lane], 0.0001f);
+				}
+			}
+
+			RayPacket<F> packet;
+			Ray rays[F::Width];
+			for (int lane = 0; lane < F::Width; ++lane) {
+				rays[lane] = f.RandomRay();
+				packet.Set(lane, rays[lane]);
+			}
+			RayHitPack<F> packetHits;
+			mask = IntersectTriangle(packet, tris[0][0], tris[0][1], tris[0][2], packetHits);
+			for (int lane = 0; lane < F::Width; ++lane) {
+				RayHit hit;
+				bool expected = IntersectTriangle(rays[lane], tris[0][0], tris[0][1], tris[0][2], hit);
+				Assert::AreEqual(expected, ((mask >> lane) & 1) != 0);
+				if (expected)
+					Assert::AreEqual(hit.t, packetHits.t[lane], 0.0001f);
+			}
+		}
+	}
+
+	template<typename F>
+	static void CheckBoxKernels()
+	{
+		RayFixture f;
+		for (int round = 0; round < 50; ++round) {
+			Ray ray = f.RandomRay();
+			AABB boxes[F::Width];
+			AABBPack<F> pack;
+			// leave the last lane empty, and make the one before empty only in y
+			for (int lane = 0; lane < F::Width - 1; ++lane) {
+				boxes[lane] = AABB();
+				boxes[lane].Expand(f.Point());
+				boxes[lane].Expand(f.Point());
+				pack.Set(lane, boxes[lane]);
+			}
+			boxes[F::Width - 2] = AABB(Vector3(-2, 2, -2), Vector3(2, -2, 2));
+			pack.Set(F::Width - 2, boxes[F::Width - 2]);
+			F entry;
+			int mask = IntersectAABBs(ray, pack, 100.0f, entry);
+			for (int lane = 0; lane < F::Width; ++lane) {
+				float t = 0.0f;
+				bool expected = IntersectAABB(ray, boxes[lane], 100.0f, t);
+				Assert::AreEqual(expected, ((mask >> lane) & 1) != 0);
+				if (expected)
+					Assert::AreEqual(t, entry[lane], 0.0001f);
+			}
+
+			RayPacket<F> packet;
+			Ray rays[F::Width];
+			for (int lane = 0; lane < F::Width; ++lane) {
+				rays[lane] = f.RandomRay();
+				packet.Set(lane, rays[lane]);
+			}
+			mask = IntersectAABB(packet, boxes[0], F(100.0f), entry);
+			for (int lane = 0; lane < F::Width; ++lane) {
+				float t = 0.0f;
+				bool expected = IntersectAABB(rays[lane], boxes[0], 100.0f, t);
+				Assert::AreEqual(expected, ((mask >> lane) & 1) != 0);
+				if (expected)
+					Assert::AreEqual(t, entry[lane], 0.0001f);
+			}
+		}
+	}
+
+	TEST_CLASS(RayTests)
+	{
+	public:
+		TEST_METHOD(TriangleHit)
+		{
+			Ray ray(Vector3(0.25f, 0.25f, -2.0f), Vector3(0, 0, 1));
+			RayHit hit;
+			Assert::IsTrue(IntersectTriangle(ray, Vector3(0, 0, 0), Vector3(1, 0, 0), Vector3(0, 1, 0), hit));
+			Assert::AreEqual(2.0f, hit.t, 0.0001f);
+			Assert::AreEqual(0.25f, hit.u, 0.0001f);
+			Assert::AreEqual(0.25f, hit.v, 0.0001f);
+			Assert::AreEqual(Vector3(0.25f, 0.25f, 0), ray.GetPoint(hit.t));
+
+			// further triangles don't replace the closest hit, and behind the origin misses
+			Assert::IsFalse(IntersectTriangle(ray, Vector3(0, 0, 1), Vector3(1, 0, 1), Vector3(0, 1, 1), hit));
+			Assert::IsFalse(IntersectTriangle(ray, Vector3(0, 0, -3), Vector3(1, 0, -3), Vector3(0, 1, -3), hit));
+			// parallel
+			Assert::IsFalse(IntersectTriangle(ray, Vector3(0, 0, 0), Vector3(0, 0, 1), Vector3(0, 1, 0), hit));
+		}
+
+		TEST_METHOD(BoxHit)
+		{
+			AABB box(Vector3(-1, -1, -1), Vector3(1, 1, 1));
+			float t = 0.0f;
+			Assert::IsTrue(IntersectAABB(Ray(Vector3(0, 0, -5), Vector3(0, 0, 1)), box, 100.0f, t));
+			Assert::AreEqual(4.0f, t);
+			Assert::IsTrue(IntersectAABB(Ray(Vector3(0, 0, 0), Vector3(1, 0, 0)), box, 100.0f, t));
+			Assert::AreEqual(0.0f, t);
+			Assert::IsFalse(IntersectAABB(Ray(Vector3(0, 0, -5), Vector3(0, 0, 1)), box, 3.0f, t));
+			Assert::IsFalse(IntersectAABB(Ray(Vector3(0, 3, -5), Vector3(0, 0, 1)), box, 100.0f, t));
+			Assert::IsFalse(IntersectAABB(Ray(Vector3(0, 0, -5), Vector3(0, 0, 1)), AABB(), 100.0f, t));
+			Assert::IsFalse(IntersectAABB(Ray(Vector3(0, 0, -5), Vector3(0, 0, 1)), AABB(Vector3(-1, 1, -1), Vector3(1, -1, 1)), 100.0f, t));
+		}
+
+		TEST_METHOD(TriangleKernels4)
+		{
+			CheckTriangleKernels<Float4>();
+		}
+
+		TEST_METHOD(TriangleKernels8)
+		{
+			CheckTriangleKernels<Float8>();
+		}
+
+		TEST_METHOD(BoxKernels4)
+		{
+			CheckBoxKernels<Float4>();
+		}
+
+		TEST_METHOD(BoxKernels8)
+		{
+			CheckBoxKernels<Float8>();
+		}
+	};
+}
@@ -0,0 +1,152 @@
+#include "CppUnitTest.h"
+#include "TestToString.h"
+
+#include "MathHeaders/Reductions.h"
+
+#include <random>
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace MathClasses;
+
+namespace MathLibraryTests
+{
+	// Two pass reference in double
+	static void ReferenceStatistics(const std::vector<Vector3>& points, double mean[3], double covariance[3][3])
+	{
+		mean[0] = mean[1] = mean[2] = 0;
+		for (const Vector3& p : points) {
+			mean[0] += p.x;
+			mean[1] += p.y;
+			mean[2] += p.z;
+		}
+		for (int k = 0; k < 3; ++k)
+			mean[k] /= double(points.size());
+		for (int r = 0; r < 3; ++r)
+			for (int c = 0; c < 3; ++c)
+				covariance[r][c] = 0;
+		for (const Vector3& p : points) {
+			double d[3] = { p.x - mean[0], p.y - mean[1], p.z - mean[2] };
+			for (int r = 0; r < 3; ++r)
+				for (int c = 0; c < 3; ++c)
+					covariance[r][c] += d[r] * d[c];
+		}
+		for (int r = 0; r < 3; ++r)
+			for (int c = 0; c < 3; ++c)
+				covariance[r][c] /= double(points.size());
+	}
+
+	static std::vector<Vector3> Cloud(size_t count, Vector3 centre, unsigned int seed)
+	{
+		std::mt19937 rng(seed);
+		std::normal_distribution<float> spread(0.0f, 1.0f);
+		std::vector<Vector3> points(count);
+		for (Vector3& p : points) {
+			float a = spread(rng), b = spread(rng), c = spread(rng);
+			// correlated, so the covariance has off diagonal terms
+			p = centre + Vector3(2 * a, a + 0.5f * b, 0.3f * c - b);
+		}
+		return points;
+	}
+
+	TEST_CLASS(ReductionsTests)
+	{
+	public:
+		TEST_METHOD(MatchesReference)
+		{
+			std::vector<Vector3> points = Cloud(50003, Vector3(1, -2, 3), 1);
+			PointStatistics stats = ComputePointStatistics(points.data(), points.size());
+
+			AABB bounds;
+			for (const Vector3& p : points)
+				bounds.Expand(p);
+			double mean[3], covariance[3][3];
+			ReferenceStatistics(points, mean, covariance);
+
+			Assert::AreEqual(points.size(), stats.count);
+			Assert::AreEqual(bounds, stats.bounds);
+			Assert::AreEqual(bounds, ComputeBounds(points.data(), points.size()));
+			Assert::AreEqual(float(mean[0]), stats.centroid.x, 1e-6f);
+			Assert::AreEqual(float(mean[1]), stats.centroid.y, 1e-6f);
+			Assert::AreEqual(float(mean[2]), stats.centroid.z, 1e-6f);
+			const float* c = &stats.covariance.m1;
+			Matrix3 expected = Matrix3(float(covariance[0][0]), float(covariance[1][0]), float(covariance[2][0]),
+				float(covariance[0][1]), float(covariance[1][1]), float(covariance[2][1]),
+				float(covariance[0][2]), float(covariance[1][2]), float(covariance[2][2]));
+			const float* e = &expected.m1;
+			for (int k = 0; k < 9; ++k)
+				Assert::AreEqual(e[k], c[k], 1e-5f);
+		}
+
+		// far from the origin a float sum of squares would cancel to nothing
+		TEST_METHOD(LargeOffset)
+		{
+			std::vector<Vector3> points = Cloud(100000, Vector3(20000, -30000, 5000), 2);
+			PointStatistics stats = ComputePointStatistics(Execution::Par, Span<const Vector3>(points.data(), points.size()));
+			double mean[3], covariance[3][3];
+			ReferenceStatistics(points, mean, covariance);
+			Assert::AreEqual(float(mean[0]), stats.centroid.x, 1e-3f);
+			Assert::AreEqual(float(mean[1]), stats.centroid.y, 1e-3f);
+			Assert::AreEqual(float(covariance[0][0]), stats.covariance.m1, 1e-3f);
+			Assert::AreEqual(float(covariance[1][1]), stats.covariance.m5, 1e-3f);
+			Assert::AreEqual(float(covariance[0][1]), stats.covariance.m2, 1e-3f);
+			Assert::AreEqual(float(covariance[2][1]), stats.covariance.m6, 1e-3f);
+		}
+
+		TEST_METHOD(ParallelMatchesSerial)
+		{
+			std::vector<Vector3> points = Cloud(100001, Vector3(-5, 5, 0), 3);
+			PointStatistics serial = ComputePointStatistics(points.data(), points.size());
+			PointStatistics parallel = ComputePointStatistics(Execution::Par, points.data(), points.size());
+			Assert::AreEqual(serial.centroid.x, parallel.centroid.x);
+			Assert::AreEqual(serial.centroid.z, parallel.centroid.z);
+			const float* s = &serial.covariance.m1;
+			const float* p = &parallel.covariance.m1;
+			for (int k = 0; k < 9; ++k)
+				Assert::AreEqual(s[k], p[k]);
+			Assert::AreEqual(serial.bounds, parallel.bounds);
+		}
+
+		// more chunks than fit on the stack at once, reduced a batch at a time or in one
+		// pass with partials from an arena, or a batch at a time when the arena is full
+		TEST_METHOD(ArenaMatchesBatches)
+		{
+			std::vector<Vector3> points = Cloud(Detail::ReductionBatchChunks * Detail::ReductionChunk * 2 + 5, Vector3(3, 0, -7), 4);
+			PointStatistics batched = ComputePointStatistics(Execution::Par, points.data(), points.size());
+			FrameArena arena(64 * 1024);
+			FrameArena full(64);
+			PointStatistics results[] = {
+				ComputePointStatistics(Execution::Par, arena, points.data(), points.size()),
+				ComputePointStatistics(full, points.data(), points.size()) };
+			Assert::AreEqual(size_t(0), arena.GetMarker().offset);
+			Assert::IsTrue(arena.GetHighWaterMark() > 0);
+			for (const PointStatistics& stats : results) {
+				Assert::AreEqual(batched.centroid, stats.centroid);
+				Assert::AreEqual(batched.covariance, stats.covariance);
+				Assert::AreEqual(batched.bounds, stats.bounds);
+			}
+			Assert::AreEqual(batched.bounds, ComputeBounds(Execution::Par, arena, points.data(), points.size()));
+
+			double mean[3], covariance[3][3];
+			ReferenceStatistics(points, mean, covariance);
+			Assert::AreEqual(mean[0], double(batched.centroid.x), 1e-4);
+			Assert::AreEqual(covariance[0][1], double(batched.covariance.m4), 1e-3);
+		}
+
+		TEST_METHOD(SmallAndEmpty)
+		{
+			PointStatistics empty = ComputePointStatistics(nullptr, 0);
+			Assert::AreEqual(size_t(0), empty.count);
+			Assert::IsTrue(empty.bounds.IsEmpty());
+			Assert::IsTrue(ComputeBounds(nullptr, 0).IsEmpty());
+
+			std::vector<Vector3> points = { Vector3(1, 0, 0), Vector3(-1, 0, 0), Vector3(0, 2, 0) };
+			PointStatistics stats = ComputePointStatistics(points.data(), points.size());
+			Assert::AreEqual(Vector3(0, 2.0f / 3.0f, 0), stats.centroid);
+			Assert::AreEqual(AABB(Vector3(-1, 0, 0), Vector3(1, 2, 0)), stats.bounds);
+			Assert::AreEqual(2.0f / 3.0f, stats.covariance.m1, 1e-6f);
+			Assert::AreEqual(8.0f / 9.0f, stats.covariance.m5, 1e-6f);
+			Assert::AreEqual(0.0f, stats.covariance.m9);
+		}
+	};
+}
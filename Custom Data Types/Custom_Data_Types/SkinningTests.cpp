@@ -0,0 +1,209 @@
+#include "CppUnitTest.h"
+#include "TestToString.h"
+
+#include "Utils.h"
+#include "MathHeaders/Skinning.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace MathClasses;
+
+namespace MathLibraryTests
+{
+	// Vertices bound to a three bone palette; by default a handful, not a multiple of four
+	struct SkinningFixture
+	{
+		size_t count;
+		std::vector<float> px, py, pz, nx, ny, nz, weights;
+		std::vector<uint32_t> bones;
+		std::vector<float> ox, oy, oz, onx, ony, onz;
+		Matrix4 palette[3];
+
+		explicit SkinningFixture(size_t count = 11) :
+			count(count), px(count), py(count), pz(count), nx(count), ny(count), nz(count), weights(count * 4),
+			bones(count), ox(count), oy(count), oz(count), onx(count), ony(count), onz(count)
+		{
+			palette[0] = Matrix4::MakeIdentity();
+			palette[1] = Matrix4::MakeTranslation(1.0f, 2.0f, 3.0f) * Matrix4::MakeRotateZ(0.5f);
+			palette[2] = Matrix4::MakeTranslation(-4.0f, 0.0f, 1.0f) * Matrix4::MakeRotateX(-1.25f);
+
+			for (size_t i = 0; i < count; ++i) {
+				px[i] = float(i); py[i] = 1.0f - float(i) * 0.5f; pz[i] = 2.0f;
+				nx[i] = 0.0f; ny[i] = 1.0f; nz[i] = 0.0f;
+				bones[i] = uint32_t(i % 3) | (uint32_t((i + 1) % 3) << 8) | (2u << 16);
+				float w0 = 0.1f * float(i % 5) + 0.2f;
+				weights[i * 4 + 0] = w0;
+				weights[i * 4 + 1] = 1.0f - w0;
+				weights[i * 4 + 2] = 0.0f;
+				weights[i * 4 + 3] = 0.0f;
+			}
+		}
+
+		SkinningInput Input()
+		{
+			SkinningInput in;
+			in.positionX = px.data(); in.positionY = py.data(); in.positionZ = pz.data();
+			in.normalX = nx.data(); in.normalY = ny.data(); in.normalZ = nz.data();
+			in.boneIndices = bones.data();
+			in.boneWeights = weights.data();
+			in.vertexCount = count;
+			return in;
+		}
+
+		SkinningOutput Output()
+		{
+			return SkinningOutput{ ox.data(), oy.data(), oz.data(), onx.data(), ony.data(), onz.data() };
+		}
+
+		Vector3 Position(size_t i) const { return Vector3(ox[i], oy[i], oz[i]); }
+		Vector3 Normal(size_t i) const { return Vector3(onx[i], ony[i], onz[i]); }
+	};
+
+	TEST_CLASS(SkinningTests)
+	{
+	public:
+		// matches summing weighted matrices and transforming through operator*
+		TEST_METHOD(LinearBlendMatchesReference)
+		{
+			SkinningFixture f;
+			SkinLinearBlend(f.palette, f.Input(), f.Output());
+
+			for (size_t i = 0; i < f.count; ++i) {
+				Matrix4 blended;
+				for (int k = 0; k < 4; ++k) {
+					const Matrix4& bone = f.palette[(f.bones[i] >> (8 * k)) & 0xFF];
+					float w = f.weights[i * 4 + k];
+					const float* src = &bone.m1;
+					float* dst = &blended.m1;
+					for (int e = 0; e < 16; ++e)
+						dst[e] += src[e] * w;
+				}
+				Vector4 p = blended * Vector4(f.px[i], f.py[i], f.pz[i], 1.0f);
+				Vector4 n = blended * Vector4(f.nx[i], f.ny[i], f.nz[i], 0.0f);
+
+				Assert::AreEqual(Vector3(p.x, p.y, p.z), f.Position(i));
+				Assert::AreEqual(Vector3(n.x, n.y, n.z).Normalised(), f.Normal(i));
+			}
+		}
+
+		// a vertex fully weighted to one bone follows that bone exactly in both methods
+		TEST_METHOD(SingleInfluence)
+		{
+			SkinningFixture f;
+			for (size_t i = 0; i < f.count; ++i) {
+				f.bones[i] = 1;
+				f.weights[i * 4] = 1.0f;
+				f.weights[i * 4 + 1] = 0.0f;
+			}
+			DualQuaternion dqPalette[3];
+			BuildDualQuaternionPalette(f.palette, dqPalette, 3);
+
+			for (int method = 0; method < 2; ++method) {
+				if (method == 0)
+					SkinLinearBlend(f.palette, f.Input(), f.Output());
+				else
+					SkinDualQuaternion(dqPalette, f.Input(), f.Output());
+
+				for (size_t i = 0; i < f.count; ++i) {
+					Vector4 p = f.palette[1] * Vector4(f.px[i], f.py[i], f.pz[i], 1.0f);
+					Vector4 n = f.palette[1] * Vector4(f.nx[i], f.ny[i], f.nz[i], 0.0f);
+					Assert::AreEqual(Vector3(p.x, p.y, p.z), f.Position(i));
+					Assert::AreEqual(Vector3(n.x, n.y, n.z), f.Normal(i));
+				}
+			}
+		}
+
+		// dual quaternion skinning keeps the distance to a blended joint, where linear
+		// blending of a 180 degree twist collapses the vertex onto the axis
+		TEST_METHOD(DualQuaternionPreservesVolume)
+		{
+			Matrix4 palette[2] = { Matrix4::MakeIdentity(), Matrix4::MakeRotateX(Pi) };
+			DualQuaternion dqPalette[2];
+			BuildDualQuaternionPalette(palette, dqPalette, 2);
+
+			float x = 0.0f, y = 1.0f, z = 0.0f;
+			uint32_t bones = 0 | (1u << 8);
+			float weights[4] = { 0.5f, 0.5f, 0.0f, 0.0f };
+			float ox, oy, oz;
+			SkinningInput in;
+			in.positionX = &x; in.positionY = &y; in.positionZ = &z;
+			in.boneIndices = &bones;
+			in.boneWeights = weights;
+			in.vertexCount = 1;
+			SkinningOutput out{ &ox, &oy, &oz };
+
+			SkinLinearBlend(palette, in, out);
+			Assert::AreEqual(0.0f, Vector3(ox, oy, oz).Magnitude(), 0.0001f);
+
+			SkinDualQuaternion(dqPalette, in, out);
+			Assert::AreEqual(1.0f, Vector3(ox, oy, oz).Magnitude(), 0.0001f);
+		}
+
+		// several grains of vertices so Par splits the work, with a tail that isn't a
+		// multiple of four at the end of the last range
+		TEST_METHOD(ParallelMatchesSerial)
+		{
+			SkinningFixture f(4 * GrainForBytes(Detail::SkinningBytesPerVertex) + 7);
+			DualQuaternion dq[3];
+			BuildDualQuaternionPalette(f.palette, dq, 3);
+			for (int dual = 0; dual < 2; ++dual) {
+				if (dual)
+					SkinDualQuaternion(dq, f.Input(), f.Output());
+				else
+					SkinLinearBlend(f.palette, f.Input(), f.Output());
+				std::vector<float> serial[] = { f.ox, f.oy, f.oz, f.onx, f.ony, f.onz };
+
+				std::fill(f.ox.begin(), f.ox.end(), 0.0f);
+				std::fill(f.onz.begin(), f.onz.end(), 0.0f);
+				if (dual)
+					SkinDualQuaternion(Execution::Par, dq, f.Input(), f.Output());
+				else
+					SkinLinearBlend(Execution::Par, f.palette, f.Input(), f.Output());
+				const std::vector<float>* parallel[] = { &f.ox, &f.oy, &f.oz, &f.onx, &f.ony, &f.onz };
+				for (int c = 0; c < 6; ++c)
+					for (size_t i = 0; i < f.count; ++i)
+						Assert::AreEqual(serial[c][i], (*parallel[c])[i]);
+			}
+		}
+
+		// skinning into arena arrays gives the same vertices, and a full arena gives none
+		TEST_METHOD(OutputFromArena)
+		{
+			SkinningFixture f;
+			DualQuaternion dq[3];
+			BuildDualQuaternionPalette(f.palette, dq, 3);
+			FrameArena arena(16 * 1024);
+			for (int dual = 0; dual < 2; ++dual) {
+				SkinningOutput out;
+				if (dual) {
+					SkinDualQuaternion(dq, f.Input(), f.Output());
+					out = SkinDualQuaternion(Execution::Par, arena, dq, f.Input());
+				}
+				else {
+					SkinLinearBlend(f.palette, f.Input(), f.Output());
+					out = SkinLinearBlend(arena, f.palette, f.Input());
+				}
+				Assert::IsTrue(out.normalZ != nullptr);
+				for (size_t i = 0; i < f.count; ++i) {
+					Assert::AreEqual(f.Position(i), Vector3(out.positionX[i], out.positionY[i], out.positionZ[i]));
+					Assert::AreEqual(f.Normal(i), Vector3(out.normalX[i], out.normalY[i], out.normalZ[i]));
+				}
+			}
+
+			SkinningInput positionsOnly = f.Input();
+			positionsOnly.normalX = positionsOnly.normalY = positionsOnly.normalZ = nullptr;
+			SkinningOutput out = SkinLinearBlend(arena, f.palette, positionsOnly);
+			Assert::IsTrue(out.positionX != nullptr);
+			Assert::IsTrue(out.normalX == nullptr);
+
+			FrameArena small(4 * 64);
+			out = SkinLinearBlend(small, f.palette, f.Input());
+			Assert::IsTrue(out.positionX == nullptr);
+			Assert::IsTrue(out.normalZ == nullptr);
+			Assert::AreEqual(size_t(0), small.GetMarker().offset);
+		}
+	};
+}
@@ -0,0 +1,132 @@
+#include "CppUnitTest.h"
+#include "TestToString.h"
+
+#include "MathHeaders/SpaceFillingCurves.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace MathClasses;
+
+namespace MathLibraryTests
+{
+	// Cells one step apart along exactly one axis
+	static bool Neighbours(uint32_t ax, uint32_t ay, uint32_t az, uint32_t bx, uint32_t by, uint32_t bz)
+	{
+		int steps = std::abs(int(ax) - int(bx)) + std::abs(int(ay) - int(by)) + std::abs(int(az) - int(bz));
+		return steps == 1;
+	}
+
+	TEST_CLASS(SpaceFillingCurvesTests)
+	{
+	public:
+		TEST_METHOD(MortonInterleaves)
+		{
+			Assert::AreEqual(1u, EncodeMorton30(1, 0, 0));
+			Assert::AreEqual(2u, EncodeMorton30(0, 1, 0));
+			Assert::AreEqual(4u, EncodeMorton30(0, 0, 1));
+			Assert::AreEqual(9u, EncodeMorton30(3, 0, 0));
+			Assert::AreEqual(0x3FFFFFFFu, EncodeMorton30(1023, 1023, 1023));
+			Assert::AreEqual(uint64_t(0x7FFFFFFFFFFFFFFF), EncodeMorton63(0x1FFFFF, 0x1FFFFF, 0x1FFFFF));
+			Assert::AreEqual(uint64_t(1) << 62, EncodeMorton63(0, 0, 1u << 20));
+
+			std::mt19937 rng(45);
+			for (int i = 0; i < 1000; ++i) {
+				uint32_t x = rng() & 0x1FFFFF, y = rng() & 0x1FFFFF, z = rng() & 0x1FFFFF;
+				uint32_t dx, dy, dz;
+				DecodeMorton63(EncodeMorton63(x, y, z), dx, dy, dz);
+				Assert::IsTrue(dx == x && dy == y && dz == z);
+				DecodeMorton30(EncodeMorton30(x & 0x3FF, y & 0x3FF, z & 0x3FF), dx, dy, dz);
+				Assert::IsTrue(dx == (x & 0x3FF) && dy == (y & 0x3FF) && dz == (z & 0x3FF));
+			}
+		}
+
+		TEST_METHOD(HilbertStepsToNeighbours)
+		{
+			Assert::AreEqual(0u, EncodeHilbert30(0, 0, 0));
+			std::mt19937 rng(46);
+			for (int i = 0; i < 2000; ++i) {
+				uint32_t code = rng() % ((1u << 30) - 1);
+				uint32_t ax, ay, az, bx, by, bz;
+				DecodeHilbert30(code, ax, ay, az);
+				DecodeHilbert30(code + 1, bx, by, bz);
+				Assert::IsTrue(Neighbours(ax, ay, az, bx, by, bz));
+				Assert::AreEqual(code, EncodeHilbert30(ax, ay, az));
+
+				uint64_t code63 = (uint64_t(rng()) << 31 ^ rng()) % ((uint64_t(1) << 63) - 1);
+				DecodeHilbert63(code63, ax, ay, az);
+				DecodeHilbert63(code63 + 1, bx, by, bz);
+				Assert::IsTrue(Neighbours(ax, ay, az, bx, by, bz));
+				Assert::AreEqual(code63, EncodeHilbert63(ax, ay, az));
+			}
+		}
+
+		TEST_METHOD(QuantiseClampsToGrid)
+		{
+			GridQuantiser grid(AABB(Vector3(-1, 0, 5), Vector3(1, 4, 5)), 10);
+			uint32_t x, y, z;
+			grid.Quantise(Vector3(-1, 0, 5), x, y, z);
+			Assert::IsTrue(x == 0 && y == 0 && z == 0);
+			grid.Quantise(Vector3(1, 4, 5), x, y, z);
+			Assert::IsTrue(x == 1023 && y == 1023 && z == 0);
+			grid.Quantise(Vector3(0, 1, 5), x, y, z);
+			Assert::IsTrue(x == 512 && y == 256);
+			grid.Quantise(Vector3(-50, 50, 9), x, y, z);
+			Assert::IsTrue(x == 0 && y == 1023 && z == 0);
+		}
+
+		TEST_METHOD(CurveOrderSortsCodes)
+		{
+			std::mt19937 rng(47);
+			std::uniform_real_distribution<float> coordinate(-30.0f, 30.0f);
+			std::vector<Vector3> points(50000);
+			for (Vector3& p : points)
+				p = Vector3(coordinate(rng), coordinate(rng), coordinate(rng));
+			AABB bounds;
+			for (const Vector3& p : points)
+				bounds.Expand(p);
+
+			for (SpaceFillingCurve curve : { SpaceFillingCurve::Morton, SpaceFillingCurve::Hilbert }) {
+				std::vector<uint64_t> codes(points.size());
+				std::vector<uint32_t> codes30(points.size()), serial30(points.size());
+				ComputeCurveCodes(curve, points.data(), points.size(), bounds, codes.data());
+				ComputeCurveCodes(Execution::Par, curve, points.data(), points.size(), bounds, codes30.data());
+				ComputeCurveCodes(curve, points.data(), points.size(), bounds, serial30.data());
+				Assert::IsTrue(codes30 == serial30);
+
+				std::vector<uint32_t> order(points.size()), parallelOrder(points.size());
+				ComputeCurveOrder(curve, points.data(), points.size(), order.data());
+				ComputeCurveOrder(Execution::Par, curve, points.data(), points.size(), parallelOrder.data());
+				Assert::IsTrue(order == parallelOrder);
+
+				FrameArena arena(2 * 1024 * 1024);
+				Span<uint64_t> arenaCodes = ComputeCurveCodes<uint64_t>(Execution::Par, arena, curve, points.data(), points.size(), bounds);
+				Assert::IsTrue(std::equal(codes.begin(), codes.end(), arenaCodes.begin(), arenaCodes.end()));
+				Span<uint32_t> arenaOrder = ComputeCurveOrder(Execution::Par, arena, curve, points.data(), points.size());
+				Assert::IsTrue(std::equal(order.begin(), order.end(), arenaOrder.begin(), arenaOrder.end()));
+				Assert::AreEqual(points.size() * (sizeof(uint64_t) + sizeof(uint32_t)), arena.GetMarker().offset);
+				FrameArena small(points.size() * sizeof(uint32_t) + 64);
+				Assert::IsTrue(ComputeCurveOrder(small, curve, points.data(), points.size()).Empty());
+				Assert::AreEqual(size_t(0), small.GetMarker().offset);
+
+				std::vector<Vector3> sorted(points.size());
+				ApplyPermutation(Execution::Par, points.data(), order.data(), sorted.data(), points.size());
+				for (size_t i = 1; i < points.size(); ++i) {
+					Assert::IsTrue(codes[order[i - 1]] <= codes[order[i]]);
+					Assert::AreEqual(points[order[i]], sorted[i]);
+				}
+
+				// walking the curve keeps consecutive points much closer than the input order does
+				double curveStep = 0, inputStep = 0;
+				for (size_t i = 1; i < points.size(); ++i) {
+					curveStep += (sorted[i] - sorted[i - 1]).Magnitude();
+					inputStep += (points[i] - points[i - 1]).Magnitude();
+				}
+				Assert::IsTrue(curveStep * 5 < inputStep);
+			}
+		}
+	};
+}
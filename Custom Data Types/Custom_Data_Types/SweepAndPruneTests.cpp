@@ -0,0 +1,217 @@
+#include "CppUnitTest.h"
+#include "TestToString.h"
+
+#include "MathHeaders/SweepAndPrune.h"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace MathClasses;
+
+namespace MathLibraryTests
+{
+	static std::vector<BroadphasePair> BruteForcePairs(const std::vector<AABB>& boxes)
+	{
+		std::vector<BroadphasePair> pairs;
+		for (uint32_t i = 0; i < boxes.size(); ++i)
+			for (uint32_t j = i + 1; j < boxes.size(); ++j)
+				if (boxes[i].Overlaps(boxes[j]))
+					pairs.push_back(BroadphasePair{ i, j });
+		return pairs;
+	}
+
+	static std::vector<AABB> RandomBoxes(std::mt19937& rng, size_t count)
+	{
+		std::uniform_real_distribution<float> position(-50.0f, 50.0f), size(0.5f, 4.0f);
+		std::vector<AABB> boxes;
+		for (size_t i = 0; i < count; ++i) {
+			// spread out most along x
+			Vector3 centre(position(rng) * 4.0f, position(rng), position(rng) * 0.5f);
+			boxes.push_back(AABB::FromCentreExtents(centre, Vector3(size(rng), size(rng), size(rng))));
+		}
+		return boxes;
+	}
+
+	static void AssertSamePairs(std::vector<BroadphasePair> expected, std::vector<BroadphasePair> actual)
+	{
+		std::sort(expected.begin(), expected.end());
+		std::sort(actual.begin(), actual.end());
+		Assert::AreEqual(expected.size(), actual.size());
+		for (size_t i = 0; i < expected.size(); ++i)
+			Assert::IsTrue(expected[i] == actual[i]);
+	}
+
+	TEST_CLASS(SweepAndPruneTests)
+	{
+	public:
+		TEST_METHOD(AABBBasics)
+		{
+			AABB box;
+			Assert::IsTrue(box.IsEmpty());
+			box.Expand(Vector3(1, 2, 3));
+			box.Expand(Vector3(-1, 0, 5));
+			Assert::AreEqual(AABB(Vector3(-1, 0, 3), Vector3(1, 2, 5)), box);
+			Assert::AreEqual(Vector3(0, 1, 4), box.GetCentre());
+			Assert::AreEqual(Vector3(1, 1, 1), box.GetExtents());
+			Assert::IsTrue(box.Contains(Vector3(0, 1, 4)));
+			Assert::IsFalse(box.Contains(Vector3(0, 3, 4)));
+
+			// touching counts, a gap doesn't
+			Assert::IsTrue(box.Overlaps(AABB(Vector3(1, 0, 3), Vector3(2, 1, 4))));
+			Assert::IsFalse(box.Overlaps(AABB(Vector3(1.5f, 0, 3), Vector3(2, 1, 4))));
+		}
+
+		TEST_METHOD(TransformAABBMatchesCorners)
+		{
+			AABB local(Vector3(-1, 0.5f, -2), Vector3(3, 2, 1));
+			Matrix4 m = Matrix4::MakeTranslation(5, -6, 7) * Matrix4::MakeEuler(0.4f, -1.3f, 2.2f) * Matrix4::MakeScale(2, -1, 0.5f);
+			AABB corners;
+			for (int k = 0; k < 8; ++k) {
+				Vector3 c((k & 1) ? local.max.x : local.min.x, (k & 2) ? local.max.y : local.min.y, (k & 4) ? local.max.z : local.min.z);
+				Vector4 p = m * Vector4(c.x, c.y, c.z, 1);
+				corners.Expand(Vector3(p.x, p.y, p.z));
+			}
+			AABB world = TransformAABB(m, local);
+			Assert::AreEqual(corners.min.x, world.min.x, 1e-5f);
+			Assert::AreEqual(corners.min.y, world.min.y, 1e-5f);
+			Assert::AreEqual(corners.min.z, world.min.z, 1e-5f);
+			Assert::AreEqual(corners.max.x, world.max.x, 1e-5f);
+			Assert::AreEqual(corners.max.y, world.max.y, 1e-5f);
+			Assert::AreEqual(corners.max.z, world.max.z, 1e-5f);
+
+			Assert::AreEqual(AABB(Vector3(6, 7, 8), Vector3(6, 7, 8)), TransformAABB(Matrix4::MakeTranslation(5, 5, 5), Vector3(1, 2, 3), Vector3(1, 2, 3)));
+			Assert::IsTrue(TransformAABB(m, AABB()).IsEmpty());
+		}
+
+		TEST_METHOD(MatchesBruteForce)
+		{
+			std::mt19937 rng(7);
+			std::vector<AABB> boxes = RandomBoxes(rng, 500);
+			SweepAndPrune sap;
+			sap.SetBounds(boxes.data(), boxes.size());
+			Assert::AreEqual(0, sap.GetAxis());
+
+			std::vector<BroadphasePair> pairs;
+			sap.FindPairs(pairs);
+			Assert::IsTrue(pairs.size() > 0);
+			AssertSamePairs(BruteForcePairs(boxes), pairs);
+		}
+
+		TEST_METHOD(TouchingBoxesPair)
+		{
+			std::vector<AABB> boxes = {
+				AABB(Vector3(0, 0, 0), Vector3(1, 1, 1)),
+				AABB(Vector3(1, 0, 0), Vector3(2, 1, 1)),
+				AABB(Vector3(2, 1, 0), Vector3(3, 3, 1)),
+			};
+			SweepAndPrune sap;
+			sap.SetBounds(boxes.data(), boxes.size());
+			std::vector<BroadphasePair> pairs;
+			sap.FindPairs(pairs);
+			Assert::AreEqual(size_t(2), pairs.size());
+			AssertSamePairs(BruteForcePairs(boxes), pairs);
+		}
+
+		// boxes touching at zero, where one's max is -0 and the other's min is +0, pair
+		// after the radix sort as they do after the insertion sort
+		TEST_METHOD(TouchingAtSignedZero)
+		{
+			std::vector<AABB> boxes = {
+				AABB(Vector3(-1, 0, 0), Vector3(-0.0f, 1, 1)),
+				AABB(Vector3(0, 0, 0), Vector3(1, 1, 1)),
+				AABB(Vector3(5, 0, 0), Vector3(6, 1, 1)),
+			};
+			SweepAndPrune sap;
+			sap.SetBounds(boxes.data(), boxes.size());
+			std::vector<BroadphasePair> pairs;
+			sap.FindPairs(pairs);
+			Assert::AreEqual(size_t(1), pairs.size());
+			Assert::IsTrue(BroadphasePair{ 0, 1 } == pairs[0]);
+
+			// a small move, sorted by insertion
+			boxes[2] = AABB(Vector3(5.5f, 0, 0), Vector3(6.5f, 1, 1));
+			sap.UpdateBounds(boxes.data(), boxes.size());
+			sap.FindPairs(pairs);
+			Assert::AreEqual(size_t(1), pairs.size());
+			Assert::IsTrue(BroadphasePair{ 0, 1 } == pairs[0]);
+		}
+
+		// empty boxes have their max below their min; they're skipped, never paired
+		TEST_METHOD(EmptyBoxesNeverPair)
+		{
+			std::vector<AABB> boxes = {
+				AABB(Vector3(0, 0, 0), Vector3(1, 1, 1)),
+				AABB(),
+				AABB(Vector3(0.5f, 0.5f, 0.5f), Vector3(2, 2, 2)),
+				AABB(),
+				AABB(Vector3(10, 0, 0), Vector3(11, 1, 1)),
+			};
+			SweepAndPrune sap;
+			sap.SetBounds(boxes.data(), boxes.size());
+			std::vector<BroadphasePair> pairs;
+			sap.FindPairs(pairs);
+			Assert::AreEqual(size_t(1), pairs.size());
+			Assert::IsTrue(BroadphasePair{ 0, 2 } == pairs[0]);
+
+			// boxes becoming empty, and empty ones getting bounds, between frames
+			boxes[1] = AABB(Vector3(10.5f, 0, 0), Vector3(12, 1, 1));
+			boxes[2] = AABB();
+			sap.UpdateBounds(boxes.data(), boxes.size());
+			sap.FindPairs(pairs);
+			Assert::AreEqual(size_t(1), pairs.size());
+			Assert::IsTrue(BroadphasePair{ 1, 4 } == pairs[0]);
+
+			std::vector<AABB> allEmpty(4);
+			sap.SetBounds(allEmpty.data(), allEmpty.size());
+			sap.FindPairs(pairs);
+			Assert::AreEqual(size_t(0), pairs.size());
+		}
+
+		// small moves each frame go through the insertion sort, a teleport through the radix sort
+		TEST_METHOD(IncrementalUpdates)
+		{
+			std::mt19937 rng(11);
+			std::vector<AABB> boxes = RandomBoxes(rng, 300);
+			SweepAndPrune sap;
+			sap.SetBounds(boxes.data(), boxes.size());
+			std::vector<BroadphasePair> pairs;
+
+			std::uniform_real_distribution<float> nudge(-0.5f, 0.5f);
+			for (int frame = 0; frame < 20; ++frame) {
+				for (AABB& box : boxes) {
+					Vector3 move(nudge(rng) * 4.0f, nudge(rng), nudge(rng));
+					box = AABB(box.min + move, box.max + move);
+				}
+				sap.UpdateBounds(boxes.data(), boxes.size());
+				sap.FindPairs(pairs);
+				AssertSamePairs(BruteForcePairs(boxes), pairs);
+			}
+
+			std::shuffle(boxes.begin(), boxes.end(), rng);
+			sap.UpdateBounds(boxes.data(), boxes.size());
+			sap.FindPairs(pairs);
+			AssertSamePairs(BruteForcePairs(boxes), pairs);
+		}
+
+		TEST_METHOD(SwitchesAxis)
+		{
+			std::mt19937 rng(3);
+			std::vector<AABB> boxes = RandomBoxes(rng, 200);
+			SweepAndPrune sap;
+			sap.SetBounds(boxes.data(), boxes.size());
+			Assert::AreEqual(0, sap.GetAxis());
+
+			// swap x and y so the boxes are now spread along y
+			for (AABB& box : boxes)
+				box = AABB(Vector3(box.min.y, box.min.x, box.min.z), Vector3(box.max.y, box.max.x, box.max.z));
+			sap.UpdateBounds(boxes.data(), boxes.size());
+			Assert::AreEqual(1, sap.GetAxis());
+
+			std::vector<BroadphasePair> pairs;
+			sap.FindPairs(pairs);
+			AssertSamePairs(BruteForcePairs(boxes), pairs);
+		}
+	};
+}
@@ -10,6 +10,8 @@
 #include "MathHeaders/Matrix3.h"
 #include "MathHeaders/Matrix4.h"
 #include "MathHeaders/Colour.h"
+#include "MathHeaders/Quaternion.h"
+#include "MathHeaders/AABB.h"
 
 namespace Microsoft {
 	namespace VisualStudio {
@@ -20,6 +22,8 @@ namespace Microsoft {
 			using MathClasses::Matrix3;
 			using MathClasses::Matrix4;
 			using MathClasses::Colour;
+			using MathClasses::Quaternion;
+			using MathClasses::AABB;
 
 			template<> inline std::wstring ToString<Vector3>(const Vector3& t)
 			{
@@ -109,6 +113,50 @@ namespace Microsoft {
 				return ws;
 			}
 
+			template<> inline std::wstring ToString<Quaternion>(const Quaternion& t)
+			{
+				auto str = t.ToString();
+
+				// mbstowcs_s will expect space to write L'\0' if it isn't already included
+				// in the src buffer
+				//
+				// we don't expect that with ToString() which returns a std::string, so we
+				// add 1 to the length here
+				//
+				// without it, it will raise a runtime "Invalid parameter" error
+				// 
+				// see https://en.cppreference.com/w/c/string/multibyte/mbstowcs
+				std::wstring ws(str.length() + 1, L' ');
+
+				size_t size = 0;
+				mbstowcs_s(&size, &ws[0], ws.length(), str.c_str(), str.length());
+
+				ws.resize(size); // resize to actual fit
+				return ws;
+			}
+
+			template<> inline std::wstring ToString<AABB>(const AABB& t)
+			{
+				auto str = t.ToString();
+
+				// mbstowcs_s will expect space to write L'\0' if it isn't already included
+				// in the src buffer
+				//
+				// we don't expect that with ToString() which returns a std::string, so we
+				// add 1 to the length here
+				//
+				// without it, it will raise a runtime "Invalid parameter" error
+				// 
+				// see https://en.cppreference.com/w/c/string/multibyte/mbstowcs
+				std::wstring ws(str.length() + 1, L' ');
+
+				size_t size = 0;
+				mbstowcs_s(&size, &ws[0], ws.length(), str.c_str(), str.length());
+
+				ws.resize(size); // resize to actual fit
+				return ws;
+			}
+
 			//template<> inline std::wstring ToString<Colour>(const Colour& t)
 			//{
 			//	auto str =	std::to_string(t.GetRed()) +
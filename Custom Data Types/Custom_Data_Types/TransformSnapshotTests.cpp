@@ -0,0 +1,130 @@
+#include "CppUnitTest.h"
+#include "TestToString.h"
+
+#include "MathHeaders/TransformSnapshot.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace MathClasses;
+
+namespace MathLibraryTests
+{
+	TEST_CLASS(TransformSnapshotTests)
+	{
+	public:
+		TEST_METHOD(PublishAndAcquire)
+		{
+			PositionSnapshot positions(10, Vector3(1, 1, 1), 4);
+			Span<const Vector3> snapshot = positions.Acquire();
+			Assert::AreEqual(uint64_t(0), positions.GetSnapshotFrame());
+			Assert::AreEqual(Vector3(1, 1, 1), snapshot[9]);
+
+			positions.Set(3, Vector3(3, 0, 0));
+			// nothing published yet, so the reader's view doesn't change
+			Assert::AreEqual(Vector3(1, 1, 1), positions.Acquire()[3]);
+			positions.Publish();
+			snapshot = positions.Acquire();
+			Assert::AreEqual(uint64_t(1), positions.GetSnapshotFrame());
+			Assert::AreEqual(Vector3(3, 0, 0), snapshot[3]);
+
+			// the writer's new copy already has frame 1's change
+			Assert::AreEqual(Vector3(3, 0, 0), positions.GetWriteBuffer()[3]);
+			positions.Set(9, Vector3(9, 0, 0));
+			positions.Publish();
+			// the held snapshot isn't touched until the next Acquire
+			Assert::AreEqual(Vector3(1, 1, 1), snapshot[9]);
+			snapshot = positions.Acquire();
+			Assert::AreEqual(uint64_t(2), positions.GetSnapshotFrame());
+			Assert::AreEqual(Vector3(3, 0, 0), snapshot[3]);
+			Assert::AreEqual(Vector3(9, 0, 0), snapshot[9]);
+
+			// several publishes between reads: the reader skips to the newest
+			positions.Set(0, Vector3(5, 0, 0));
+			positions.Publish();
+			positions.Publish();
+			snapshot = positions.Acquire();
+			Assert::AreEqual(uint64_t(4), positions.GetSnapshotFrame());
+			Assert::AreEqual(Vector3(5, 0, 0), snapshot[0]);
+			Assert::AreEqual(Vector3(9, 0, 0), snapshot[9]);
+		}
+
+		TEST_METHOD(CopiesOnlyDirtyBlocks)
+		{
+			TransformSnapshot transforms(1000, Matrix4::MakeIdentity(), 100);
+			Assert::AreEqual(size_t(0), transforms.Publish());
+
+			transforms.Set(150, Matrix4::MakeTranslation(1, 2, 3));
+			transforms.MarkDirty(420, 200);
+			Span<Matrix4> write = transforms.GetWriteBuffer();
+			for (size_t i = 420; i < 620; ++i)
+				write[i] = Matrix4::MakeScale(2, 2, 2);
+			// block 1, and blocks 4 to 6
+			Assert::AreEqual(size_t(4), transforms.Publish());
+			// with no reader the writer alternates between two copies, both current now
+			Assert::AreEqual(size_t(0), transforms.Publish());
+			// a read hands the writer the third copy, still at the initial values
+			transforms.Acquire();
+			Assert::AreEqual(size_t(4), transforms.Publish());
+			Assert::AreEqual(size_t(0), transforms.Publish());
+
+			Span<const Matrix4> snapshot = transforms.Acquire();
+			Assert::IsTrue(Matrix4::MakeTranslation(1, 2, 3) == snapshot[150]);
+			Assert::IsTrue(Matrix4::MakeScale(2, 2, 2) == snapshot[619]);
+			Assert::IsTrue(Matrix4::MakeIdentity() == snapshot[620]);
+			for (size_t i = 0; i < 3; ++i) {
+				Assert::IsTrue(Matrix4::MakeTranslation(1, 2, 3) == transforms.GetWriteBuffer()[150]);
+				transforms.Publish();
+			}
+		}
+
+		// every snapshot the reader sees is one whole frame
+		TEST_METHOD(ReaderNeverSeesTornFrames)
+		{
+			const size_t count = 4096;
+			const uint64_t frames = 3000;
+			SnapshotBuffer<uint64_t> store(count, 0, 256);
+			std::atomic<bool> done{ false };
+
+			std::thread writer([&]() {
+				for (uint64_t frame = 1; frame <= frames; ++frame) {
+					// the whole array in even frames, one block in odd ones
+					size_t first = frame % 2 == 0 ? 0 : (frame * 256) % count;
+					size_t n = frame % 2 == 0 ? count : 256;
+					Span<uint64_t> values = store.GetWriteBuffer();
+					store.MarkDirty(first, n);
+					for (size_t i = first; i < first + n; ++i)
+						values[i] = frame;
+					store.Publish();
+				}
+				done = true;
+			});
+
+			uint64_t lastFrame = 0;
+			bool failed = false;
+			while (!done || store.GetSnapshotFrame() < frames) {
+				Span<const uint64_t> snapshot = store.Acquire();
+				uint64_t frame = store.GetSnapshotFrame();
+				failed |= frame < lastFrame;
+				lastFrame = frame;
+				if (frame == 0)
+					continue;
+				// nothing newer than the frame, and the frame's own writes all there
+				uint64_t evenFrame = frame % 2 == 0 ? frame : frame - 1;
+				for (size_t i = 0; i < count; ++i) {
+					failed |= snapshot[i] > frame;
+					failed |= evenFrame > 0 && snapshot[i] < evenFrame;
+				}
+				if (frame % 2 == 1) {
+					size_t first = (frame * 256) % count;
+					failed |= snapshot[first] != frame || snapshot[first + 255] != frame;
+				}
+			}
+			writer.join();
+			Assert::IsFalse(failed);
+			Assert::AreEqual(frames, store.GetSnapshotFrame());
+		}
+	};
+}
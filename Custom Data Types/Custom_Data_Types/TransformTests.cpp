@@ -0,0 +1,130 @@
+#include "CppUnitTest.h"
+#include "TestToString.h"
+
+#include "MathHeaders/Transform.h"
+
+#include <random>
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace MathClasses;
+
+namespace MathLibraryTests
+{
+	TEST_CLASS(TransformTests)
+	{
+	public:
+		TEST_METHOD(DecomposeRecoversParts)
+		{
+			Quaternion rotation = Quaternion::MakeAxisAngle(Vector3(1, 2, -1).Normalised(), 2.2f);
+			Vector3 translation(4, -5, 6), scale(2, 0.5f, 3);
+			Matrix4 m = Matrix4::MakeTranslation(translation) * rotation.ToMatrix4() * Matrix4::MakeScale(scale);
+
+			Vector3 t, s;
+			Quaternion r;
+			Assert::IsTrue(m.Decompose(t, r, s));
+			Assert::AreEqual(translation, t);
+			Assert::AreEqual(scale, s);
+			Assert::IsTrue(rotation == r);
+
+			Matrix3 basis;
+			Assert::IsTrue(m.Decompose(t, basis, s));
+			Assert::IsTrue(rotation.ToMatrix3() == basis);
+			Assert::IsTrue(Transform::ComposeMatrix(t, r, s) == m);
+		}
+
+		TEST_METHOD(DecomposeMirrorAndDegenerate)
+		{
+			Quaternion rotation = Quaternion::MakeAxisAngle(Vector3(0, 1, 0), 0.8f);
+			Matrix4 mirrored = rotation.ToMatrix4() * Matrix4::MakeScale(1, -2, 1);
+			Vector3 t, s;
+			Quaternion r;
+			Assert::IsTrue(mirrored.Decompose(t, r, s));
+			// the mirror moves to x, and the parts still rebuild the matrix
+			Assert::IsTrue(s.x < 0);
+			Assert::AreEqual(Vector3(-1, 2, 1), s);
+			Assert::AreEqual(1.0f, r.Magnitude(), 1e-5f);
+			Assert::IsTrue(Transform::ComposeMatrix(t, r, s) == mirrored);
+
+			// flattened on one axis: rebuilt from the other two
+			Matrix4 flat = rotation.ToMatrix4() * Matrix4::MakeScale(1, 1, 0);
+			Assert::IsFalse(flat.Decompose(t, r, s));
+			Assert::IsTrue(rotation == r);
+			Assert::AreEqual(0.0f, s.z);
+
+			// projective bottom row
+			Matrix4 projective = Matrix4::MakeIdentity();
+			projective.m12 = -1;
+			Assert::IsFalse(projective.Decompose(t, r, s));
+		}
+
+		TEST_METHOD(LazyForms)
+		{
+			Quaternion rotation = Quaternion::MakeAxisAngle(Vector3(0, 0, 1), 1.0f);
+			Transform transform(Vector3(1, 2, 3), rotation, Vector3(2, 2, 2));
+			Assert::IsTrue(transform.AreComponentsCurrent());
+			Assert::IsFalse(transform.IsMatrixCurrent());
+			Matrix4 expected = Matrix4::MakeTranslation(1, 2, 3) * rotation.ToMatrix4() * Matrix4::MakeScale(2, 2, 2);
+			Assert::IsTrue(expected == transform.GetMatrix());
+			Assert::IsTrue(transform.IsMatrixCurrent());
+
+			// translation keeps both forms current
+			transform.SetTranslation(Vector3(-1, 0, 0));
+			Assert::IsTrue(transform.IsMatrixCurrent() && transform.AreComponentsCurrent());
+			Assert::AreEqual(-1.0f, transform.GetMatrix().m13);
+
+			transform.SetMatrix(Matrix4::MakeTranslation(5, 6, 7) * Matrix4::MakeRotateX(0.5f) * Matrix4::MakeScale(1, 3, 1));
+			Assert::IsFalse(transform.AreComponentsCurrent());
+			Assert::AreEqual(Vector3(5, 6, 7), transform.GetTranslation());
+			Assert::IsFalse(transform.AreComponentsCurrent());
+			Assert::AreEqual(Vector3(1, 3, 1), transform.GetScale());
+			Assert::IsTrue(transform.AreComponentsCurrent());
+			Assert::IsTrue(Quaternion::MakeAxisAngle(Vector3(1, 0, 0), 0.5f) == transform.GetRotation());
+
+			transform.SetScale(Vector3(1, 1, 1));
+			Assert::IsFalse(transform.IsMatrixCurrent());
+			Assert::IsTrue(Matrix4::MakeTranslation(5, 6, 7) * Matrix4::MakeRotateX(0.5f) == transform.GetMatrix());
+
+			Transform identity;
+			Assert::IsTrue(Matrix4::MakeIdentity() == identity.GetMatrix());
+			Assert::AreEqual(Vector3(1, 1, 1), identity.GetScale());
+		}
+
+		TEST_METHOD(BatchMatchesScalar)
+		{
+			std::mt19937 rng(41);
+			std::uniform_real_distribution<float> angle(-3.0f, 3.0f), position(-100.0f, 100.0f), size(0.1f, 4.0f);
+			std::vector<Matrix4> matrices;
+			for (int i = 0; i < 2000; ++i)
+				matrices.push_back(Matrix4::MakeTranslation(position(rng), position(rng), position(rng)) *
+					Matrix4::MakeEuler(angle(rng), angle(rng), angle(rng)) * Matrix4::MakeScale(size(rng), size(rng), size(rng)));
+
+			size_t count = matrices.size();
+			std::vector<Vector3> translations(count), scales(count), parallelScales(count), parallelTranslations(count);
+			std::vector<Quaternion> rotations(count), parallelRotations(count);
+			std::vector<uint8_t> valid(count);
+			DecomposeMatrices(matrices.data(), translations.data(), rotations.data(), scales.data(), valid.data(), count);
+			DecomposeMatrices(Execution::Par, matrices.data(), parallelTranslations.data(), parallelRotations.data(), parallelScales.data(), nullptr, count);
+			for (size_t i = 0; i < count; ++i) {
+				Assert::AreEqual(uint8_t(1), valid[i]);
+				Assert::IsTrue(Transform::ComposeMatrix(translations[i], rotations[i], scales[i]) == matrices[i]);
+				Assert::AreEqual(scales[i].x, parallelScales[i].x);
+				Assert::AreEqual(rotations[i].w, parallelRotations[i].w);
+				Assert::AreEqual(translations[i].z, parallelTranslations[i].z);
+			}
+
+			FrameArena arena(128 * 1024);
+			DecomposedMatrices fromArena = DecomposeMatrices(Execution::Par, arena, matrices.data(), count);
+			Assert::AreEqual(count, fromArena.valid.Size());
+			for (size_t i = 0; i < count; ++i) {
+				Assert::AreEqual(uint8_t(1), fromArena.valid[i]);
+				Assert::AreEqual(translations[i], fromArena.translations[i]);
+				Assert::AreEqual(rotations[i], fromArena.rotations[i]);
+				Assert::AreEqual(scales[i], fromArena.scales[i]);
+			}
+			FrameArena small(count * sizeof(Vector3) * 2);
+			Assert::IsTrue(DecomposeMatrices(small, matrices.data(), count).rotations.Empty());
+			Assert::AreEqual(size_t(0), small.GetMarker().offset);
+		}
+	};
+}
@@ -0,0 +1,124 @@
+#include "CppUnitTest.h"
+#include "TestToString.h"
+
+#include "Utils.h"
+#include "MathHeaders/TrigTable.h"
+#include "MathHeaders/Matrix3.h"
+#include "MathHeaders/Batch.h"
+
+#include <cmath>
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace MathClasses;
+
+namespace MathLibraryTests
+{
+	TEST_CLASS(TrigTableTests)
+	{
+	public:
+		TEST_METHOD(EveryStepMatchesLibm)
+		{
+			const SinCosTable& table = SinCosTable::Get();
+			for (uint32_t angle = 0; angle < SinCosTable::Steps; ++angle) {
+				double radians = angle * (2.0 * 3.14159265358979323846 / SinCosTable::Steps);
+				float s, c;
+				table.Lookup(angle, s, c);
+				Assert::AreEqual(float(std::sin(radians)), s, 1e-7f);
+				Assert::AreEqual(float(std::cos(radians)), c, 1e-7f);
+			}
+
+			// quarter turns are exact
+			float s, c;
+			table.Lookup(1024, s, c);
+			Assert::AreEqual(1.0f, s);
+			Assert::AreEqual(0.0f, c);
+			table.Lookup(2048, s, c);
+			Assert::AreEqual(-1.0f, c);
+		}
+
+		TEST_METHOD(AnglesWrap)
+		{
+			const SinCosTable& table = SinCosTable::Get();
+			for (uint32_t angle = 0; angle < SinCosTable::Steps; angle += 37) {
+				float s, c, ws, wc, ns, nc;
+				table.Lookup(angle, s, c);
+				table.Lookup(angle + 5 * SinCosTable::Steps, ws, wc);
+				// minus the angle, as unsigned arithmetic wraps it
+				table.Lookup(0u - angle, ns, nc);
+				Assert::AreEqual(s, ws);
+				Assert::AreEqual(c, wc);
+				Assert::AreEqual(-s, ns);
+				Assert::AreEqual(c, nc);
+			}
+			Assert::AreEqual(1024u, SinCosTable::Quantise(Pi / 2));
+			Assert::AreEqual(4095u, SinCosTable::Quantise(-Pi / 2048) & (SinCosTable::Steps - 1));
+		}
+
+		TEST_METHOD(Interpolated)
+		{
+			const SinCosTable& table = SinCosTable::Get();
+			double worst = 0;
+			for (float radians = -100.0f; radians <= 100.0f; radians += 0.0007f) {
+				float s, c;
+				table.LookupInterpolated(radians, s, c);
+				worst = std::fmax(worst, std::fabs(s - std::sin(double(radians))));
+				worst = std::fmax(worst, std::fabs(c - std::cos(double(radians))));
+			}
+			Assert::IsTrue(worst <= 2e-7);
+
+			// large angles are reduced before they're converted to steps
+			for (float radians : { 1e6f, -3.5e7f, 1e17f, -3e38f }) {
+				float s, c;
+				table.LookupInterpolated(radians, s, c);
+				double reduced = std::remainder(double(radians), SinCosTable::TwoPi);
+				Assert::AreEqual(std::sin(reduced), double(s), 2e-7);
+				Assert::AreEqual(std::cos(reduced), double(c), 2e-7);
+				Assert::IsTrue(SinCosTable::Quantise(radians) < SinCosTable::Steps);
+			}
+			float s, c;
+			table.LookupInterpolated(INFINITY, s, c);
+			Assert::IsTrue(std::isnan(s) && std::isnan(c));
+			table.LookupInterpolated(NAN, s, c);
+			Assert::IsTrue(std::isnan(s) && std::isnan(c));
+			Assert::AreEqual(0u, SinCosTable::Quantise(-INFINITY));
+			Assert::AreEqual(0u, SinCosTable::Quantise(NAN));
+			Assert::AreEqual(1024u, SinCosTable::Quantise(Pi / 2 + 1000 * 2 * Pi));
+		}
+
+		TEST_METHOD(RotationBuilders)
+		{
+			for (uint32_t angle = 0; angle < SinCosTable::Steps; angle += 61) {
+				float radians = angle * (2 * Pi / SinCosTable::Steps);
+				Matrix3 rotation = Matrix3::MakeRotation(radians), quantised = Matrix3::MakeRotationQuantised(angle);
+				Matrix3 interpolated = Matrix3::MakeRotationInterpolated(radians);
+				Matrix3 rotateZ = Matrix3::MakeRotateZ(radians), rotateZQuantised = Matrix3::MakeRotateZQuantised(angle);
+				const float* r = &rotation.m1;
+				const float* q = &quantised.m1;
+				const float* i = &interpolated.m1;
+				const float* z = &rotateZ.m1;
+				const float* zq = &rotateZQuantised.m1;
+				for (int k = 0; k < 9; ++k) {
+					Assert::AreEqual(r[k], q[k], 1e-6f);
+					Assert::AreEqual(r[k], i[k], 1e-6f);
+					Assert::AreEqual(z[k], zq[k], 1e-6f);
+				}
+			}
+		}
+
+		TEST_METHOD(BatchMatchesScalar)
+		{
+			std::vector<uint32_t> angles(5003);
+			for (size_t i = 0; i < angles.size(); ++i)
+				angles[i] = uint32_t(i * 2654435761u);
+			std::vector<Matrix3> serial(angles.size()), parallel(angles.size());
+			MakeRotationsQuantised(angles.data(), serial.data(), angles.size());
+			MakeRotationsQuantised(Execution::Par, angles.data(), parallel.data(), angles.size());
+			for (size_t i = 0; i < angles.size(); ++i) {
+				Matrix3 expected = Matrix3::MakeRotationQuantised(angles[i]);
+				Assert::IsTrue(serial[i].m1 == expected.m1 && serial[i].m2 == expected.m2 && serial[i].m4 == expected.m4 && serial[i].m5 == expected.m5);
+				Assert::IsTrue(parallel[i].m1 == expected.m1 && parallel[i].m2 == expected.m2 && parallel[i].m4 == expected.m4 && parallel[i].m5 == expected.m5);
+			}
+		}
+	};
+}
@@ -1,6 +1,7 @@
 #pragma once
 
 #define _USE_MATH_DEFINES
+#include <cfloat>
 #include <cmath>
 
 #include "MathHeaders/Colour.h"
@@ -15,6 +16,14 @@ namespace MathClasses
 		return fabsf(a - b) < MAX_FLOAT_DELTA;
 	}
 
+	// Whether a and b are within a few roundings of each other, for values worked out
+	// from inputs of about the given size. SIMD and scalar versions of a calculation
+	// can differ by that much when the compiler contracts multiplies and adds to FMA.
+	inline bool NearlyEqualAtScale(float a, float b, float scale)
+	{
+		return fabsf(a - b) <= 8.0f * FLT_EPSILON * fmaxf(scale, fmaxf(fabsf(a), fabsf(b)));
+	}
+
     inline float AngleFrom2D(float x, float y)
     {
         return atan2f(y, x);